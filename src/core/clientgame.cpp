@@ -8,6 +8,7 @@
 #include "graphicscore.h"
 #include "d3dx12.h"
 #include "context.h"
+#include "framearena.h"
 #include "resources/uploadbuffer.h"
 #include "geometry/objloader.h"
 #include "geometry/vertexformat.h"
@@ -73,7 +74,10 @@ void ClientGame::UnloadContent() {
 
 void ClientGame::OnRender(RenderEventArgs& e) {
     super::OnRender(e);
-     
+
+    //wait only if the gpu is still on the frame which used this frame slot
+    GRAPHICS_CORE::BeginFrame();
+
     ColorBuffer& currentBackbuffer = m_window->GetCurrentBackBuffer();
     auto rtv = m_window->GetCurrentRenderTargetView();
     auto dsv = m_depthBuffer.GetDSV();
@@ -94,6 +98,19 @@ void ClientGame::OnRender(RenderEventArgs& e) {
     {
         m_window->Present();
     }
+
+    //the frame slot keeps the fences of the frame
+    GRAPHICS_CORE::EndFrame();
+
+    //record the upload memory telemetry and trim the idle pages of the frame
+    DynamicLinearMemoryAllocator::EndFrame();
+    GRAPHICS_CORE::ReleaseDeferredResources();
+
+    //let the caches trim themselves before the memory budget is hit
+    MemoryBudgetManager::Instance().DispatchPressureCallbacks();
+
+    //drop the transient cpu data of the older frame
+    FrameArenaManager::Instance().EndFrame();
 }
 
 void ClientGame::OnUpdate(UpdateEventArgs& e) {
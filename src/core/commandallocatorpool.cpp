@@ -1,5 +1,9 @@
 #include "commandallocatorpool.h"
 
+//the allocators cached by current thread, one magazine per command list type
+typedef ThreadMagazine<ID3D12CommandAllocator, CommandAllocatorPool::kThreadMagazineSize> AllocatorMagazine;
+static thread_local AllocatorMagazine t_allocatorMagazines[4];
+
 CommandAllocatorPool::CommandAllocatorPool(D3D12_COMMAND_LIST_TYPE type) :
 	m_type(type), m_device(nullptr)
 {
@@ -17,40 +21,47 @@ void CommandAllocatorPool::Initialize(ID3D12Device* device)
 
 void CommandAllocatorPool::Release()
 {
-	for (size_t i = 0; i < GetPoolSize(); ++i) {
+	std::lock_guard<std::mutex> lockGuard(m_allocatorMutex);
+	for (size_t i = 0; i < m_commandAllocatorPool.size(); ++i) {
 		m_commandAllocatorPool[i]->Release();
 	}
 	m_commandAllocatorPool.clear();
+	//the allocators cached by the thread magazines are dropped by the generation of the reservoir
+	m_reservoir.Clear();
 }
 
 ID3D12CommandAllocator* CommandAllocatorPool::RequestAllocator(uint64_t fenceValue)
 {
-	std::lock_guard<std::mutex> lockGuard(m_allocatorMutex);
+	AllocatorMagazine& magazine = t_allocatorMagazines[m_type];
+	magazine.Attach(m_reservoir);
+
+	//the allocators are ready to be reused when the completed fence passes them
+	if (magazine.IsEmpty())
+		magazine.Refill(m_reservoir, [fenceValue](uint64_t allocatorFence) { return allocatorFence <= fenceValue; });
+
 	ID3D12CommandAllocator* returnAllocator = nullptr;
-	if (!m_readyAllocators.empty()) {
-		std::pair<uint64_t, ID3D12CommandAllocator*> allocatorItem = m_readyAllocators.front();
-		//check the allocator is ready to be reused
-		if (allocatorItem.first < fenceValue) {
-			ID3D12CommandAllocator* allocator = allocatorItem.second;
-			ThrowIfFailed(allocator->Reset());
-			m_readyAllocators.pop();
-			return allocator;
-		}
+	if (!magazine.IsEmpty()) {
+		returnAllocator = magazine.Pop();
+		ThrowIfFailed(returnAllocator->Reset());
+		return returnAllocator;
 	}
 
-	if (returnAllocator == nullptr) {
-		ThrowIfFailed(m_device->CreateCommandAllocator(m_type, IID_PPV_ARGS(&returnAllocator)));
-		wchar_t allocatorName[32];
-		swprintf_s(allocatorName, L"CommandAllocator %zu", m_commandAllocatorPool.size());
-		returnAllocator->SetName(allocatorName);
-		m_commandAllocatorPool.push_back(returnAllocator);
-	}
+	//every allocator is in use or waiting for the gpu
+	std::lock_guard<std::mutex> lockGuard(m_allocatorMutex);
+	ThrowIfFailed(m_device->CreateCommandAllocator(m_type, IID_PPV_ARGS(&returnAllocator)));
+	wchar_t allocatorName[32];
+	swprintf_s(allocatorName, L"CommandAllocator %zu", m_commandAllocatorPool.size());
+	returnAllocator->SetName(allocatorName);
+	m_commandAllocatorPool.push_back(returnAllocator);
 
 	return returnAllocator;
 }
 
+//the allocator is in m_commandAllocatorPool, retired into the thread magazine
+//the magazine hands its retired allocators to the reservoir in one batch
 void CommandAllocatorPool::DiscardAllocator(uint64_t fenceValue, ID3D12CommandAllocator* allocator)
 {
-	std::lock_guard<std::mutex> lockGuard(m_allocatorMutex);
-	m_readyAllocators.push(std::make_pair(fenceValue, allocator)); //the allocator is in m_commandAllocatorPool
+	AllocatorMagazine& magazine = t_allocatorMagazines[m_type];
+	magazine.Attach(m_reservoir);
+	magazine.Retire(m_reservoir, fenceValue, allocator);
 }
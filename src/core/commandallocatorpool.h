@@ -2,13 +2,20 @@
 #include <queue>
 #include <mutex>
 #include "headers.h"
+#include "fencedreservoir.h"
 
 //The command allocator is a reset every frame
 //Resue the command allocator after the GPU has finished executing the commands
+//each thread requests from its own magazine of ready allocators, the magazine is refilled in batch
+//from the reservoir, which takes every allocator whose fence completed
+//the discarded allocators are batched in the magazine too, and go to the reservoir with one lock
 
 class CommandAllocatorPool
 {
 public:
+	//the ready allocators kept by one thread for one command list type
+	static const uint32_t kThreadMagazineSize = 8;
+
 	CommandAllocatorPool(D3D12_COMMAND_LIST_TYPE type);
 	~CommandAllocatorPool();
 
@@ -18,13 +25,18 @@ public:
 	ID3D12CommandAllocator* RequestAllocator(uint64_t fenceValue);
 	void DiscardAllocator(uint64_t fenceValue, ID3D12CommandAllocator* allocator);
 
-	UINT GetPoolSize()const { return (UINT)m_commandAllocatorPool.size(); }
+	UINT GetPoolSize() {
+		std::lock_guard<std::mutex> lockGuard(m_allocatorMutex);
+		return (UINT)m_commandAllocatorPool.size();
+	}
 
 private:
 	//different command allocator pool for different type command list
 	const D3D12_COMMAND_LIST_TYPE m_type; 
 	ID3D12Device* m_device; 
+	//all the created allocators, only the creation takes the lock
 	std::vector<ID3D12CommandAllocator*> m_commandAllocatorPool;
-	std::queue<std::pair<uint64_t, ID3D12CommandAllocator*>> m_readyAllocators;
 	std::mutex m_allocatorMutex;
+	//the allocators wait for the gpu, and the allocators ready to be reset
+	FencedReservoir<ID3D12CommandAllocator> m_reservoir;
 };
\ No newline at end of file
@@ -89,6 +89,13 @@ void CommandManager::WaitForFence(uint64_t fenceValue)
 	GetQueue((D3D12_COMMAND_LIST_TYPE)(fenceValue >> 56)).WaitForFence(fenceValue);
 }
 
+void CommandManager::GetLastSubmittedFences(uint64_t fenceValues[kQueueCount])
+{
+	fenceValues[0] = m_graphicsQueue.GetLastSubmittedFence();
+	fenceValues[1] = m_computeQueue.GetLastSubmittedFence();
+	fenceValues[2] = m_copyQueue.GetLastSubmittedFence();
+}
+
 uint64_t CommandManager::CreateFenceValue(D3D12_COMMAND_LIST_TYPE type, uint64_t origin)
 {
 	return ((type << 56) | origin);
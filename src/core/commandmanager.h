@@ -11,6 +11,9 @@ using namespace Microsoft::WRL;
 class CommandManager
 {
 public:
+	//the direct, compute and copy queues
+	static const uint32_t kQueueCount = 3;
+
 	CommandManager();
 	~CommandManager();
 
@@ -54,6 +57,10 @@ public:
 	//get the fence value's command list type
 	D3D12_COMMAND_LIST_TYPE GetCommandListTypeFromFenceValue(uint64_t fenceValue);
 
+	//the last submitted fence of the direct, compute and copy queues
+	//the work submitted to any queue before the call is covered by them
+	void GetLastSubmittedFences(uint64_t fenceValues[kQueueCount]);
+
 	//waits for a fence value to be reached
 	bool IsFenceComplete(uint64_t fenceValue);
 
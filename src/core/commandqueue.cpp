@@ -1,7 +1,10 @@
 #include "commandqueue.h"
 #include "headers.h"
+#include "context.h"
+#include "graphicscore.h"
 #include <wrl.h>
 #include <queue>
+#include <vector>
 #include <cstdint>
 
 using namespace Microsoft::WRL;
@@ -11,8 +14,9 @@ CommandQueue::CommandQueue(D3D12_COMMAND_LIST_TYPE type)
 	  m_commandQueuePtr(nullptr),
 	  m_pFence(nullptr),
 	  m_nextFenceValue((uint64_t)type << 56 | 1),
-	  m_lastCompletedFenceValue((uint64_t)type << 56),
-	  m_commandAllocatorPool(type)
+	  m_lastCompletedFenceValue{ (uint64_t)type << 56 },
+	  m_commandAllocatorPool(type),
+	  m_dependencies(type)
 {
 }
 
@@ -60,16 +64,55 @@ void CommandQueue::Release() {
 
 uint64_t CommandQueue::ExecuteCommandList(ID3D12GraphicsCommandList* commandList)
 {
+	return ExecuteCommandLists(1, &commandList);
+}
+
+uint64_t CommandQueue::ExecuteCommandLists(UINT count, ID3D12GraphicsCommandList* const commandLists[])
+{
+	assert(count > 0);
+	for (UINT i = 0; i < count; ++i)
+		ThrowIfFailed(commandLists[i]->Close());
+
 	std::lock_guard<std::mutex> lock(m_fenceMutex);
-	ThrowIfFailed(commandList->Close());
-	//execute command list
-	m_commandQueuePtr->ExecuteCommandLists(1, (ID3D12CommandList* const*)&commandList);
+	//wait for the outputs of the other queues consumed by the lists
+	uint64_t waitFences[QueueDependencies::kQueueTypeCount];
+	uint32_t waitCount = m_dependencies.TakeWaits([](uint64_t fenceValue) {
+		return GRAPHICS_CORE::g_commandManager.IsFenceComplete(fenceValue);
+	}, waitFences);
+	for (uint32_t i = 0; i < waitCount; ++i)
+		StallForFence(waitFences[i]);
+	//execute command lists
+	m_commandQueuePtr->ExecuteCommandLists(count, (ID3D12CommandList* const*)commandLists);
 	//create marke
 	m_commandQueuePtr->Signal(m_pFence, m_nextFenceValue);
 	//increase the fence value
 	return m_nextFenceValue++;
 }
 
+uint64_t CommandQueue::ExecuteContexts(UINT count, Context* const contexts[])
+{
+	assert(count > 0);
+	//the submission may run on any thread, so the frame arena is not used here
+	std::vector<ID3D12GraphicsCommandList*> commandLists;
+	commandLists.reserve(count);
+	for (UINT i = 0; i < count; ++i) {
+		assert(contexts[i]->GetContextType() == m_commandListType);
+		contexts[i]->FlushResourceBarrier();
+		commandLists.push_back(contexts[i]->GetGraphicCommandList());
+	}
+
+	uint64_t fenceValue = ExecuteCommandLists(count, commandLists.data());
+	for (UINT i = 0; i < count; ++i)
+		contexts[i]->Retire(fenceValue);
+	return fenceValue;
+}
+
+uint64_t CommandQueue::GetLastSubmittedFence()
+{
+	std::lock_guard<std::mutex> lock(m_fenceMutex);
+	return m_nextFenceValue - 1;
+}
+
 uint64_t CommandQueue::IncrementFence()
 {
 	std::lock_guard<std::mutex> lock(m_fenceMutex);
@@ -77,14 +120,21 @@ uint64_t CommandQueue::IncrementFence()
 	return m_nextFenceValue++;
 }
 
+uint64_t CommandQueue::UpdateCompletedFence(uint64_t completedFenceValue)
+{
+	uint64_t lastCompletedValue = m_lastCompletedFenceValue.load(std::memory_order_relaxed);
+	while (completedFenceValue > lastCompletedValue &&
+		!m_lastCompletedFenceValue.compare_exchange_weak(lastCompletedValue, completedFenceValue, std::memory_order_relaxed)) {}
+	return std::max(lastCompletedValue, completedFenceValue);
+}
+
 bool CommandQueue::IsFenceComplete(uint64_t fenceValue)
 {
 	//If current fence not complete, update last compeleted fence
-	if (fenceValue > m_lastCompletedFenceValue)
-	{
-		m_lastCompletedFenceValue = std::max(m_lastCompletedFenceValue, m_pFence->GetCompletedValue());
-	}
-	return fenceValue <= m_lastCompletedFenceValue;
+	uint64_t lastCompletedValue = m_lastCompletedFenceValue.load(std::memory_order_relaxed);
+	if (fenceValue > lastCompletedValue)
+		lastCompletedValue = UpdateCompletedFence(m_pFence->GetCompletedValue());
+	return fenceValue <= lastCompletedValue;
 }
 
 void CommandQueue::WaitForFence(uint64_t fenceValue)
@@ -98,18 +148,27 @@ void CommandQueue::WaitForFence(uint64_t fenceValue)
 		m_pFence->SetEventOnCompletion(fenceValue, m_fenceEvent);
 		WaitForSingleObject(m_fenceEvent, INFINITE);
 		//update last completed fence
-		m_lastCompletedFenceValue = fenceValue;
+		UpdateCompletedFence(fenceValue);
 	}
 }
 
 void CommandQueue::StallForFence(uint64_t fenceValue)
 {
-	//Todo: stall for fence
+	//the producer queue is in the top byte of the fence value
+	CommandManager& commandManager = GRAPHICS_CORE::g_commandManager;
+	CommandQueue& producer = commandManager.GetQueue(commandManager.GetCommandListTypeFromFenceValue(fenceValue));
+	//the commands of the same queue run in order
+	if (&producer == this)
+		return;
+	ThrowIfFailed(m_commandQueuePtr->Wait(producer.m_pFence, fenceValue));
 }
 
 void CommandQueue::StallForProducer(CommandQueue& producer)
 {
-	//Todo: stall for producer
+	if (&producer == this)
+		return;
+	//the last signaled fence of the producer, read under its lock since it may be submitting
+	ThrowIfFailed(m_commandQueuePtr->Wait(producer.m_pFence, producer.GetLastSubmittedFence()));
 }
 
 ID3D12CommandAllocator* CommandQueue::RequestAllocator() {
@@ -2,11 +2,15 @@
 #include <d3d12.h>
 #include <wrl.h>
 #include <queue>
+#include <atomic>
 #include <cstdint>
 #include "commandallocatorpool.h"
+#include "queuedependencies.h"
 
 using namespace Microsoft::WRL;
 
+class Context;
+
 /*
 * The Encapsualted CommandQueue
 */
@@ -25,22 +29,39 @@ public:
 
 
 	uint64_t ExecuteCommandList(ID3D12GraphicsCommandList* commandList);
+	//close and submit the command lists in order with one call, the lists share the returned fence
+	uint64_t ExecuteCommandLists(UINT count, ID3D12GraphicsCommandList* const commandLists[]);
+	//submit the contexts in order with one call and one fence signal
+	//the allocators, pages and descriptor blocks of all the contexts retire with the returned fence,
+	//and the contexts go back to the context manager
+	uint64_t ExecuteContexts(UINT count, Context* const contexts[]);
+
+	//the next submission of this queue consumes the output of the fence from another queue
+	//the queue waits on the gpu before the submission, the cpu is not blocked
+	void AddDependency(uint64_t producerFenceValue) { m_dependencies.AddDependency(producerFenceValue); }
 
 	uint64_t IncrementFence();
 	bool IsFenceComplete(uint64_t fenceValue);
+	//the gpu waits for the fence of the queue encoded in the fence value
 	void StallForFence(uint64_t fenceValue);
+	//the gpu waits for all the submissions of the producer so far
 	void StallForProducer(CommandQueue& producer);
 	void WaitForFence(uint64_t fenceValue);
 	void Flush(){ WaitForFence(IncrementFence());}
 
 	ID3D12CommandQueue* GetCommandQueue() const { return m_commandQueuePtr; }
 	uint64_t GetNextFenceValue() const { return m_nextFenceValue; }
+	//the fence of the last submission, read under the fence lock
+	uint64_t GetLastSubmittedFence();
 
 protected:
 	ID3D12CommandAllocator* RequestAllocator();
 	void DiscardCommandAllocator(uint64_t fenceValueForReset, ID3D12CommandAllocator* allocatorForDiscard);
 
 private:
+	//raise the last completed fence, never lower it, the recording threads check the fences concurrently
+	uint64_t UpdateCompletedFence(uint64_t completedFenceValue);
+
 	ID3D12CommandQueue* m_commandQueuePtr;
 
 	const D3D12_COMMAND_LIST_TYPE m_commandListType;
@@ -49,10 +70,11 @@ private:
 	std::mutex m_eventMutex;
 
 	ID3D12Fence* m_pFence;
-	uint64_t m_lastCompletedFenceValue;
+	std::atomic<uint64_t> m_lastCompletedFenceValue;
 	uint64_t m_nextFenceValue;
 	HANDLE m_fenceEvent;
 	CommandAllocatorPool m_commandAllocatorPool; //reallocate the memory for the command lists
+	QueueDependencies m_dependencies;
 
 	friend class CommandManager;
 };
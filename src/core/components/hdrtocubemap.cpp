@@ -51,8 +51,10 @@ void HDRLoader::Render() {
          XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f,  0.0f, -1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
     };
 
-    GraphicsContext& graphicsContext = GRAPHICS_CORE::g_contextManager.GetAvailableGraphicsContext();
+    GenerateHDRMips();
 
+    GraphicsContext& graphicsContext = GRAPHICS_CORE::g_contextManager.GetAvailableGraphicsContext();
+    graphicsContext.TransitionResource(m_hdrMips, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
     //initialize the graphics context
     graphicsContext.SetPiplelineObject(*m_pso);
@@ -86,7 +88,24 @@ void HDRLoader::Render() {
         graphicsContext.DrawIndexedInstanced(m_indicies.size(), 1, 0, 0, 0);
     }
 
-    uint64_t fenceValue = graphicsContext.Finish(true);
+    //the cubemap is read by the later passes of the same queue, so the cpu does not wait
+    graphicsContext.Finish();
+}
+
+void HDRLoader::GenerateHDRMips()
+{
+    //the hdr map is in the generic read state, which contains the copy source state
+    GraphicsContext& copyContext = GRAPHICS_CORE::g_contextManager.GetAvailableGraphicsContext();
+    copyContext.TransitionResource(m_hdrMips, D3D12_RESOURCE_STATE_COPY_DEST);
+    copyContext.CopySubResource(m_hdrMips, 0, *m_hdrmap.Get(), 0);
+    //the compute queue can not leave the copy state, so the copy context hands it over as uav
+    copyContext.TransitionResource(m_hdrMips, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    uint64_t copyFence = copyContext.Finish();
+
+    //the gpu queues wait for each other, the cpu does not wait for any of them
+    GRAPHICS_CORE::g_commandManager.GetComputeQueue().AddDependency(copyFence);
+    uint64_t mipsFence = GRAPHICS_CORE::g_mipmapGenerator.GenerateMipmap(&m_hdrMips);
+    GRAPHICS_CORE::g_commandManager.GetDirectQueue().AddDependency(mipsFence);
 }
 
 void HDRLoader::InitializeGeometry()
@@ -215,13 +234,16 @@ void HDRLoader::InitializeHDRmap()
     //loading hdr texture
     m_hdrmap = GRAPHICS_CORE::g_textureManager.LoadDDSFromFile("resource/textures/hdr/hdrsky.hdr", BlackCubeMap, true);
 
+    //the cube faces are smaller than the hdr map, so they sample the mips
+    D3D12_RESOURCE_DESC hdrDesc = m_hdrmap.Get()->GetResource()->GetDesc();
+    m_hdrMips.CreateBuffer(L"HDR Mips", (uint32_t)hdrDesc.Width, hdrDesc.Height, 0, hdrDesc.Format);
+
     //allocate descriptor handle
     m_textureHandle = GRAPHICS_CORE::g_texturesDescriptorHeap.Alloc(1);
-    m_samplerHandle = GRAPHICS_CORE::g_samplersDescriptorHeap.Alloc(1);
 
     //texture loading process
     D3D12_CPU_DESCRIPTOR_HANDLE textures[] = {
-        m_hdrmap.GetSRV()
+        m_hdrMips.GetSRV()
     };
 
     UINT destNum = 1;
@@ -229,10 +251,6 @@ void HDRLoader::InitializeHDRmap()
 
     GRAPHICS_CORE::g_device->CopyDescriptors(1, &m_textureHandle, &destNum, destNum, textures, srcNums, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-    //sampler loading process
-    D3D12_CPU_DESCRIPTOR_HANDLE samplers[] = {
-        GRAPHICS_CORE::g_samplerLinearWrap
-    };
-
-    GRAPHICS_CORE::g_device->CopyDescriptors(1, &m_samplerHandle, &destNum, destNum, samplers, srcNums, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+    //the sampler table is shared
+    m_samplerHandle = GRAPHICS_CORE::g_samplerManager.GetSamplerTable(&GRAPHICS_CORE::g_samplerLinearWrapDesc, 1);
 }
@@ -27,6 +27,8 @@ private:
 	void InitializePSO();
 	void InitializeHDRmap();
 	void InitializeCubemapRenderTargets();
+	//copy the hdr map into the mip chain and generate the mips on the compute queue
+	void GenerateHDRMips();
 
 
 private:
@@ -52,6 +54,8 @@ private:
 
 	//cubemap
 	TextureRef m_hdrmap;
+	//the hdr map with the mip chain, the cube faces sample it
+	ColorBuffer m_hdrMips;
 	TextureRef m_cubmapGenerated;
 	CD3DX12_CPU_DESCRIPTOR_HANDLE m_cubemapRTV[6];
 
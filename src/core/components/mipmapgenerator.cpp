@@ -2,6 +2,7 @@
 #include "resources/colorbuffer.h"
 #include "context.h"
 #include "graphicscore.h"
+#include <algorithm>
 
 
 void MipmapGenerator::Initialize() {
@@ -9,11 +10,12 @@ void MipmapGenerator::Initialize() {
 	InitializePSO();
 }
 
-void MipmapGenerator::GenerateMipmap(ColorBuffer* colorbuffer)
+uint64_t MipmapGenerator::GenerateMipmap(ColorBuffer* colorbuffer)
 {
 	Context* context = GRAPHICS_CORE::g_contextManager.AllocateContext(D3D12_COMMAND_LIST_TYPE_COMPUTE);
 	ComputeContext& computeContext = context->GetComputeContext();
 
+	computeContext.SetRootSignature(m_rootSig);
 	computeContext.TransitionResource(*colorbuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 	computeContext.SetDynamicDescriptor(1, 0, colorbuffer->GetSRV());
 
@@ -24,8 +26,8 @@ void MipmapGenerator::GenerateMipmap(ColorBuffer* colorbuffer)
 	for (uint32_t i = 0; i < numMipmaps; ++i) {
 		uint32_t srcWidth = originWidth >> i;
 		uint32_t srcHeight = originHeight >> i;
-		uint32_t dstWidth = srcWidth >> 1;
-		uint32_t dstHeight = srcHeight >> 1;
+		uint32_t dstWidth = std::max(srcWidth >> 1, 1u);
+		uint32_t dstHeight = std::max(srcHeight >> 1, 1u);
 
 		//set the mip map to the compute context
 		uint32_t mipType = (srcWidth & 1) | (srcHeight & 1) << 1;
@@ -33,7 +35,8 @@ void MipmapGenerator::GenerateMipmap(ColorBuffer* colorbuffer)
 
 		computeContext.SetConstants(0, i, 1.0f / (float)dstWidth, 1.0f / (float)dstHeight);
 
-		D3D12_CPU_DESCRIPTOR_HANDLE uav = colorbuffer->GetUAV(i);
+		//read the mip i and write the next one
+		D3D12_CPU_DESCRIPTOR_HANDLE uav = colorbuffer->GetUAV(i + 1);
 
 		computeContext.SetDynamicDescriptor(2, 0, uav);
 		computeContext.Dispatch2D(dstWidth, dstHeight);
@@ -41,9 +44,11 @@ void MipmapGenerator::GenerateMipmap(ColorBuffer* colorbuffer)
 		computeContext.InsertUAVBarrier(*colorbuffer);
 	}
 
-	computeContext.TransitionResource(*colorbuffer, 
-		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE |
-		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	//the compute queue can not use the pixel shader state, the graphics context transitions it when it is read
+	computeContext.TransitionResource(*colorbuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+	//the graphics work goes on while the mips are generated
+	return computeContext.Finish();
 }
 
 void MipmapGenerator::InitializeRS()
@@ -21,7 +21,9 @@ public:
 public:
 	void Initialize();
 
-	void GenerateMipmap(ColorBuffer* colorbuffer);
+	//the mips are generated on the compute queue, return the compute fence
+	//the graphics queue consumes the mips after AddDependency with the fence
+	uint64_t GenerateMipmap(ColorBuffer* colorbuffer);
 
 
 private:
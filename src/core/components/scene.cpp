@@ -1,10 +1,24 @@
 #include "scene.h"
 #include "graphicscore.h"
+#include "framearena.h"
+#include "parallelrecorder.h"
 #include "resources/colorbuffer.h"
 #include "resources/depthbuffer.h"
 #include "geometry/defaultgeometry.h"
 #include "camera.h"
 
+//the per frame constants of the pbr shaders
+__declspec(align(16)) struct CommonInfor
+{
+    XMMATRIX model;
+    XMMATRIX view;
+    XMMATRIX proj;
+    XMFLOAT3 eyepos;
+    XMFLOAT3 sundirection;
+    XMFLOAT3 sunintensity;
+    XMFLOAT2 iblparameter; //[0] is ibl range, [1] is ibl bias
+};
+
 RenderScene::RenderScene() {
 
 }
@@ -39,33 +53,24 @@ void RenderScene::Render(D3D12_CPU_DESCRIPTOR_HANDLE rtv, D3D12_CPU_DESCRIPTOR_H
         graphicsContext.TransitionResource(backBuffer, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET, true);
     }
 
+    //the states every recording context starts from
+    GraphicsPassState passState;
     {
-        graphicsContext.SetPiplelineObject(*m_pso);
-        graphicsContext.SetRootSignature(*m_rootSignature);
-        graphicsContext.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        graphicsContext.SetViewportAndScissor(viewport, scissorrect);
-        graphicsContext.SetRenderTargets(1, &rtv, dsv);
-    }
-
-    //set the descriptor heap
-    {
-        graphicsContext.SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, GRAPHICS_CORE::g_texturesDescriptorHeap.GetDescriptorHeap());
-        graphicsContext.SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, GRAPHICS_CORE::g_samplersDescriptorHeap.GetDescriptorHeap());
+        passState.m_pso = m_pso;
+        passState.m_rootSignature = m_rootSignature;
+        passState.m_topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        passState.m_viewport = viewport;
+        passState.m_scissor = scissorrect;
+        passState.m_numRTVs = 1;
+        passState.m_rtvs[0] = rtv;
+        passState.m_dsv = dsv;
+        passState.m_descriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV] = GRAPHICS_CORE::g_texturesDescriptorHeap.GetDescriptorHeap();
+        passState.m_descriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER] = GRAPHICS_CORE::g_samplersDescriptorHeap.GetDescriptorHeap();
     }
 
     //bind the shader visible resource
+    CommonInfor commoninforcb;
     {
-        __declspec(align(16)) struct CommonInfor
-        {
-            XMMATRIX model;
-            XMMATRIX view;
-            XMMATRIX proj;
-            XMFLOAT3 eyepos;
-            XMFLOAT3 sundirection;
-            XMFLOAT3 sunintensity;
-            XMFLOAT2 iblparameter; //[0] is ibl range, [1] is ibl bias
-        } commoninforcb;
-
         commoninforcb.model = modelMat;
         commoninforcb.view = m_camera->GetViewMatrix();
         commoninforcb.proj = m_camera->GetProjMatrix();
@@ -73,41 +78,54 @@ void RenderScene::Render(D3D12_CPU_DESCRIPTOR_HANDLE rtv, D3D12_CPU_DESCRIPTOR_H
         commoninforcb.sundirection = m_dirLight.GetDirection();
         commoninforcb.sunintensity = m_dirLight.GetColor();
         commoninforcb.iblparameter = XMFLOAT2(0.0F, 0.0F);
-        graphicsContext.SetDynamicConstantBufferView(0, sizeof(CommonInfor), &commoninforcb);
-
-        //for each model
-        for (int i = 0; i < m_renderItems.size(); ++i) {
-            RenderItem renderItem = m_renderItems[i];
-            UINT submeshSize = m_renderItems[i].GetSubmeshSize();
-
-            std::vector<D3D12_VERTEX_BUFFER_VIEW>& submeshesVertices = renderItem.GetMeshVertexBufferView();
-            std::vector<D3D12_INDEX_BUFFER_VIEW>& submeshesIndices = renderItem.GetIndicesVertexBufferView();
-            std::vector<UINT32>&  submeshesIndicesSizes = renderItem.GetIndicesSizes();
-            std::vector<uint16_t>& submeshesTexturesSRV = renderItem.GetTextureSRVOffset();
-            std::vector<uint16_t>& submeshesSamplersSRV = renderItem.GetSamplersSRVOffset();
-
-            //for each submesh in model
-            for (int submeshIndex = 0; submeshIndex < submeshSize; ++submeshIndex) {
-                D3D12_VERTEX_BUFFER_VIEW subvertexView = submeshesVertices[submeshIndex];
-                D3D12_INDEX_BUFFER_VIEW subindexView = submeshesIndices[submeshIndex];
-                UINT32 subindicesSize = submeshesIndicesSizes[submeshIndex];
-                //the srv related resources
-                uint16_t textureSRV = submeshesTexturesSRV[submeshIndex];
-                uint16_t samplerSRV = submeshesSamplersSRV[submeshIndex];
-
-                graphicsContext.SetDescriptorTable(1, GRAPHICS_CORE::g_texturesDescriptorHeap[textureSRV]);
-                graphicsContext.SetDescriptorTable(2, GRAPHICS_CORE::g_samplersDescriptorHeap[samplerSRV]);
-                graphicsContext.SetVertexBuffer(0, subvertexView);
-                graphicsContext.SetIndexBuffer(subindexView);
-                graphicsContext.DrawIndexedInstanced(subindicesSize, 1, 0, 0, 0);
-            }
-        }
+    }
+    bool commonInforPromoted = m_rootLayout.IsPromoted(m_commonInforParam);
+    UINT commonInforRootIndex = m_rootLayout.GetRootIndex(m_commonInforParam);
+    UINT texturesRootIndex = m_rootLayout.GetRootIndex(m_texturesParam);
+    UINT samplersRootIndex = m_rootLayout.GetRootIndex(m_samplersParam);
+
+    //flatten the submeshes of all the models, so the draws can be split evenly
+    FrameVector<std::pair<RenderItem*, UINT>> draws;
+    for (int i = 0; i < m_renderItems.size(); ++i) {
+        UINT submeshSize = m_renderItems[i].GetSubmeshSize();
+        for (UINT submeshIndex = 0; submeshIndex < submeshSize; ++submeshIndex)
+            draws.emplace_back(&m_renderItems[i], submeshIndex);
     }
 
+    ParallelGraphicsRecorder recorder(graphicsContext);
+    recorder.Record(passState, (uint32_t)draws.size(), [&](GraphicsContext& context, uint32_t begin, uint32_t end) {
+        //every context binds the constants itself
+        if (commonInforPromoted)
+            context.SetConstantArray(commonInforRootIndex, sizeof(CommonInfor) / 4, &commoninforcb);
+        else
+            context.SetDynamicConstantBufferView(commonInforRootIndex, sizeof(CommonInfor), &commoninforcb);
+
+        //the draw loop should not touch the global heap
+        FrameHeapGuard heapGuard;
+
+        for (uint32_t drawIndex = begin; drawIndex < end; ++drawIndex) {
+            RenderItem& renderItem = *draws[drawIndex].first;
+            UINT submeshIndex = draws[drawIndex].second;
+
+            D3D12_VERTEX_BUFFER_VIEW subvertexView = renderItem.GetMeshVertexBufferView()[submeshIndex];
+            D3D12_INDEX_BUFFER_VIEW subindexView = renderItem.GetIndicesVertexBufferView()[submeshIndex];
+            UINT32 subindicesSize = renderItem.GetIndicesSizes()[submeshIndex];
+            //the srv related resources
+            uint16_t textureSRV = renderItem.GetTextureSRVOffset()[submeshIndex];
+            uint16_t samplerSRV = renderItem.GetSamplersSRVOffset()[submeshIndex];
+
+            context.SetDescriptorTable(texturesRootIndex, GRAPHICS_CORE::g_texturesDescriptorHeap[textureSRV]);
+            context.SetDescriptorTable(samplersRootIndex, GRAPHICS_CORE::g_samplersDescriptorHeap[samplerSRV]);
+            context.SetVertexBuffer(0, subvertexView);
+            context.SetIndexBuffer(subindexView);
+            context.DrawIndexedInstanced(subindicesSize, 1, 0, 0, 0);
+        }
+    });
+
     // execute the sky box render pass
     {
-        graphicsContext.TransitionResource(backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT, true);
-        uint64_t fenceValue = graphicsContext.Finish(true);
+        recorder.GetLastContext().TransitionResource(backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT, true);
+        recorder.Finish();
     }
 
 }
@@ -124,7 +142,18 @@ void RenderScene::InitializeRenderItems() {
 void RenderScene::InitializeMaterials() {
 
     for (int i = 0; i < (int)m_renderItems.size(); ++i) {
-        std::vector<Material*> renderItemMaterials = m_renderItems[i].GetMaterials();
+        std::vector<Material*>& renderItemMaterials = m_renderItems[i].GetMaterials();
+
+        //give back the descriptors of last initialization
+        std::vector<uint16_t>& texturesSRVOffsets = m_renderItems[i].GetTextureSRVOffset();
+        std::vector<uint16_t>& samplersSRVOffsets = m_renderItems[i].GetSamplersSRVOffset();
+        for (int j = 0; j < (int)texturesSRVOffsets.size(); ++j) {
+            UINT32 texturesNum = GRAPHICS_CORE::g_materialManager.GetMaterialTypeDescriptorNum(renderItemMaterials[j]->GetMatType());
+            GRAPHICS_CORE::g_texturesDescriptorHeap.Free(GRAPHICS_CORE::g_texturesDescriptorHeap[texturesSRVOffsets[j]], texturesNum);
+        }
+        texturesSRVOffsets.clear();
+        samplersSRVOffsets.clear();
+
         for (int j = 0; j < (int)renderItemMaterials.size(); ++j) {
             //get submesh material properties
             MATERIAL_TYPE matType = renderItemMaterials[j]->GetMatType();
@@ -132,24 +161,18 @@ void RenderScene::InitializeMaterials() {
             
             //initialize the texture num 
             UINT texturesDestNum = texturesNum;
-            UINT* srcNums = new UINT[texturesNum];
-            for (int i = 0; i < texturesNum; ++i)
-                srcNums[i] = 1;
+            FrameVector<UINT> srcNums(texturesNum, 1);
 
             //allocate the memory descriptor handle
             DescriptorHandle texturesHandle = GRAPHICS_CORE::g_texturesDescriptorHeap.Alloc(texturesNum);
             uint32_t texturesSRVOffset = GRAPHICS_CORE::g_texturesDescriptorHeap.GetOffset(texturesHandle);
 
-            DescriptorHandle samplersHandle = GRAPHICS_CORE::g_samplersDescriptorHeap.Alloc(texturesNum);
-            uint32_t samplersSRVOffset = GRAPHICS_CORE::g_samplersDescriptorHeap.GetOffset(samplersHandle);
+            //the sampler tables are shared by the materials
+            uint32_t samplersSRVOffset = renderItemMaterials[j]->GetSamplerTableIndex();
 
-            std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> textures = renderItemMaterials[j]->GetTextureSRVArray();
+            FrameVector<D3D12_CPU_DESCRIPTOR_HANDLE> textures = renderItemMaterials[j]->GetTextureSRVArray();
             GRAPHICS_CORE::g_device->CopyDescriptors(1, &texturesHandle, &texturesDestNum, texturesDestNum, 
-                textures.data(), srcNums, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-            std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> samplers = renderItemMaterials[j]->GetSamplerSRVArray();
-            GRAPHICS_CORE::g_device->CopyDescriptors(1, &samplersHandle, &texturesDestNum, texturesDestNum,
-                samplers.data(), srcNums, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+                textures.data(), srcNums.data(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
             //binding the srv information with meshes
             m_renderItems[i].GetTextureSRVOffset().push_back(texturesSRVOffset);
@@ -172,10 +195,15 @@ void RenderScene::InitializeRootSignature() {
         D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
         D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS;
 
-    m_rootSignature = new RootSignature(3, 0);
-    (*m_rootSignature)[0].InitAsConstantBuffer(0, D3D12_SHADER_VISIBILITY_ALL);
-    (*m_rootSignature)[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 5, D3D12_SHADER_VISIBILITY_ALL);
-    (*m_rootSignature)[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, 0, 5, D3D12_SHADER_VISIBILITY_ALL);
+    //the material tables change per draw, so they go before the per frame constants
+    m_commonInforParam = m_rootLayout.AddConstantBuffer(ROOT_PARAMETER_PER_FRAME, 0, sizeof(CommonInfor));
+    m_texturesParam = m_rootLayout.AddDescriptorRange(ROOT_PARAMETER_PER_DRAW, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 5);
+    m_samplersParam = m_rootLayout.AddDescriptorRange(ROOT_PARAMETER_PER_DRAW, D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, 0, 5);
+    bool layoutFits = m_rootLayout.Build();
+    assert(layoutFits);
+
+    m_rootSignature = new RootSignature();
+    m_rootSignature->InitFromLayout(m_rootLayout);
     m_rootSignature->Finalize(L"", rootSignatureFlag);
 }
 
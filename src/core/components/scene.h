@@ -11,6 +11,7 @@
 #include "components/hdrtocubemap.h"
 #include "geometry/light.h"
 #include "renderelement/renderitem.h"
+#include "rootsignaturelayout.h"
 
 
 class RootSignature;
@@ -50,6 +51,10 @@ private:
 
 	//root signature
 	RootSignature* m_rootSignature;
+	RootSignatureLayout m_rootLayout;
+	uint32_t m_commonInforParam = 0;
+	uint32_t m_texturesParam = 0;
+	uint32_t m_samplersParam = 0;
 
 	//pso
 	GraphicsPSO* m_pso;
@@ -109,7 +109,6 @@ void SkyBox::InitializeCubemap() {
 
     //allocate descriptor handle
     m_textureHandle = GRAPHICS_CORE::g_texturesDescriptorHeap.Alloc(1);
-    m_samplerHandle = GRAPHICS_CORE::g_samplersDescriptorHeap.Alloc(1);
 
     //texture loading process
     D3D12_CPU_DESCRIPTOR_HANDLE textures[] = {
@@ -121,12 +120,8 @@ void SkyBox::InitializeCubemap() {
 
     GRAPHICS_CORE::g_device->CopyDescriptors(1, &m_textureHandle, &destNum, destNum, textures, srcNums, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-    //sampler loading process
-    D3D12_CPU_DESCRIPTOR_HANDLE samplers[] = {
-        GRAPHICS_CORE::g_samplerLinearWrap
-    };
-
-    GRAPHICS_CORE::g_device->CopyDescriptors(1, &m_samplerHandle, &destNum, destNum, samplers, srcNums, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+    //the sampler table is shared
+    m_samplerHandle = GRAPHICS_CORE::g_samplerManager.GetSamplerTable(&GRAPHICS_CORE::g_samplerLinearWrapDesc, 1);
 }
 
 void SkyBox::Initialize(std::string skyboxName) {
@@ -201,6 +196,6 @@ void SkyBox::Render(
     // execute the sky box render pass
     {
         graphicsContext.TransitionResource(backbuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT, true);
-        uint64_t fenceValue = graphicsContext.Finish(true);
+        graphicsContext.Finish();
     }
 }
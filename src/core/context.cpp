@@ -11,24 +11,27 @@
 /*
 * ContextManager
 */
+//the free contexts cached by current thread, one magazine per command list type
+typedef ThreadMagazine<Context, ContextManager::kThreadMagazineSize> ContextMagazine;
+static thread_local ContextMagazine t_contextMagazines[4];
+
 Context* ContextManager::AllocateContext(D3D12_COMMAND_LIST_TYPE type)
 {
-	std::lock_guard<std::mutex> lockGuard(sm_contextAllocatorMutex);
-
-	auto& availableContexts = m_availableContextPool[type];
+	ContextMagazine& magazine = t_contextMagazines[type];
+	magazine.Attach(m_availableContextPool[type]);
+	if (magazine.IsEmpty())
+		magazine.Refill(m_availableContextPool[type], [](uint64_t) { return true; });
 
-	Context* ret = nullptr;
-	if (availableContexts.empty()) {
-		ret = new Context(type);
-		m_contextPool[type].emplace_back(ret);
-		ret->Initialize();
-	}
-	else {
-		ret = availableContexts.front();
-		availableContexts.pop();
+	if (!magazine.IsEmpty()) {
+		Context* ret = magazine.Pop();
 		ret->Reset();
+		return ret;
 	}
 
+	std::lock_guard<std::mutex> lockGuard(sm_contextAllocatorMutex);
+	Context* ret = new Context(type);
+	m_contextPool[type].emplace_back(ret);
+	ret->Initialize();
 	return ret;
 }
 
@@ -49,12 +52,23 @@ ComputeContext& ContextManager::GetAvailableComputeContext() {
 
 void ContextManager::FreeContext(Context* usedContext)
 {
-	std::lock_guard<std::mutex> lockGuard(sm_contextAllocatorMutex);
-	m_availableContextPool[usedContext->GetContextType()].push(usedContext);
+	D3D12_COMMAND_LIST_TYPE type = usedContext->GetContextType();
+	ContextMagazine& magazine = t_contextMagazines[type];
+	magazine.Attach(m_availableContextPool[type]);
+	//the magazine is full, give back a batch to the other threads
+	if (magazine.IsFull())
+		magazine.Drain(m_availableContextPool[type]);
+	magazine.Push(usedContext);
 }
 
+//no context should be in use, the magazines of all the threads are dropped by the generation
 void ContextManager::DestroyAllContexts()
 {
+	std::lock_guard<std::mutex> lockGuard(sm_contextAllocatorMutex);
+	for (uint32_t i = 0; i < 4; ++i) {
+		m_availableContextPool[i].Clear();
+		m_contextPool[i].clear();
+	}
 }
 
 
@@ -65,11 +79,12 @@ Context::Context(D3D12_COMMAND_LIST_TYPE type) :
 	m_type(type),
 	m_dynamicViewDescriptorHeap(*this, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV),
 	m_dynamicSamplerDescriptorHeap(*this, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER),
-	m_cpuLinearAllocator(CPU_MEMORY_ALLOCATION)
+	m_cpuLinearAllocator(CPU_RING_MEMORY_ALLOCATION)
 {
 	m_graphicsCommandList = nullptr;
 	m_commandAllocator = nullptr;
 	ZeroMemory(m_currentDescriptorHeap, sizeof(m_currentDescriptorHeap));
+	m_descriptorHeapBindCount = 0;
 
 	m_graphicsSignature = nullptr;
 	m_computeSignature = nullptr;
@@ -128,26 +143,27 @@ uint64_t Context::Flush(bool waitForCompletion) {
 
 uint64_t Context::Finish(bool waitForCompletion) {
 
-	FlushResourceBarrier();
-
 	assert(m_commandAllocator != nullptr);
 
-	CommandQueue& queue = GRAPHICS_CORE::g_commandManager.GetDirectQueue();
+	Context* context = this;
+	uint64_t fenceValue = GRAPHICS_CORE::g_commandManager.GetQueue(m_type).ExecuteContexts(1, &context);
+
+	if (waitForCompletion)
+		GRAPHICS_CORE::g_commandManager.WaitForFence(fenceValue);
+
+	return fenceValue;
+}
 
-	uint64_t fenceValue = queue.ExecuteCommandList(m_graphicsCommandList);
-	queue.DiscardCommandAllocator(fenceValue, m_commandAllocator);
+void Context::Retire(uint64_t fenceValue) {
+	GRAPHICS_CORE::g_commandManager.GetQueue(m_type).DiscardCommandAllocator(fenceValue, m_commandAllocator);
 	m_commandAllocator = nullptr;
 
 	m_cpuLinearAllocator.ClearUpPages(fenceValue);
+	m_scratchAllocator.ClearUpPages(fenceValue);
 	m_dynamicViewDescriptorHeap.CleanupUsedHeap(fenceValue);
 	m_dynamicSamplerDescriptorHeap.CleanupUsedHeap(fenceValue);
 
-	if (waitForCompletion)
-		GRAPHICS_CORE::g_commandManager.WaitForFence(fenceValue);
-
 	GRAPHICS_CORE::g_contextManager.FreeContext(this);
-
-	return fenceValue;
 }
 
 void Context::CopyBuffer(GPUResource& dest, GPUResource& src) {
@@ -253,7 +269,7 @@ void Context::InsertUAVBarrier(GPUResource& resource, bool flushImm) {
 	curBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 	curBarrier.UAV.pResource = resource.GetResource();
 
-	if (flushImm)
+	if (flushImm || m_numBarriersToFlush == 16)
 		FlushResourceBarrier();
 }
 
@@ -276,8 +292,10 @@ void Context::SetDescriptorHeaps(UINT heapCount, D3D12_DESCRIPTOR_HEAP_TYPE type
 	ID3D12DescriptorHeap* heapPtrs[]) {
 	bool changed = false;
 	for (int i = 0; i < heapCount; ++i) {
-		if (m_currentDescriptorHeap[type[i]] != heapPtrs[type[i]])
-			m_currentDescriptorHeap[type[i]] = heapPtrs[type[i]];
+		if (m_currentDescriptorHeap[type[i]] != heapPtrs[i]) {
+			m_currentDescriptorHeap[type[i]] = heapPtrs[i];
+			changed = true;
+		}
 	}
 	if (changed)
 		BindDescriptorHeaps();
@@ -305,6 +323,7 @@ void Context::BindDescriptorHeaps() {
 	//bind the heaps to current graphics command list
 	if (nonNullHeaps > 0)
 		m_graphicsCommandList->SetDescriptorHeaps(nonNullHeaps, heapsToBind);
+	m_descriptorHeapBindCount++;
 }
 
 void GlobalContext::InitializeTexture(GPUResource& dest, UINT numSubresources, D3D12_SUBRESOURCE_DATA subData[], D3D12_RESOURCE_STATES usage)
@@ -434,6 +453,32 @@ void GraphicsContext::SetRootSignature(const RootSignature& rootSig)
 	m_dynamicSamplerDescriptorHeap.ParseGraphicsRootSignature(rootSig);
 }
 
+void GraphicsContext::SetPassState(const GraphicsPassState& pass)
+{
+	assert(pass.m_rootSignature != nullptr && pass.m_pso != nullptr);
+	SetPiplelineObject(*pass.m_pso);
+	SetRootSignature(*pass.m_rootSignature);
+	SetPrimitiveTopology(pass.m_topology);
+	SetViewportAndScissor(pass.m_viewport, pass.m_scissor);
+	if (pass.m_dsv.ptr != 0)
+		SetRenderTargets(pass.m_numRTVs, pass.m_rtvs, pass.m_dsv);
+	else
+		SetRenderTargets(pass.m_numRTVs, pass.m_rtvs);
+
+	//the heaps are bound in one call
+	UINT heapCount = 0;
+	D3D12_DESCRIPTOR_HEAP_TYPE heapTypes[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+	ID3D12DescriptorHeap* heaps[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+	for (UINT i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i) {
+		if (pass.m_descriptorHeaps[i] != nullptr) {
+			heapTypes[heapCount] = (D3D12_DESCRIPTOR_HEAP_TYPE)i;
+			heaps[heapCount++] = pass.m_descriptorHeaps[i];
+		}
+	}
+	if (heapCount > 0)
+		SetDescriptorHeaps(heapCount, heapTypes, heaps);
+}
+
 void GraphicsContext::SetRenderTargets(UINT numRTVs, const D3D12_CPU_DESCRIPTOR_HANDLE RTVs[])
 {
 	m_graphicsCommandList->OMSetRenderTargets(numRTVs, RTVs, FALSE, nullptr);
@@ -670,6 +715,21 @@ void GraphicsContext::DrawIndexedInstanced(UINT indexCountPerInstance, UINT Inst
 		startIndexLocation, startVertexLocation, startInstanceLocation);
 }
 
+DynamicAlloc ComputeContext::ReserveScratch(size_t size, size_t alignment)
+{
+	bool aliased = false;
+	DynamicAlloc scratch = m_scratchAllocator.Reserve(size, alignment, aliased);
+	//the earlier dispatches on the aliased memory have to finish before it is written again
+	if (aliased)
+		InsertUAVBarrier(scratch.m_resource);
+	return scratch;
+}
+
+void ComputeContext::ReleaseScratch(const DynamicAlloc& scratch)
+{
+	m_scratchAllocator.Release(scratch);
+}
+
 void ComputeContext::ClearUAV(GPUBuffer& buffer)
 {
 	FlushResourceBarrier();
@@ -17,6 +17,7 @@
 #include "resources/uploadbuffer.h"
 #include "types/commontypes.h"
 #include "pso.h"
+#include "fencedreservoir.h"
 
 
 class Context;
@@ -24,9 +25,14 @@ class GraphicsContext;
 class ComputeContext;
 
 
+//each thread allocates and frees the contexts through its own magazine
+//the magazines are refilled from and drained to the shared available contexts in batch
 class ContextManager
 {
 public:
+	//the free contexts kept by one thread for one command list type
+	static const uint32_t kThreadMagazineSize = 8;
+
 	ContextManager(){}
 	Context* AllocateContext(D3D12_COMMAND_LIST_TYPE type);
 	Context& GetAvailableContext();
@@ -37,9 +43,11 @@ public:
 	void DestroyAllContexts();
 
 private:
+	//all the created contexts, only the creation takes the lock
 	std::vector<std::unique_ptr<Context>> m_contextPool[4];
-	std::queue<Context*> m_availableContextPool[4];
 	std::mutex sm_contextAllocatorMutex;
+	//the contexts are reusable as soon as they are submitted, so the fences are not used
+	FencedReservoir<Context> m_availableContextPool[4];
 };
 
 //Central Context contains multiple static functions related to temp context
@@ -61,6 +69,21 @@ struct NonCopyable
 	NonCopyable& operator=(const NonCopyable& v) = delete;
 };
 
+//the states shared by the contexts recording one pass
+struct GraphicsPassState
+{
+	const RootSignature* m_rootSignature = nullptr;
+	const PSO* m_pso = nullptr;
+	D3D12_PRIMITIVE_TOPOLOGY m_topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	D3D12_VIEWPORT m_viewport = {};
+	D3D12_RECT m_scissor = {};
+	UINT m_numRTVs = 0;
+	D3D12_CPU_DESCRIPTOR_HANDLE m_rtvs[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT] = {};
+	D3D12_CPU_DESCRIPTOR_HANDLE m_dsv = {}; //no depth stencil if the ptr is 0
+	//the shader visible heaps of the pass, indexed by the heap type
+	ID3D12DescriptorHeap* m_descriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES] = {};
+};
+
 //basic context class
 class Context : public NonCopyable
 {
@@ -69,6 +92,9 @@ class Context : public NonCopyable
 private:  //only context manager can generate a context
 	Context(D3D12_COMMAND_LIST_TYPE type);
 	void Reset();
+	//retire the allocator, the pages and the descriptor blocks with the fence of the submitted commands
+	//then give the context back to the context manager
+	void Retire(uint64_t fenceValue);
 
 public:
 
@@ -117,11 +143,13 @@ public:
 	void TransitionResource(GPUResource& resource, D3D12_RESOURCE_STATES oldState, D3D12_RESOURCE_STATES newState, bool flushImm = false);
 	void TransitionResource(GPUResource& resource, D3D12_RESOURCE_STATES newState, bool flushImm = false);
 	void InsertUAVBarrier(GPUResource& resource, bool flushImm = false);
-	inline void FlushResourceBarrier();
+	void FlushResourceBarrier();
 
 	void SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE type, ID3D12DescriptorHeap* heapPtr);
 	void SetDescriptorHeaps(UINT heapCount, D3D12_DESCRIPTOR_HEAP_TYPE type[], ID3D12DescriptorHeap* heapPtrs[]);
 	void SetPiplelineObject(const PSO& pso);
+	//increased when the heaps are bound, the descriptor tables bound before are invalid
+	uint64_t GetDescriptorHeapBindCount() const { return m_descriptorHeapBindCount; }
 
 
 	D3D12_COMMAND_LIST_TYPE GetContextType() { return m_type; }
@@ -144,8 +172,11 @@ protected:
 	UINT m_numBarriersToFlush;
 
 	ID3D12DescriptorHeap* m_currentDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE::D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+	uint64_t m_descriptorHeapBindCount;
 
 	DynamicLinearMemoryAllocator m_cpuLinearAllocator;
+	//the transient uav buffers of compute work
+	ScratchBufferAllocator m_scratchAllocator;
 
 	std::wstring m_ID;
 	void setID(const std::wstring& id) { m_ID = id; }
@@ -169,6 +200,8 @@ public:
 
 
 	void SetRootSignature(const RootSignature& root);
+	//set all the states of the pass, the contexts recording the same pass start from the same states
+	void SetPassState(const GraphicsPassState& pass);
 
 	void SetRenderTargets(UINT numRTVs, const D3D12_CPU_DESCRIPTOR_HANDLE RTVs[]);
 	void SetRenderTargets(UINT numRTVs, const D3D12_CPU_DESCRIPTOR_HANDLE RTVs[], D3D12_CPU_DESCRIPTOR_HANDLE DSV);
@@ -230,6 +263,11 @@ public:
 	void ClearUAV(ColorBuffer& target);
 	void SetRootSignature(const RootSignature& rootSig);
 
+	//reserve a transient uav buffer in default heap, it is valid until the context finished
+	//after ReleaseScratch, the memory may be aliased by the later scratch buffers of the same command list
+	DynamicAlloc ReserveScratch(size_t size, size_t alignment = DEFAULT_ALIGN);
+	void ReleaseScratch(const DynamicAlloc& scratch);
+
 	void SetConstantArray(UINT rootIndex, UINT numConstants, const void* pConstants);
 	void SetConstant(UINT rootIndex, UINT offset, DWParam val);
 	void SetConstants(UINT rootIndex, DWParam X);
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+//Deferred Release Queue
+//the items are waiting for the gpu, and recycled after the fence completed
+//producers push the items without lock, the items with the same fence are gathered in one bucket
+//so that the whole bucket is retired by one fence check
+template<typename T>
+class DeferredReleaseQueue
+{
+public:
+	DeferredReleaseQueue() : m_pendingHead(nullptr), m_count(0) {}
+	~DeferredReleaseQueue() { ClearPendingNodes(); }
+
+	DeferredReleaseQueue(const DeferredReleaseQueue&) = delete;
+	DeferredReleaseQueue& operator=(const DeferredReleaseQueue&) = delete;
+
+	//lock-free, can be called from any thread
+	void Push(uint64_t fenceValue, T* item) {
+		PendingNode* node = new PendingNode{ fenceValue, item, nullptr };
+		//counted before the node is published, so a concurrent Retire never takes the count below zero
+		m_count.fetch_add(1, std::memory_order_relaxed);
+		node->m_next = m_pendingHead.load(std::memory_order_relaxed);
+		while (!m_pendingHead.compare_exchange_weak(node->m_next, node,
+			std::memory_order_release, std::memory_order_relaxed)) {}
+	}
+
+	//retire the buckets in order until a fence is not completed
+	//return the number of items released
+	template<typename FenceCompleteFunc, typename ReleaseFunc>
+	size_t Retire(FenceCompleteFunc isFenceComplete, ReleaseFunc release) {
+		std::lock_guard<std::mutex> lockGuard(m_bucketsMutex);
+		GatherPendingNodes();
+
+		size_t releasedCount = 0;
+		while (!m_buckets.empty() && isFenceComplete(m_buckets.front().m_fenceValue)) {
+			for (T* item : m_buckets.front().m_items)
+				release(item);
+			releasedCount += m_buckets.front().m_items.size();
+			m_buckets.pop_front();
+		}
+		m_count.fetch_sub(releasedCount, std::memory_order_relaxed);
+		return releasedCount;
+	}
+
+	//release all the items without checking the fences
+	template<typename ReleaseFunc>
+	void Flush(ReleaseFunc release) {
+		Retire([](uint64_t) { return true; }, release);
+	}
+
+	//the number of items waiting for the fences
+	size_t GetCount() const { return m_count.load(std::memory_order_relaxed); }
+	bool IsEmpty() const { return GetCount() == 0; }
+
+private:
+	struct PendingNode
+	{
+		uint64_t m_fenceValue;
+		T* m_item;
+		PendingNode* m_next;
+	};
+
+	struct Bucket
+	{
+		uint64_t m_fenceValue;
+		std::vector<T*> m_items;
+	};
+
+	//move the pushed nodes into the buckets, the caller should hold the buckets mutex
+	void GatherPendingNodes() {
+		PendingNode* node = m_pendingHead.exchange(nullptr, std::memory_order_acquire);
+
+		//the pushed list is in reverse order
+		PendingNode* ordered = nullptr;
+		while (node != nullptr) {
+			PendingNode* next = node->m_next;
+			node->m_next = ordered;
+			ordered = node;
+			node = next;
+		}
+
+		while (ordered != nullptr) {
+			PendingNode* next = ordered->m_next;
+			FindOrCreateBucket(ordered->m_fenceValue).m_items.push_back(ordered->m_item);
+			delete ordered;
+			ordered = next;
+		}
+	}
+
+	Bucket& FindOrCreateBucket(uint64_t fenceValue) {
+		//the fences are almost in order, so only the recent buckets are checked
+		for (auto it = m_buckets.rbegin(); it != m_buckets.rend(); ++it) {
+			if (it->m_fenceValue == fenceValue)
+				return *it;
+			if (it->m_fenceValue < fenceValue)
+				break;
+		}
+		m_buckets.push_back(Bucket{ fenceValue, std::vector<T*>() });
+		return m_buckets.back();
+	}
+
+	void ClearPendingNodes() {
+		PendingNode* node = m_pendingHead.exchange(nullptr);
+		while (node != nullptr) {
+			PendingNode* next = node->m_next;
+			delete node;
+			node = next;
+		}
+	}
+
+	std::atomic<PendingNode*> m_pendingHead;
+	std::atomic<size_t> m_count;
+	std::deque<Bucket> m_buckets;
+	std::mutex m_bucketsMutex;
+};
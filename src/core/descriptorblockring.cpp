@@ -0,0 +1,43 @@
+#include "descriptorblockring.h"
+#include <cassert>
+
+void DescriptorBlockRing::Initialize(uint32_t blockSize, uint32_t blockCount)
+{
+	m_blockSize = blockSize;
+	m_blockCount = blockCount;
+	m_head.store(0, std::memory_order_relaxed);
+	m_blockStates.reset(blockCount > 0 ? new std::atomic<uint64_t>[blockCount] : nullptr);
+	for (uint32_t i = 0; i < blockCount; ++i)
+		m_blockStates[i].store(kUnusedState, std::memory_order_relaxed);
+}
+
+void DescriptorBlockRing::Retire(uint32_t blockIndex, uint64_t fenceValue)
+{
+	assert(blockIndex < m_blockCount);
+	assert(m_blockStates[blockIndex].load(std::memory_order_relaxed) == kReservedState);
+	assert(fenceValue != kUnusedState && fenceValue != kReservedState);
+	m_blockStates[blockIndex].store(fenceValue, std::memory_order_release);
+}
+
+uint32_t DescriptorBlockRing::GetReservedCount() const
+{
+	uint32_t reservedCount = 0;
+	for (uint32_t i = 0; i < m_blockCount; ++i) {
+		if (m_blockStates[i].load(std::memory_order_relaxed) == kReservedState)
+			reservedCount++;
+	}
+	return reservedCount;
+}
+
+uint64_t DescriptorBlockRing::GetOldestRetiredFence() const
+{
+	uint64_t oldestFence = kUnusedState;
+	for (uint32_t i = 0; i < m_blockCount; ++i) {
+		uint64_t blockState = m_blockStates[i].load(std::memory_order_acquire);
+		if (blockState == kUnusedState || blockState == kReservedState)
+			continue;
+		if (oldestFence == kUnusedState || blockState < oldestFence)
+			oldestFence = blockState;
+	}
+	return oldestFence;
+}
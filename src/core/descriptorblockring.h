@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+//Descriptor Block Ring
+//the dynamic region of a shared shader visible heap is divided into fixed-size blocks
+//the contexts reserve the blocks with an atomic bump over the ring, and retire them with the fence of their command lists
+//a block is reusable after its fence completed, the blocks retired out of order are skipped by the bump
+//the ring does not touch the device, so it can be tested alone
+class DescriptorBlockRing
+{
+public:
+	static const uint32_t kInvalidBlock = 0xFFFFFFFF;
+
+	DescriptorBlockRing() : m_blockSize(0), m_blockCount(0), m_head{ 0 } {}
+
+	void Initialize(uint32_t blockSize, uint32_t blockCount);
+
+	//return the index of the reserved block, or kInvalidBlock when every block is in use
+	template<typename FenceCompleteFunc>
+	uint32_t Reserve(FenceCompleteFunc isFenceComplete) {
+		for (uint32_t i = 0; i < m_blockCount; ++i) {
+			uint32_t blockIndex = (uint32_t)(m_head.fetch_add(1, std::memory_order_relaxed) % m_blockCount);
+			std::atomic<uint64_t>& blockState = m_blockStates[blockIndex];
+			uint64_t retiredFence = blockState.load(std::memory_order_acquire);
+			if (retiredFence == kReservedState)
+				continue;
+			if (retiredFence != kUnusedState && !isFenceComplete(retiredFence))
+				continue;
+			//another thread may take the same block after the bump wrapped
+			if (blockState.compare_exchange_strong(retiredFence, kReservedState, std::memory_order_acq_rel))
+				return blockIndex;
+		}
+		return kInvalidBlock;
+	}
+	//the block is reusable after the fence completed
+	void Retire(uint32_t blockIndex, uint64_t fenceValue);
+
+	uint32_t GetBlockSize() const { return m_blockSize; }
+	uint32_t GetBlockCount() const { return m_blockCount; }
+	//the blocks reserved by the contexts, for the stats
+	uint32_t GetReservedCount() const;
+	//the lowest fence retiring a block, waiting for it frees at least one block
+	//0 when no block is retired, every block is then held by the recording contexts
+	uint64_t GetOldestRetiredFence() const;
+
+private:
+	static const uint64_t kUnusedState = 0;
+	static const uint64_t kReservedState = 0xFFFFFFFFFFFFFFFFull;
+
+	uint32_t m_blockSize;
+	uint32_t m_blockCount;
+	std::atomic<uint64_t> m_head;
+	//the fence retiring each block, or one of the states above
+	std::unique_ptr<std::atomic<uint64_t>[]> m_blockStates;
+};
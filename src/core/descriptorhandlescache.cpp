@@ -0,0 +1,203 @@
+#include "descriptorhandlescache.h"
+#include <cassert>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//index of the lowest set bit, return false when no bit is set
+static inline bool ScanForward(unsigned long* index, unsigned long mask)
+{
+#if defined(_MSC_VER)
+	return _BitScanForward(index, mask) != 0;
+#else
+	if (mask == 0)
+		return false;
+	*index = (unsigned long)__builtin_ctzl(mask);
+	return true;
+#endif
+}
+
+//index of the highest set bit, return false when no bit is set
+static inline bool ScanReverse(unsigned long* index, unsigned long mask)
+{
+#if defined(_MSC_VER)
+	return _BitScanReverse(index, mask) != 0;
+#else
+	if (mask == 0)
+		return false;
+	*index = (unsigned long)(sizeof(unsigned long) * 8 - 1 - __builtin_clzl(mask));
+	return true;
+#endif
+}
+
+DescriptorHandlesCache::DescriptorHandlesCache() {
+	ReleaseCaches();
+}
+
+void DescriptorHandlesCache::CommitDescriptorHandleToDescriptorHeap(
+	ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t descriptorsSize,
+	const D3D12_CPU_DESCRIPTOR_HANDLE tableCPUHandles[], const D3D12_GPU_DESCRIPTOR_HANDLE tableGPUHandles[],
+	uint32_t commitTablesBitMap, uint32_t copyTablesBitMap, ID3D12GraphicsCommandList* cmdList,
+	void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::* SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE)) {
+
+	//
+	static const uint32_t maxNumCopyDescriptorsNum = 16;
+
+	uint32_t destDescriptorRangeIndex = 0;
+	D3D12_CPU_DESCRIPTOR_HANDLE pDestDescriptorRangeStart[maxNumCopyDescriptorsNum];
+	uint32_t destDescriptorRangeDescriptorsSize[maxNumCopyDescriptorsNum];
+
+	uint32_t srcDescriptorRangeIndex = 0;
+	D3D12_CPU_DESCRIPTOR_HANDLE pSrcDescriptorRangeStart[maxNumCopyDescriptorsNum];
+	uint32_t srcDescriptorRangeDescriptorsSize[maxNumCopyDescriptorsNum];
+	//loop each descriptor table
+	unsigned long rootIndex = 0;
+	unsigned long commitDescriptorTablesBitMap = commitTablesBitMap;
+	while (ScanForward(&rootIndex, commitDescriptorTablesBitMap)) {
+		commitDescriptorTablesBitMap ^= (1 << rootIndex);
+		(cmdList->*SetFunc)(rootIndex, tableGPUHandles[rootIndex]);
+		//the table is already in the descriptor heap
+		if ((copyTablesBitMap & (1 << rootIndex)) == 0)
+			continue;
+
+		//the source descriptor handle
+		DescriptorTableEntry& descriptorTableCachedInfo = m_rootDescriptorTable[rootIndex];
+		D3D12_CPU_DESCRIPTOR_HANDLE* srcHandles = descriptorTableCachedInfo.tableStart;
+		unsigned long assignedDescriptorBitMap = descriptorTableCachedInfo.assignedHandlesBitMap;
+		//the destination descriptor handle
+		D3D12_CPU_DESCRIPTOR_HANDLE dstHandles = tableCPUHandles[rootIndex];
+
+		//copy the source descriptors in descriptor table to the descriptor heap and recover the descriptor layout
+		unsigned long skipCount;
+		while (ScanForward(&skipCount, assignedDescriptorBitMap))
+		{
+			//skip the first several empty descriptor slots
+			assignedDescriptorBitMap >>= skipCount;
+			srcHandles += skipCount;
+			dstHandles.ptr += skipCount * descriptorsSize;
+
+			//gain the non-empty descriptor slots number in current filled block
+			unsigned long descriptorCount;
+			ScanForward(&descriptorCount, ~assignedDescriptorBitMap);
+			assignedDescriptorBitMap >>= descriptorCount;
+
+			//if current descriptors block is extend the max copy number
+			if (srcDescriptorRangeIndex + descriptorCount > maxNumCopyDescriptorsNum)
+			{
+				//copy the data directly, current loop's data will be copied in the next loop
+				device->CopyDescriptors(
+					destDescriptorRangeIndex, pDestDescriptorRangeStart, destDescriptorRangeDescriptorsSize,
+					srcDescriptorRangeIndex, pSrcDescriptorRangeStart, srcDescriptorRangeDescriptorsSize, type
+				);
+
+				srcDescriptorRangeIndex = 0;
+				destDescriptorRangeIndex = 0;
+			}
+
+			//initial the descriptor range infomation of destination descriptor block
+			pDestDescriptorRangeStart[destDescriptorRangeIndex] = dstHandles;
+			destDescriptorRangeDescriptorsSize[destDescriptorRangeIndex] = descriptorCount;
+			destDescriptorRangeIndex++;
+
+			//initial the descriptor range information of source descriptor block and load the source data
+			for (unsigned long srcDescriptorIndex = 0; srcDescriptorIndex < descriptorCount; srcDescriptorIndex++)
+			{
+				pSrcDescriptorRangeStart[srcDescriptorRangeIndex] = srcHandles[srcDescriptorIndex];
+				srcDescriptorRangeDescriptorsSize[srcDescriptorRangeIndex] = 1;
+				srcDescriptorRangeIndex++;
+			}
+
+			srcHandles += descriptorCount;
+			dstHandles.ptr += descriptorCount * descriptorsSize;
+		}
+	}
+
+	if (srcDescriptorRangeIndex > 0) {
+		device->CopyDescriptors(
+			destDescriptorRangeIndex, pDestDescriptorRangeStart, destDescriptorRangeDescriptorsSize,
+			srcDescriptorRangeIndex, pSrcDescriptorRangeStart, srcDescriptorRangeDescriptorsSize, type
+		);
+	}
+}
+
+uint32_t DescriptorHandlesCache::ComputeTableDescriptorsSize(uint32_t rootIndex) {
+	unsigned long lastAssignedIndex;
+	bool isAssigned = ScanReverse(&lastAssignedIndex, m_rootDescriptorTable[rootIndex].assignedHandlesBitMap);
+	assert(isAssigned);
+	return isAssigned ? lastAssignedIndex + 1 : 0;
+}
+
+uint32_t DescriptorHandlesCache::GatherTableHandles(uint32_t rootIndex, D3D12_CPU_DESCRIPTOR_HANDLE handles[]) {
+	const DescriptorTableEntry& tableEntry = m_rootDescriptorTable[rootIndex];
+	uint32_t handlesCount = 0;
+	unsigned long slotIndex;
+	unsigned long assignedBitMap = tableEntry.assignedHandlesBitMap;
+	while (ScanForward(&slotIndex, assignedBitMap)) {
+		assignedBitMap ^= (1 << slotIndex);
+		handles[handlesCount++] = tableEntry.tableStart[slotIndex];
+	}
+	return handlesCount;
+}
+
+uint32_t DescriptorHandlesCache::ComputeAssignedDescriptorsSize() {
+	//calculate the descriptors size need for the descriptor heap.
+	uint32_t assignedSize = 0;
+	unsigned long assignedDescriptorBitMap = m_assignedRootParamsBitMap;
+	unsigned long rootIndex;
+	while (ScanForward(&rootIndex, assignedDescriptorBitMap)) {
+		assignedDescriptorBitMap ^= (1 << rootIndex);
+		assignedSize += ComputeTableDescriptorsSize(rootIndex);
+	}
+	return assignedSize;
+}
+
+void DescriptorHandlesCache::StoreDescriptorsCPUHandles(UINT rootIndex, UINT offset, UINT handlesCount, const D3D12_CPU_DESCRIPTOR_HANDLE descriptorsHandleList[]) {
+	DescriptorTableEntry& curTableEntry = m_rootDescriptorTable[rootIndex];
+	D3D12_CPU_DESCRIPTOR_HANDLE* copyDest = curTableEntry.tableStart + offset;
+	for (UINT i = 0; i < handlesCount; ++i)
+		copyDest[i] = descriptorsHandleList[i];
+	//record the assigned cpu handles bit map
+	curTableEntry.assignedHandlesBitMap |= ((1 << handlesCount) - 1) << offset;
+	//indicate the root index descriptors table is valid and need to be committed
+	m_assignedRootParamsBitMap |= (1 << rootIndex);
+	m_dirtyRootParamsBitMap |= (1 << rootIndex);
+
+}
+
+//analysis the descriptor tables information in root signature
+void DescriptorHandlesCache::ParseRootSignature(uint32_t descriptorTablesBitMap, const uint32_t descriptorTableSize[]) {
+
+	uint32_t currentOffset = 0;
+	m_assignedRootParamsBitMap = 0;
+	m_dirtyRootParamsBitMap = 0;
+	m_rootDescriptorTablesBitMap = descriptorTablesBitMap;
+
+	unsigned long tmpBitMap = m_rootDescriptorTablesBitMap;
+	unsigned long curDescriptorTableIndex = 0;
+	while (ScanForward(&curDescriptorTableIndex, tmpBitMap))
+	{
+		tmpBitMap ^= (1 << curDescriptorTableIndex);
+
+		uint32_t curDescriptorTableSize = descriptorTableSize[curDescriptorTableIndex];
+		assert(curDescriptorTableSize > 0);
+
+		//record the descriptors table information and allocate the descriptor memory block
+		DescriptorTableEntry& tableEntry = m_rootDescriptorTable[curDescriptorTableIndex];
+		tableEntry.tableSize = curDescriptorTableSize;
+		tableEntry.tableStart = m_descriptors + currentOffset;
+		tableEntry.assignedHandlesBitMap = 0;
+		
+		currentOffset += curDescriptorTableSize;
+	}
+	m_cachedDescriptorsNum += currentOffset;
+	assert(m_cachedDescriptorsNum < maxNumDescriptors);
+}
+
+void DescriptorHandlesCache::ReleaseCaches() {
+	//lazy release: we just modify the data flag 
+	m_rootDescriptorTablesBitMap = 0;
+	m_assignedRootParamsBitMap = 0;
+	m_dirtyRootParamsBitMap = 0;
+	m_cachedDescriptorsNum = 0;
+}
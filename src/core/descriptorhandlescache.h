@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <d3d12.h>
+
+//describe the detail of a descriptor table entry
+struct DescriptorTableEntry
+{
+	DescriptorTableEntry() : assignedHandlesBitMap(0), tableStart(nullptr), tableSize(0){}
+	uint32_t assignedHandlesBitMap;
+	D3D12_CPU_DESCRIPTOR_HANDLE* tableStart;
+	uint32_t tableSize;
+};
+
+//the dynamic descriptors cache structure only consider about the descriptors tables
+//the other descriptor we can bind directly to the commandlist.
+//the cache only sees the device and the command list through the parameters, so it can be benchmarked with fakes
+struct DescriptorHandlesCache
+{
+	DescriptorHandlesCache();
+
+	//compute the descriptors size need in a descriptor heap
+	uint32_t ComputeAssignedDescriptorsSize();
+	//store the descriptors handle to current cache
+	void StoreDescriptorsCPUHandles(UINT rootIndex, UINT offset, UINT handlesCount, const D3D12_CPU_DESCRIPTOR_HANDLE descriptorsHandleList[]);
+	//the descriptors size of one table in a descriptor heap, the empty slots behind the last assigned one are not copied
+	uint32_t ComputeTableDescriptorsSize(uint32_t rootIndex);
+	//gather the assigned handles of one table, return the handles number
+	uint32_t GatherTableHandles(uint32_t rootIndex, D3D12_CPU_DESCRIPTOR_HANDLE handles[]);
+	//bind the tables in commitTablesBitMap to their gpu handles, only the tables in copyTablesBitMap are copied to their cpu handles
+	void CommitDescriptorHandleToDescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t descriptorsSize,
+		const D3D12_CPU_DESCRIPTOR_HANDLE tableCPUHandles[], const D3D12_GPU_DESCRIPTOR_HANDLE tableGPUHandles[],
+		uint32_t commitTablesBitMap, uint32_t copyTablesBitMap, ID3D12GraphicsCommandList* cmdList,
+		void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::* SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE));
+	//record the descriptor tables of the root signature, the sizes are indexed by the root index
+	void ParseRootSignature(uint32_t descriptorTablesBitMap, const uint32_t descriptorTableSize[]);
+	//clear current cache
+	void ReleaseCaches();
+
+	//the max number of descriptors and descriptor tables
+	static const uint32_t maxNumDescriptors = 256; 
+	static const uint32_t maxNumDescriptorTables = 16;
+
+	//the bit map of descriptor table in current root signature 
+	uint32_t m_rootDescriptorTablesBitMap = 0;
+	//the non empty slot of current root signature
+	uint32_t m_assignedRootParamsBitMap = 0;
+	//the tables modified since the last commit, only these tables are staged and bound
+	uint32_t m_dirtyRootParamsBitMap = 0;
+	//the heap bind count of the owning context when the tables were bound
+	uint64_t m_committedHeapBindCount = 0;
+	//record the information of descriptor table in root signature
+	DescriptorTableEntry m_rootDescriptorTable[maxNumDescriptorTables];
+	//store the descriptor of descriptors table in a linear way
+	D3D12_CPU_DESCRIPTOR_HANDLE m_descriptors[maxNumDescriptors];
+	//the descriptor number
+	uint32_t m_cachedDescriptorsNum = 0;
+};
@@ -2,48 +2,143 @@
 #include "headers.h"
 #include "graphicscore.h"
 
-std::mutex DescriptorAllocator::g_allocatorMutex; //resource critical section
-std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> DescriptorAllocator::g_descriptorPool; //descriptor heap pool
+//the single descriptors cached by current thread, one cache per heap type
+struct DescriptorThreadCache
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE m_handles[DescriptorAllocator::kThreadCacheSize];
+	uint32_t m_count = 0;
+	//the generation of the allocator when the cache was filled, 0 for never
+	uint64_t m_generation = 0;
+};
+static thread_local DescriptorThreadCache t_descriptorCaches[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+
+//the generations are unique among all the allocators
+static uint64_t NextDescriptorGeneration() {
+	static std::atomic<uint64_t> nextGeneration{ 1 };
+	return nextGeneration++;
+}
 
 DescriptorAllocator::DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type):
-	m_type(type), m_currentHeap(nullptr), m_descriptorSize(0), m_remainingFreeHandles(0)
+	m_type(type), m_descriptorSize(0), m_generation{ NextDescriptorGeneration() }, m_freeGeneration{ 0 }
 {
-	m_currentHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
+}
+
+DescriptorThreadCache& DescriptorAllocator::GetThreadCache() {
+	DescriptorThreadCache& cache = t_descriptorCaches[m_type];
+	//the cached descriptors belong to the heaps released by the last Destroy
+	uint64_t generation = m_generation.load(std::memory_order_relaxed);
+	if (cache.m_generation != generation) {
+		cache.m_generation = generation;
+		cache.m_count = 0;
+	}
+	return cache;
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocator::Allocator(uint32_t count) {
-	//The first initialize of the current heap, there is only one heap for per descriptor type
-	if (m_currentHeap != nullptr || m_remainingFreeHandles < count) {
-		m_currentHeap = RequestNewHeap(m_type);
-		m_currentHandle = m_currentHeap->GetCPUDescriptorHandleForHeapStart();
-		m_remainingFreeHandles = DescriptorAllocator::g_numDescriptorPerHeap;
-		if (m_descriptorSize == 0)
-			m_descriptorSize = GRAPHICS_CORE::g_device->GetDescriptorHandleIncrementSize(m_type);
+	if (count == 1) {
+		DescriptorThreadCache& cache = GetThreadCache();
+		//refill the cache in batch, so the lock is taken once for several descriptors
+		if (cache.m_count == 0) {
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			for (uint32_t i = 0; i < kThreadCacheRefill; ++i)
+				cache.m_handles[cache.m_count++] = AllocateFromHeaps(1);
+		}
+		return cache.m_handles[--cache.m_count];
 	}
 
-	//return a ptr on the heap
-	D3D12_CPU_DESCRIPTOR_HANDLE ret = m_currentHandle;
-	m_currentHandle.ptr += count * m_descriptorSize;
-	m_remainingFreeHandles -= count;
-	return ret;
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	return AllocateFromHeaps(count);
+}
+
+void DescriptorAllocator::Free(D3D12_CPU_DESCRIPTOR_HANDLE handle, uint32_t count) {
+	//the handle may get a new view right after, before the recording contexts finished
+	m_freeGeneration.fetch_add(1, std::memory_order_release);
+	if (count == 1) {
+		DescriptorThreadCache& cache = GetThreadCache();
+		if (cache.m_count < kThreadCacheSize) {
+			cache.m_handles[cache.m_count++] = handle;
+			return;
+		}
+
+		//the cache is full, give back a batch to the heaps
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		for (uint32_t i = 0; i < kThreadCacheRefill; ++i)
+			FreeToHeaps(cache.m_handles[--cache.m_count], 1);
+		cache.m_handles[cache.m_count++] = handle;
+		return;
+	}
+
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	FreeToHeaps(handle, count);
+}
+
+void DescriptorAllocator::Destroy() {
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	MemoryBudgetManager::Instance().ReportRelease(MEMORY_CATEGORY_DESCRIPTOR_HEAP,
+		(uint64_t)m_descriptorSize * g_numDescriptorPerHeap * m_heapsPool.size());
+	m_heapsPool.clear(); //clear the descriptor pool
+	//the descriptors cached by all the threads belong to the destroyed heaps
+	m_generation.store(NextDescriptorGeneration());
 }
 
-void DescriptorAllocator::DestroyAll() {
-	DescriptorAllocator::g_descriptorPool.clear(); //clear the descriptor pool
+uint32_t DescriptorAllocator::GetHeapCount() {
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	return (uint32_t)m_heapsPool.size();
 }
 
-ID3D12DescriptorHeap* DescriptorAllocator::RequestNewHeap(D3D12_DESCRIPTOR_HEAP_TYPE type) {
-	std::lock_guard<std::mutex> resourceLock(DescriptorAllocator::g_allocatorMutex);
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocator::AllocateFromHeaps(uint32_t count) {
+	assert(count <= g_numDescriptorPerHeap);
 
+	//fill the existing heaps before creating a new one
+	DescriptorHeapPage* heapPage = nullptr;
+	uint32_t index = DescriptorIndexAllocator::kInvalidIndex;
+	for (auto& page : m_heapsPool) {
+		index = page->m_indexAllocator.Alloc(count);
+		if (index != DescriptorIndexAllocator::kInvalidIndex) {
+			heapPage = page.get();
+			break;
+		}
+	}
+
+	if (heapPage == nullptr) {
+		heapPage = RequestNewHeap();
+		index = heapPage->m_indexAllocator.Alloc(count);
+	}
+
+	D3D12_CPU_DESCRIPTOR_HANDLE ret = heapPage->m_startHandle;
+	ret.ptr += (size_t)index * m_descriptorSize;
+	return ret;
+}
+
+void DescriptorAllocator::FreeToHeaps(D3D12_CPU_DESCRIPTOR_HANDLE handle, uint32_t count) {
+	size_t heapBytes = (size_t)g_numDescriptorPerHeap * m_descriptorSize;
+	for (auto& page : m_heapsPool) {
+		size_t heapStart = page->m_startHandle.ptr;
+		if (handle.ptr >= heapStart && handle.ptr < heapStart + heapBytes) {
+			page->m_indexAllocator.Free((uint32_t)((handle.ptr - heapStart) / m_descriptorSize), count);
+			return;
+		}
+	}
+	assert(false && "the descriptor is not allocated by this allocator");
+}
+
+DescriptorAllocator::DescriptorHeapPage* DescriptorAllocator::RequestNewHeap() {
 	D3D12_DESCRIPTOR_HEAP_DESC desc;
-	desc.Type = type;
+	desc.Type = m_type;
 	desc.NumDescriptors = DescriptorAllocator::g_numDescriptorPerHeap;
 	desc.NodeMask = 0;
 	desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
 
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> newHeap;
-	ThrowIfFailed(GRAPHICS_CORE::g_device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&newHeap)));
-	DescriptorAllocator::g_descriptorPool.push_back(newHeap);
-	return newHeap.Get();
-}
+	if (m_descriptorSize == 0)
+		m_descriptorSize = GRAPHICS_CORE::g_device->GetDescriptorHandleIncrementSize(m_type);
+
+	std::unique_ptr<DescriptorHeapPage> heapPage(new DescriptorHeapPage());
+	ThrowIfFailed(GRAPHICS_CORE::g_device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heapPage->m_heap)));
+	MemoryBudgetManager::Instance().ReportAllocation(MEMORY_CATEGORY_DESCRIPTOR_HEAP,
+		(uint64_t)m_descriptorSize * desc.NumDescriptors);
+	heapPage->m_startHandle = heapPage->m_heap->GetCPUDescriptorHandleForHeapStart();
+	heapPage->m_indexAllocator.Initialize(g_numDescriptorPerHeap);
 
+	m_heapsPool.push_back(std::move(heapPage));
+	return m_heapsPool.back().get();
+}
@@ -1,34 +1,60 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <vector>
 #include <string>
+#include <memory>
 #include <d3d12.h>
 #include <wrl/client.h>
+#include "descriptorindexallocator.h"
+
+struct DescriptorThreadCache;
 
 /*
-* Descriptor Allocator is responsible for allocate the descriptor 
+* Descriptor Allocator is responsible for allocate the descriptor
 * Static Descriptor Heap: for the descriptor of textures, samples
 * Dynamic Descriptor Heap: for the descriptors that only use in one frame
 */
+//the cpu descriptors are read when the commands are recorded, so the freed descriptors are reused immediately
+//the single descriptors are cached per thread, the loading threads rarely take the lock
 class DescriptorAllocator
 {
 public:
 	DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type);
 
 	D3D12_CPU_DESCRIPTOR_HANDLE Allocator(uint32_t count);
+	void Free(D3D12_CPU_DESCRIPTOR_HANDLE handle, uint32_t count = 1);
+	void Destroy();
 
-	static void DestroyAll();
+	uint32_t GetHeapCount();
+	//changed by every Free, the tables copied from a freed view are stale after it changed
+	uint64_t GetFreeGeneration() const { return m_freeGeneration.load(std::memory_order_acquire); }
 
-protected:
 	static const uint32_t g_numDescriptorPerHeap = 256; //the number of the descriptors in each heap
-	static std::mutex g_allocatorMutex; //resource critical section
-	static std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> g_descriptorPool; //descriptor heap pool
-	static ID3D12DescriptorHeap* RequestNewHeap(D3D12_DESCRIPTOR_HEAP_TYPE type);
+	static const uint32_t kThreadCacheSize = 32; //the single descriptors cached by each thread
+	static const uint32_t kThreadCacheRefill = 16; //the descriptors moved between the cache and the heaps in batch
+
+protected:
+	struct DescriptorHeapPage
+	{
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_heap;
+		D3D12_CPU_DESCRIPTOR_HANDLE m_startHandle;
+		DescriptorIndexAllocator m_indexAllocator;
+	};
+
+	//the caller should hold the mutex
+	D3D12_CPU_DESCRIPTOR_HANDLE AllocateFromHeaps(uint32_t count);
+	void FreeToHeaps(D3D12_CPU_DESCRIPTOR_HANDLE handle, uint32_t count);
+	DescriptorHeapPage* RequestNewHeap();
+	//the cache of current thread, emptied when it was filled before the last Destroy
+	DescriptorThreadCache& GetThreadCache();
 
 	D3D12_DESCRIPTOR_HEAP_TYPE m_type; //heap type
-	ID3D12DescriptorHeap* m_currentHeap; //current heap
-	D3D12_CPU_DESCRIPTOR_HANDLE m_currentHandle; //current heap head ptr
 	uint32_t m_descriptorSize; //the size of each descriptor
-	uint32_t m_remainingFreeHandles; // the remain space
+	std::vector<std::unique_ptr<DescriptorHeapPage>> m_heapsPool; //descriptor heap pool
+	std::mutex m_mutex;
+	//changed by Destroy, the thread caches of the other threads are dropped on their next use
+	std::atomic<uint64_t> m_generation;
+	std::atomic<uint64_t> m_freeGeneration;
 };
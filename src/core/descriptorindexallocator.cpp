@@ -0,0 +1,116 @@
+#include "descriptorindexallocator.h"
+#include <cassert>
+
+void DescriptorIndexAllocator::Initialize(uint32_t capacity)
+{
+	m_capacity = capacity;
+	m_usedCount = 0;
+	m_pendingFreeCount = 0;
+	m_freeRangesByIndex.clear();
+	m_freeRangesBySize.clear();
+	m_pendingFrees.clear();
+	if (capacity > 0)
+		AddFreeRange(0, capacity);
+}
+
+uint32_t DescriptorIndexAllocator::Alloc(uint32_t count)
+{
+	assert(count > 0);
+
+	//the smallest range which fits the request
+	auto sizeIter = m_freeRangesBySize.lower_bound(count);
+	if (sizeIter == m_freeRangesBySize.end())
+		return kInvalidIndex;
+
+	uint32_t rangeSize = sizeIter->first;
+	uint32_t rangeIndex = sizeIter->second;
+	RemoveFreeRange(m_freeRangesByIndex.find(rangeIndex));
+
+	//keep the tail of the range
+	if (rangeSize > count)
+		AddFreeRange(rangeIndex + count, rangeSize - count);
+
+	m_usedCount += count;
+	return rangeIndex;
+}
+
+void DescriptorIndexAllocator::Free(uint32_t index, uint32_t count, uint64_t fenceValue)
+{
+	Free(index, count, &fenceValue, 1);
+}
+
+void DescriptorIndexAllocator::Free(uint32_t index, uint32_t count, const uint64_t fenceValues[], uint32_t fenceCount)
+{
+	assert(index + count <= m_capacity && count <= m_usedCount);
+	assert(fenceCount <= kMaxFenceCount);
+	PendingFree pendingFree;
+	for (uint32_t i = 0; i < fenceCount; ++i)
+		pendingFree.m_fenceValues[i] = fenceValues[i];
+	pendingFree.m_fenceCount = fenceCount;
+	pendingFree.m_index = index;
+	pendingFree.m_count = count;
+	m_pendingFrees.push_back(pendingFree);
+	m_usedCount -= count;
+	m_pendingFreeCount += count;
+}
+
+void DescriptorIndexAllocator::Free(uint32_t index, uint32_t count)
+{
+	assert(index + count <= m_capacity && count <= m_usedCount);
+	AddFreeRange(index, count);
+	m_usedCount -= count;
+}
+
+DescriptorIndexReport DescriptorIndexAllocator::GetReport() const
+{
+	DescriptorIndexReport report;
+	report.m_capacity = m_capacity;
+	report.m_usedCount = m_usedCount;
+	report.m_pendingFreeCount = m_pendingFreeCount;
+	report.m_freeRangeCount = (uint32_t)m_freeRangesByIndex.size();
+	if (!m_freeRangesBySize.empty())
+		report.m_largestFreeRange = m_freeRangesBySize.rbegin()->first;
+
+	uint32_t freeCount = m_capacity - m_usedCount - m_pendingFreeCount;
+	if (freeCount > 0)
+		report.m_fragmentation = 1.0f - (float)report.m_largestFreeRange / (float)freeCount;
+	return report;
+}
+
+void DescriptorIndexAllocator::AddFreeRange(uint32_t index, uint32_t count)
+{
+	//merge with the next range
+	auto nextIter = m_freeRangesByIndex.lower_bound(index);
+	assert(nextIter == m_freeRangesByIndex.end() || nextIter->first >= index + count);
+	if (nextIter != m_freeRangesByIndex.end() && nextIter->first == index + count) {
+		count += nextIter->second;
+		RemoveFreeRange(nextIter);
+	}
+
+	//merge with the previous range
+	auto prevIter = m_freeRangesByIndex.lower_bound(index);
+	if (prevIter != m_freeRangesByIndex.begin()) {
+		--prevIter;
+		assert(prevIter->first + prevIter->second <= index);
+		if (prevIter->first + prevIter->second == index) {
+			index = prevIter->first;
+			count += prevIter->second;
+			RemoveFreeRange(prevIter);
+		}
+	}
+
+	m_freeRangesByIndex[index] = count;
+	m_freeRangesBySize.insert(std::make_pair(count, index));
+}
+
+void DescriptorIndexAllocator::RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator offsetIter)
+{
+	auto sizeRange = m_freeRangesBySize.equal_range(offsetIter->second);
+	for (auto sizeIter = sizeRange.first; sizeIter != sizeRange.second; ++sizeIter) {
+		if (sizeIter->second == offsetIter->first) {
+			m_freeRangesBySize.erase(sizeIter);
+			break;
+		}
+	}
+	m_freeRangesByIndex.erase(offsetIter);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+//The occupancy report of the descriptor indices
+struct DescriptorIndexReport
+{
+	uint32_t m_capacity = 0;
+	uint32_t m_usedCount = 0;
+	uint32_t m_pendingFreeCount = 0;
+	uint32_t m_freeRangeCount = 0;
+	uint32_t m_largestFreeRange = 0;
+	//1 - largest free range / free count, 0 means all the free indices are contiguous
+	float m_fragmentation = 0.0f;
+};
+
+//Descriptor Index Allocator
+//range free-list over the descriptor indices of one heap, the ranges are best fit and merged on free
+//the frees are deferred until the fence of the last use completed
+//the allocator does not touch the device, so it can be tested alone
+class DescriptorIndexAllocator
+{
+public:
+	static const uint32_t kInvalidIndex = 0xFFFFFFFF;
+	//the fences of one free, one for each queue which may reference the range
+	static const uint32_t kMaxFenceCount = 4;
+
+	DescriptorIndexAllocator() : m_capacity(0), m_usedCount(0), m_pendingFreeCount(0) {}
+
+	void Initialize(uint32_t capacity);
+
+	//return kInvalidIndex if there is no range big enough
+	uint32_t Alloc(uint32_t count);
+	//the range is reusable after the fence completed
+	void Free(uint32_t index, uint32_t count, uint64_t fenceValue);
+	//the range is reusable after all the fences completed
+	void Free(uint32_t index, uint32_t count, const uint64_t fenceValues[], uint32_t fenceCount);
+	//the range is reusable immediately, for the descriptors never referenced by the gpu
+	void Free(uint32_t index, uint32_t count);
+	//give back the ranges whose fences completed, return the number of released indices
+	template<typename FenceCompleteFunc>
+	uint32_t ReleaseCompleted(FenceCompleteFunc isFenceComplete) {
+		uint32_t releasedCount = 0;
+		for (auto iter = m_pendingFrees.begin(); iter != m_pendingFrees.end();) {
+			bool completed = true;
+			for (uint32_t i = 0; i < iter->m_fenceCount && completed; ++i)
+				completed = isFenceComplete(iter->m_fenceValues[i]);
+			if (completed) {
+				AddFreeRange(iter->m_index, iter->m_count);
+				releasedCount += iter->m_count;
+				iter = m_pendingFrees.erase(iter);
+			}
+			else
+				++iter;
+		}
+		m_pendingFreeCount -= releasedCount;
+		return releasedCount;
+	}
+
+	uint32_t GetCapacity() const { return m_capacity; }
+	uint32_t GetUsedCount() const { return m_usedCount; }
+	DescriptorIndexReport GetReport() const;
+
+private:
+	struct PendingFree
+	{
+		uint64_t m_fenceValues[kMaxFenceCount];
+		uint32_t m_fenceCount;
+		uint32_t m_index;
+		uint32_t m_count;
+	};
+
+	void AddFreeRange(uint32_t index, uint32_t count);
+	void RemoveFreeRange(std::map<uint32_t, uint32_t>::iterator offsetIter);
+
+	uint32_t m_capacity;
+	uint32_t m_usedCount;
+	uint32_t m_pendingFreeCount;
+	//the free ranges keyed by start index, and by size for the best fit
+	std::map<uint32_t, uint32_t> m_freeRangesByIndex;
+	std::multimap<uint32_t, uint32_t> m_freeRangesBySize;
+	//the fences may come from different queues, so every pending free is checked
+	std::vector<PendingFree> m_pendingFrees;
+};
@@ -47,20 +47,3 @@ private:
 	D3D12_CPU_DESCRIPTOR_HANDLE m_cpuHandle;
 	D3D12_GPU_DESCRIPTOR_HANDLE m_gpuHandle;
 };
-
-//describe the detail of a descriptor table entry
-struct DescriptorTableEntry
-{
-	DescriptorTableEntry() : assignedHandlesBitMap(0), tableSize(0), tableStart(nullptr){}
-	uint32_t assignedHandlesBitMap;
-	D3D12_CPU_DESCRIPTOR_HANDLE* tableStart;
-	uint32_t tableSize;
-};
-
-
-
-
-
-
-
-
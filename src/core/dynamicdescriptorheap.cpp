@@ -7,247 +7,44 @@
 #include <d3d12.h>
 #include "graphicscore.h"
 #include "context.h"
-
-const uint32_t g_maxDescriptorsNumPerHeap = 1024;
-
-enum DynamicDescriptorHeapTypes
-{
-	CBV_SRV_UAV_RTV_DSV = 0,
-	SAMPLER = 1
-};
+#include "hashutils.h"
+
+//hash of the assigned slots and the source cpu handles of a descriptor table
+static uint64_t HashDescriptorTable(uint32_t assignedBitMap, uint32_t handlesCount, const D3D12_CPU_DESCRIPTOR_HANDLE handles[]) {
+	uint64_t hashValue = HashWord(assignedBitMap);
+	for (uint32_t i = 0; i < handlesCount; ++i)
+		hashValue = HashWord((uint64_t)handles[i].ptr, hashValue);
+	return hashValue;
+}
 
 /*
 * DynamicDescriptorsManager
 */
-ID3D12DescriptorHeap* DynamicDescriptorsManager::RequestDescriptorHeap(
-	D3D12_DESCRIPTOR_HEAP_TYPE heapType) {
-	
-	uint32_t heapIdx = GetDescriptorHeapIdx(heapType);
+void DynamicDescriptorsManager::ReportTableCacheStats(const DescriptorTableCacheStats& stats) {
 	std::lock_guard<std::mutex> lockGuard(m_mutex);
-
-	//update the descriptor heaps
-	while (!m_retiredDescriptorHeap[heapIdx].empty() &&
-		GRAPHICS_CORE::g_commandManager.IsFenceComplete(m_retiredDescriptorHeap[heapIdx].front().first))
-	{
-		m_availableHeap[heapIdx].push(m_retiredDescriptorHeap[heapIdx].front().second);
-		m_retiredDescriptorHeap[heapIdx].pop();
-	}
-	
-	//if there is available heap, we return the heap pointer
-	if (!m_availableHeap[heapIdx].empty())
-	{
-		ID3D12DescriptorHeap* heapPtr = m_availableHeap[heapIdx].front();
-		m_availableHeap[heapIdx].pop();
-		return heapPtr;
-	}
-	else { //if there is no available heap, we create a new descriptor heaps
-		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
-		heapDesc.Type = heapType;
-		heapDesc.NumDescriptors = g_maxDescriptorsNumPerHeap;
-		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-		heapDesc.NodeMask = 0;
-
-		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heapPtr;
-		ThrowIfFailed(GRAPHICS_CORE::g_device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heapPtr)));
-		return heapPtr.Get();
-	}
+	m_tableCacheStats.Accumulate(stats);
 }
 
-void DynamicDescriptorsManager::DiscardDescriptors(
-	D3D12_DESCRIPTOR_HEAP_TYPE heapType,
-	uint64_t fenceValue,
-	const std::vector<ID3D12DescriptorHeap*>& usedHeaps) {
-	uint32_t heapIdx = GetDescriptorHeapIdx(heapType);
+DescriptorTableCacheStats DynamicDescriptorsManager::GetTableCacheStats() {
 	std::lock_guard<std::mutex> lockGuard(m_mutex);
-	for (auto iter = usedHeaps.begin(); iter != usedHeaps.end(); iter++)
-		m_retiredDescriptorHeap[heapIdx].push(std::make_pair(fenceValue, *iter));
-}
-
-//process descriptors heap
-uint32_t DynamicDescriptorsManager::GetDescriptorHeapIdx(D3D12_DESCRIPTOR_HEAP_TYPE
-	heapType) {
-	uint32_t idx;
-	if (heapType == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER)
-		idx = DynamicDescriptorHeapTypes::SAMPLER;
-	else
-		idx = DynamicDescriptorHeapTypes::CBV_SRV_UAV_RTV_DSV;
-	return idx;
-}
-
-
-DescriptorHandlesCache::DescriptorHandlesCache() {
-	ReleaseCaches();
-}
-
-void DescriptorHandlesCache::CommitDescriptorHandleToDescriptorHeap(
-	D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t descriptorsSize,
-	DescriptorHandle dstHandleStart, ID3D12GraphicsCommandList* cmdList,
-	void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::* SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE)) {
-
-	//Extract the dynamic descriptor heaps properties for efficiency
-	uint32_t descriptorTableSize[maxNumDescriptorTables];
-	uint32_t rootIndexDoc[maxNumDescriptorTables];
-	uint32_t assignedDescriptorTableCount = 0;
-	unsigned long descriptorsSpaceSize = 0;
-	unsigned long rootIndex = 0;
-
-	unsigned long assignedDescriptorTablesBitMap = m_assignedRootParamsBitMap;
-	while (_BitScanForward(&rootIndex, assignedDescriptorTablesBitMap)) {
-		rootIndexDoc[assignedDescriptorTableCount] = rootIndex;
-		assignedDescriptorTablesBitMap ^= (1 << rootIndex);
-		//extract the descriptors space in current descriptor table
-		unsigned long descriptorsNumInDescriptorTable;
-		_BitScanReverse(&descriptorsNumInDescriptorTable, assignedDescriptorTablesBitMap);
-
-		descriptorsSpaceSize += descriptorsNumInDescriptorTable + 1;
-		descriptorTableSize[assignedDescriptorTableCount] = descriptorsNumInDescriptorTable + 1;
-		assignedDescriptorTableCount++;
-	}
-
-	//
-	static const uint32_t maxNumCopyDescriptorsNum = 16;
-
-	uint32_t destDescriptorRangeIndex = 0;
-	D3D12_CPU_DESCRIPTOR_HANDLE pDestDescriptorRangeStart[maxNumCopyDescriptorsNum];
-	uint32_t destDescriptorRangeDescriptorsSize[maxNumCopyDescriptorsNum];
-
-	uint32_t srcDescriptorRangeIndex = 0;
-	D3D12_CPU_DESCRIPTOR_HANDLE pSrcDescriptorRangeStart[maxNumCopyDescriptorsNum];
-	uint32_t srcDescriptorRangeDescriptorsSize[maxNumCopyDescriptorsNum];
-	//loop each descriptor table
-	for (uint32_t i = 0; i < assignedDescriptorTableCount; ++i) {
-		rootIndex = rootIndexDoc[i];
-		(cmdList->*SetFunc)(rootIndex, dstHandleStart);
-		
-		//the source descriptor handle
-		DescriptorTableEntry& descriptorTableCachedInfo = m_rootDescriptorTable[rootIndex];
-		D3D12_CPU_DESCRIPTOR_HANDLE* srcHandles = descriptorTableCachedInfo.tableStart;
-		unsigned long assignedDescriptorBitMap = descriptorTableCachedInfo.assignedHandlesBitMap;
-		//the destination descriptor handle
-		D3D12_CPU_DESCRIPTOR_HANDLE dstHandles = dstHandleStart;
-		dstHandleStart += descriptorTableSize[i] * descriptorsSize;
-
-		//copy the source descriptors in descriptor table to the descriptor heap and recover the descriptor layout
-		unsigned long skipCount;
-		while (_BitScanForward(&skipCount, assignedDescriptorBitMap))
-		{
-			//skip the first several empty descriptor slots
-			assignedDescriptorBitMap >>= skipCount;
-			srcHandles += skipCount;
-			dstHandles.ptr += skipCount * descriptorsSize;
-
-			//gain the non-empty descriptor slots number in current filled block
-			unsigned long descriptorCount;
-			_BitScanForward(&descriptorCount, ~assignedDescriptorBitMap);
-			assignedDescriptorBitMap >>= descriptorCount;
-
-			//if current descriptors block is extend the max copy number
-			if (srcDescriptorRangeIndex + descriptorCount > maxNumCopyDescriptorsNum)
-			{
-				//copy the data directly, current loop's data will be copied in the next loop
-				GRAPHICS_CORE::g_device->CopyDescriptors(
-					destDescriptorRangeIndex, pDestDescriptorRangeStart, destDescriptorRangeDescriptorsSize,
-					srcDescriptorRangeIndex, pSrcDescriptorRangeStart, srcDescriptorRangeDescriptorsSize, type
-				);
-
-				srcDescriptorRangeIndex = 0;
-				destDescriptorRangeIndex = 0;
-			}
-
-			//initial the descriptor range infomation of destination descriptor block
-			pDestDescriptorRangeStart[destDescriptorRangeIndex] = dstHandles;
-			destDescriptorRangeDescriptorsSize[destDescriptorRangeIndex] = descriptorCount;
-			destDescriptorRangeIndex++;
-
-			//initial the descriptor range information of source descriptor block and load the source data
-			for (int srcDescriptorIndex = 0; srcDescriptorIndex < descriptorCount; srcDescriptorIndex++)
-			{
-				pSrcDescriptorRangeStart[srcDescriptorRangeIndex] = srcHandles[srcDescriptorIndex];
-				srcDescriptorRangeDescriptorsSize[srcDescriptorRangeIndex] = 1;
-				srcDescriptorRangeIndex++;
-			}
-
-			srcHandles += descriptorCount;
-			dstHandles.ptr += descriptorCount * descriptorsSize;
-		}
-	}
-
-	GRAPHICS_CORE::g_device->CopyDescriptors(
-		destDescriptorRangeIndex, pDestDescriptorRangeStart, destDescriptorRangeDescriptorsSize,
-		srcDescriptorRangeIndex, pSrcDescriptorRangeStart, srcDescriptorRangeDescriptorsSize, type
-	);
-}
-
-uint32_t DescriptorHandlesCache::ComputeAssignedDescriptorsSize() {
-	//calculate the descriptors size need for the descriptor heap.
-	uint32_t assignedSize = 0;
-	unsigned long assignedDescriptorBitMap = m_assignedRootParamsBitMap;
-	unsigned long rootIndex;
-	while (_BitScanForward(&rootIndex, assignedDescriptorBitMap)) {
-		assignedDescriptorBitMap ^= (1 << rootIndex);
-		unsigned long descriptorsSize;
-		assert(TRUE == _BitScanReverse(&descriptorsSize, m_rootDescriptorTable[rootIndex].assignedHandlesBitMap));
-		assignedSize += descriptorsSize + 1;
-	}
-	return assignedSize;
-}
-
-void DescriptorHandlesCache::StoreDescriptorsCPUHandles(UINT rootIndex, UINT offset, UINT handlesCount, const D3D12_CPU_DESCRIPTOR_HANDLE descriptorsHandleList[]) {
-	DescriptorTableEntry& curTableEntry = m_rootDescriptorTable[rootIndex];
-	D3D12_CPU_DESCRIPTOR_HANDLE* copyDest = curTableEntry.tableStart + offset;
-	for (int i = 0; i < handlesCount; ++i)
-		copyDest[i] = descriptorsHandleList[i];
-	//record the assigned cpu handles bit map
-	curTableEntry.assignedHandlesBitMap |= ((1 << handlesCount) - 1) << offset;
-	//indicate the root index descriptors table is valid
-	m_assignedRootParamsBitMap |= (1 << rootIndex);
-
+	return m_tableCacheStats;
 }
 
-//analysis the descriptor tables information in root signature
-void DescriptorHandlesCache::ParseRootSignature(D3D12_DESCRIPTOR_HEAP_TYPE type, 
-	const RootSignature& rootSig) {
-
-	uint32_t currentOffset = 0;
-	m_assignedRootParamsBitMap = 0;
-	if (type == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER)
-		m_rootDescriptorTablesBitMap = rootSig.m_samplerBitMap;
-	else
-		m_rootDescriptorTablesBitMap = rootSig.m_descriptorTableBitMap;
-
-	unsigned long tmpBitMap = m_rootDescriptorTablesBitMap;
-	unsigned long curDescriptorTableIndex = 0;
-	while (_BitScanForward(&curDescriptorTableIndex, tmpBitMap))
-	{
-		tmpBitMap ^= (1 << curDescriptorTableIndex);
-
-		uint32_t curDescriptorTableSize = rootSig.m_descriptorTableSize[curDescriptorTableIndex];
-		assert(curDescriptorTableSize > 0);
-
-		//record the descriptors table information and allocate the descriptor memory block
-		DescriptorTableEntry& tableEntry = m_rootDescriptorTable[curDescriptorTableIndex];
-		tableEntry.tableSize = curDescriptorTableSize;
-		tableEntry.tableStart = m_descriptors + currentOffset;
-		tableEntry.assignedHandlesBitMap = 0;
-		
-		currentOffset += curDescriptorTableSize;
-	}
-	m_cachedDescriptorsNum += currentOffset;
-	assert(m_cachedDescriptorsNum < maxNumDescriptors);
+void DynamicDescriptorsManager::ResetTableCacheStats() {
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_tableCacheStats = DescriptorTableCacheStats();
 }
 
-void DescriptorHandlesCache::ReleaseCaches() {
-	//lazy release: we just modify the data flag 
-	m_rootDescriptorTablesBitMap = 0;
-	m_assignedRootParamsBitMap = 0;
-	m_cachedDescriptorsNum = 0;
-}
 
 DynamicDescriptorHeap::DynamicDescriptorHeap(Context& owningContext, D3D12_DESCRIPTOR_HEAP_TYPE heapType)
-	: m_owningContext(owningContext), m_descriptorHeapType(heapType)
+	: m_owningContext(owningContext),
+	m_sharedHeap(heapType == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER ?
+		GRAPHICS_CORE::g_samplersDescriptorHeap : GRAPHICS_CORE::g_texturesDescriptorHeap),
+	m_descriptorHeapType(heapType)
 {
 	m_curDescriptorHeap = nullptr;
 	m_currentOffset = 0;
+	m_cachedFreeGeneration = 0;
 	m_descriptorSize = GRAPHICS_CORE::g_device->GetDescriptorHandleIncrementSize(heapType);
 }
 
@@ -256,8 +53,13 @@ DynamicDescriptorHeap::~DynamicDescriptorHeap() {
 }
 
 void DynamicDescriptorHeap::CleanupUsedHeap(uint64_t fence) {
-	RetireCurrentHeap();
-	RetireUsedHeaps(fence);
+	RetireCurrentBlock();
+	RetireUsedBlocks(fence);
+	//the cached tables live in the retired blocks
+	m_cachedTables.clear();
+	m_cachedTableHandles.clear();
+	DynamicDescriptorsManager::Instance().ReportTableCacheStats(m_tableCacheStats);
+	m_tableCacheStats = DescriptorTableCacheStats();
 	m_graphicsDescriptorsCache.ReleaseCaches();
 	m_computeDescriptorsCache.ReleaseCaches();
 }
@@ -273,36 +75,108 @@ void DynamicDescriptorHeap::SetComputeDescriptorHandles(uint32_t rootIndex, uint
 }
 
 void DynamicDescriptorHeap::ParseGraphicsRootSignature(const RootSignature& rootSignature) {
-	m_graphicsDescriptorsCache.ParseRootSignature(m_descriptorHeapType, rootSignature);
+	m_graphicsDescriptorsCache.ParseRootSignature(GetTablesBitMap(rootSignature), rootSignature.m_descriptorTableSize);
 }
 
 void DynamicDescriptorHeap::ParseComputeRootSignature(const RootSignature& rootSignature) {
-	m_computeDescriptorsCache.ParseRootSignature(m_descriptorHeapType, rootSignature);
+	m_computeDescriptorsCache.ParseRootSignature(GetTablesBitMap(rootSignature), rootSignature.m_descriptorTableSize);
+}
+
+uint32_t DynamicDescriptorHeap::GetTablesBitMap(const RootSignature& rootSignature) const {
+	if (m_descriptorHeapType == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER)
+		return rootSignature.m_samplerBitMap;
+	return rootSignature.m_descriptorTableBitMap;
 }
 
 void DynamicDescriptorHeap::CommittedDescriptorTables(DescriptorHandlesCache& handleCache, ID3D12GraphicsCommandList* cmdList,
 	void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::* SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE)) {
-	//calculate the descriptors size in dyanmic descriptors caches 
-	uint32_t needSize = handleCache.ComputeAssignedDescriptorsSize();
-	if (!HasFreeSpace(needSize)) {
-		RetireCurrentHeap();
+	const uint32_t maxNumDescriptorTables = DescriptorHandlesCache::maxNumDescriptorTables;
+	DescriptorHandle tableHandles[maxNumDescriptorTables];
+	uint64_t tableHashes[maxNumDescriptorTables];
+	uint32_t tableSizes[maxNumDescriptorTables];
+	uint32_t commitTablesBitMap = handleCache.m_dirtyRootParamsBitMap;
+
+	//a view freed and created again on the same handle would hit the copy of the old view
+	uint64_t freeGeneration = GRAPHICS_CORE::g_descriptorHeapAllocator[m_descriptorHeapType].GetFreeGeneration();
+	if (freeGeneration != m_cachedFreeGeneration) {
+		m_cachedTables.clear();
+		m_cachedTableHandles.clear();
+		m_cachedFreeGeneration = freeGeneration;
 	}
+	uint32_t copyTablesBitMap = 0;
+	uint32_t copySize = 0;
+
+	//the tables with the same source handles are reused from current heap
+	D3D12_CPU_DESCRIPTOR_HANDLE tableSrcHandles[32]; //the assigned bit map holds 32 slots
+	unsigned long rootIndex;
+	unsigned long dirtyTablesBitMap = commitTablesBitMap;
+	while (_BitScanForward(&rootIndex, dirtyTablesBitMap)) {
+		dirtyTablesBitMap ^= (1 << rootIndex);
+		uint32_t assignedBitMap = handleCache.m_rootDescriptorTable[rootIndex].assignedHandlesBitMap;
+		uint32_t handlesCount = handleCache.GatherTableHandles(rootIndex, tableSrcHandles);
+		tableHashes[rootIndex] = HashDescriptorTable(assignedBitMap, handlesCount, tableSrcHandles);
+		tableSizes[rootIndex] = handleCache.ComputeTableDescriptorsSize(rootIndex);
+
+		if (FindCachedTable(tableHashes[rootIndex], assignedBitMap, handlesCount, tableSrcHandles, tableHandles[rootIndex])) {
+			m_tableCacheStats.m_hitCount++;
+			m_tableCacheStats.m_skippedDescriptors += handlesCount;
+		}
+		else {
+			m_tableCacheStats.m_missCount++;
+			copyTablesBitMap |= (1 << rootIndex);
+			copySize += tableSizes[rootIndex];
+		}
+	}
+
+	//the cached tables stay in the retired block, only the missed tables are copied to the new block
+	assert(copySize <= m_sharedHeap.GetDynamicBlockSize());
+	if (!HasFreeSpace(copySize))
+		RetireCurrentBlock();
 
 	//Set Descriptor Heaps to Graphics Context
 	m_owningContext.SetDescriptorHeap(m_descriptorHeapType, GetHeapPointer());
 
-	handleCache.CommitDescriptorHandleToDescriptorHeap(m_descriptorHeapType, m_descriptorSize,
-		Allocate(needSize), cmdList, SetFunc);
+	unsigned long copyBitMap = copyTablesBitMap;
+	while (_BitScanForward(&rootIndex, copyBitMap)) {
+		copyBitMap ^= (1 << rootIndex);
+		tableHandles[rootIndex] = Allocate(tableSizes[rootIndex]);
+		uint32_t assignedBitMap = handleCache.m_rootDescriptorTable[rootIndex].assignedHandlesBitMap;
+		uint32_t handlesCount = handleCache.GatherTableHandles(rootIndex, tableSrcHandles);
+		InsertCachedTable(tableHashes[rootIndex], assignedBitMap, handlesCount, tableSrcHandles, tableHandles[rootIndex]);
+		m_tableCacheStats.m_copiedDescriptors += handlesCount;
+	}
+
+	//split the handles for the cache, it does not know the descriptor handle type
+	D3D12_CPU_DESCRIPTOR_HANDLE tableCPUHandles[maxNumDescriptorTables];
+	D3D12_GPU_DESCRIPTOR_HANDLE tableGPUHandles[maxNumDescriptorTables];
+	unsigned long commitBitMap = commitTablesBitMap;
+	while (_BitScanForward(&rootIndex, commitBitMap)) {
+		commitBitMap ^= (1 << rootIndex);
+		tableCPUHandles[rootIndex] = tableHandles[rootIndex];
+		tableGPUHandles[rootIndex] = tableHandles[rootIndex];
+	}
+
+	handleCache.CommitDescriptorHandleToDescriptorHeap(GRAPHICS_CORE::g_device, m_descriptorHeapType, m_descriptorSize,
+		tableCPUHandles, tableGPUHandles, commitTablesBitMap, copyTablesBitMap, cmdList, SetFunc);
+	handleCache.m_dirtyRootParamsBitMap = 0;
+	handleCache.m_committedHeapBindCount = m_owningContext.GetDescriptorHeapBindCount();
+}
+
+void DynamicDescriptorHeap::InvalidateTablesOnHeapChange(DescriptorHandlesCache& handleCache) {
+	if (handleCache.m_committedHeapBindCount != m_owningContext.GetDescriptorHeapBindCount())
+		handleCache.m_dirtyRootParamsBitMap = handleCache.m_assignedRootParamsBitMap;
 }
 
 void DynamicDescriptorHeap::CommitGraphicsDescriptorTablesOfRootSignature(ID3D12GraphicsCommandList* graphicsList) {
-	if (m_graphicsDescriptorsCache.m_assignedRootParamsBitMap != 0) {
+	InvalidateTablesOnHeapChange(m_graphicsDescriptorsCache);
+	if (m_graphicsDescriptorsCache.m_dirtyRootParamsBitMap != 0) {
 		CommittedDescriptorTables(m_graphicsDescriptorsCache, graphicsList, &ID3D12GraphicsCommandList::SetGraphicsRootDescriptorTable);
 	}
 }
 
 void DynamicDescriptorHeap::CommitComputeDescriptorTablesOfRootSignature(ID3D12GraphicsCommandList* computeList) {
-	if (m_computeDescriptorsCache.m_assignedRootParamsBitMap != 0) {
+	InvalidateTablesOnHeapChange(m_computeDescriptorsCache);
+	if (m_computeDescriptorsCache.m_dirtyRootParamsBitMap != 0) {
 		CommittedDescriptorTables(m_computeDescriptorsCache, computeList, &ID3D12GraphicsCommandList::SetComputeRootDescriptorTable);
 	}
 }
@@ -310,7 +184,7 @@ void DynamicDescriptorHeap::CommitComputeDescriptorTablesOfRootSignature(ID3D12G
 D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::UploadDirect(D3D12_CPU_DESCRIPTOR_HANDLE handle)
 {
 	if (!HasFreeSpace(1)) {
-		RetireCurrentHeap();
+		RetireCurrentBlock();
 	}
 
 	m_owningContext.SetDescriptorHeap(m_descriptorHeapType, GetHeapPointer());
@@ -332,35 +206,64 @@ DescriptorHandle DynamicDescriptorHeap::Allocate(UINT count) {
 }
 
 bool DynamicDescriptorHeap::HasFreeSpace(UINT count) {
-	return (m_curDescriptorHeap != nullptr) && (m_currentOffset + count <= kNumDescriptorsPerHeap);
+	return (m_curDescriptorHeap != nullptr) && (m_currentOffset + count <= m_sharedHeap.GetDynamicBlockSize());
 }
 
 ID3D12DescriptorHeap* DynamicDescriptorHeap::GetHeapPointer() {
 	if (m_curDescriptorHeap == nullptr) {
 		assert(m_currentOffset == 0);
-		m_curDescriptorHeap = DynamicDescriptorsManager::Instance().RequestDescriptorHeap(m_descriptorHeapType);
-		m_firstDescriptorHandle = DescriptorHandle(
-			m_curDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
-			m_curDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+		m_curDescriptorHeap = m_sharedHeap.GetDescriptorHeap();
+		m_firstDescriptorHandle = m_sharedHeap.ReserveDynamicBlock();
 	}
 	return m_curDescriptorHeap;
 }
 
-void DynamicDescriptorHeap::RetireCurrentHeap() {
-	//never retire empty heap
-	if (m_currentOffset == 0) {
-		assert(m_curDescriptorHeap == nullptr);
+void DynamicDescriptorHeap::RetireCurrentBlock() {
+	if (m_curDescriptorHeap == nullptr) {
+		assert(m_currentOffset == 0);
 		return;
 	}
-	assert(m_curDescriptorHeap != nullptr);
-	m_retiredDescriptorHeaps.push_back(m_curDescriptorHeap);
-	//refresh the descriptor heap
+	m_retiredBlocks.push_back(m_firstDescriptorHandle);
+	//the next block is in the same heap, so the bound heap and the tables in the retired block stay valid
 	m_curDescriptorHeap = nullptr;
 	m_currentOffset = 0;
 }
 
-void DynamicDescriptorHeap::RetireUsedHeaps(uint64_t fenceValue) {
-	//discard all the retired descriptor heaps
-	DynamicDescriptorsManager::Instance().DiscardDescriptors(m_descriptorHeapType, fenceValue, m_retiredDescriptorHeaps);
-	m_retiredDescriptorHeaps.clear();
+void DynamicDescriptorHeap::RetireUsedBlocks(uint64_t fenceValue) {
+	//the blocks are reused after the command list finished
+	for (auto iter = m_retiredBlocks.begin(); iter != m_retiredBlocks.end(); iter++)
+		m_sharedHeap.RetireDynamicBlock(*iter, fenceValue);
+	m_retiredBlocks.clear();
+}
+
+bool DynamicDescriptorHeap::FindCachedTable(uint64_t tableHash, uint32_t assignedBitMap, uint32_t handlesCount,
+	const D3D12_CPU_DESCRIPTOR_HANDLE handles[], DescriptorHandle& tableHandle) {
+	auto iter = m_cachedTables.find(tableHash);
+	if (iter == m_cachedTables.end())
+		return false;
+
+	//compare the source handles, a hash collision is treated as a miss
+	const CachedDescriptorTable& cachedTable = iter->second;
+	if (cachedTable.m_assignedBitMap != assignedBitMap || cachedTable.m_handlesCount != handlesCount)
+		return false;
+	const D3D12_CPU_DESCRIPTOR_HANDLE* cachedHandles = m_cachedTableHandles.data() + cachedTable.m_firstHandle;
+	for (uint32_t i = 0; i < handlesCount; ++i) {
+		if (cachedHandles[i].ptr != handles[i].ptr)
+			return false;
+	}
+
+	tableHandle = cachedTable.m_tableHandle;
+	return true;
+}
+
+void DynamicDescriptorHeap::InsertCachedTable(uint64_t tableHash, uint32_t assignedBitMap, uint32_t handlesCount,
+	const D3D12_CPU_DESCRIPTOR_HANDLE handles[], DescriptorHandle tableHandle) {
+	CachedDescriptorTable cachedTable;
+	cachedTable.m_tableHandle = tableHandle;
+	cachedTable.m_assignedBitMap = assignedBitMap;
+	cachedTable.m_firstHandle = (uint32_t)m_cachedTableHandles.size();
+	cachedTable.m_handlesCount = handlesCount;
+	m_cachedTableHandles.insert(m_cachedTableHandles.end(), handles, handles + handlesCount);
+	//the newest copy replaces the collided one
+	m_cachedTables[tableHash] = cachedTable;
 }
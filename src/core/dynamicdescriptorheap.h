@@ -3,14 +3,38 @@
 #include <mutex>
 #include <vector>
 #include <string>
-#include <queue>
+#include <unordered_map>
 #include <d3d12.h>
 #include <wrl/client.h>
 #include "descriptortypes.h"
+#include "descriptorhandlescache.h"
 #include "rootsignature.h"
+#include "staticdecriptorheap.h"
 
 class Context;
 
+//the hit rate of the descriptor table cache
+struct DescriptorTableCacheStats
+{
+	uint64_t m_hitCount = 0;
+	uint64_t m_missCount = 0;
+	//the descriptors copied to the shader visible heaps, and the copies skipped by the hits
+	uint64_t m_copiedDescriptors = 0;
+	uint64_t m_skippedDescriptors = 0;
+
+	float GetHitRate() const {
+		uint64_t lookupCount = m_hitCount + m_missCount;
+		return lookupCount == 0 ? 0.0f : (float)m_hitCount / (float)lookupCount;
+	}
+	void Accumulate(const DescriptorTableCacheStats& stats) {
+		m_hitCount += stats.m_hitCount;
+		m_missCount += stats.m_missCount;
+		m_copiedDescriptors += stats.m_copiedDescriptors;
+		m_skippedDescriptors += stats.m_skippedDescriptors;
+	}
+};
+
+//the dynamic descriptor tables of all the contexts live in the dynamic blocks of the global shader visible heaps
 class DynamicDescriptorsManager
 {
 public:
@@ -19,62 +43,21 @@ public:
 		return instance;
 	}
 
-	ID3D12DescriptorHeap* RequestDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE heapType);
-
-	void DiscardDescriptors(
-		D3D12_DESCRIPTOR_HEAP_TYPE heapType,
-		uint64_t fenceValue, 
-		const std::vector<ID3D12DescriptorHeap*>& usedHeaps);
+	//the contexts report the table cache stats when their command lists are finished
+	void ReportTableCacheStats(const DescriptorTableCacheStats& stats);
+	DescriptorTableCacheStats GetTableCacheStats();
+	void ResetTableCacheStats();
 
 private:
 	DynamicDescriptorsManager(){}
 	DynamicDescriptorsManager(const DynamicDescriptorsManager& copy) = delete;
 	DynamicDescriptorsManager& operator=(const DynamicDescriptorsManager& v) = delete;
-	uint32_t GetDescriptorHeapIdx(D3D12_DESCRIPTOR_HEAP_TYPE heapType);
 
 private:
 	std::mutex m_mutex;
-	std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> m_descriptorHeapsPool[2];
-	std::queue<std::pair<uint32_t, ID3D12DescriptorHeap*>> m_retiredDescriptorHeap[2];
-	std::queue<ID3D12DescriptorHeap*> m_availableHeap[2];
+	DescriptorTableCacheStats m_tableCacheStats;
 };
 
-//the dynamic descriptors cache structure only consider about the descriptors tables
-//the other descriptor we can bind directly to the commandlist.
-struct DescriptorHandlesCache
-{
-	DescriptorHandlesCache();
-
-	//compute the descriptors size need in a descriptor heap
-	uint32_t ComputeAssignedDescriptorsSize();
-	//store the descriptors handle to current cache
-	void StoreDescriptorsCPUHandles(UINT rootIndex, UINT offset, UINT handlesCount, const D3D12_CPU_DESCRIPTOR_HANDLE descriptorsHandleList[]);
-	//copy the descriptors handles in current cache to a descriptor heaps
-	void CommitDescriptorHandleToDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t descriptorsSize,
-		DescriptorHandle dstHandleStart, ID3D12GraphicsCommandList* cmdList,
-		void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::* SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE));
-	//analysis the root signature and only consider the descriptors tables
-	void ParseRootSignature(D3D12_DESCRIPTOR_HEAP_TYPE type, const RootSignature& rootSig);
-	//clear current cache
-	void ReleaseCaches();
-
-	//the max number of descriptors and descriptor tables
-	static const uint32_t maxNumDescriptors = 256; 
-	static const uint32_t maxNumDescriptorTables = 16;
-
-	//the bit map of descriptor table in current root signature 
-	uint32_t m_rootDescriptorTablesBitMap = 0;
-	//the non empty slot of current root signature
-	uint32_t m_assignedRootParamsBitMap = 0;
-	//record the information of descriptor table in root signature
-	DescriptorTableEntry m_rootDescriptorTable[maxNumDescriptorTables];
-	//store the descriptor of descriptors table in a linear way
-	D3D12_CPU_DESCRIPTOR_HANDLE m_descriptors[maxNumDescriptors];
-	//the descriptor number
-	uint32_t m_cachedDescriptorsNum = 0;
-};
-
-
 class DynamicDescriptorHeap
 {
 public: 
@@ -95,27 +78,57 @@ public:
 	//bypass the cache and upload directly to the shader-visible heap
 	D3D12_GPU_DESCRIPTOR_HANDLE UploadDirect(D3D12_CPU_DESCRIPTOR_HANDLE handles);
 
+	const DescriptorTableCacheStats& GetTableCacheStats() const { return m_tableCacheStats; }
 
 private:
 	void CommittedDescriptorTables(DescriptorHandlesCache& handleCache, ID3D12GraphicsCommandList* cmdList,
 		void (STDMETHODCALLTYPE ID3D12GraphicsCommandList::*SetFunc)(UINT, D3D12_GPU_DESCRIPTOR_HANDLE));
+	//the tables bound before are invalid when the context binds another heap
+	void InvalidateTablesOnHeapChange(DescriptorHandlesCache& handleCache);
+	//the table bit map of the heap type
+	uint32_t GetTablesBitMap(const RootSignature& rootSignature) const;
 	DescriptorHandle Allocate(UINT count);
 	bool HasFreeSpace(UINT count);
 	ID3D12DescriptorHeap* GetHeapPointer();
-	void RetireCurrentHeap();
-	void RetireUsedHeaps(uint64_t fenceValue);
+	//the retired blocks stay referenced by the command list until the fence completed
+	void RetireCurrentBlock();
+	void RetireUsedBlocks(uint64_t fenceValue);
+	//find the table copied to the blocks of current command list before, the hash is computed from the source cpu handles
+	bool FindCachedTable(uint64_t tableHash, uint32_t assignedBitMap, uint32_t handlesCount,
+		const D3D12_CPU_DESCRIPTOR_HANDLE handles[], DescriptorHandle& tableHandle);
+	void InsertCachedTable(uint64_t tableHash, uint32_t assignedBitMap, uint32_t handlesCount,
+		const D3D12_CPU_DESCRIPTOR_HANDLE handles[], DescriptorHandle tableHandle);
+
+	//the table copied to a block, its source handles are kept to reject the hash collisions
+	struct CachedDescriptorTable
+	{
+		DescriptorHandle m_tableHandle;
+		uint32_t m_assignedBitMap;
+		uint32_t m_firstHandle;
+		uint32_t m_handlesCount;
+	};
 
 private: 
 	Context& m_owningContext;
-	static const uint32_t kNumDescriptorsPerHeap = 1024;
 	DescriptorHandlesCache m_graphicsDescriptorsCache;
 	DescriptorHandlesCache m_computeDescriptorsCache;
 
+	//the global heap owning the dynamic blocks
+	StaticDescriptorHeap& m_sharedHeap;
+	//null when no block is reserved
 	ID3D12DescriptorHeap* m_curDescriptorHeap;
-	std::vector<ID3D12DescriptorHeap*> m_retiredDescriptorHeaps;
+	std::vector<DescriptorHandle> m_retiredBlocks;
 
 	uint32_t m_descriptorSize;
 	uint32_t m_currentOffset;
 	DescriptorHandle m_firstDescriptorHandle;
 	D3D12_DESCRIPTOR_HEAP_TYPE m_descriptorHeapType;
+
+	//the tables copied to the blocks of current command list, cleared when the command list is finished
+	//a hit assumes the views behind the source handles are not rewritten while the command list is recorded
+	//the freed cpu descriptors are reused immediately, so the tables are also cleared when a descriptor was freed
+	std::unordered_map<uint64_t, CachedDescriptorTable> m_cachedTables;
+	uint64_t m_cachedFreeGeneration;
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_cachedTableHandles;
+	DescriptorTableCacheStats m_tableCacheStats;
 };
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+//Fenced Reservoir
+//the global store behind the thread magazines of a recycling pool
+//the retired items wait for their fences, the ready items are taken and given back in batches
+//so the lock is taken once for a batch, not once for each item
+//the reservoir does not touch the device, so it can be tested and benchmarked alone
+template<typename T>
+class FencedReservoir
+{
+public:
+	struct RetiredItem
+	{
+		uint64_t m_fenceValue;
+		T* m_item;
+	};
+
+	FencedReservoir() : m_generation(NextGeneration()) {}
+
+	FencedReservoir(const FencedReservoir&) = delete;
+	FencedReservoir& operator=(const FencedReservoir&) = delete;
+
+	//the items are ready after their fences completed
+	void Retire(const RetiredItem items[], uint32_t count) {
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_retiredItems.insert(m_retiredItems.end(), items, items + count);
+	}
+
+	void Retire(uint64_t fenceValue, T* item) {
+		RetiredItem retiredItem = { fenceValue, item };
+		Retire(&retiredItem, 1);
+	}
+
+	//give back the items ready to be used
+	void GiveBack(T* const items[], uint32_t count) {
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_readyItems.insert(m_readyItems.end(), items, items + count);
+	}
+
+	//retire the batch of the caller, move the completed items to the ready items when they are short
+	//then take up to maxCount of them, all under one lock
+	//return the count of the items written into items
+	template<typename FenceCompleteFunc>
+	uint32_t Take(FenceCompleteFunc isFenceComplete, T* items[], uint32_t maxCount,
+		const RetiredItem retiredItems[] = nullptr, uint32_t retiredCount = 0) {
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_retiredItems.insert(m_retiredItems.end(), retiredItems, retiredItems + retiredCount);
+
+		//the retired items come from several threads, so their fences are not in order
+		if (m_readyItems.size() < maxCount) {
+			size_t i = 0;
+			while (i < m_retiredItems.size()) {
+				if (isFenceComplete(m_retiredItems[i].m_fenceValue)) {
+					m_readyItems.push_back(m_retiredItems[i].m_item);
+					m_retiredItems[i] = m_retiredItems.back();
+					m_retiredItems.pop_back();
+				}
+				else {
+					++i;
+				}
+			}
+		}
+
+		uint32_t takenCount = 0;
+		while (takenCount < maxCount && !m_readyItems.empty()) {
+			items[takenCount++] = m_readyItems.back();
+			m_readyItems.pop_back();
+		}
+		return takenCount;
+	}
+
+	//drop all the items, the owner of the items releases them
+	//the magazines of the other threads can not be reached, they are dropped on their next use by the generation
+	void Clear() {
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_generation.store(NextGeneration());
+		m_retiredItems.clear();
+		m_readyItems.clear();
+	}
+
+	uint64_t GetGeneration() const { return m_generation.load(std::memory_order_relaxed); }
+
+	size_t GetRetiredCount() {
+		std::lock_guard<std::mutex> guard(m_mutex);
+		return m_retiredItems.size();
+	}
+	size_t GetReadyCount() {
+		std::lock_guard<std::mutex> guard(m_mutex);
+		return m_readyItems.size();
+	}
+
+private:
+	//the generations are unique among all the reservoirs, so a magazine never keeps the items of another reservoir
+	static uint64_t NextGeneration() {
+		static std::atomic<uint64_t> nextGeneration{ 1 };
+		return nextGeneration++;
+	}
+
+	std::atomic<uint64_t> m_generation;
+	//the vectors keep their capacity, so the steady state does not allocate
+	std::vector<RetiredItem> m_retiredItems;
+	std::vector<T*> m_readyItems;
+	std::mutex m_mutex;
+};
+
+//the items cached by one thread in front of a reservoir, the thread takes and gives back without lock
+template<typename T, uint32_t kSize>
+struct ThreadMagazine
+{
+	static const uint32_t kCapacity = kSize;
+	//the batch moved between the magazine and the reservoir
+	static const uint32_t kRefillCount = kSize / 2;
+
+	T* m_items[kSize];
+	uint32_t m_count = 0;
+	//the items retired by the thread, handed to the reservoir in one batch
+	typename FencedReservoir<T>::RetiredItem m_retiredItems[kRefillCount];
+	uint32_t m_retiredCount = 0;
+	//the generation of the reservoir when the magazine was filled, 0 for never
+	uint64_t m_generation = 0;
+
+	//the magazine was filled before the last Clear of the reservoir, its items were released with the owner
+	void Attach(const FencedReservoir<T>& reservoir) {
+		uint64_t generation = reservoir.GetGeneration();
+		if (m_generation != generation) {
+			m_generation = generation;
+			m_count = 0;
+			m_retiredCount = 0;
+		}
+	}
+
+	bool IsEmpty() const { return m_count == 0; }
+	bool IsFull() const { return m_count == kSize; }
+	T* Pop() { return m_items[--m_count]; }
+	void Push(T* item) { m_items[m_count++] = item; }
+
+	//the retired batch of the thread goes with the refill, so the thread can reuse its own items
+	template<typename FenceCompleteFunc>
+	uint32_t Refill(FencedReservoir<T>& reservoir, FenceCompleteFunc isFenceComplete) {
+		m_count += reservoir.Take(isFenceComplete, m_items + m_count, kRefillCount, m_retiredItems, m_retiredCount);
+		m_retiredCount = 0;
+		return m_count;
+	}
+
+	void Retire(FencedReservoir<T>& reservoir, uint64_t fenceValue, T* item) {
+		m_retiredItems[m_retiredCount].m_fenceValue = fenceValue;
+		m_retiredItems[m_retiredCount].m_item = item;
+		if (++m_retiredCount == kRefillCount) {
+			reservoir.Retire(m_retiredItems, m_retiredCount);
+			m_retiredCount = 0;
+		}
+	}
+
+	//give the oldest batch back, so the recently used items stay in the thread
+	void Drain(FencedReservoir<T>& reservoir) {
+		uint32_t drainCount = m_count;
+		if (drainCount > kRefillCount)
+			drainCount = kRefillCount;
+		reservoir.GiveBack(m_items, drainCount);
+		for (uint32_t i = drainCount; i < m_count; ++i)
+			m_items[i - drainCount] = m_items[i];
+		m_count -= drainCount;
+	}
+};
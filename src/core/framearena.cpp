@@ -0,0 +1,142 @@
+#include "framearena.h"
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+static size_t AlignUpSize(size_t value, size_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+FrameArena::FrameArena(size_t blockSize) :
+	m_block(nullptr), m_blockSize(blockSize), m_offset(0), m_overflowSize(0)
+{
+	m_block = static_cast<uint8_t*>(std::malloc(m_blockSize));
+	assert(m_block != nullptr);
+}
+
+FrameArena::~FrameArena()
+{
+	for (uint8_t* overflowBlock : m_overflowBlocks)
+		std::free(overflowBlock);
+	m_overflowBlocks.clear();
+	std::free(m_block);
+	m_block = nullptr;
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	assert((alignment & (alignment - 1)) == 0);
+	if (size == 0)
+		size = 1;
+
+	uintptr_t blockBase = reinterpret_cast<uintptr_t>(m_block);
+	size_t offset = m_offset.load(std::memory_order_relaxed);
+	for (;;) {
+		size_t alignedOffset = AlignUpSize(blockBase + offset, alignment) - blockBase;
+		size_t endOffset = alignedOffset + size;
+		if (endOffset > m_blockSize)
+			return AllocateOverflow(size, alignment);
+		if (m_offset.compare_exchange_weak(offset, endOffset, std::memory_order_relaxed))
+			return m_block + alignedOffset;
+	}
+}
+
+void* FrameArena::AllocateOverflow(size_t size, size_t alignment)
+{
+	std::lock_guard<std::mutex> lockGuard(m_overflowMutex);
+
+	//the vector growth should not be counted by the heap guard
+	if (m_overflowBlocks.size() == m_overflowBlocks.capacity())
+		m_overflowBlocks.reserve(m_overflowBlocks.empty() ? 8 : m_overflowBlocks.size() * 2);
+
+	uint8_t* overflowBlock = static_cast<uint8_t*>(std::malloc(size + alignment));
+	assert(overflowBlock != nullptr);
+	m_overflowBlocks.push_back(overflowBlock);
+	m_overflowSize += size + alignment;
+
+	uintptr_t address = AlignUpSize(reinterpret_cast<uintptr_t>(overflowBlock), alignment);
+	return reinterpret_cast<void*>(address);
+}
+
+void FrameArena::Reset()
+{
+	std::lock_guard<std::mutex> lockGuard(m_overflowMutex);
+
+	//grow the block, so the same workload fits in one block next time
+	if (!m_overflowBlocks.empty()) {
+		for (uint8_t* overflowBlock : m_overflowBlocks)
+			std::free(overflowBlock);
+		m_overflowBlocks.clear();
+
+		std::free(m_block);
+		m_blockSize = AlignUpSize(m_blockSize + m_overflowSize, kDefaultBlockSize);
+		m_block = static_cast<uint8_t*>(std::malloc(m_blockSize));
+		assert(m_block != nullptr);
+	}
+	m_overflowSize = 0;
+	m_offset.store(0, std::memory_order_relaxed);
+}
+
+void FrameArenaManager::EndFrame()
+{
+	m_currentArena = (m_currentArena + 1) % kFrameArenaCount;
+	m_arenas[m_currentArena].Reset();
+}
+
+//the depth of the heap guard scopes on this thread
+static thread_local uint32_t t_heapGuardDepth = 0;
+
+FrameHeapGuard::FrameHeapGuard()
+{
+	t_heapGuardDepth++;
+}
+
+FrameHeapGuard::~FrameHeapGuard()
+{
+	assert(t_heapGuardDepth > 0);
+	t_heapGuardDepth--;
+}
+
+bool FrameHeapGuard::IsActive()
+{
+	return t_heapGuardDepth > 0;
+}
+
+#if defined(GLIMMER_FRAME_HEAP_ASSERT)
+
+//replace the global heap operators, any allocation inside a guarded scope is a bug
+void* operator new(size_t size)
+{
+	assert(!FrameHeapGuard::IsActive() && "global heap allocation inside the frame heap guard");
+	void* memory = std::malloc(size == 0 ? 1 : size);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+#endif
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+//Frame Arena
+//a bump allocator for the transient cpu data of one frame
+//all the allocations are dropped together when the arena is reset, there is no per allocation free
+class FrameArena
+{
+public:
+	static const size_t kDefaultBlockSize = 0x10000; //64kb
+
+	FrameArena(size_t blockSize = kDefaultBlockSize);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	//lock-free inside the block, the overflow allocations take the lock
+	void* Allocate(size_t size, size_t alignment);
+	//drop all the allocations, the overflow of last use is merged into a larger block
+	void Reset();
+
+	size_t GetUsedSize() const { return m_offset.load(std::memory_order_relaxed) + m_overflowSize; }
+	size_t GetCapacity() const { return m_blockSize; }
+
+private:
+	void* AllocateOverflow(size_t size, size_t alignment);
+
+	uint8_t* m_block;
+	size_t m_blockSize;
+	std::atomic<size_t> m_offset;
+
+	//the block is full, the allocations fall back to the dedicated memory
+	std::vector<uint8_t*> m_overflowBlocks;
+	size_t m_overflowSize;
+	std::mutex m_overflowMutex;
+};
+
+//Frame Arena Manager
+//the arenas are double buffered, so the data of last frame is still valid in the current frame
+class FrameArenaManager
+{
+public:
+	static const uint32_t kFrameArenaCount = 2;
+
+	static FrameArenaManager& Instance() {
+		static FrameArenaManager instance;
+		return instance;
+	}
+
+	FrameArena& GetCurrentArena() { return m_arenas[m_currentArena]; }
+	void* Allocate(size_t size, size_t alignment) { return GetCurrentArena().Allocate(size, alignment); }
+
+	//switch to the next arena and reset it, called once at the end of the frame
+	void EndFrame();
+
+private:
+	FrameArenaManager() : m_currentArena(0) {}
+
+	FrameArena m_arenas[kFrameArenaCount];
+	uint32_t m_currentArena;
+};
+
+//STL allocator adaptor
+//the container keeps the arena it was created with, deallocate does nothing
+template<typename T>
+class FrameArenaSTLAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameArenaSTLAllocator() : m_arena(&FrameArenaManager::Instance().GetCurrentArena()) {}
+	explicit FrameArenaSTLAllocator(FrameArena& arena) : m_arena(&arena) {}
+	template<typename U>
+	FrameArenaSTLAllocator(const FrameArenaSTLAllocator<U>& other) : m_arena(other.GetArena()) {}
+
+	T* allocate(size_t count) {
+		return static_cast<T*>(m_arena->Allocate(count * sizeof(T), alignof(T)));
+	}
+	void deallocate(T*, size_t) {}
+
+	FrameArena* GetArena() const { return m_arena; }
+
+private:
+	FrameArena* m_arena;
+};
+
+template<typename T, typename U>
+bool operator==(const FrameArenaSTLAllocator<T>& lhs, const FrameArenaSTLAllocator<U>& rhs) {
+	return lhs.GetArena() == rhs.GetArena();
+}
+
+template<typename T, typename U>
+bool operator!=(const FrameArenaSTLAllocator<T>& lhs, const FrameArenaSTLAllocator<U>& rhs) {
+	return !(lhs == rhs);
+}
+
+template<typename T>
+using FrameVector = std::vector<T, FrameArenaSTLAllocator<T>>;
+
+//Frame Heap Guard
+//mark a scope which should not touch the global heap
+//with GLIMMER_FRAME_HEAP_ASSERT defined, the global operator new asserts inside the scope
+class FrameHeapGuard
+{
+public:
+	FrameHeapGuard();
+	~FrameHeapGuard();
+
+	FrameHeapGuard(const FrameHeapGuard&) = delete;
+	FrameHeapGuard& operator=(const FrameHeapGuard&) = delete;
+
+	static bool IsActive();
+};
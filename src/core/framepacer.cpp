@@ -0,0 +1,75 @@
+#include "framepacer.h"
+#include <algorithm>
+#include <cassert>
+
+FramePacer::FramePacer()
+	: m_framesInFlight(1), m_frameIndex(0), m_stallCount(0), m_inFrame(false)
+{
+	for (uint32_t i = 0; i < kMaxFramesInFlight; ++i) {
+		for (uint32_t j = 0; j < kQueueTypeCount; ++j)
+			m_slots[i].m_fences[j] = 0;
+	}
+}
+
+void FramePacer::Initialize(uint32_t framesInFlight, const FenceCompleteFunc& isFenceComplete, const FenceWaitFunc& waitForFence)
+{
+	assert(framesInFlight > 0 && framesInFlight <= kMaxFramesInFlight);
+	assert(!m_inFrame);
+	//the slots of the old frame count are drained before they are remapped
+	WaitForAllFrames();
+	m_framesInFlight = framesInFlight;
+	m_isFenceComplete = isFenceComplete;
+	m_waitForFence = waitForFence;
+}
+
+void FramePacer::BeginFrame()
+{
+	assert(!m_inFrame);
+	if (WaitForSlot(m_slots[GetFrameSlot()]))
+		m_stallCount++;
+	m_inFrame = true;
+}
+
+void FramePacer::AddFrameFence(uint64_t fenceValue)
+{
+	assert(m_inFrame);
+	uint32_t queueIndex = (uint32_t)(fenceValue >> 56);
+	assert(queueIndex < kQueueTypeCount);
+	uint64_t& slotFence = m_slots[GetFrameSlot()].m_fences[queueIndex];
+	slotFence = std::max(slotFence, fenceValue);
+}
+
+void FramePacer::EndFrame()
+{
+	assert(m_inFrame);
+	m_inFrame = false;
+	m_frameIndex++;
+}
+
+void FramePacer::WaitForAllFrames()
+{
+	for (uint32_t i = 0; i < m_framesInFlight; ++i)
+		WaitForSlot(m_slots[i]);
+}
+
+uint64_t FramePacer::GetSlotFence(uint32_t slot, uint32_t queueIndex) const
+{
+	assert(slot < m_framesInFlight && queueIndex < kQueueTypeCount);
+	return m_slots[slot].m_fences[queueIndex];
+}
+
+bool FramePacer::WaitForSlot(FrameSlot& slot)
+{
+	bool stalled = false;
+	for (uint32_t i = 0; i < kQueueTypeCount; ++i) {
+		uint64_t fenceValue = slot.m_fences[i];
+		if (fenceValue == 0)
+			continue;
+		if (!m_isFenceComplete(fenceValue)) {
+			m_waitForFence(fenceValue);
+			stalled = true;
+		}
+		slot.m_fences[i] = 0;
+	}
+	return stalled;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+//Frame Pacer
+//the cpu records the next frames while the gpu executes the older ones
+//each frame in flight has a fence slot, which keeps the last fence of every queue submitted in the frame
+//the cpu waits only when it is going to reuse the slot of a frame the gpu has not finished
+//the pacer does not touch the device, the fences are checked through the callbacks
+//called from the main thread only
+class FramePacer
+{
+public:
+	static const uint32_t kMaxFramesInFlight = 8;
+	//direct, bundle, compute and copy
+	static const uint32_t kQueueTypeCount = 4;
+
+	typedef std::function<bool(uint64_t)> FenceCompleteFunc;
+	typedef std::function<void(uint64_t)> FenceWaitFunc;
+
+	FramePacer();
+
+	void Initialize(uint32_t framesInFlight, const FenceCompleteFunc& isFenceComplete, const FenceWaitFunc& waitForFence);
+
+	//wait until the gpu finished the frame which used the slot of the new frame
+	void BeginFrame();
+	//a submission of the current frame, the queue is in the top byte of the fence value
+	void AddFrameFence(uint64_t fenceValue);
+	void EndFrame();
+
+	//wait for all the frames in flight
+	void WaitForAllFrames();
+
+	uint64_t GetFrameIndex() const { return m_frameIndex; }
+	uint32_t GetFrameSlot() const { return (uint32_t)(m_frameIndex % m_framesInFlight); }
+	uint32_t GetFramesInFlight() const { return m_framesInFlight; }
+	//the fence of the queue in the slot, 0 if the frame did not submit to the queue
+	uint64_t GetSlotFence(uint32_t slot, uint32_t queueIndex) const;
+	//the count of the frames whose begin waited for the gpu
+	uint64_t GetStallCount() const { return m_stallCount; }
+
+private:
+	struct FrameSlot
+	{
+		uint64_t m_fences[kQueueTypeCount];
+	};
+
+	//wait for the fences of the slot and clear it, return true if the cpu had to wait
+	bool WaitForSlot(FrameSlot& slot);
+
+	FenceCompleteFunc m_isFenceComplete;
+	FenceWaitFunc m_waitForFence;
+	FrameSlot m_slots[kMaxFramesInFlight];
+	uint32_t m_framesInFlight;
+	uint64_t m_frameIndex;
+	uint64_t m_stallCount;
+	bool m_inFrame;
+};
@@ -17,19 +17,21 @@ PBRMaterial::PBRMaterial(const std::string& albedo, const std::string& normal,
     //ResourceInitialize();
 }
 
-std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> PBRMaterial::GetSamplerSRVArray() {
-    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> srvArray;
-    srvArray.push_back(GRAPHICS_CORE::g_samplerAnisoWrap);
-    srvArray.push_back(GRAPHICS_CORE::g_samplerAnisoWrap);
-    srvArray.push_back(GRAPHICS_CORE::g_samplerAnisoWrap);
-    srvArray.push_back(GRAPHICS_CORE::g_samplerAnisoWrap);
-    srvArray.push_back(GRAPHICS_CORE::g_samplerAnisoWrap);
-    return srvArray;
+void PBRMaterial::GetSamplerDescs(D3D12_SAMPLER_DESC descs[kSamplersNum]) {
+    for (uint32_t i = 0; i < kSamplersNum; ++i)
+        descs[i] = GRAPHICS_CORE::g_samplerAnisoWrapDesc;
+}
+
+uint32_t PBRMaterial::GetSamplerTableIndex() {
+    D3D12_SAMPLER_DESC descs[kSamplersNum];
+    GetSamplerDescs(descs);
+    return GRAPHICS_CORE::g_samplerManager.GetSamplerTableIndex(descs, kSamplersNum);
 }
 
-std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> PBRMaterial::GetTextureSRVArray()
+FrameVector<D3D12_CPU_DESCRIPTOR_HANDLE> PBRMaterial::GetTextureSRVArray()
 {
-    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> srvArray;
+    FrameVector<D3D12_CPU_DESCRIPTOR_HANDLE> srvArray;
+    srvArray.reserve(5);
     srvArray.push_back(m_albedoTexture.GetSRV());
     srvArray.push_back(m_normalTexture.GetSRV());
     srvArray.push_back(m_roughnessTexture.GetSRV());
@@ -48,9 +50,12 @@ void PBRMaterial::ResourceLoading() {
 
 void PBRMaterial::ResourceInitialize()
 {
+    //give back the descriptors of last initialization
+    if (m_materialHandle.IsShaderVisible())
+        GRAPHICS_CORE::g_texturesDescriptorHeap.Free(m_materialHandle, 5);
+
     //allocate descriptor handle
     m_materialHandle = GRAPHICS_CORE::g_texturesDescriptorHeap.Alloc(5);
-    m_samplerHandle = GRAPHICS_CORE::g_samplersDescriptorHeap.Alloc(1);
 
     //texture loading process
     D3D12_CPU_DESCRIPTOR_HANDLE textures[] = {
@@ -67,16 +72,10 @@ void PBRMaterial::ResourceInitialize()
     GRAPHICS_CORE::g_device->CopyDescriptors(1, &m_materialHandle, &texturesDestNum, texturesDestNum, 
         textures, texturesSrcNums, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-    UINT samplerDestNum = 1;
-    UINT samplerSrcNums[] = { 1 };
-
-    //sampler loading process
-    D3D12_CPU_DESCRIPTOR_HANDLE samplers[] = {
-        GRAPHICS_CORE::g_samplerLinearWrap
-    };
-
-    GRAPHICS_CORE::g_device->CopyDescriptors(1, &m_samplerHandle, &samplerDestNum, samplerDestNum,
-        samplers, samplerSrcNums, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+    //the sampler table is shared with the other materials
+    D3D12_SAMPLER_DESC samplers[kSamplersNum];
+    GetSamplerDescs(samplers);
+    m_samplerHandle = GRAPHICS_CORE::g_samplerManager.GetSamplerTable(samplers, kSamplersNum);
 }
 
 MaterialManager::~MaterialManager() {
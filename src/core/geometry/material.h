@@ -3,6 +3,7 @@
 #include <string>
 #include "texturemanager.h"
 #include "descriptortypes.h"
+#include "framearena.h"
 #include <map>
 
 
@@ -16,8 +17,10 @@ class Material
 {
 public:
 	MATERIAL_TYPE GetMatType() { return m_matType; }
-	virtual std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> GetTextureSRVArray() = 0;
-	virtual std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> GetSamplerSRVArray() = 0;
+	//the arrays are transient, they live in the frame arena
+	virtual FrameVector<D3D12_CPU_DESCRIPTOR_HANDLE> GetTextureSRVArray() = 0;
+	//the samplers are shared by the materials, the table is referenced by its offset in the sampler heap
+	virtual uint32_t GetSamplerTableIndex() = 0;
 
 protected:
 	virtual void ResourceLoading() = 0;
@@ -37,14 +40,18 @@ public:
 	UINT64 GetTexturesGPUPtr() { return m_materialHandle.GetGPUPtr(); }
 	UINT64 GetSamplersGPUPtr() { return m_samplerHandle.GetGPUPtr(); }
 
-	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> GetTextureSRVArray() override;
-	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> GetSamplerSRVArray() override;
+	FrameVector<D3D12_CPU_DESCRIPTOR_HANDLE> GetTextureSRVArray() override;
+	uint32_t GetSamplerTableIndex() override;
 
 protected:
 	void ResourceLoading() override;
 	void ResourceInitialize() override;
 
 private:
+	//the samplers of the five textures
+	static const uint32_t kSamplersNum = 5;
+	void GetSamplerDescs(D3D12_SAMPLER_DESC descs[kSamplersNum]);
+
 	//texture path
 	std::string m_albedoPath;
 	std::string m_normalPath;
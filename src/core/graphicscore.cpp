@@ -1,13 +1,19 @@
 #include "graphicscore.h"
 #include "headers.h"
 #include "descriptorheapallocator.h"
+#include "rootsignature.h"
 #include "resources/depthbuffer.h"
 #include "resources/colorbuffer.h"
+#include "window.h"
 
 
 namespace GRAPHICS_CORE
 {
 	TextureManager g_textureManager;
+	SamplerManager g_samplerManager;
+	PipelineStateCache g_pipelineStateCache;
+	TaskPool g_taskPool;
+	FramePacer g_framePacer;
 	CommandManager g_commandManager;
 	ContextManager g_contextManager;
 	MaterialManager g_materialManager;
@@ -20,8 +26,11 @@ namespace GRAPHICS_CORE
 
 	ID3D12Device* g_device = nullptr;
 	bool g_tearingSupport;
+	//one frame for each back buffer by default
+	uint32_t g_framesInFlight = Window::BufferCount;
 
 	std::string g_texturePath = "resource/textures/";
+	std::string g_pipelineCachePath = "pipelinecache.bin";
 	std::string g_pbrmaterialTextureName[5] = {
 		"alebdo", "normal", "roughness", "metalness", "ao"
 	};
@@ -45,6 +54,90 @@ namespace GRAPHICS_CORE
 		D3D12_DESCRIPTOR_HEAP_TYPE_DSV
 	};
 
+	//the resources wait for the gpu before released
+	//the resource is pushed to the queue of every command queue still using it, and released by the last one
+	struct DeferredResource
+	{
+		ID3D12Resource* m_resource;
+		PlacedAllocation m_placedAllocation;
+		std::atomic<uint32_t> m_pendingQueues;
+	};
+	DeferredReleaseQueue<DeferredResource> g_deferredResources[CommandManager::kQueueCount];
+
+	static void ReleaseResource(DeferredResource* deferredResource)
+	{
+		if (deferredResource->m_pendingQueues.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+		deferredResource->m_resource->Release();
+		PlacedHeapAllocator::Instance().Free(deferredResource->m_placedAllocation);
+		delete deferredResource;
+	}
+
+	void DeferredReleaseResource(ID3D12Resource* resource, const PlacedAllocation& placedAllocation)
+	{
+		DeferredResource* deferredResource = new DeferredResource{ resource, placedAllocation, {1} };
+
+		//the gpu is idle or released, release the resource immediately
+		if (g_device == nullptr) {
+			ReleaseResource(deferredResource);
+			return;
+		}
+
+		//the contexts are submitted to the queues of their types
+		//the resource should not be destroyed while any queue may still use it
+		uint64_t fenceValues[CommandManager::kQueueCount];
+		g_commandManager.GetLastSubmittedFences(fenceValues);
+		uint32_t pendingQueues = 0;
+		bool pending[CommandManager::kQueueCount];
+		for (uint32_t i = 0; i < CommandManager::kQueueCount; ++i) {
+			pending[i] = !g_commandManager.IsFenceComplete(fenceValues[i]);
+			if (pending[i])
+				pendingQueues++;
+		}
+		if (pendingQueues == 0) {
+			ReleaseResource(deferredResource);
+			return;
+		}
+
+		//the count is set before any push, so a queue retiring early does not release it
+		deferredResource->m_pendingQueues.store(pendingQueues, std::memory_order_relaxed);
+		for (uint32_t i = 0; i < CommandManager::kQueueCount; ++i) {
+			if (pending[i])
+				g_deferredResources[i].Push(fenceValues[i], deferredResource);
+		}
+	}
+
+	void ReleaseDeferredResources()
+	{
+		for (uint32_t i = 0; i < CommandManager::kQueueCount; ++i) {
+			g_deferredResources[i].Retire(
+				[](uint64_t fenceValue) { return g_commandManager.IsFenceComplete(fenceValue); },
+				ReleaseResource);
+		}
+		g_texturesDescriptorHeap.ReleaseRetiredDescriptors();
+		g_samplersDescriptorHeap.ReleaseRetiredDescriptors();
+	}
+
+	void BeginFrame()
+	{
+		g_framePacer.BeginFrame();
+	}
+
+	void EndFrame()
+	{
+		//the queues run in order, so the last fence covers all the submissions of the frame
+		uint64_t fenceValues[CommandManager::kQueueCount];
+		g_commandManager.GetLastSubmittedFences(fenceValues);
+		for (uint32_t i = 0; i < CommandManager::kQueueCount; ++i)
+			g_framePacer.AddFrameFence(fenceValues[i]);
+		g_framePacer.EndFrame();
+	}
+
+	uint64_t GetResourceAllocationSize(const D3D12_RESOURCE_DESC& desc)
+	{
+		return g_device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+	}
+
 	UINT32 GetDescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE type)
 	{
 		return GRAPHICS_CORE::g_device->GetDescriptorHandleIncrementSize(type);
@@ -55,6 +148,13 @@ namespace GRAPHICS_CORE
 		return g_descriptorHeapAllocator[type].Allocator(count);
 	}
 
+	void FreeDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE type, D3D12_CPU_DESCRIPTOR_HANDLE handle, UINT count)
+	{
+		//the heaps are destroyed with the device
+		if (g_device != nullptr)
+			g_descriptorHeapAllocator[type].Free(handle, count);
+	}
+
 	//Get the adapter from current computer
 	ComPtr<IDXGIAdapter4> GainAdapter(bool bUseWarp) {
 		ComPtr<IDXGIFactory4> dxgiFactory;
@@ -180,6 +280,21 @@ namespace GRAPHICS_CORE
 		g_samplerPointBorder = g_samplerPointBorderDesc.CreateSamplerDescHandle();
 	}
 
+	//the caches and pools trim themselves before the budget is hit
+	void MemoryBudgetInitialize(ComPtr<IDXGIAdapter4> adapter) {
+		DXGI_QUERY_VIDEO_MEMORY_INFO videoMemoryInfo = {};
+		if (adapter && SUCCEEDED(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &videoMemoryInfo)))
+			MemoryBudgetManager::Instance().SetTotalBudget(videoMemoryInfo.Budget);
+
+		MemoryBudgetManager::Instance().RegisterPressureCallback(MEMORY_CATEGORY_UPLOAD,
+			[](const MemoryPressureEvent&) { DynamicLinearMemoryAllocator::TrimPages(0); });
+		//the gpu linear pages are default buffers
+		MemoryBudgetManager::Instance().RegisterPressureCallback(MEMORY_CATEGORY_BUFFER,
+			[](const MemoryPressureEvent&) { DynamicLinearMemoryAllocator::TrimPages(0); });
+		MemoryBudgetManager::Instance().RegisterPressureCallback(MEMORY_CATEGORY_TEXTURE,
+			[](const MemoryPressureEvent&) { g_textureManager.TrimUnusedTextures(); });
+	}
+
 	void GraphicsCoreInitialize()
 	{
 		EnableDX12DebugLayer();
@@ -193,12 +308,16 @@ namespace GRAPHICS_CORE
 		if (GRAPHICS_CORE::g_device) {
 			//Update essential d3d12 device
 			GRAPHICS_CORE::g_commandManager.Initialize(GRAPHICS_CORE::g_device);
+			MemoryBudgetInitialize(dxgiAdapter);
 			GRAPHICS_CORE::g_textureManager.Initialize(g_texturePath);
 			SamplersInitialize();
+			GRAPHICS_CORE::g_pipelineStateCache.Initialize(GRAPHICS_CORE::g_device, g_pipelineCachePath);
 
 			//Create the descriptor heap for textures and samplers
-			GRAPHICS_CORE::g_texturesDescriptorHeap.Initialize(L"TextureDescriptorHeap", D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4096);
-			GRAPHICS_CORE::g_samplersDescriptorHeap.Initialize(L"SamplerDescriptorHeap", D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 2048);
+			//the static descriptors and the dynamic blocks of all the contexts share one heap each
+			//the shader visible sampler heap holds 2048 descriptors at most
+			GRAPHICS_CORE::g_texturesDescriptorHeap.Initialize(L"TextureDescriptorHeap", D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4096, 256, 64);
+			GRAPHICS_CORE::g_samplersDescriptorHeap.Initialize(L"SamplerDescriptorHeap", D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 1024, 64, 16);
 			
 			//Initialize the static model loading
 			GRAPHICS_CORE::g_staticModelsManager.Initialize();
@@ -210,11 +329,31 @@ namespace GRAPHICS_CORE
 			GRAPHICS_CORE::g_mipmapGenerator.Initialize();
 
 			g_tearingSupport = CheckTearingSupport();
+
+			//the caller thread joins the parallel loops, so one core is left for it
+			uint32_t coreCount = std::max(std::thread::hardware_concurrency(), 1u);
+			GRAPHICS_CORE::g_taskPool.Initialize(coreCount - 1);
+
+			GRAPHICS_CORE::g_framePacer.Initialize(g_framesInFlight,
+				[](uint64_t fenceValue) { return GRAPHICS_CORE::g_commandManager.IsFenceComplete(fenceValue); },
+				[](uint64_t fenceValue) { GRAPHICS_CORE::g_commandManager.WaitForFence(fenceValue); });
 		}
 	}
 
 	void GraphicsCoreRelease() {
 		if (GRAPHICS_CORE::g_device != nullptr) {
+			GRAPHICS_CORE::g_taskPool.Release();
+			//wait for the gpu, then release all the deferred resources
+			GRAPHICS_CORE::g_commandManager.Flush();
+			for (uint32_t i = 0; i < CommandManager::kQueueCount; ++i)
+				GRAPHICS_CORE::g_deferredResources[i].Flush(ReleaseResource);
+			GRAPHICS_CORE::g_contextManager.DestroyAllContexts();
+			GRAPHICS_CORE::g_samplerManager.Release();
+			GRAPHICS_CORE::g_pipelineStateCache.Release();
+			RootSignatureManager::Instance().Release();
+			for (UINT i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+				GRAPHICS_CORE::g_descriptorHeapAllocator[i].Destroy();
+
 			GRAPHICS_CORE::g_device->Release();
 			GRAPHICS_CORE::g_device = nullptr;
 		}
@@ -5,15 +5,25 @@
 #include "context.h"
 #include "descriptorheapallocator.h"
 #include "texturemanager.h"
+#include "samplermanager.h"
+#include "pipelinestatecache.h"
+#include "taskpool.h"
+#include "framepacer.h"
 #include "resources/samplerdesc.h"
 #include "geometry/model.h"
 #include "geometry/material.h"
 #include "staticdecriptorheap.h"
 #include "components/mipmapgenerator.h"
+#include "deferredreleasequeue.h"
+#include "memorybudget.h"
 
 namespace GRAPHICS_CORE
 {
 	extern TextureManager g_textureManager;
+	extern SamplerManager g_samplerManager;
+	extern PipelineStateCache g_pipelineStateCache;
+	extern TaskPool g_taskPool;
+	extern FramePacer g_framePacer;
 	extern CommandManager g_commandManager;
 	extern ContextManager g_contextManager;
 	extern StaticDescriptorHeap g_texturesDescriptorHeap;
@@ -24,12 +34,14 @@ namespace GRAPHICS_CORE
 
 	extern ID3D12Device* g_device;
 	extern bool g_tearingSupport;
+	extern uint32_t g_framesInFlight;
 
 	extern DescriptorAllocator g_descriptorHeapAllocator[];
 
 
 	//resource pathes
 	extern std::string g_texturePath;
+	extern std::string g_pipelineCachePath;
 	extern std::string g_pbrmaterialTextureName[5];
 
 
@@ -48,8 +60,17 @@ namespace GRAPHICS_CORE
 
 	void GraphicsCoreInitialize();
 	void GraphicsCoreRelease();
+	//release the destroyed resources whose fences completed, called once per frame
+	void ReleaseDeferredResources();
+	//the cpu waits in BeginFrame only when it is g_framesInFlight frames ahead of the gpu
+	//EndFrame puts the last fence of every queue into the slot of the frame
+	void BeginFrame();
+	void EndFrame();
+	uint64_t GetResourceAllocationSize(const D3D12_RESOURCE_DESC& desc);
 
 	D3D12_CPU_DESCRIPTOR_HANDLE AllocatorDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE type, UINT count = 1);
+	//the cpu descriptors are reusable immediately, the views are copied when the commands are recorded
+	void FreeDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE type, D3D12_CPU_DESCRIPTOR_HANDLE handle, UINT count = 1);
 	UINT32 GetDescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE type);
 	UINT GetDXGIFormatSize(DXGI_FORMAT format);
 
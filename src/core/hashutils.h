@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//64-bit fnv-1a, the hash of the caches keyed by the descs and of the pipeline blobs on the disk
+//the values do not depend on the run or the build, so they can be persisted
+static const uint64_t kFnv1aOffsetBasis = 0xcbf29ce484222325ull;
+static const uint64_t kFnv1aPrime = 0x100000001b3ull;
+
+//fnv-1a of the raw bytes, the hash can be continued over several buffers
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hashValue = kFnv1aOffsetBasis) {
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (size_t i = 0; i < size; ++i)
+		hashValue = (hashValue ^ bytes[i]) * kFnv1aPrime;
+	return hashValue;
+}
+
+inline uint64_t HashUint(uint32_t value, uint64_t hashValue) {
+	return HashBytes(&value, sizeof(uint32_t), hashValue);
+}
+
+//one fnv step for a whole word, faster than the bytes for the per-draw keys
+//the values differ from HashBytes, so they are for the caches in memory only
+inline uint64_t HashWord(uint64_t value, uint64_t hashValue = kFnv1aOffsetBasis) {
+	return (hashValue ^ value) * kFnv1aPrime;
+}
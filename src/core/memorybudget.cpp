@@ -0,0 +1,163 @@
+#include "memorybudget.h"
+#include <cassert>
+
+MemoryBudgetManager::MemoryBudgetManager() :
+	m_totalUsage(0), m_totalBudget(kUnlimitedBudget), m_pressureThreshold(0.9f),
+	m_pressureEvents(0), m_nextCallbackId(1)
+{
+	for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+		m_usage[i].store(0, std::memory_order_relaxed);
+		m_peakUsage[i].store(0, std::memory_order_relaxed);
+		m_budget[i].store(kUnlimitedBudget, std::memory_order_relaxed);
+	}
+}
+
+void MemoryBudgetManager::SetCategoryBudget(MemoryCategory category, uint64_t budget)
+{
+	assert(category < MEMORY_CATEGORY_COUNT);
+	m_budget[category].store(budget, std::memory_order_relaxed);
+}
+
+void MemoryBudgetManager::SetTotalBudget(uint64_t budget)
+{
+	m_totalBudget.store(budget, std::memory_order_relaxed);
+}
+
+void MemoryBudgetManager::SetPressureThreshold(float threshold)
+{
+	assert(threshold > 0.0f && threshold <= 1.0f);
+	m_pressureThreshold.store(threshold, std::memory_order_relaxed);
+}
+
+void MemoryBudgetManager::ReportAllocation(MemoryCategory category, uint64_t size)
+{
+	assert(category < MEMORY_CATEGORY_COUNT);
+	uint64_t usage = m_usage[category].fetch_add(size, std::memory_order_relaxed) + size;
+	m_totalUsage.fetch_add(size, std::memory_order_relaxed);
+
+	//record the peak usage
+	uint64_t peakUsage = m_peakUsage[category].load(std::memory_order_relaxed);
+	while (usage > peakUsage &&
+		!m_peakUsage[category].compare_exchange_weak(peakUsage, usage, std::memory_order_relaxed)) {}
+}
+
+void MemoryBudgetManager::ReportRelease(MemoryCategory category, uint64_t size)
+{
+	assert(category < MEMORY_CATEGORY_COUNT);
+	assert(m_usage[category].load(std::memory_order_relaxed) >= size);
+	m_usage[category].fetch_sub(size, std::memory_order_relaxed);
+	m_totalUsage.fetch_sub(size, std::memory_order_relaxed);
+}
+
+bool MemoryBudgetManager::CanAllocate(MemoryCategory category, uint64_t size) const
+{
+	uint64_t budget = m_budget[category].load(std::memory_order_relaxed);
+	uint64_t totalBudget = m_totalBudget.load(std::memory_order_relaxed);
+	return GetUsage(category) + size <= budget && GetTotalUsage() + size <= totalBudget;
+}
+
+uint32_t MemoryBudgetManager::RegisterPressureCallback(MemoryCategory category, const MemoryPressureCallback& callback)
+{
+	std::lock_guard<std::mutex> lockGuard(m_callbacksMutex);
+	uint32_t callbackId = m_nextCallbackId++;
+	m_callbacks.push_back(PressureCallbackEntry{ callbackId, category, callback });
+	return callbackId;
+}
+
+void MemoryBudgetManager::UnregisterPressureCallback(uint32_t callbackId)
+{
+	std::lock_guard<std::mutex> lockGuard(m_callbacksMutex);
+	for (auto iter = m_callbacks.begin(); iter != m_callbacks.end(); ++iter) {
+		if (iter->m_id == callbackId) {
+			m_callbacks.erase(iter);
+			return;
+		}
+	}
+}
+
+uint32_t MemoryBudgetManager::DispatchPressureCallbacks()
+{
+	//collect the events first, the callbacks release memory and change the usage
+	std::vector<MemoryPressureEvent> events;
+	for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+		uint64_t usage = GetUsage((MemoryCategory)i);
+		uint64_t budget = m_budget[i].load(std::memory_order_relaxed);
+		if (IsUnderPressure(usage, budget)) {
+			MemoryPressureEvent pressureEvent;
+			pressureEvent.m_category = (MemoryCategory)i;
+			pressureEvent.m_usage = usage;
+			pressureEvent.m_budget = budget;
+			pressureEvent.m_bytesOverThreshold = usage - GetThreshold(budget);
+			events.push_back(pressureEvent);
+		}
+	}
+
+	uint64_t totalUsage = GetTotalUsage();
+	uint64_t totalBudget = m_totalBudget.load(std::memory_order_relaxed);
+	if (IsUnderPressure(totalUsage, totalBudget)) {
+		MemoryPressureEvent pressureEvent;
+		pressureEvent.m_usage = totalUsage;
+		pressureEvent.m_budget = totalBudget;
+		pressureEvent.m_bytesOverThreshold = totalUsage - GetThreshold(totalBudget);
+		events.push_back(pressureEvent);
+	}
+
+	if (events.empty())
+		return 0;
+
+	//the callbacks may register or unregister callbacks, so they are invoked without the lock
+	std::vector<PressureCallbackEntry> callbacks;
+	{
+		std::lock_guard<std::mutex> lockGuard(m_callbacksMutex);
+		callbacks = m_callbacks;
+	}
+
+	for (const MemoryPressureEvent& pressureEvent : events) {
+		for (const PressureCallbackEntry& entry : callbacks) {
+			if (pressureEvent.m_category == MEMORY_CATEGORY_COUNT || pressureEvent.m_category == entry.m_category)
+				entry.m_callback(pressureEvent);
+		}
+	}
+
+	m_pressureEvents.fetch_add(events.size(), std::memory_order_relaxed);
+	return (uint32_t)events.size();
+}
+
+MemoryBudgetReport MemoryBudgetManager::GetReport() const
+{
+	MemoryBudgetReport report;
+	for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+		report.m_usage[i] = m_usage[i].load(std::memory_order_relaxed);
+		report.m_peakUsage[i] = m_peakUsage[i].load(std::memory_order_relaxed);
+		report.m_budget[i] = m_budget[i].load(std::memory_order_relaxed);
+	}
+	report.m_totalUsage = GetTotalUsage();
+	report.m_totalBudget = m_totalBudget.load(std::memory_order_relaxed);
+	report.m_pressureEvents = m_pressureEvents.load(std::memory_order_relaxed);
+	return report;
+}
+
+void MemoryBudgetManager::Reset()
+{
+	for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i) {
+		m_usage[i].store(0, std::memory_order_relaxed);
+		m_peakUsage[i].store(0, std::memory_order_relaxed);
+	}
+	m_totalUsage.store(0, std::memory_order_relaxed);
+	m_pressureEvents.store(0, std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> lockGuard(m_callbacksMutex);
+	m_callbacks.clear();
+}
+
+uint64_t MemoryBudgetManager::GetThreshold(uint64_t budget) const
+{
+	return (uint64_t)((double)budget * (double)m_pressureThreshold.load(std::memory_order_relaxed) + 0.5);
+}
+
+bool MemoryBudgetManager::IsUnderPressure(uint64_t usage, uint64_t budget) const
+{
+	if (budget == kUnlimitedBudget)
+		return false;
+	return usage > GetThreshold(budget);
+}
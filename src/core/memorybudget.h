@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+//the categories of the committed gpu memory
+enum MemoryCategory
+{
+	MEMORY_CATEGORY_TEXTURE = 0,
+	MEMORY_CATEGORY_BUFFER = 1, //geometry, the gpu linear allocation pages and the other default buffers
+	MEMORY_CATEGORY_UPLOAD = 2, //upload buffers, cpu linear allocation pages and readback buffers
+	MEMORY_CATEGORY_RENDER_TARGET = 3,
+	MEMORY_CATEGORY_DESCRIPTOR_HEAP = 4,
+	MEMORY_CATEGORY_COUNT = 5
+};
+
+//the information passed to the pressure callbacks
+struct MemoryPressureEvent
+{
+	MemoryCategory m_category = MEMORY_CATEGORY_COUNT; //MEMORY_CATEGORY_COUNT means the total budget
+	uint64_t m_usage = 0;
+	uint64_t m_budget = 0;
+	//the bytes to release to go back under the pressure threshold
+	uint64_t m_bytesOverThreshold = 0;
+};
+
+typedef std::function<void(const MemoryPressureEvent&)> MemoryPressureCallback;
+
+struct MemoryBudgetReport
+{
+	uint64_t m_usage[MEMORY_CATEGORY_COUNT] = {};
+	uint64_t m_peakUsage[MEMORY_CATEGORY_COUNT] = {};
+	uint64_t m_budget[MEMORY_CATEGORY_COUNT] = {};
+	uint64_t m_totalUsage = 0;
+	uint64_t m_totalBudget = 0;
+	uint64_t m_pressureEvents = 0;
+};
+
+//Memory Budget Manager
+//every resource-creating path reports its committed memory with a category
+//the accounting is plain c++, it does not touch the device
+//the pressure callbacks are dispatched once per frame, so the trimming never runs inside an allocator lock
+class MemoryBudgetManager
+{
+public:
+	static const uint64_t kUnlimitedBudget = UINT64_MAX;
+
+	static MemoryBudgetManager& Instance() {
+		static MemoryBudgetManager instance;
+		return instance;
+	}
+
+	MemoryBudgetManager();
+
+	MemoryBudgetManager(const MemoryBudgetManager&) = delete;
+	MemoryBudgetManager& operator=(const MemoryBudgetManager&) = delete;
+
+	void SetCategoryBudget(MemoryCategory category, uint64_t budget);
+	void SetTotalBudget(uint64_t budget);
+	//the fraction of the budget where the pressure begins, the caches trim before the limit is hit
+	void SetPressureThreshold(float threshold);
+
+	//thread-safe, called by the resource-creating paths
+	void ReportAllocation(MemoryCategory category, uint64_t size);
+	void ReportRelease(MemoryCategory category, uint64_t size);
+
+	//whether the allocation fits in both the category and the total budgets
+	bool CanAllocate(MemoryCategory category, uint64_t size) const;
+
+	//the callback of a category also receives the total budget pressure
+	uint32_t RegisterPressureCallback(MemoryCategory category, const MemoryPressureCallback& callback);
+	void UnregisterPressureCallback(uint32_t callbackId);
+	//invoke the callbacks of the categories under pressure, return the number of events
+	uint32_t DispatchPressureCallbacks();
+
+	uint64_t GetUsage(MemoryCategory category) const { return m_usage[category].load(std::memory_order_relaxed); }
+	uint64_t GetTotalUsage() const { return m_totalUsage.load(std::memory_order_relaxed); }
+	MemoryBudgetReport GetReport() const;
+
+	//clear the usage and the callbacks
+	void Reset();
+
+private:
+	struct PressureCallbackEntry
+	{
+		uint32_t m_id;
+		MemoryCategory m_category;
+		MemoryPressureCallback m_callback;
+	};
+
+	uint64_t GetThreshold(uint64_t budget) const;
+	bool IsUnderPressure(uint64_t usage, uint64_t budget) const;
+
+	std::atomic<uint64_t> m_usage[MEMORY_CATEGORY_COUNT];
+	std::atomic<uint64_t> m_peakUsage[MEMORY_CATEGORY_COUNT];
+	std::atomic<uint64_t> m_budget[MEMORY_CATEGORY_COUNT];
+	std::atomic<uint64_t> m_totalUsage;
+	std::atomic<uint64_t> m_totalBudget;
+	std::atomic<float> m_pressureThreshold;
+	std::atomic<uint64_t> m_pressureEvents;
+
+	std::vector<PressureCallbackEntry> m_callbacks;
+	uint32_t m_nextCallbackId;
+	std::mutex m_callbacksMutex;
+};
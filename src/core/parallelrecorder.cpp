@@ -0,0 +1,73 @@
+#include "parallelrecorder.h"
+#include "graphicscore.h"
+#include <cassert>
+
+ParallelGraphicsRecorder::ParallelGraphicsRecorder(GraphicsContext& mainContext)
+	: m_mainContext(&mainContext)
+{
+}
+
+ParallelGraphicsRecorder::~ParallelGraphicsRecorder()
+{
+	assert(m_mainContext == nullptr && "the recorder is not finished");
+}
+
+uint32_t ParallelGraphicsRecorder::GetChunkCount(uint32_t drawCount, uint32_t workerCount)
+{
+	return TaskPool::GetChunkCount(drawCount, kMinDrawsPerChunk, workerCount);
+}
+
+void ParallelGraphicsRecorder::Record(const GraphicsPassState& pass, uint32_t drawCount, const RecordFunc& record)
+{
+	assert(m_mainContext != nullptr);
+	uint32_t chunkCount = GetChunkCount(drawCount, GRAPHICS_CORE::g_taskPool.GetWorkerCount());
+
+	//a single chunk is recorded after the commands of the last context
+	if (chunkCount == 1) {
+		GraphicsContext& context = GetLastContext();
+		context.SetPassState(pass);
+		record(context, 0, drawCount);
+		return;
+	}
+
+	//the contexts are allocated here, so their order does not depend on the workers
+	size_t firstChunk = m_chunkContexts.size();
+	for (uint32_t i = 0; i < chunkCount; ++i)
+		m_chunkContexts.push_back(&GRAPHICS_CORE::g_contextManager.GetAvailableGraphicsContext());
+
+	GraphicsContext* const* chunkContexts = m_chunkContexts.data() + firstChunk;
+	GRAPHICS_CORE::g_taskPool.ParallelFor(chunkCount, [&](uint32_t chunkIndex) {
+		uint32_t begin, end;
+		TaskPool::GetChunkRange(drawCount, chunkCount, chunkIndex, begin, end);
+		GraphicsContext& context = *chunkContexts[chunkIndex];
+		context.SetPassState(pass);
+		record(context, begin, end);
+	});
+}
+
+GraphicsContext& ParallelGraphicsRecorder::GetLastContext()
+{
+	assert(m_mainContext != nullptr);
+	return m_chunkContexts.empty() ? *m_mainContext : *m_chunkContexts.back();
+}
+
+uint64_t ParallelGraphicsRecorder::Finish(bool waitForCompletion)
+{
+	assert(m_mainContext != nullptr);
+
+	std::vector<Context*> contexts;
+	contexts.reserve(m_chunkContexts.size() + 1);
+	contexts.push_back(m_mainContext);
+	contexts.insert(contexts.end(), m_chunkContexts.begin(), m_chunkContexts.end());
+
+	CommandQueue& queue = GRAPHICS_CORE::g_commandManager.GetQueue(m_mainContext->GetContextType());
+	uint64_t fenceValue = queue.ExecuteContexts((UINT)contexts.size(), contexts.data());
+
+	m_mainContext = nullptr;
+	m_chunkContexts.clear();
+
+	if (waitForCompletion)
+		GRAPHICS_CORE::g_commandManager.WaitForFence(fenceValue);
+
+	return fenceValue;
+}
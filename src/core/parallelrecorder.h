@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "context.h"
+
+//Parallel Graphics Recorder
+//the draws of one pass are split into chunks, and each chunk is recorded on a worker of the task pool
+//into its own pooled context, which starts from the pass state
+//the main context keeps the commands before the pass, the chunk contexts follow it in the submission order
+//all the lists are submitted with one queue call and share one fence
+class ParallelGraphicsRecorder
+{
+public:
+	//the draws are not worth a context of their own below this count
+	static const uint32_t kMinDrawsPerChunk = 64;
+
+	//record the draws in [begin, end) into the context
+	typedef std::function<void(GraphicsContext&, uint32_t, uint32_t)> RecordFunc;
+
+	explicit ParallelGraphicsRecorder(GraphicsContext& mainContext);
+	~ParallelGraphicsRecorder();
+
+	ParallelGraphicsRecorder(const ParallelGraphicsRecorder&) = delete;
+	ParallelGraphicsRecorder& operator=(const ParallelGraphicsRecorder&) = delete;
+
+	//record the draws of the pass, the record function is called from the worker threads
+	void Record(const GraphicsPassState& pass, uint32_t drawCount, const RecordFunc& record);
+
+	//the context recorded last, the commands after the pass go into it
+	GraphicsContext& GetLastContext();
+
+	//submit the main context and the chunk contexts in order, and release all of them
+	uint64_t Finish(bool waitForCompletion = false);
+
+	//the chunk count for the draw count and the worker count, at least one chunk
+	static uint32_t GetChunkCount(uint32_t drawCount, uint32_t workerCount);
+
+private:
+	GraphicsContext* m_mainContext;
+	std::vector<GraphicsContext*> m_chunkContexts;
+};
@@ -0,0 +1,60 @@
+#include "pipelineblobfile.h"
+#include "hashutils.h"
+#include <cstdio>
+#include <fstream>
+
+static const uint32_t kPipelineBlobMagic = 0x424C5047; //"GPLB"
+
+struct PipelineBlobHeader
+{
+	uint32_t m_magic;
+	uint32_t m_version;
+	uint64_t m_size;
+	uint64_t m_hash; //the hash of the data, to catch the partially written files
+};
+
+bool PipelineBlobFile::Load(const std::string& path, std::vector<uint8_t>& data)
+{
+	data.clear();
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	PipelineBlobHeader header = {};
+	if (!file.read((char*)&header, sizeof(PipelineBlobHeader)))
+		return false;
+	if (header.m_magic != kPipelineBlobMagic || header.m_version != kVersion || header.m_size == 0)
+		return false;
+
+	data.resize((size_t)header.m_size);
+	if (!file.read((char*)data.data(), (std::streamsize)header.m_size) ||
+		HashBytes(data.data(), data.size()) != header.m_hash) {
+		data.clear();
+		return false;
+	}
+	return true;
+}
+
+bool PipelineBlobFile::Save(const std::string& path, const void* data, size_t size)
+{
+	//write to a temporary file first, so a crash never leaves a broken blob at the path
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		PipelineBlobHeader header;
+		header.m_magic = kPipelineBlobMagic;
+		header.m_version = kVersion;
+		header.m_size = size;
+		header.m_hash = HashBytes(data, size);
+		file.write((const char*)&header, sizeof(PipelineBlobHeader));
+		file.write((const char*)data, (std::streamsize)size);
+		if (!file)
+			return false;
+	}
+
+	std::remove(path.c_str());
+	return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//Pipeline Blob File
+//the serialized pipeline library on the disk, with a header to reject the truncated or stale files
+//the file does not touch the device, so it can be tested alone
+class PipelineBlobFile
+{
+public:
+	//the version of the file layout, bumped when the header changes
+	static const uint32_t kVersion = 1;
+
+	//return false if the file is missing, truncated or written by another version
+	static bool Load(const std::string& path, std::vector<uint8_t>& data);
+	static bool Save(const std::string& path, const void* data, size_t size);
+};
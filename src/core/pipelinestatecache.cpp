@@ -0,0 +1,147 @@
+#include "pipelinestatecache.h"
+#include "pipelinestatehash.h"
+#include "pipelineblobfile.h"
+#include "graphicscore.h"
+
+void PipelineStateCache::Initialize(ID3D12Device* device, const std::string& path)
+{
+	m_path = path;
+	m_libraryDirty = false;
+
+	ComPtr<ID3D12Device1> device1;
+	if (FAILED(device->QueryInterface(IID_PPV_ARGS(&device1))))
+		return;
+
+	//a stale blob of another driver or adapter is dropped, and the library starts empty
+	if (PipelineBlobFile::Load(m_path, m_libraryBlob) &&
+		SUCCEEDED(device1->CreatePipelineLibrary(m_libraryBlob.data(), m_libraryBlob.size(), IID_PPV_ARGS(&m_library))))
+		return;
+
+	m_libraryBlob.clear();
+	if (FAILED(device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_library))))
+		m_library = nullptr;
+}
+
+void PipelineStateCache::Release()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_libraryMutex);
+		if (m_library != nullptr && m_libraryDirty) {
+			std::vector<uint8_t> serializedLibrary(m_library->GetSerializedSize());
+			if (SUCCEEDED(m_library->Serialize(serializedLibrary.data(), serializedLibrary.size())))
+				PipelineBlobFile::Save(m_path, serializedLibrary.data(), serializedLibrary.size());
+		}
+		m_library = nullptr;
+		m_libraryBlob.clear();
+		m_libraryDirty = false;
+	}
+
+	std::lock_guard<std::mutex> guard(m_mutex);
+	m_graphicsPipelines.clear();
+	m_computePipelines.clear();
+}
+
+ID3D12PipelineState* PipelineStateCache::GetGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+	uint64_t rootSignatureHash, const wchar_t* name)
+{
+	std::vector<uint8_t> key;
+	BuildGraphicsPipelineKey(desc, rootSignatureHash, key);
+	return GetPipeline(m_graphicsPipelines, key, desc.pRootSignature, L'G', name,
+		[&desc](ID3D12PipelineLibrary* library, const wchar_t* libraryName, ComPtr<ID3D12PipelineState>& pso) {
+			return library->LoadGraphicsPipeline(libraryName, &desc, IID_PPV_ARGS(&pso));
+		},
+		[&desc](ComPtr<ID3D12PipelineState>& pso) {
+			ThrowIfFailed(GRAPHICS_CORE::g_device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pso)));
+		});
+}
+
+ID3D12PipelineState* PipelineStateCache::GetComputePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc,
+	uint64_t rootSignatureHash, const wchar_t* name)
+{
+	std::vector<uint8_t> key;
+	BuildComputePipelineKey(desc, rootSignatureHash, key);
+	return GetPipeline(m_computePipelines, key, desc.pRootSignature, L'C', name,
+		[&desc](ID3D12PipelineLibrary* library, const wchar_t* libraryName, ComPtr<ID3D12PipelineState>& pso) {
+			return library->LoadComputePipeline(libraryName, &desc, IID_PPV_ARGS(&pso));
+		},
+		[&desc](ComPtr<ID3D12PipelineState>& pso) {
+			ThrowIfFailed(GRAPHICS_CORE::g_device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pso)));
+		});
+}
+
+uint32_t PipelineStateCache::GetCompiledCount()
+{
+	std::lock_guard<std::mutex> guard(m_libraryMutex);
+	return m_compiledCount;
+}
+
+uint32_t PipelineStateCache::GetLibraryLoadedCount()
+{
+	std::lock_guard<std::mutex> guard(m_libraryMutex);
+	return m_libraryLoadedCount;
+}
+
+uint32_t PipelineStateCache::GetPipelineCount()
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	return (uint32_t)(m_graphicsPipelines.size() + m_computePipelines.size());
+}
+
+ID3D12PipelineState* PipelineStateCache::FindPipeline(PipelineMap& pipelines, uint64_t hashValue,
+	const std::vector<uint8_t>& key, ID3D12RootSignature* rootSignature)
+{
+	auto range = pipelines.equal_range(hashValue);
+	for (auto iter = range.first; iter != range.second; ++iter) {
+		if (iter->second.m_rootSignature == rootSignature && iter->second.m_key == key)
+			return iter->second.m_pso.Get();
+	}
+	return nullptr;
+}
+
+template<typename LoadFunc, typename CreateFunc>
+ID3D12PipelineState* PipelineStateCache::GetPipeline(PipelineMap& pipelines, const std::vector<uint8_t>& key,
+	ID3D12RootSignature* rootSignature, wchar_t typeTag, const wchar_t* name,
+	LoadFunc loadFromLibrary, CreateFunc createPipeline)
+{
+	uint64_t hashValue = HashPipelineKey(key);
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		ID3D12PipelineState* cachedPipeline = FindPipeline(pipelines, hashValue, key, rootSignature);
+		if (cachedPipeline != nullptr)
+			return cachedPipeline;
+	}
+
+	//the pipelines are named by their type and hash in the library
+	//a colliding desc fails to load the pipeline stored under its name, and is compiled
+	wchar_t libraryName[20];
+	swprintf_s(libraryName, L"%c%016llx", typeTag, (unsigned long long)hashValue);
+
+	//the compilation is out of the locks, so the threads compile different pipelines at the same time
+	ComPtr<ID3D12PipelineState> pso;
+	bool loaded = false;
+	{
+		std::lock_guard<std::mutex> guard(m_libraryMutex);
+		loaded = m_library != nullptr && SUCCEEDED(loadFromLibrary(m_library.Get(), libraryName, pso));
+		if (loaded)
+			m_libraryLoadedCount++;
+	}
+
+	if (!loaded) {
+		createPipeline(pso);
+
+		//another thread may store the same pipeline first, then the store fails and nothing changes
+		std::lock_guard<std::mutex> guard(m_libraryMutex);
+		m_compiledCount++;
+		if (m_library != nullptr && SUCCEEDED(m_library->StorePipeline(libraryName, pso.Get())))
+			m_libraryDirty = true;
+	}
+	pso->SetName(name);
+
+	//another thread may insert the same pipeline first, then its pipeline is kept
+	std::lock_guard<std::mutex> guard(m_mutex);
+	ID3D12PipelineState* cachedPipeline = FindPipeline(pipelines, hashValue, key, rootSignature);
+	if (cachedPipeline != nullptr)
+		return cachedPipeline;
+	CachedPipeline newPipeline = { key, rootSignature, pso };
+	return pipelines.insert(std::make_pair(hashValue, newPipeline))->second.m_pso.Get();
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "headers.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//Pipeline State Cache
+//the pipeline states with the same desc share one object, keyed by the hash of the desc
+//the canonical bytes of the desc are kept and compared on a hit, the colliding descs are stored side by side
+//the compiled pipelines are stored in a pipeline library, which is serialized to the disk at release,
+//so the next launch loads the pipelines from the library instead of compiling them in the driver
+class PipelineStateCache
+{
+public:
+	PipelineStateCache() : m_libraryDirty(false), m_compiledCount(0), m_libraryLoadedCount(0) {}
+
+	//load the pipeline library from the path, the cache works in memory only if the device has no pipeline library
+	void Initialize(ID3D12Device* device, const std::string& path);
+	//serialize the pipeline library if new pipelines were compiled, then release all the pipeline states
+	void Release();
+
+	//the returned pipeline state is owned by the cache
+	ID3D12PipelineState* GetGraphicsPipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+		uint64_t rootSignatureHash, const wchar_t* name);
+	ID3D12PipelineState* GetComputePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc,
+		uint64_t rootSignatureHash, const wchar_t* name);
+
+	uint32_t GetPipelineCount();
+	//the pipelines compiled by the driver and loaded from the library since the initialization
+	uint32_t GetCompiledCount();
+	uint32_t GetLibraryLoadedCount();
+
+private:
+	struct CachedPipeline
+	{
+		std::vector<uint8_t> m_key;
+		//the root signatures are only hashed in the key, the object tells the colliding layouts apart
+		ID3D12RootSignature* m_rootSignature;
+		Microsoft::WRL::ComPtr<ID3D12PipelineState> m_pso;
+	};
+	typedef std::unordered_multimap<uint64_t, CachedPipeline> PipelineMap;
+
+	//the caller should hold m_mutex
+	ID3D12PipelineState* FindPipeline(PipelineMap& pipelines, uint64_t hashValue,
+		const std::vector<uint8_t>& key, ID3D12RootSignature* rootSignature);
+
+	template<typename LoadFunc, typename CreateFunc>
+	ID3D12PipelineState* GetPipeline(PipelineMap& pipelines, const std::vector<uint8_t>& key,
+		ID3D12RootSignature* rootSignature, wchar_t typeTag, const wchar_t* name,
+		LoadFunc loadFromLibrary, CreateFunc createPipeline);
+
+	std::mutex m_mutex;
+	PipelineMap m_graphicsPipelines;
+	PipelineMap m_computePipelines;
+
+	//the library keeps pointing at the loaded blob, so the blob lives as long as the library
+	std::mutex m_libraryMutex;
+	Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> m_library;
+	std::vector<uint8_t> m_libraryBlob;
+	std::string m_path;
+	bool m_libraryDirty;
+
+	uint32_t m_compiledCount;
+	uint32_t m_libraryLoadedCount;
+};
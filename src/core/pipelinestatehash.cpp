@@ -0,0 +1,145 @@
+#include "pipelinestatehash.h"
+#include "hashutils.h"
+#include <cstring>
+
+static void AppendBytes(std::vector<uint8_t>& key, const void* data, size_t size) {
+	const uint8_t* bytes = (const uint8_t*)data;
+	key.insert(key.end(), bytes, bytes + size);
+}
+
+static void AppendUint(std::vector<uint8_t>& key, uint32_t value) {
+	AppendBytes(key, &value, sizeof(uint32_t));
+}
+
+static void AppendString(std::vector<uint8_t>& key, const char* value) {
+	//the terminator is kept too, so the neighbouring strings do not run together
+	if (value == nullptr)
+		AppendUint(key, 0);
+	else
+		AppendBytes(key, value, strlen(value) + 1);
+}
+
+static void AppendShader(std::vector<uint8_t>& key, const D3D12_SHADER_BYTECODE& shader) {
+	AppendBytes(key, &shader.BytecodeLength, sizeof(shader.BytecodeLength));
+	if (shader.pShaderBytecode != nullptr)
+		AppendBytes(key, shader.pShaderBytecode, shader.BytecodeLength);
+}
+
+static void AppendStencilOp(std::vector<uint8_t>& key, const D3D12_DEPTH_STENCILOP_DESC& stencilOp) {
+	AppendUint(key, stencilOp.StencilFailOp);
+	AppendUint(key, stencilOp.StencilDepthFailOp);
+	AppendUint(key, stencilOp.StencilPassOp);
+	AppendUint(key, stencilOp.StencilFunc);
+}
+
+void BuildGraphicsPipelineKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash, std::vector<uint8_t>& key)
+{
+	key.clear();
+	AppendBytes(key, &rootSignatureHash, sizeof(uint64_t));
+	AppendShader(key, desc.VS);
+	AppendShader(key, desc.PS);
+	AppendShader(key, desc.DS);
+	AppendShader(key, desc.HS);
+	AppendShader(key, desc.GS);
+
+	const D3D12_STREAM_OUTPUT_DESC& streamOutput = desc.StreamOutput;
+	AppendUint(key, streamOutput.NumEntries);
+	for (UINT i = 0; i < streamOutput.NumEntries; ++i) {
+		const D3D12_SO_DECLARATION_ENTRY& entry = streamOutput.pSODeclaration[i];
+		AppendUint(key, entry.Stream);
+		AppendString(key, entry.SemanticName);
+		AppendUint(key, entry.SemanticIndex);
+		AppendUint(key, entry.StartComponent);
+		AppendUint(key, entry.ComponentCount);
+		AppendUint(key, entry.OutputSlot);
+	}
+	AppendUint(key, streamOutput.NumStrides);
+	if (streamOutput.NumStrides > 0)
+		AppendBytes(key, streamOutput.pBufferStrides, sizeof(UINT) * streamOutput.NumStrides);
+	AppendUint(key, streamOutput.RasterizedStream);
+
+	//without independent blend, only the first render target blend is used
+	const D3D12_BLEND_DESC& blendState = desc.BlendState;
+	AppendUint(key, blendState.AlphaToCoverageEnable);
+	AppendUint(key, blendState.IndependentBlendEnable);
+	UINT blendTargetsNum = blendState.IndependentBlendEnable ? 8 : 1;
+	for (UINT i = 0; i < blendTargetsNum; ++i) {
+		const D3D12_RENDER_TARGET_BLEND_DESC& blendTarget = blendState.RenderTarget[i];
+		AppendUint(key, blendTarget.BlendEnable);
+		AppendUint(key, blendTarget.LogicOpEnable);
+		AppendUint(key, blendTarget.SrcBlend);
+		AppendUint(key, blendTarget.DestBlend);
+		AppendUint(key, blendTarget.BlendOp);
+		AppendUint(key, blendTarget.SrcBlendAlpha);
+		AppendUint(key, blendTarget.DestBlendAlpha);
+		AppendUint(key, blendTarget.BlendOpAlpha);
+		AppendUint(key, blendTarget.LogicOp);
+		AppendUint(key, blendTarget.RenderTargetWriteMask);
+	}
+	AppendUint(key, desc.SampleMask);
+
+	//the rasterizer desc is made of 4 bytes fields, so there is no padding in the key
+	AppendBytes(key, &desc.RasterizerState, sizeof(D3D12_RASTERIZER_DESC));
+
+	const D3D12_DEPTH_STENCIL_DESC& depthStencilState = desc.DepthStencilState;
+	AppendUint(key, depthStencilState.DepthEnable);
+	AppendUint(key, depthStencilState.DepthWriteMask);
+	AppendUint(key, depthStencilState.DepthFunc);
+	AppendUint(key, depthStencilState.StencilEnable);
+	AppendUint(key, depthStencilState.StencilReadMask);
+	AppendUint(key, depthStencilState.StencilWriteMask);
+	AppendStencilOp(key, depthStencilState.FrontFace);
+	AppendStencilOp(key, depthStencilState.BackFace);
+
+	AppendUint(key, desc.InputLayout.NumElements);
+	for (UINT i = 0; i < desc.InputLayout.NumElements; ++i) {
+		const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+		AppendString(key, element.SemanticName);
+		AppendUint(key, element.SemanticIndex);
+		AppendUint(key, element.Format);
+		AppendUint(key, element.InputSlot);
+		AppendUint(key, element.AlignedByteOffset);
+		AppendUint(key, element.InputSlotClass);
+		AppendUint(key, element.InstanceDataStepRate);
+	}
+
+	AppendUint(key, desc.IBStripCutValue);
+	AppendUint(key, desc.PrimitiveTopologyType);
+	//the formats after the render targets are not used
+	AppendUint(key, desc.NumRenderTargets);
+	for (UINT i = 0; i < desc.NumRenderTargets && i < 8; ++i)
+		AppendUint(key, desc.RTVFormats[i]);
+	AppendUint(key, desc.DSVFormat);
+	AppendUint(key, desc.SampleDesc.Count);
+	AppendUint(key, desc.SampleDesc.Quality);
+	AppendUint(key, desc.NodeMask);
+	AppendUint(key, desc.Flags);
+}
+
+void BuildComputePipelineKey(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash, std::vector<uint8_t>& key)
+{
+	key.clear();
+	AppendBytes(key, &rootSignatureHash, sizeof(uint64_t));
+	AppendShader(key, desc.CS);
+	AppendUint(key, desc.NodeMask);
+	AppendUint(key, desc.Flags);
+}
+
+uint64_t HashGraphicsPipelineDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash)
+{
+	std::vector<uint8_t> key;
+	BuildGraphicsPipelineKey(desc, rootSignatureHash, key);
+	return HashPipelineKey(key);
+}
+
+uint64_t HashComputePipelineDesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash)
+{
+	std::vector<uint8_t> key;
+	BuildComputePipelineKey(desc, rootSignatureHash, key);
+	return HashPipelineKey(key);
+}
+
+uint64_t HashPipelineKey(const std::vector<uint8_t>& key)
+{
+	return HashBytes(key.data(), key.size());
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <d3d12.h>
+#include <cstdint>
+#include <vector>
+
+//stable 64-bit hashes of the pipeline state descs, the keys of the pipeline state cache
+//the root signature is hashed by its layout hash, the shaders and the input layout by their contents,
+//and the states by the fields the pipeline uses, so equal descs built separately share one hash
+//the hashes do not touch the device, so they can be tested alone
+uint64_t HashGraphicsPipelineDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash);
+uint64_t HashComputePipelineDesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash);
+
+//the canonical bytes the hashes are computed from, the cache compares them to reject the hash collisions
+void BuildGraphicsPipelineKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash, std::vector<uint8_t>& key);
+void BuildComputePipelineKey(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash, std::vector<uint8_t>& key);
+uint64_t HashPipelineKey(const std::vector<uint8_t>& key);
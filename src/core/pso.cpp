@@ -90,8 +90,8 @@ void GraphicsPSO::Finalize()
 	//set input layout
 	m_psoDesc.InputLayout.pInputElementDescs = m_inputLayout.get();
 	
-	ThrowIfFailed(GRAPHICS_CORE::g_device->CreateGraphicsPipelineState(&m_psoDesc, IID_PPV_ARGS(&m_pso)));
-	m_pso->SetName(m_name);
+	//the same desc is compiled once, and loaded from the pipeline library in the next launches
+	m_pso = GRAPHICS_CORE::g_pipelineStateCache.GetGraphicsPipeline(m_psoDesc, m_rootSignature->GetHash(), m_name);
 }
 
 /*
@@ -107,7 +107,5 @@ void ComputePSO::Finalize()
 {
 	m_psoDesc.pRootSignature = m_rootSignature->GetSignature();
 	assert(m_psoDesc.pRootSignature != nullptr);
-	ThrowIfFailed(GRAPHICS_CORE::g_device->CreateComputePipelineState(&m_psoDesc, 
-		IID_PPV_ARGS(&m_pso)));
-	m_pso->SetName(m_name);
+	m_pso = GRAPHICS_CORE::g_pipelineStateCache.GetComputePipeline(m_psoDesc, m_rootSignature->GetHash(), m_name);
 }
@@ -13,6 +13,7 @@ public:
 	void SetRootSignature(RootSignature* rootSignature) { m_rootSignature = rootSignature; }
 	const RootSignature* GetRootSignature() const { return m_rootSignature; }
 
+	//the pipeline state is owned by the pipeline state cache
 	ID3D12PipelineState* GetPSO() const { return m_pso; }
 protected:
 	const wchar_t* m_name = nullptr;
@@ -0,0 +1,60 @@
+#include "queuedependencies.h"
+#include <algorithm>
+#include <cassert>
+
+QueueDependencies::QueueDependencies(D3D12_COMMAND_LIST_TYPE consumerType)
+	: m_consumerIndex((uint32_t)consumerType)
+{
+	assert(m_consumerIndex < kQueueTypeCount);
+	for (uint32_t i = 0; i < kQueueTypeCount; ++i) {
+		m_pendingFences[i] = 0;
+		m_waitedFences[i] = 0;
+	}
+}
+
+void QueueDependencies::AddDependency(uint64_t producerFenceValue)
+{
+	uint32_t producerIndex = GetQueueIndex(producerFenceValue);
+	assert(producerIndex < kQueueTypeCount);
+	//the commands of the same queue run in order
+	if (producerIndex == m_consumerIndex)
+		return;
+
+	std::lock_guard<std::mutex> guard(m_mutex);
+	if (producerFenceValue > m_waitedFences[producerIndex])
+		m_pendingFences[producerIndex] = std::max(m_pendingFences[producerIndex], producerFenceValue);
+}
+
+bool QueueDependencies::HasDependencies()
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	for (uint32_t i = 0; i < kQueueTypeCount; ++i) {
+		if (m_pendingFences[i] != 0)
+			return true;
+	}
+	return false;
+}
+
+uint32_t QueueDependencies::TakeWaits(const FenceCompleteFunc& isFenceComplete, uint64_t waitFences[kQueueTypeCount])
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	uint32_t waitCount = 0;
+	for (uint32_t i = 0; i < kQueueTypeCount; ++i) {
+		uint64_t fenceValue = m_pendingFences[i];
+		if (fenceValue == 0)
+			continue;
+		m_pendingFences[i] = 0;
+		if (fenceValue <= m_waitedFences[i] || isFenceComplete(fenceValue))
+			continue;
+		m_waitedFences[i] = fenceValue;
+		waitFences[waitCount++] = fenceValue;
+	}
+	return waitCount;
+}
+
+uint64_t QueueDependencies::GetWaitedFence(uint32_t producerIndex)
+{
+	assert(producerIndex < kQueueTypeCount);
+	std::lock_guard<std::mutex> guard(m_mutex);
+	return m_waitedFences[producerIndex];
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <d3d12.h>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+//Queue Dependencies
+//the fences of the other queues which the next submission of one queue consumes
+//the queue type is in the top byte of the fence value, so one fence is kept for each producer queue
+//a gpu wait covers all the older fences of the same producer, so they are not waited again
+//the bookkeeping does not touch the device, so it can be tested with simulated fences
+class QueueDependencies
+{
+public:
+	//direct, bundle, compute and copy
+	static const uint32_t kQueueTypeCount = 4;
+
+	typedef std::function<bool(uint64_t)> FenceCompleteFunc;
+
+	explicit QueueDependencies(D3D12_COMMAND_LIST_TYPE consumerType);
+
+	static uint32_t GetQueueIndex(uint64_t fenceValue) { return (uint32_t)(fenceValue >> 56); }
+
+	//the next submission of the consumer queue reads the output of the producer fence, can be called from any thread
+	void AddDependency(uint64_t producerFenceValue);
+	bool HasDependencies();
+
+	//take the fences to wait before the next submission, one for each producer queue at most
+	//the fences complete on the cpu side and the fences waited already are dropped
+	//return the count of the fences written into waitFences
+	uint32_t TakeWaits(const FenceCompleteFunc& isFenceComplete, uint64_t waitFences[kQueueTypeCount]);
+
+	//the highest fence of the producer queue the consumer waited on the gpu, 0 for none
+	uint64_t GetWaitedFence(uint32_t producerIndex);
+
+private:
+	uint32_t m_consumerIndex;
+
+	std::mutex m_mutex;
+	uint64_t m_pendingFences[kQueueTypeCount]; //0 for no dependency
+	uint64_t m_waitedFences[kQueueTypeCount];
+};
@@ -5,19 +5,12 @@
 ColorBuffer::ColorBuffer(Color clearColor)
 	: m_clearColor(clearColor), m_mips(0), m_fragmentCount(1), m_sampleCount(1)
 {
-	m_rtvHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-	m_srvHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-	for (int i = 0; i < _countof(m_uavHandle); ++i)
-		m_uavHandle[i].ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-
-
 	std::cout << "color buffer init" << std::endl;
 }
 
 void ColorBuffer::CreateFromSwapChain(const std::wstring& name, ID3D12Resource* baseResource) {
 	AssociateWithResource(GRAPHICS_CORE::g_device, name, baseResource, D3D12_RESOURCE_STATE_PRESENT);
-	m_rtvHandle = GRAPHICS_CORE::AllocatorDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-	GRAPHICS_CORE::g_device->CreateRenderTargetView(m_resource, nullptr, m_rtvHandle);
+	m_mips = 0;
 }
 
 void ColorBuffer::CreateBuffer(const std::wstring& name, uint32_t width, uint32_t height, uint32_t mips,
@@ -37,7 +30,7 @@ void ColorBuffer::CreateBuffer(const std::wstring& name, uint32_t width, uint32_
 	clearValue.Color[3] = m_clearColor.A();
 
 	CreateTextureResource(GRAPHICS_CORE::g_device, name, resourceDesc, clearValue, vidMemPtr);
-	CreateDerivedViews(GRAPHICS_CORE::g_device, format, 1, mips);
+	m_mips = mips - 1;
 }
 
 void ColorBuffer::CreateBufferArray(const std::wstring& name, uint32_t width, uint32_t height, uint32_t arrayCount,
@@ -54,83 +47,77 @@ void ColorBuffer::CreateBufferArray(const std::wstring& name, uint32_t width, ui
 	clearValue.Color[3] = m_clearColor.A();
 
 	CreateTextureResource(GRAPHICS_CORE::g_device, name, resourceDesc, clearValue, vidMemPtr);
-	CreateDerivedViews(GRAPHICS_CORE::g_device, format, arrayCount, 1);
+	m_mips = 0;
 }
 
-void ColorBuffer::CreateDerivedViews(ID3D12Device* device, DXGI_FORMAT format,
-	uint32_t arraySize, uint32_t numMips) {
-	assert(arraySize == 1 || numMips == 1, "We dont support auto-mips on texture arrays");
-
-	m_mips = numMips - 1;
-
-	D3D12_RENDER_TARGET_VIEW_DESC rtvDesc = {};
-	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-
-	rtvDesc.Format = format;
-	uavDesc.Format = GetUAVFormat(format);
-	srvDesc.Format = format;
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-
-
-	if (arraySize > 1) //for texture array
-	{
-		rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
-		rtvDesc.Texture2DArray.MipSlice = 0;
-		rtvDesc.Texture2DArray.FirstArraySlice = 0;
-		rtvDesc.Texture2DArray.ArraySize = (UINT)arraySize;
-
-		uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2DARRAY;
-		uavDesc.Texture2DArray.MipSlice = 0;
-		uavDesc.Texture2DArray.FirstArraySlice = 0;
-		uavDesc.Texture2DArray.ArraySize = (UINT)arraySize;
-
-		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
-		srvDesc.Texture2DArray.MipLevels = numMips;
-		srvDesc.Texture2DArray.MostDetailedMip = 0;
-		srvDesc.Texture2DArray.FirstArraySlice = 0;
-		srvDesc.Texture2DArray.ArraySize = (UINT)arraySize;
+void ColorBuffer::CreateView(const PixelViewKey& key, D3D12_CPU_DESCRIPTOR_HANDLE handle) const {
+	ID3D12Device* device = GRAPHICS_CORE::g_device;
+	uint32_t numMips = m_mips + 1;
+	assert(m_arraySize == 1 || numMips == 1);
+
+	if (key.m_type == PIXEL_VIEW_RTV) {
+		D3D12_RENDER_TARGET_VIEW_DESC rtvDesc = {};
+		rtvDesc.Format = key.m_format;
+		if (m_arraySize > 1) //for texture array
+		{
+			rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
+			rtvDesc.Texture2DArray.MipSlice = key.m_mipSlice;
+			rtvDesc.Texture2DArray.FirstArraySlice = key.m_firstArraySlice;
+			rtvDesc.Texture2DArray.ArraySize = (UINT)(m_arraySize - key.m_firstArraySlice);
+		}
+		else if (m_fragmentCount > 1) //for msaa
+		{
+			rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DMS;
+		}
+		else //for a single texture
+		{
+			rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
+			rtvDesc.Texture2D.MipSlice = key.m_mipSlice;
+		}
+		device->CreateRenderTargetView(m_resource, &rtvDesc, handle);
 	}
-	else if (m_fragmentCount > 1) //for msaa
-	{
-		rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DMS;
-		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DMS;
+	else if (key.m_type == PIXEL_VIEW_SRV) {
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = key.m_format;
+		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		if (m_arraySize > 1) //for texture array
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+			srvDesc.Texture2DArray.MipLevels = numMips - key.m_mipSlice;
+			srvDesc.Texture2DArray.MostDetailedMip = key.m_mipSlice;
+			srvDesc.Texture2DArray.FirstArraySlice = key.m_firstArraySlice;
+			srvDesc.Texture2DArray.ArraySize = (UINT)(m_arraySize - key.m_firstArraySlice);
+		}
+		else if (m_fragmentCount > 1) //for msaa
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DMS;
+		}
+		else //for a single texture
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MipLevels = numMips - key.m_mipSlice;
+			srvDesc.Texture2D.MostDetailedMip = key.m_mipSlice;
+		}
+		device->CreateShaderResourceView(m_resource, &srvDesc, handle);
 	}
-	else //for a single texture
-	{
-		rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
-		rtvDesc.Texture2D.MipSlice = 0;
-
-		uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-		uavDesc.Texture2D.MipSlice = 0;
-
-		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-		srvDesc.Texture2D.MipLevels = numMips;
-		srvDesc.Texture2D.MostDetailedMip = 0;
-	}
-
-	//Create RTV and SRV
-	if (m_srvHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
-	{
-		m_rtvHandle = GRAPHICS_CORE::AllocatorDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-		m_srvHandle = GRAPHICS_CORE::AllocatorDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	}
-	device->CreateRenderTargetView(m_resource, &rtvDesc, m_rtvHandle);
-	device->CreateShaderResourceView(m_resource, &srvDesc, m_srvHandle);
-
-	//if msaa is enabled, there is no need to create uav
-	if (m_fragmentCount > 1)
-		return;
-
-	// Create the UAVs for each mip level (RWTexture2D) 
-	for (uint32_t i = 0; i < numMips; ++i)
-	{
-		if (m_uavHandle[i].ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
-			m_uavHandle[i] = GRAPHICS_CORE::AllocatorDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-		GRAPHICS_CORE::g_device->CreateUnorderedAccessView(m_resource, nullptr, &uavDesc, m_uavHandle[i]);
-
-		uavDesc.Texture2D.MipSlice++;
+	else {
+		//if msaa is enabled, there is no uav
+		assert(key.m_type == PIXEL_VIEW_UAV && m_fragmentCount == 1);
+		assert(key.m_mipSlice < numMips);
+		D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+		uavDesc.Format = key.m_format;
+		if (m_arraySize > 1) //for texture array
+		{
+			uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2DARRAY;
+			uavDesc.Texture2DArray.MipSlice = key.m_mipSlice;
+			uavDesc.Texture2DArray.FirstArraySlice = key.m_firstArraySlice;
+			uavDesc.Texture2DArray.ArraySize = (UINT)(m_arraySize - key.m_firstArraySlice);
+		}
+		else //for a single texture
+		{
+			uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+			uavDesc.Texture2D.MipSlice = key.m_mipSlice;
+		}
+		device->CreateUnorderedAccessView(m_resource, nullptr, &uavDesc, handle);
 	}
 }
-
@@ -16,10 +16,13 @@ public:
 	void CreateBufferArray(const std::wstring& name, uint32_t width, uint32_t height, uint32_t arrayCount,
 		DXGI_FORMAT format, D3D12_GPU_VIRTUAL_ADDRESS vidMemPtr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN);
 
-	const D3D12_CPU_DESCRIPTOR_HANDLE& GetSRV() const { return m_srvHandle; }
-	const D3D12_CPU_DESCRIPTOR_HANDLE& GetRTV() const { return m_rtvHandle; }
-	const D3D12_CPU_DESCRIPTOR_HANDLE& GetUAV() const { return m_uavHandle[0]; }
-	D3D12_CPU_DESCRIPTOR_HANDLE GetUAV(uint32_t i) { return m_uavHandle[i]; }
+	//the views are created on the first request
+	D3D12_CPU_DESCRIPTOR_HANDLE GetSRV() const { return GetOrCreateView(PIXEL_VIEW_SRV, m_format); }
+	D3D12_CPU_DESCRIPTOR_HANDLE GetRTV() const { return GetOrCreateView(PIXEL_VIEW_RTV, m_format); }
+	//the uav of the mip level
+	D3D12_CPU_DESCRIPTOR_HANDLE GetUAV(uint32_t mip = 0) const {
+		return GetOrCreateView(PIXEL_VIEW_UAV, GetUAVFormat(m_format), mip);
+	}
 	const uint32_t GetMipsMap() const { return m_mips; }
 
 	void SetClearColor(Color clearColor) { m_clearColor = clearColor; }
@@ -48,12 +51,8 @@ protected:
 		return highbit + 1;
 	}
 	
-	void CreateDerivedViews(ID3D12Device* device, DXGI_FORMAT format,
-		uint32_t arraySize, uint32_t numMips = 1);
+	virtual void CreateView(const PixelViewKey& key, D3D12_CPU_DESCRIPTOR_HANDLE handle) const override;
 
-	D3D12_CPU_DESCRIPTOR_HANDLE m_srvHandle;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_rtvHandle;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_uavHandle[12];
 	uint32_t m_mips;
 	uint32_t m_fragmentCount;
 	uint32_t m_sampleCount;
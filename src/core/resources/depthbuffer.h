@@ -7,14 +7,7 @@ class DepthBuffer : public PixelBuffer
 {
 public:
 	DepthBuffer(float clearDepth = 1.0f, uint8_t clearStencil = 0) :
-		m_clearDepth(clearDepth), m_clearStencil(clearStencil){
-		m_hdsv[0].ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-		m_hdsv[1].ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-		m_hdsv[2].ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-		m_hdsv[3].ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-		m_hDepthSRV.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-		m_hStencilSRV.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-	}
+		m_clearDepth(clearDepth), m_clearStencil(clearStencil){}
 
 	void Create(const std::wstring& name, uint32_t width, uint32_t height,
 		DXGI_FORMAT format);
@@ -25,26 +18,28 @@ public:
 	void Create(const std::wstring& name, uint32_t width, uint32_t height, uint32_t samplesNum,
 		DXGI_FORMAT format);
 
-	const D3D12_CPU_DESCRIPTOR_HANDLE GetDSV() { return m_hdsv[0]; }
-	const D3D12_CPU_DESCRIPTOR_HANDLE GetDSV_depthonly() { return m_hdsv[1]; }
-	const D3D12_CPU_DESCRIPTOR_HANDLE GetDSV_stencilonly() { return m_hdsv[2]; }
-	const D3D12_CPU_DESCRIPTOR_HANDLE GetDSV_readonly() { return m_hdsv[3]; }
-	const D3D12_CPU_DESCRIPTOR_HANDLE GetDepthSRV() { return m_hDepthSRV; }
-	const D3D12_CPU_DESCRIPTOR_HANDLE GetStencilSRV() { return m_hStencilSRV; }
+	//the views are created on the first request
+	//without stencil, the stencil read only views are the same as the depth views
+	D3D12_CPU_DESCRIPTOR_HANDLE GetDSV() const { return GetOrCreateView(PIXEL_VIEW_DSV, m_format, 0, 0, D3D12_DSV_FLAG_NONE); }
+	D3D12_CPU_DESCRIPTOR_HANDLE GetDSV_depthonly() const {
+		return GetOrCreateView(PIXEL_VIEW_DSV, m_format, 0, 0, D3D12_DSV_FLAG_READ_ONLY_DEPTH);
+	}
+	D3D12_CPU_DESCRIPTOR_HANDLE GetDSV_stencilonly() const {
+		return HasStencil() ? GetOrCreateView(PIXEL_VIEW_DSV, m_format, 0, 0, D3D12_DSV_FLAG_READ_ONLY_STENCIL) : GetDSV();
+	}
+	D3D12_CPU_DESCRIPTOR_HANDLE GetDSV_readonly() const {
+		return HasStencil() ? GetOrCreateView(PIXEL_VIEW_DSV, m_format, 0, 0,
+			D3D12_DSV_FLAG_READ_ONLY_DEPTH | D3D12_DSV_FLAG_READ_ONLY_STENCIL) : GetDSV_depthonly();
+	}
+	D3D12_CPU_DESCRIPTOR_HANDLE GetDepthSRV() const { return GetOrCreateView(PIXEL_VIEW_SRV, GetDepthFormat(m_format)); }
+	D3D12_CPU_DESCRIPTOR_HANDLE GetStencilSRV() const;
 	float GetClearValue() { return m_clearDepth; }
 	uint8_t GetStencilValue() { return m_clearStencil; }
 
 protected:
-	void CreateDerivedViews(ID3D12Device* device, DXGI_FORMAT format);
+	virtual void CreateView(const PixelViewKey& key, D3D12_CPU_DESCRIPTOR_HANDLE handle) const override;
+	bool HasStencil() const { return GetStencilFormat(m_format) != DXGI_FORMAT_UNKNOWN; }
 
 	float m_clearDepth;
 	uint8_t m_clearStencil;
-
-	D3D12_CPU_DESCRIPTOR_HANDLE m_hdsv[4];
-	D3D12_CPU_DESCRIPTOR_HANDLE m_hDepthSRV;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_hStencilSRV;
-
-
-
 };
-
@@ -17,18 +17,9 @@ void GPUBuffer::Create(const std::wstring& name, uint32_t elements,
 	//describe the default gpu buffer 
 	D3D12_RESOURCE_DESC m_resourceDesc = DescribeBuffer();
 
-	//create the heap for current buffer
-	D3D12_HEAP_PROPERTIES heapProp;
-	heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
-	heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-	heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	heapProp.CreationNodeMask = 0;
-	heapProp.VisibleNodeMask = 0;
-
-	//create buffer
-	ThrowIfFailed(GRAPHICS_CORE::g_device->CreateCommittedResource(
-		&heapProp, D3D12_HEAP_FLAG_NONE, &m_resourceDesc, m_usageState, nullptr, IID_PPV_ARGS(&m_resource)
-	));
+	//place the buffer in the default buffer heaps
+	PlacedHeapAllocator::Instance().CreatePlacedResource(PLACED_HEAP_DEFAULT_BUFFER, MEMORY_CATEGORY_BUFFER,
+		m_resourceDesc, m_usageState, nullptr, m_placedAllocation, &m_resource);
 	m_resource->SetName(name.c_str());
 	m_gpuAddress = m_resource->GetGPUVirtualAddress();
 
@@ -54,18 +45,9 @@ void GPUBuffer::Create(const std::wstring& name, uint32_t elements, uint32_t ele
 	//describe the default gpu buffer 
 	D3D12_RESOURCE_DESC m_resourceDesc = DescribeBuffer();
 
-	//create the heap for current buffer
-	D3D12_HEAP_PROPERTIES heapProp;
-	heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
-	heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-	heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	heapProp.CreationNodeMask = 0;
-	heapProp.VisibleNodeMask = 0;
-
-	//create buffer
-	ThrowIfFailed(GRAPHICS_CORE::g_device->CreateCommittedResource(
-		&heapProp, D3D12_HEAP_FLAG_NONE, &m_resourceDesc, m_usageState, nullptr, IID_PPV_ARGS(&m_resource)
-	));
+	//place the buffer in the default buffer heaps
+	PlacedHeapAllocator::Instance().CreatePlacedResource(PLACED_HEAP_DEFAULT_BUFFER, MEMORY_CATEGORY_BUFFER,
+		m_resourceDesc, m_usageState, nullptr, m_placedAllocation, &m_resource);
 	m_resource->SetName(name.c_str());
 	m_gpuAddress = m_resource->GetGPUVirtualAddress();
 
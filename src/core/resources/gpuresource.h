@@ -1,5 +1,14 @@
 #pragma once
 #include "headers.h"
+#include "memoryallocator/placedheapallocator.h"
+
+namespace GRAPHICS_CORE
+{
+	//release the resource and its placed memory after the gpu finished the submitted work
+	void DeferredReleaseResource(ID3D12Resource* resource, const PlacedAllocation& placedAllocation);
+	//the bytes the device commits for the resource
+	uint64_t GetResourceAllocationSize(const D3D12_RESOURCE_DESC& desc);
+}
 
 /*
 * GPUResource: the basic class for buffer
@@ -9,21 +18,47 @@ class GPUResource
 public:
 	GPUResource() : m_resource(nullptr), m_gpuAddress(D3D12_GPU_VIRTUAL_ADDRESS_NULL),
 		m_usageState(D3D12_RESOURCE_STATE_COMMON),
-		m_transmissionState((D3D12_RESOURCE_STATES)-1) {}
+		m_transmissionState((D3D12_RESOURCE_STATES)-1), m_ownsResource(true),
+		m_committedCategory(MEMORY_CATEGORY_BUFFER), m_committedSize(0) {}
 	
+	//wrap a resource owned by others, the wrapper never releases it
 	GPUResource(ID3D12Resource* instance, D3D12_RESOURCE_STATES usage) :
 		m_resource(instance), m_gpuAddress(D3D12_GPU_VIRTUAL_ADDRESS_NULL),
-		m_usageState(usage), m_transmissionState((D3D12_RESOURCE_STATES)-1) {}
+		m_usageState(usage), m_transmissionState((D3D12_RESOURCE_STATES)-1), m_ownsResource(false),
+		m_committedCategory(MEMORY_CATEGORY_BUFFER), m_committedSize(0) {}
 
 	~GPUResource() { Destroy(); }
 
+	//Destroy releases the owned resource, a copy would release it twice
+	GPUResource(const GPUResource&) = delete;
+	GPUResource& operator=(const GPUResource&) = delete;
+
 	virtual void Destroy() {
 		if (m_resource != nullptr) {
-			//do not release the resource in here!
-			//m_resource->Release();
+			//the gpu may still use the resource, so it is released after the fence
+			if (m_ownsResource)
+				GRAPHICS_CORE::DeferredReleaseResource(m_resource, m_placedAllocation);
 			m_resource = nullptr;
 		}
+		else {
+			//give the memory back to the placed heap
+			PlacedHeapAllocator::Instance().Free(m_placedAllocation);
+		}
+		m_placedAllocation = PlacedAllocation();
 		m_gpuAddress = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
+
+		if (m_committedSize > 0) {
+			MemoryBudgetManager::Instance().ReportRelease(m_committedCategory, m_committedSize);
+			m_committedSize = 0;
+		}
+	}
+
+	//report the memory of a committed resource, the placed resources are reported by their heaps
+	void TrackCommittedMemory(MemoryCategory category) {
+		assert(m_resource != nullptr && m_committedSize == 0);
+		m_committedCategory = category;
+		m_committedSize = GRAPHICS_CORE::GetResourceAllocationSize(m_resource->GetDesc());
+		MemoryBudgetManager::Instance().ReportAllocation(m_committedCategory, m_committedSize);
 	}
 
 	ID3D12Resource* operator->() { return m_resource; }
@@ -42,6 +77,12 @@ protected:
 	D3D12_RESOURCE_STATES m_usageState;
 	D3D12_RESOURCE_STATES m_transmissionState;
 	D3D12_GPU_VIRTUAL_ADDRESS m_gpuAddress;
+	//valid if the resource is placed in the heaps of PlacedHeapAllocator
+	PlacedAllocation m_placedAllocation;
+	bool m_ownsResource;
+	//the committed memory reported to the budget manager
+	MemoryCategory m_committedCategory;
+	uint64_t m_committedSize;
 };
 
 
@@ -2,46 +2,35 @@
 #include "linearallocator.h"
 #include "graphicscore.h"
 #include "mathematics/bitoperation.h"
+#include <chrono>
 
 
-LinearAllocationPageManager::LinearAllocationPageManager()
+/*
+* LinearAllocationPageManager
+*/
+static bool IsFenceComplete(uint64_t fenceValue)
 {
+	return GRAPHICS_CORE::g_commandManager.IsFenceComplete(fenceValue);
 }
 
-LinearPage* LinearAllocationPageManager::RequestPage(void)
+LinearAllocationPageManager::LinearAllocationPageManager(LinearAllocationType type) :
+	m_allocationType(type), m_pageCache(type)
 {
-	std::lock_guard<std::mutex> lockguard(m_mutex);
-
-	//process the retired pages
-	while (!m_retiredPages.empty() && GRAPHICS_CORE::g_commandManager.IsFenceComplete(m_retiredPages.front().first)) {
-		m_availablePages.push(m_retiredPages.front().second);
-		m_retiredPages.pop();
-	}
-
-	LinearPage* pagePtr = nullptr;
+}
 
-	//Create or reuse the linear memory page
-	if (!m_availablePages.empty()) {
-		pagePtr = m_availablePages.front();
-		m_availablePages.pop();
-	}
-	else {
-		pagePtr = CreateNewPage();
+LinearPage* LinearAllocationPageManager::RequestPage(void)
+{
+	return m_pageCache.Request(IsFenceComplete, [this]() {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		LinearPage* pagePtr = CreateNewPage();
+		pagePtr->m_lastUsedFrame = m_frameIndex;
 		m_pagesPool.emplace_back(pagePtr);
-	}
-
-	return pagePtr;
+		return pagePtr;
+	});
 }
 
 LinearPage* LinearAllocationPageManager::CreateNewPage(size_t pageSize)
 {
-	//create heap properties
-	D3D12_HEAP_PROPERTIES heapProp;
-	heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-	heapProp.CreationNodeMask = 1;
-	heapProp.VisibleNodeMask = 1;
-
 	//create gpu resource description
 	D3D12_RESOURCE_DESC gpuResourceDesc;
 	gpuResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
@@ -55,79 +44,356 @@ LinearPage* LinearAllocationPageManager::CreateNewPage(size_t pageSize)
 	gpuResourceDesc.SampleDesc.Quality = 0;
 
 	D3D12_RESOURCE_STATES defaultUsage;
+	PlacedHeapType heapType;
+	MemoryCategory category;
 
 	//for gpu, the allocated memory used for computer shader
 	if (m_allocationType == GPU_MEMORY_ALLOCATION) {
-		heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+		heapType = PLACED_HEAP_DEFAULT_BUFFER;
+		category = MEMORY_CATEGORY_BUFFER;
 		gpuResourceDesc.Width = pageSize == 0 ? gpuAllocatorPageSize : pageSize;
 		gpuResourceDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
 		defaultUsage = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
 	}
 	else { //for cpu, the allocated memory used for uploading data to GPU
-		heapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
+		heapType = PLACED_HEAP_UPLOAD_BUFFER;
+		category = MEMORY_CATEGORY_UPLOAD;
 		gpuResourceDesc.Width = pageSize == 0 ? cpuAllocatorPageSize : pageSize;
 		gpuResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 		defaultUsage = D3D12_RESOURCE_STATE_GENERIC_READ;
 	}
 
-	//Create the resource
+	//Create the resource in the placed buffer heaps
 	ID3D12Resource* bufferInstance;
+	PlacedAllocation placedAllocation;
 
-	ThrowIfFailed(GRAPHICS_CORE::g_device->CreateCommittedResource(
-		&heapProp, D3D12_HEAP_FLAG_NONE, &gpuResourceDesc, defaultUsage,
-		nullptr, IID_PPV_ARGS(&bufferInstance)));
+	PlacedHeapAllocator::Instance().CreatePlacedResource(heapType, category, gpuResourceDesc,
+		defaultUsage, nullptr, placedAllocation, &bufferInstance);
 	bufferInstance->SetName(L"LinearAllocatorPage");
-	return new LinearPage(bufferInstance, defaultUsage);
+	m_counters.m_pagesCreated++;
+	return new LinearPage(bufferInstance, defaultUsage, gpuResourceDesc.Width, placedAllocation);
 }
 
-void LinearAllocationPageManager::DiscardPages(uint64_t fenceID, const std::vector<LinearPage*>& pages)
+LinearPage* LinearAllocationPageManager::CreatePersistentPage(size_t pageSize)
 {
 	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	LinearPage* pagePtr = CreateNewPage(pageSize);
+	m_pagesPool.emplace_back(pagePtr);
+	return pagePtr;
+}
+
+//the pages are retired without lock
+void LinearAllocationPageManager::DiscardPages(uint64_t fenceID, const std::vector<LinearPage*>& pages)
+{
 	for (size_t i = 0; i < pages.size(); ++i) {
-		m_retiredPages.push(std::make_pair(fenceID, pages[i]));
+		pages[i]->m_lastUsedFrame = m_frameIndex;
+		m_pageCache.Retire(fenceID, pages[i]);
 	}
+	m_counters.m_pagesRetired += pages.size();
+	UpdatePeakInFlightBytes();
 }
 
 void LinearAllocationPageManager::FreeLargePages(uint64_t fenceID, const std::vector<LinearPage*>& pages)
 {
 	std::lock_guard <std::mutex> lockGuard(m_mutex);
 
-	while (!m_deleteQueue.empty() && GRAPHICS_CORE::g_commandManager.IsFenceComplete(m_deleteQueue.front().first))
-	{
-		delete m_deleteQueue.front().second;
-		m_deleteQueue.pop();
+	m_deleteQueue.Retire(IsFenceComplete, [&](LinearPage* pagePtr) {
+		m_counters.m_inFlightBytes -= pagePtr->m_pageSize;
+		delete pagePtr;
+	});
+
+	//keep the large pages for reuse until the size class reaches the cap
+	for (size_t i = 0; i < pages.size(); ++i) {
+		uint32_t sizeClass = GetLargePageClass(pages[i]->m_pageSize);
+		if (sizeClass < kNumLargePageClasses &&
+			m_retiredLargePages[sizeClass].GetCount() + m_availableLargePages[sizeClass].size() < m_largePageCap) {
+			m_retiredLargePages[sizeClass].Push(fenceID, pages[i]);
+			AddInFlightBytes(pages[i]->m_pageSize);
+		}
+		else {
+			DeleteLargePage(fenceID, pages[i]);
+		}
 	}
+}
 
+void LinearAllocationPageManager::DeleteLargePage(uint64_t fenceID, LinearPage* page)
+{
 	//To delete a memory, we should ummap the current gpu resource
-	for (size_t i = 0; i < pages.size(); ++i) {
-		pages[i]->Unmap();
-		m_deleteQueue.push(std::make_pair(fenceID, pages[i]));
+	page->Unmap();
+	m_deleteQueue.Push(fenceID, page);
+	AddInFlightBytes(page->m_pageSize);
+	m_largePageStats.m_released++;
+}
+
+LinearPage* LinearAllocationPageManager::RequestLargePage(size_t sizeInBytes)
+{
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+
+	//the request is too big to be pooled
+	uint32_t sizeClass = GetLargePageClass(sizeInBytes);
+	if (sizeClass == kNumLargePageClasses) {
+		m_largePageStats.m_misses++;
+		return CreateNewPage(sizeInBytes);
+	}
+
+	std::vector<LinearPage*>& availablePages = m_availableLargePages[sizeClass];
+	m_retiredLargePages[sizeClass].Retire(IsFenceComplete, [&](LinearPage* pagePtr) {
+		availablePages.push_back(pagePtr);
+		m_counters.m_inFlightBytes -= pagePtr->m_pageSize;
+	});
+
+	if (!availablePages.empty()) {
+		LinearPage* pagePtr = availablePages.back();
+		availablePages.pop_back();
+		m_largePageStats.m_hits++;
+		m_counters.m_pagesReused++;
+		return pagePtr;
 	}
+
+	//create the page with the full size of the class, so that it fits any later request of the class
+	m_largePageStats.m_misses++;
+	return CreateNewPage(GetDefaultPageSize() << (sizeClass + 1));
+}
+
+void LinearAllocationPageManager::SetLargePageCap(uint32_t capPerClass)
+{
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_largePageCap = capPerClass;
+}
+
+LargePageStats LinearAllocationPageManager::GetLargePageStats()
+{
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	return m_largePageStats;
+}
+
+uint32_t LinearAllocationPageManager::GetLargePageClass(size_t pageSize) const
+{
+	//class i contains the pages of (default page size << (i + 1))
+	size_t classSize = GetDefaultPageSize() << 1;
+	for (uint32_t i = 0; i < kNumLargePageClasses; ++i, classSize <<= 1) {
+		if (pageSize <= classSize)
+			return i;
+	}
+	return kNumLargePageClasses;
+}
+
+void LinearAllocationPageManager::SetTrimPolicy(uint32_t idleFrames, uint32_t highWaterPages)
+{
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_trimIdleFrames = idleFrames;
+	m_trimHighWater = highWaterPages;
+}
+
+void LinearAllocationPageManager::EndFrame()
+{
+	uint32_t idleFrames, highWater;
+	{
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		m_frameIndex++;
+		idleFrames = m_trimIdleFrames;
+		highWater = m_trimHighWater;
+	}
+	TrimPages(highWater, idleFrames);
+}
+
+void LinearAllocationPageManager::TrimPages(uint32_t maxAvailablePages, uint32_t idleFrames)
+{
+	//the cache holds its mutex while trimming, the pool is changed under m_mutex
+	m_pageCache.Trim(IsFenceComplete, m_frameIndex, maxAvailablePages, idleFrames, [this](LinearPage* pagePtr) {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		ReleasePage(pagePtr);
+	});
+}
+
+void LinearAllocationPageManager::ReleasePage(LinearPage* page)
+{
+	for (size_t i = 0; i < m_pagesPool.size(); ++i) {
+		if (m_pagesPool[i].get() == page) {
+			m_pagesPool[i].swap(m_pagesPool.back());
+			m_pagesPool.pop_back();
+			return;
+		}
+	}
+}
+
+void LinearAllocationPageManager::AddInFlightBytes(uint64_t size)
+{
+	m_counters.m_inFlightBytes += size;
+	UpdatePeakInFlightBytes();
+}
+
+void LinearAllocationPageManager::UpdatePeakInFlightBytes()
+{
+	uint64_t inFlightBytes = m_counters.m_inFlightBytes + m_pageCache.GetCounters().m_inFlightBytes;
+	uint64_t peakBytes = m_counters.m_peakInFlightBytes.load();
+	while (inFlightBytes > peakBytes && !m_counters.m_peakInFlightBytes.compare_exchange_weak(peakBytes, inFlightBytes)) {}
+}
+
+void LinearAllocationPageManager::ReportAllocatorStats(const LinearAllocatorStats& stats)
+{
+	m_counters.m_bytesRequested += stats.m_bytesRequested;
+	m_counters.m_bytesConsumed += stats.m_bytesConsumed;
+	m_counters.m_largePageCount += stats.m_largePageCount;
+}
+
+void LinearAllocationPageManager::SnapshotFrameStats()
+{
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+
+	LinearPageManagerStats cumulativeStats;
+	cumulativeStats.m_allocations.m_bytesRequested = m_counters.m_bytesRequested;
+	cumulativeStats.m_allocations.m_bytesConsumed = m_counters.m_bytesConsumed;
+	cumulativeStats.m_allocations.m_largePageCount = m_counters.m_largePageCount;
+	cumulativeStats.m_pagesCreated = m_counters.m_pagesCreated;
+	const LinearPageCacheCounters& cacheCounters = m_pageCache.GetCounters();
+	cumulativeStats.m_pagesReused = m_counters.m_pagesReused + cacheCounters.m_pagesReused;
+	cumulativeStats.m_pagesRetired = m_counters.m_pagesRetired;
+	cumulativeStats.m_lockWaitMicroseconds = cacheCounters.m_lockWaitMicroseconds;
+
+	//the counters of the frame are the differences from last snapshot
+	LinearPageManagerStats& frameStats = m_frameStats;
+	frameStats.m_allocations.m_bytesRequested = cumulativeStats.m_allocations.m_bytesRequested - m_lastCumulativeStats.m_allocations.m_bytesRequested;
+	frameStats.m_allocations.m_bytesConsumed = cumulativeStats.m_allocations.m_bytesConsumed - m_lastCumulativeStats.m_allocations.m_bytesConsumed;
+	frameStats.m_allocations.m_largePageCount = cumulativeStats.m_allocations.m_largePageCount - m_lastCumulativeStats.m_allocations.m_largePageCount;
+	frameStats.m_pagesCreated = cumulativeStats.m_pagesCreated - m_lastCumulativeStats.m_pagesCreated;
+	frameStats.m_pagesReused = cumulativeStats.m_pagesReused - m_lastCumulativeStats.m_pagesReused;
+	frameStats.m_pagesRetired = cumulativeStats.m_pagesRetired - m_lastCumulativeStats.m_pagesRetired;
+	frameStats.m_lockWaitMicroseconds = cumulativeStats.m_lockWaitMicroseconds - m_lastCumulativeStats.m_lockWaitMicroseconds;
+	m_lastCumulativeStats = cumulativeStats;
+
+	frameStats.m_pagesTotal = m_pagesPool.size();
+	frameStats.m_pagesWaiting = m_pageCache.GetRetiredCount() + m_deleteQueue.GetCount();
+	for (uint32_t i = 0; i < kNumLargePageClasses; ++i)
+		frameStats.m_pagesWaiting += m_retiredLargePages[i].GetCount();
+	frameStats.m_inFlightBytes = m_counters.m_inFlightBytes + cacheCounters.m_inFlightBytes;
+	frameStats.m_peakInFlightBytes = m_counters.m_peakInFlightBytes;
+}
+
+LinearPageManagerStats LinearAllocationPageManager::GetFrameStats()
+{
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	return m_frameStats;
+}
+
+size_t LinearAllocationPageManager::GetDefaultPageSize() const
+{
+	return m_allocationType == GPU_MEMORY_ALLOCATION ? gpuAllocatorPageSize : cpuAllocatorPageSize;
 }
 
 //the pages pool contains unique ptr of allocation pages
 //which means we can release the resources safely
 void LinearAllocationPageManager::Destroy() {
+	//the cached pages, even the pages parked in the magazines of other threads, are released with the pool
+	m_pageCache.Clear();
+
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
 	if (!m_pagesPool.empty()) {
 		m_pagesPool.clear();
 	}
+
+	for (uint32_t i = 0; i < kNumLargePageClasses; ++i) {
+		m_retiredLargePages[i].Flush([](LinearPage* page) { delete page; });
+		for (LinearPage* page : m_availableLargePages[i])
+			delete page;
+		m_availableLargePages[i].clear();
+	}
+
+	m_deleteQueue.Flush([](LinearPage* page) { delete page; });
 }
 
-LinearAllocationPageManager DynamicLinearMemoryAllocator::g_allocator[2];
+/*
+* UploadRingPool
+*/
+UploadRingRegion* UploadRingPool::AcquireRegion(LinearAllocationPageManager& pageManager)
+{
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+
+	//the ring page is created when the first ring allocation comes
+	if (m_ringPage == nullptr) {
+		m_ringPage = pageManager.CreatePersistentPage(cpuRingBufferSize);
+		m_freeRegions.clear();
+		for (uint32_t i = 0; i < kRegionCount; ++i) {
+			m_regions[i].m_baseOffset = i * kRegionSize;
+			m_regions[i].m_ring.Initialize(kRegionSize);
+			m_freeRegions.push_back(&m_regions[kRegionCount - 1 - i]);
+		}
+	}
+
+	if (m_freeRegions.empty())
+		return nullptr;
+	UploadRingRegion* region = m_freeRegions.back();
+	m_freeRegions.pop_back();
+	return region;
+}
+
+void UploadRingPool::ReleaseRegion(UploadRingRegion* region)
+{
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_freeRegions.push_back(region);
+}
+
+void UploadRingPool::Destroy()
+{
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_ringPage = nullptr;
+	m_freeRegions.clear();
+}
+
+/*
+* DynamicLinearMemoryAllocator
+*/
+LinearAllocationPageManager DynamicLinearMemoryAllocator::g_allocator[2] = {
+	{ CPU_MEMORY_ALLOCATION },
+	{ GPU_MEMORY_ALLOCATION }
+};
+
+UploadRingPool DynamicLinearMemoryAllocator::g_ringPool;
 
 DynamicAlloc DynamicLinearMemoryAllocator::Allocate(size_t size, size_t alignment)
 {
 	//from 100000000 to 011111111
 	const size_t alignmentMask = alignment - 1;
 	//calculate a aligned page size
-	const size_t alignPageSize = Mathematics::AlignUpWithMask<size_t>(size, alignment);
+	const size_t alignPageSize = Mathematics::AlignUpWithMask<size_t>(size, alignmentMask);
+
+	m_stats.m_bytesRequested += size;
+	m_pendingStats.m_bytesRequested += size;
+
+	//take the memory from the ring region if there is enough space
+	if (m_curType == CPU_RING_MEMORY_ALLOCATION) {
+		if (m_ringRegion == nullptr)
+			m_ringRegion = g_ringPool.AcquireRegion(g_allocator[m_pageType]);
+	}
+
+	size_t ringOffset;
+	if (m_ringRegion != nullptr) {
+		m_ringRegion->m_ring.ReleaseCompleted([](uint64_t fenceValue) {
+			return GRAPHICS_CORE::g_commandManager.IsFenceComplete(fenceValue);
+		});
+
+		//the regions are aligned by the region size, the offset keeps the alignment
+		if (m_ringRegion->m_ring.Allocate(alignPageSize, alignment, ringOffset)) {
+			ringOffset += m_ringRegion->m_baseOffset;
+			LinearPage* ringPage = g_ringPool.GetRingPage();
+			m_stats.m_bytesConsumed += alignPageSize;
+			m_pendingStats.m_bytesConsumed += alignPageSize;
+			DynamicAlloc dynamicAlloc(*ringPage, ringOffset, alignPageSize);
+			dynamicAlloc.m_cpuVirtualAddress = (uint8_t*)ringPage->m_cpuVirtualAddress + ringOffset;
+			dynamicAlloc.m_gpuVirtualAddress = ringPage->m_gpuVirtualAddress + ringOffset;
+			return dynamicAlloc;
+		}
+	}
 
 	//apply for a large page if the request size is bigger than current page size 
 	if (alignPageSize > m_curPageSize)
 		return AllocateLargePage(alignPageSize);
 
-	//align the current offset
-	m_curOffset = Mathematics::AlignUpWithMask<size_t>(m_curOffset, alignmentMask);
+	//align the current offset, the padding is consumed as well
+	size_t alignedOffset = Mathematics::AlignUpWithMask<size_t>(m_curOffset, alignmentMask);
+	m_stats.m_bytesConsumed += alignedOffset - m_curOffset;
+	m_pendingStats.m_bytesConsumed += alignedOffset - m_curOffset;
+	m_curOffset = alignedOffset;
 
 	//the memory of current page is not enough for the request
 	if (m_curOffset + alignPageSize > m_curPageSize) {
@@ -136,7 +402,7 @@ DynamicAlloc DynamicLinearMemoryAllocator::Allocate(size_t size, size_t alignmen
 	}
 
 	if (m_curPage == nullptr) {
-		m_curPage = g_allocator[m_curType].RequestPage(); //apply for default memory page
+		m_curPage = g_allocator[m_pageType].RequestPage(); //apply for default memory page
 		m_curOffset = 0;
 	}
 
@@ -146,34 +412,109 @@ DynamicAlloc DynamicLinearMemoryAllocator::Allocate(size_t size, size_t alignmen
 	dynamicAlloc.m_gpuVirtualAddress = m_curPage->m_gpuVirtualAddress + m_curOffset;
 
 	m_curOffset += alignPageSize;
+	m_stats.m_bytesConsumed += alignPageSize;
+	m_pendingStats.m_bytesConsumed += alignPageSize;
 
 	return dynamicAlloc;
 }
 
 void DynamicLinearMemoryAllocator::ClearUpPages(uint64_t fenceValue)
 {
-	if (m_curPage == nullptr)
-		return;
+	//the region keeps the retired segment, then other contexts can record into it
+	if (m_ringRegion != nullptr) {
+		m_ringRegion->m_ring.Retire(fenceValue);
+		g_ringPool.ReleaseRegion(m_ringRegion);
+		m_ringRegion = nullptr;
+	}
 
-	m_retiredPages.push_back(m_curPage);
-	m_curPage = nullptr;
-	m_curOffset = 0;
+	//the large pages have to be recycled even if no default page is used
+	if (m_curPage != nullptr) {
+		m_retiredPages.push_back(m_curPage);
+		m_curPage = nullptr;
+		m_curOffset = 0;
+	}
 
-	g_allocator[m_curType].DiscardPages(fenceValue, m_retiredPages);
+	g_allocator[m_pageType].DiscardPages(fenceValue, m_retiredPages);
 	m_retiredPages.clear();
 
-	g_allocator[m_curType].FreeLargePages(fenceValue, m_largePages);
+	g_allocator[m_pageType].FreeLargePages(fenceValue, m_largePages);
 	m_largePages.clear();
+
+	g_allocator[m_pageType].ReportAllocatorStats(m_pendingStats);
+	m_pendingStats = LinearAllocatorStats();
 }
 
 DynamicAlloc DynamicLinearMemoryAllocator::AllocateLargePage(size_t sizeInBytes)
 {
-	LinearPage* largeMemPage = g_allocator[m_curType].CreateNewPage(sizeInBytes);
+	LinearPage* largeMemPage = g_allocator[m_pageType].RequestLargePage(sizeInBytes);
 	m_largePages.push_back(largeMemPage);
 
+	m_stats.m_bytesConsumed += largeMemPage->m_pageSize;
+	m_stats.m_largePageCount++;
+	m_pendingStats.m_bytesConsumed += largeMemPage->m_pageSize;
+	m_pendingStats.m_largePageCount++;
+
 	DynamicAlloc largePage(*largeMemPage, 0, sizeInBytes);
 	largePage.m_cpuVirtualAddress = largeMemPage->m_cpuVirtualAddress;
 	largePage.m_gpuVirtualAddress = largeMemPage->m_gpuVirtualAddress;
 
 	return largePage;
 }
+
+DynamicAlloc ScratchBufferAllocator::Reserve(size_t size, size_t alignment, bool& aliased)
+{
+	LinearPage* pagePtr = nullptr;
+	ScratchRange range;
+	aliased = false;
+
+	if (size > m_planner.GetPageSize()) {
+		pagePtr = DynamicLinearMemoryAllocator::g_allocator[GPU_MEMORY_ALLOCATION].RequestLargePage(size);
+		m_largePages.push_back(pagePtr);
+		range.m_size = size;
+	}
+	else {
+		if (!m_planner.Allocate(size, alignment, range)) {
+			m_pages.push_back(DynamicLinearMemoryAllocator::g_allocator[GPU_MEMORY_ALLOCATION].RequestPage());
+			uint32_t pageIndex = m_planner.AddPage();
+			assert(pageIndex + 1 == m_pages.size());
+			bool allocated = m_planner.Allocate(size, alignment, range);
+			assert(allocated);
+		}
+		pagePtr = m_pages[range.m_pageIndex];
+		aliased = range.m_aliased;
+	}
+
+	DynamicAlloc scratch(*pagePtr, (size_t)range.m_offset, size);
+	scratch.m_cpuVirtualAddress = nullptr;
+	scratch.m_gpuVirtualAddress = pagePtr->m_gpuVirtualAddress + range.m_offset;
+	return scratch;
+}
+
+void ScratchBufferAllocator::Release(const DynamicAlloc& scratch)
+{
+	for (uint32_t pageIndex = 0; pageIndex < m_pages.size(); ++pageIndex) {
+		if (&scratch.m_resource == m_pages[pageIndex]) {
+			ScratchRange range;
+			range.m_pageIndex = pageIndex;
+			range.m_offset = scratch.offset;
+			range.m_size = scratch.size;
+			m_planner.Release(range);
+			return;
+		}
+	}
+	//the large pages are retired with the command list
+}
+
+void ScratchBufferAllocator::ClearUpPages(uint64_t fenceValue)
+{
+	LinearAllocationPageManager& pageManager = DynamicLinearMemoryAllocator::g_allocator[GPU_MEMORY_ALLOCATION];
+	if (!m_pages.empty()) {
+		pageManager.DiscardPages(fenceValue, m_pages);
+		m_pages.clear();
+	}
+	if (!m_largePages.empty()) {
+		pageManager.FreeLargePages(fenceValue, m_largePages);
+		m_largePages.clear();
+	}
+	m_planner.Reset();
+}
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "../gpuresource.h"
+#include "ringbufferallocator.h"
+#include "scratchaliasplanner.h"
+#include "linearpagecache.h"
+#include "deferredreleasequeue.h"
 #include <vector>
 #include <queue>
 #include <mutex>
+#include <atomic>
 
 //constant block is multiples of 16
 #define DEFAULT_ALIGN 256
@@ -11,12 +16,15 @@
 enum LinearAllocationType
 {
 	CPU_MEMORY_ALLOCATION = 0,
-	GPU_MEMORY_ALLOCATION = 1
+	GPU_MEMORY_ALLOCATION = 1,
+	//upload memory from the regions of the shared persistent mapped ring, recycled by fences
+	CPU_RING_MEMORY_ALLOCATION = 2
 };
 
 enum LinearAllocatorPageSize {
 	gpuAllocatorPageSize = 0x10000, //64k
-	cpuAllocatorPageSize = 0x200000 //2mb
+	cpuAllocatorPageSize = 0x200000, //2mb
+	cpuRingBufferSize = 0x800000 //8mb, shared by all the ring allocators
 };
 
 //The memory allocated based on Linear Page
@@ -37,15 +45,28 @@ struct DynamicAlloc
 class LinearPage : public GPUResource
 {
 public:
-	LinearPage(ID3D12Resource* pResource, D3D12_RESOURCE_STATES usage) : GPUResource()
+	LinearPage(ID3D12Resource* pResource, D3D12_RESOURCE_STATES usage, size_t pageSize = 0,
+		const PlacedAllocation& placedAllocation = PlacedAllocation()) : 
+		GPUResource(), m_pageSize(pageSize)
 	{
 		m_resource = pResource;
+		m_placedAllocation = placedAllocation;
 		m_usageState = usage;
-		m_resource->Map(0, nullptr, &m_cpuVirtualAddress);
+		//only the upload pages can be mapped, the default heap pages are gpu only
+		if (usage == D3D12_RESOURCE_STATE_GENERIC_READ)
+			m_resource->Map(0, nullptr, &m_cpuVirtualAddress);
 		m_gpuVirtualAddress = m_resource->GetGPUVirtualAddress();
 	}
 
-	~LinearPage(){}
+	//the page is released only after its fence completed
+	~LinearPage() {
+		Unmap();
+		if (m_resource != nullptr) {
+			m_resource->Release();
+			m_resource = nullptr;
+		}
+		PlacedHeapAllocator::Instance().Free(m_placedAllocation);
+	}
 
 	void Map() {
 		if (m_cpuVirtualAddress == nullptr)
@@ -61,44 +82,188 @@ public:
 
 	void* m_cpuVirtualAddress = nullptr;
 	D3D12_GPU_VIRTUAL_ADDRESS m_gpuVirtualAddress;
+	size_t m_pageSize;
+	//the frame that the page was used last time
+	uint64_t m_lastUsedFrame = 0;
+	//intrusive link used by the lock-free ready pages stack of LinearPageCache
+	LinearPage* m_nextReadyPage = nullptr;
+};
+
+class LinearAllocationPageManager;
+
+//The statistics of large page pools
+struct LargePageStats
+{
+	uint64_t m_hits = 0;
+	uint64_t m_misses = 0;
+	//the large pages deleted because the size class is full or too big
+	uint64_t m_released = 0;
+};
+
+//The telemetry of one dynamic linear allocator
+struct LinearAllocatorStats
+{
+	//the bytes asked by callers and the bytes taken from pages after alignment
+	uint64_t m_bytesRequested = 0;
+	uint64_t m_bytesConsumed = 0;
+	uint64_t m_largePageCount = 0;
+};
+
+//The telemetry of one page manager, snapshotted each frame
+struct LinearPageManagerStats
+{
+	//the counters of the last frame
+	LinearAllocatorStats m_allocations;
+	uint64_t m_pagesCreated = 0;
+	uint64_t m_pagesReused = 0;
+	uint64_t m_pagesRetired = 0;
+	uint64_t m_lockWaitMicroseconds = 0;
+
+	//the states at the end of the last frame
+	uint64_t m_pagesTotal = 0;
+	uint64_t m_pagesWaiting = 0;
+	uint64_t m_inFlightBytes = 0;
+	uint64_t m_peakInFlightBytes = 0;
 };
 
 //Linear Page Allocation 
 class LinearAllocationPageManager
 {
 public:
-	LinearAllocationPageManager();
+	LinearAllocationPageManager(LinearAllocationType type);
 	LinearPage* RequestPage(void);
 	LinearPage* CreateNewPage(size_t pageSize = 0);
+	//the page lives until the page manager destroyed
+	LinearPage* CreatePersistentPage(size_t pageSize);
 	void DiscardPages(uint64_t fenceID, const std::vector<LinearPage*>& pages);
 	void FreeLargePages(uint64_t fenceID, const std::vector <LinearPage*>& pages);
 	void Destroy();
 
+	//large pages are pooled in power-of-two size classes
+	LinearPage* RequestLargePage(size_t sizeInBytes);
+	void SetLargePageCap(uint32_t capPerClass);
+	LargePageStats GetLargePageStats();
+
+	static const uint32_t kNumLargePageClasses = 8;
+	static const uint32_t kDefaultLargePageCap = 4;
+
+	//release the available pages idle for more than idle frames, or above the high-water count
+	void SetTrimPolicy(uint32_t idleFrames, uint32_t highWaterPages);
+	void EndFrame();
+	//release the available pages until no more than maxAvailablePages left
+	void TrimPages(uint32_t maxAvailablePages, uint32_t idleFrames = 0xFFFFFFFF);
+
+	static const uint32_t kDefaultTrimIdleFrames = 300;
+	static const uint32_t kDefaultTrimHighWater = 16;
+
+	//telemetry
+	void ReportAllocatorStats(const LinearAllocatorStats& stats);
+	void SnapshotFrameStats();
+	LinearPageManagerStats GetFrameStats();
+
 private:
-	static LinearAllocationType allocationType;
+	//the size class of a large page, return kNumLargePageClasses if the page is not pooled
+	uint32_t GetLargePageClass(size_t pageSize) const;
+	size_t GetDefaultPageSize() const;
+	void DeleteLargePage(uint64_t fenceID, LinearPage* page);
+	void AddInFlightBytes(uint64_t size);
+	//the peak of the bytes in flight, counting the pages of the cache
+	void UpdatePeakInFlightBytes();
+	//the caller should hold the mutex
+	void ReleasePage(LinearPage* page);
+
+	//the cumulative counters, updated without lock
+	struct Counters
+	{
+		std::atomic<uint64_t> m_bytesRequested{ 0 };
+		std::atomic<uint64_t> m_bytesConsumed{ 0 };
+		std::atomic<uint64_t> m_largePageCount{ 0 };
+		std::atomic<uint64_t> m_pagesCreated{ 0 };
+		std::atomic<uint64_t> m_pagesReused{ 0 };
+		std::atomic<uint64_t> m_pagesRetired{ 0 };
+		//the large pages and the pages to delete, the cache counts its own pages
+		std::atomic<uint64_t> m_inFlightBytes{ 0 };
+		std::atomic<uint64_t> m_peakInFlightBytes{ 0 };
+	};
+
 	LinearAllocationType m_allocationType;
 	//all the linear pages
 	std::vector<std::unique_ptr<LinearPage>> m_pagesPool;
-	//the linear pages waits for reuse
-	std::queue<std::pair<uint64_t, LinearPage*>> m_retiredPages;
+	//the default size pages waiting for reuse and available to use, shared by all threads
+	//it takes its own mutex before m_mutex, never after
+	LinearPageCache<LinearPage> m_pageCache;
 	//the linear pages ready to delete
-	std::queue<std::pair<uint64_t, LinearPage*>> m_deleteQueue;
-	//the linear pages available to use
-	std::queue<LinearPage*> m_availablePages;
+	DeferredReleaseQueue<LinearPage> m_deleteQueue;
 	std::mutex m_mutex;
+
+	//the large pages waits for reuse and available to use, one queue per size class
+	DeferredReleaseQueue<LinearPage> m_retiredLargePages[kNumLargePageClasses];
+	std::vector<LinearPage*> m_availableLargePages[kNumLargePageClasses];
+	uint32_t m_largePageCap = kDefaultLargePageCap;
+	LargePageStats m_largePageStats;
+
+	std::atomic<uint64_t> m_frameIndex{ 0 };
+	uint32_t m_trimIdleFrames = kDefaultTrimIdleFrames;
+	uint32_t m_trimHighWater = kDefaultTrimHighWater;
+
+	Counters m_counters;
+	//the cumulative counters at last snapshot
+	LinearPageManagerStats m_lastCumulativeStats;
+	LinearPageManagerStats m_frameStats;
 };
 
 
+//One region of the shared upload ring
+struct UploadRingRegion
+{
+	//the offset of the region in the ring page
+	size_t m_baseOffset = 0;
+	RingBufferAllocator m_ring;
+};
+
+//Upload Ring Pool
+//one persistent page is divided into the ring regions, so the resident upload memory does not grow with the contexts
+//a ring allocator holds a region while its context records, and gives it back with the fence of the submission
+//the retired segments stay in the region, so the next holder allocates after them and never overwrites them
+class UploadRingPool
+{
+public:
+	static const uint32_t kRegionCount = 8;
+	static const size_t kRegionSize = cpuRingBufferSize / kRegionCount;
+
+	UploadRingPool() : m_ringPage(nullptr) {}
+
+	//return nullptr if every region is held, the caller falls back to the pages
+	UploadRingRegion* AcquireRegion(LinearAllocationPageManager& pageManager);
+	void ReleaseRegion(UploadRingRegion* region);
+	LinearPage* GetRingPage() const { return m_ringPage; }
+	//the ring page is released by the page manager
+	void Destroy();
+
+private:
+	std::mutex m_mutex;
+	LinearPage* m_ringPage;
+	UploadRingRegion m_regions[kRegionCount];
+	//the most recently released region is taken first
+	std::vector<UploadRingRegion*> m_freeRegions;
+};
+
 //Dynamic Memory Allocator
 //apply for one linear memory page, and split the memory for requests
 class DynamicLinearMemoryAllocator
 {
+	friend class ScratchBufferAllocator;
 public:
 	DynamicLinearMemoryAllocator(LinearAllocationType type) :
-		m_curType(type), m_curPage(nullptr), m_curPageSize(0), m_curOffset(0) {
-		if (type == CPU_MEMORY_ALLOCATION)
+		m_curType(type), m_pageType(type), m_curPage(nullptr), m_curPageSize(0), m_curOffset(0),
+		m_ringRegion(nullptr) {
+		//the ring allocator falls back to cpu pages when the ring is full or no region is free
+		if (type == CPU_RING_MEMORY_ALLOCATION)
+			m_pageType = CPU_MEMORY_ALLOCATION;
+
+		if (m_pageType == CPU_MEMORY_ALLOCATION)
 			m_curPageSize = LinearAllocatorPageSize::cpuAllocatorPageSize;
-		else if (type == GPU_MEMORY_ALLOCATION)
+		else if (m_pageType == GPU_MEMORY_ALLOCATION)
 			m_curPageSize = LinearAllocatorPageSize::gpuAllocatorPageSize;
 
 		assert(m_curPageSize != 0);
@@ -107,24 +272,75 @@ public:
 	DynamicAlloc Allocate(size_t size, size_t alignment = DEFAULT_ALIGN);
 	void ClearUpPages(uint64_t fenceValue);
 	static void DestroyAll() {
+		g_ringPool.Destroy();
 		g_allocator[CPU_MEMORY_ALLOCATION].Destroy();
 		g_allocator[GPU_MEMORY_ALLOCATION].Destroy();
 	}
 
+	//the cumulative telemetry of current allocator
+	const LinearAllocatorStats& GetStats() const { return m_stats; }
+	//snapshot the telemetry and trim the idle pages, should be called once per frame
+	static void EndFrame() {
+		g_allocator[CPU_MEMORY_ALLOCATION].SnapshotFrameStats();
+		g_allocator[GPU_MEMORY_ALLOCATION].SnapshotFrameStats();
+		g_allocator[CPU_MEMORY_ALLOCATION].EndFrame();
+		g_allocator[GPU_MEMORY_ALLOCATION].EndFrame();
+	}
+	//release the available pages, for example after loading a level
+	static void TrimPages(uint32_t maxAvailablePages = 0) {
+		g_allocator[CPU_MEMORY_ALLOCATION].TrimPages(maxAvailablePages);
+		g_allocator[GPU_MEMORY_ALLOCATION].TrimPages(maxAvailablePages);
+	}
+	static LinearPageManagerStats GetFrameStats(LinearAllocationType type) {
+		return g_allocator[type == GPU_MEMORY_ALLOCATION ? GPU_MEMORY_ALLOCATION : CPU_MEMORY_ALLOCATION].GetFrameStats();
+	}
+
 private:
 	DynamicAlloc AllocateLargePage(size_t sizeInBytes);
 
 	//all dynamic linear memory allocators are based on two page managers
 	static LinearAllocationPageManager g_allocator[2];
+	//the upload ring shared by the CPU_RING_MEMORY_ALLOCATION allocators
+	static UploadRingPool g_ringPool;
 
 
 	LinearAllocationType m_curType;
+	//the type of page manager
+	LinearAllocationType m_pageType;
 	LinearPage* m_curPage; 
 	size_t m_curPageSize;
 	size_t m_curOffset;
 	std::vector<LinearPage*> m_retiredPages;
 	std::vector<LinearPage*> m_largePages; 
+
+	//the region of the shared ring held until the next ClearUpPages, for CPU_RING_MEMORY_ALLOCATION
+	UploadRingRegion* m_ringRegion;
+
+	//the counters not reported to the page manager yet
+	LinearAllocatorStats m_stats;
+	LinearAllocatorStats m_pendingStats;
 };
 
+//Scratch Buffer Allocator
+//transient uav buffers on the GPU_MEMORY_ALLOCATION pages, the pages are recycled by fences
+//the ranges released inside one command list are aliased by the later reservations
+class ScratchBufferAllocator
+{
+public:
+	ScratchBufferAllocator() { m_planner.Initialize(LinearAllocatorPageSize::gpuAllocatorPageSize); }
+
+	//aliased is true if the memory was used by a released range of the command list
+	DynamicAlloc Reserve(size_t size, size_t alignment, bool& aliased);
+	//the lifetime of the scratch ended, the later reservations may alias its memory
+	void Release(const DynamicAlloc& scratch);
+	void ClearUpPages(uint64_t fenceValue);
 
+	const ScratchPlannerStats& GetStats() const { return m_planner.GetStats(); }
 
+private:
+	ScratchAliasPlanner m_planner;
+	//the pages of the planner, indexed by the page index of the ranges
+	std::vector<LinearPage*> m_pages;
+	//the scratch bigger than one page owns a large page, it is never aliased
+	std::vector<LinearPage*> m_largePages;
+};
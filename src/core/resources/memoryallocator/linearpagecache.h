@@ -0,0 +1,268 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "deferredreleasequeue.h"
+
+//Lock-free stack of the pages ready to be reused, TPage links the stack with m_nextReadyPage
+//the head packs the page pointer(low 48 bits) with a tag(high 16 bits) to avoid ABA problem
+//the tag does not protect the memory, a pop reads the link of a head page another thread may take
+//so the pops are counted in two epochs, and the pages are released only after they were detached
+//from the stack and the pops of the older epoch left
+template<typename TPage>
+class LinearPageStack
+{
+public:
+	LinearPageStack() : m_head(0), m_popEpoch(0) {
+		m_activePops[0].store(0);
+		m_activePops[1].store(0);
+	}
+
+	void Push(TPage* page) {
+		uint64_t oldHead = m_head.load(std::memory_order_relaxed);
+		uint64_t newHead;
+		do {
+			page->m_nextReadyPage = (TPage*)(oldHead & kPointerMask);
+			newHead = ((oldHead & ~kPointerMask) + kTagIncrement) | (uint64_t)page;
+		} while (!m_head.compare_exchange_weak(oldHead, newHead,
+			std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	TPage* Pop() {
+		//join the current epoch, retry if the epoch moved before the pop was counted
+		uint32_t epoch;
+		while (true) {
+			epoch = m_popEpoch.load() & 1;
+			m_activePops[epoch].fetch_add(1);
+			if ((m_popEpoch.load() & 1) == epoch)
+				break;
+			m_activePops[epoch].fetch_sub(1);
+		}
+
+		uint64_t oldHead = m_head.load(std::memory_order_acquire);
+		uint64_t newHead;
+		TPage* page;
+		do {
+			page = (TPage*)(oldHead & kPointerMask);
+			if (page == nullptr)
+				break;
+			//the page may be taken by another thread, but it is not released before this pop left the epoch
+			newHead = ((oldHead & ~kPointerMask) + kTagIncrement) | (uint64_t)page->m_nextReadyPage;
+		} while (!m_head.compare_exchange_weak(oldHead, newHead,
+			std::memory_order_acquire, std::memory_order_acquire));
+
+		m_activePops[epoch].fetch_sub(1, std::memory_order_release);
+		if (page != nullptr)
+			page->m_nextReadyPage = nullptr;
+		return page;
+	}
+
+	//take all the pages out of the stack, no pop reads their links once the call returned
+	//the callers are serialized by the owner
+	TPage* DetachAll() {
+		uint64_t oldHead = m_head.load();
+		while (!m_head.compare_exchange_weak(oldHead, (oldHead & ~kPointerMask) + kTagIncrement)) {}
+
+		//the pops started later see the empty head, wait for the pops which may still read the detached links
+		uint32_t oldEpoch = m_popEpoch.fetch_add(1) & 1;
+		while (m_activePops[oldEpoch].load() != 0)
+			std::this_thread::yield();
+		return (TPage*)(oldHead & kPointerMask);
+	}
+
+	void Clear() { m_head.store(0); }
+
+private:
+	static const uint64_t kPointerMask = 0x0000FFFFFFFFFFFFull;
+	static const uint64_t kTagIncrement = 0x0001000000000000ull;
+
+	std::atomic<uint64_t> m_head;
+	std::atomic<uint32_t> m_popEpoch;
+	//the pops running in each epoch
+	std::atomic<uint32_t> m_activePops[2];
+};
+
+//The counters of a page cache, updated without lock
+struct LinearPageCacheCounters
+{
+	std::atomic<uint64_t> m_pagesReused{ 0 };
+	std::atomic<uint64_t> m_lockWaitMicroseconds{ 0 };
+	//the bytes of the retired pages whose fences are not completed
+	std::atomic<uint64_t> m_inFlightBytes{ 0 };
+};
+
+//Linear Page Cache
+//the fixed-size pages of one page manager, recycled by fences and shared by all threads
+//page rollover pops from the magazine of the thread without any lock, a drained magazine takes a batch
+//from the lock-free stack, and the mutex is only taken to retire the completed pages, create pages and trim
+//the cache neither owns the pages nor touches the device, the owner creates and releases them
+//so it can be benchmarked with fake pages, TPage has m_nextReadyPage, m_pageSize and m_lastUsedFrame
+//the cache outlives the threads which request its pages
+template<typename TPage>
+class LinearPageCache
+{
+public:
+	//the caches sharing one slot use the same thread magazines, so they should not live at the same time
+	static const uint32_t kMaxSlots = 4;
+
+	//a magazine holds one refill batch, so a thread takes the shared stack once every kMagazineSize rollovers
+	//it also bounds the pages parked in one thread, which are not trimmed until the thread uses them
+	static const uint32_t kMagazineSize = 4;
+
+	explicit LinearPageCache(uint32_t slot) : m_slot(slot), m_generation(NextGeneration()) {
+		assert(slot < kMaxSlots);
+	}
+
+	LinearPageCache(const LinearPageCache&) = delete;
+	LinearPageCache& operator=(const LinearPageCache&) = delete;
+
+	//createPage is called under the mutex when no page can be reused
+	template<typename FenceCompleteFunc, typename CreatePageFunc>
+	TPage* Request(FenceCompleteFunc isFenceComplete, CreatePageFunc createPage) {
+		Magazine& magazine = t_magazines[m_slot];
+		//the magazine was filled before the last Clear, its pages were released with the cache
+		uint64_t generation = m_generation.load(std::memory_order_relaxed);
+		if (magazine.m_generation != generation) {
+			magazine.m_owner = this;
+			magazine.m_generation = generation;
+			magazine.m_count = 0;
+		}
+
+		//only take the slow path when the thread cache is drained
+		if (magazine.m_count == 0)
+			Refill(magazine, isFenceComplete, createPage);
+
+		assert(magazine.m_count > 0);
+		return magazine.m_pages[--magazine.m_count];
+	}
+
+	//lock-free, the page is reusable after the fence completed
+	void Retire(uint64_t fenceValue, TPage* page) {
+		m_retiredPages.Push(fenceValue, page);
+		m_counters.m_inFlightBytes += page->m_pageSize;
+	}
+
+	//release the ready pages idle for more than idleFrames, or above maxAvailablePages
+	//the pages parked in the thread magazines are not trimmed
+	template<typename FenceCompleteFunc, typename ReleasePageFunc>
+	void Trim(FenceCompleteFunc isFenceComplete, uint64_t frameIndex, uint32_t maxAvailablePages, uint32_t idleFrames,
+		ReleasePageFunc releasePage) {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+
+		//move the completed retired pages into the ready pages, so that they can be trimmed as well
+		m_retiredPages.Retire(isFenceComplete, [&](TPage* pagePtr) {
+			m_counters.m_inFlightBytes -= pagePtr->m_pageSize;
+			m_readyPages.Push(pagePtr);
+		});
+
+		//detach the pages before releasing any of them, a concurrent refill may still read the links of the stack
+		//the list starts from the most recently used pages
+		std::vector<TPage*> keptPages;
+		TPage* nextPage = m_readyPages.DetachAll();
+		while (TPage* pagePtr = nextPage) {
+			nextPage = pagePtr->m_nextReadyPage;
+			pagePtr->m_nextReadyPage = nullptr;
+			bool isIdle = frameIndex - pagePtr->m_lastUsedFrame > idleFrames;
+			if (!isIdle && keptPages.size() < maxAvailablePages)
+				keptPages.push_back(pagePtr);
+			else
+				releasePage(pagePtr);
+		}
+
+		//keep the order of the stack
+		for (auto it = keptPages.rbegin(); it != keptPages.rend(); ++it)
+			m_readyPages.Push(*it);
+	}
+
+	//forget all the pages before the owner releases them, no thread should request at the same time
+	//the magazines of the other threads can not be reached, they are dropped on their next request by the generation
+	void Clear() {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		m_generation.store(NextGeneration());
+		m_readyPages.Clear();
+		m_retiredPages.Flush([](TPage*) {});
+		m_counters.m_inFlightBytes = 0;
+	}
+
+	size_t GetRetiredCount() const { return m_retiredPages.GetCount(); }
+	const LinearPageCacheCounters& GetCounters() const { return m_counters; }
+
+private:
+	//the per-thread cache of the pages
+	struct Magazine
+	{
+		//return the cached pages to the shared stack when the thread exits
+		~Magazine() {
+			if (m_owner != nullptr && m_count > 0 && m_owner->m_generation.load() == m_generation) {
+				for (uint32_t i = 0; i < m_count; ++i)
+					m_owner->m_readyPages.Push(m_pages[i]);
+			}
+			m_count = 0;
+		}
+
+		LinearPageCache* m_owner = nullptr;
+		//the generation of the owner when the magazine was filled, 0 for never
+		uint64_t m_generation = 0;
+		TPage* m_pages[kMagazineSize];
+		uint32_t m_count = 0;
+	};
+
+	//the generations are unique among all the caches, so a magazine never takes the pages of another cache
+	static uint64_t NextGeneration() {
+		static std::atomic<uint64_t> nextGeneration{ 1 };
+		return nextGeneration++;
+	}
+
+	template<typename FenceCompleteFunc, typename CreatePageFunc>
+	void Refill(Magazine& magazine, FenceCompleteFunc isFenceComplete, CreatePageFunc createPage) {
+		//grab a batch of ready pages from the lock-free stack
+		while (magazine.m_count < kMagazineSize) {
+			TPage* pagePtr = m_readyPages.Pop();
+			if (pagePtr == nullptr)
+				break;
+			magazine.m_pages[magazine.m_count++] = pagePtr;
+			m_counters.m_pagesReused++;
+		}
+
+		if (magazine.m_count > 0)
+			return;
+
+		std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		m_counters.m_lockWaitMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - waitStart).count();
+
+		//process the retired pages, the surplus goes to the shared stack
+		m_retiredPages.Retire(isFenceComplete, [&](TPage* pagePtr) {
+			m_counters.m_inFlightBytes -= pagePtr->m_pageSize;
+			m_counters.m_pagesReused++;
+			if (magazine.m_count < kMagazineSize)
+				magazine.m_pages[magazine.m_count++] = pagePtr;
+			else
+				m_readyPages.Push(pagePtr);
+		});
+
+		//there is no page to reuse, create a new page
+		if (magazine.m_count == 0)
+			magazine.m_pages[magazine.m_count++] = createPage();
+	}
+
+	static thread_local Magazine t_magazines[kMaxSlots];
+
+	uint32_t m_slot;
+	std::atomic<uint64_t> m_generation;
+	//the pages waiting for their fences
+	DeferredReleaseQueue<TPage> m_retiredPages;
+	//the pages available to use, shared by all threads
+	LinearPageStack<TPage> m_readyPages;
+	std::mutex m_mutex;
+	LinearPageCacheCounters m_counters;
+};
+
+template<typename TPage>
+thread_local typename LinearPageCache<TPage>::Magazine LinearPageCache<TPage>::t_magazines[LinearPageCache<TPage>::kMaxSlots];
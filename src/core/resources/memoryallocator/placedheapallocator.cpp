@@ -0,0 +1,188 @@
+#include "placedheapallocator.h"
+#include "graphicscore.h"
+#include "mathematics/bitoperation.h"
+
+void PlacedHeapAllocator::CreatePlacedResource(PlacedHeapType heapType, MemoryCategory category,
+	const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initState, const D3D12_CLEAR_VALUE* clearValue,
+	PlacedAllocation& allocation, ID3D12Resource** resource)
+{
+	D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = GRAPHICS_CORE::g_device->GetResourceAllocationInfo(0, 1, &desc);
+	allocation.m_heapType = heapType;
+	allocation.m_category = category;
+
+	//find a heap with enough space
+	ID3D12Heap* heap = nullptr;
+	{
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		if (AllocateFromHeaps(heapType, allocationInfo.SizeInBytes, allocationInfo.Alignment, allocation))
+			heap = m_heapsPool[heapType][allocation.m_heapIndex]->m_heap;
+	}
+
+	//create a new heap, the resource bigger than default size owns a dedicated heap
+	//the range is taken before the heap is shared, so the other threads can not fill it first
+	if (heap == nullptr) {
+		uint64_t heapSize = Mathematics::AlignUp<uint64_t>(allocationInfo.SizeInBytes + allocationInfo.Alignment,
+			D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+		std::unique_ptr<PlacedHeap> placedHeap = CreateHeap(heapType, heapSize > kDefaultHeapSize ? heapSize : kDefaultHeapSize);
+		placedHeap->m_dedicated = heapSize > kDefaultHeapSize;
+		bool allocated = placedHeap->m_allocator.Allocate(allocationInfo.SizeInBytes,
+			allocationInfo.Alignment, allocation.m_range);
+		assert(allocated);
+		heap = placedHeap->m_heap;
+
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		allocation.m_heapIndex = AddHeap(heapType, std::move(placedHeap));
+	}
+
+	//the range goes back to the heap if the resource can not be created
+	HRESULT hr = GRAPHICS_CORE::g_device->CreatePlacedResource(heap, allocation.m_range.m_offset, &desc,
+		initState, clearValue, IID_PPV_ARGS(resource));
+	if (FAILED(hr)) {
+		ID3D12Heap* emptyHeap = nullptr;
+		{
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			emptyHeap = FreeRange(allocation);
+		}
+		if (emptyHeap != nullptr)
+			emptyHeap->Release();
+		allocation.m_range = TLSFAllocation();
+		ThrowIfFailed(hr);
+	}
+
+	MemoryBudgetManager::Instance().ReportAllocation(category, allocation.m_range.m_size);
+}
+
+void PlacedHeapAllocator::Free(PlacedAllocation& allocation)
+{
+	if (!allocation.IsValid())
+		return;
+
+	ID3D12Heap* emptyHeap = nullptr;
+	{
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		emptyHeap = FreeRange(allocation);
+	}
+	//the dedicated heap is not resident anymore once its resource is freed
+	if (emptyHeap != nullptr)
+		emptyHeap->Release();
+
+	MemoryBudgetManager::Instance().ReportRelease(allocation.m_category, allocation.m_range.m_size);
+	allocation.m_range = TLSFAllocation();
+}
+
+void PlacedHeapAllocator::Destroy()
+{
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	for (uint32_t i = 0; i < PLACED_HEAP_TYPE_COUNT; ++i) {
+		for (std::unique_ptr<PlacedHeap>& heap : m_heapsPool[i]) {
+			if (heap != nullptr && heap->m_heap != nullptr)
+				heap->m_heap->Release();
+		}
+		m_heapsPool[i].clear();
+	}
+}
+
+PlacedHeapReport PlacedHeapAllocator::GetReport(PlacedHeapType heapType)
+{
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+
+	PlacedHeapReport report;
+	uint64_t freeSize = 0;
+	for (std::unique_ptr<PlacedHeap>& heap : m_heapsPool[heapType]) {
+		if (heap == nullptr)
+			continue;
+		TLSFReport heapReport = heap->m_allocator.GetReport();
+		report.m_heapCount++;
+		report.m_capacity += heapReport.m_capacity;
+		report.m_usedSize += heapReport.m_usedSize;
+		report.m_allocationCount += heapReport.m_allocationCount;
+		report.m_freeBlockCount += heapReport.m_freeBlockCount;
+		if (heapReport.m_largestFreeBlock > report.m_largestFreeBlock)
+			report.m_largestFreeBlock = heapReport.m_largestFreeBlock;
+		freeSize += heapReport.m_freeSize;
+	}
+
+	if (freeSize > 0)
+		report.m_fragmentation = 1.0f - (float)((double)report.m_largestFreeBlock / (double)freeSize);
+	return report;
+}
+
+bool PlacedHeapAllocator::AllocateFromHeaps(PlacedHeapType heapType, uint64_t size, uint64_t alignment,
+	PlacedAllocation& allocation)
+{
+	std::vector<std::unique_ptr<PlacedHeap>>& heapsPool = m_heapsPool[heapType];
+	for (uint32_t heapIndex = 0; heapIndex < heapsPool.size(); ++heapIndex) {
+		PlacedHeap* placedHeap = heapsPool[heapIndex].get();
+		if (placedHeap == nullptr || placedHeap->m_dedicated)
+			continue;
+		if (placedHeap->m_allocator.Allocate(size, alignment, allocation.m_range)) {
+			allocation.m_heapIndex = heapIndex;
+			return true;
+		}
+	}
+	return false;
+}
+
+uint32_t PlacedHeapAllocator::AddHeap(PlacedHeapType heapType, std::unique_ptr<PlacedHeap> placedHeap)
+{
+	//reuse the slot of a released dedicated heap
+	std::vector<std::unique_ptr<PlacedHeap>>& heapsPool = m_heapsPool[heapType];
+	for (uint32_t heapIndex = 0; heapIndex < heapsPool.size(); ++heapIndex) {
+		if (heapsPool[heapIndex] == nullptr) {
+			heapsPool[heapIndex] = std::move(placedHeap);
+			return heapIndex;
+		}
+	}
+	heapsPool.push_back(std::move(placedHeap));
+	return (uint32_t)(heapsPool.size() - 1);
+}
+
+ID3D12Heap* PlacedHeapAllocator::FreeRange(const PlacedAllocation& allocation)
+{
+	//the heaps may be destroyed before the resources at shutdown
+	std::vector<std::unique_ptr<PlacedHeap>>& heapsPool = m_heapsPool[allocation.m_heapType];
+	if (allocation.m_heapIndex >= heapsPool.size() || heapsPool[allocation.m_heapIndex] == nullptr)
+		return nullptr;
+
+	PlacedHeap* placedHeap = heapsPool[allocation.m_heapIndex].get();
+	placedHeap->m_allocator.Free(allocation.m_range);
+	if (!placedHeap->m_dedicated)
+		return nullptr;
+
+	//the only resource of the dedicated heap is gone
+	ID3D12Heap* emptyHeap = placedHeap->m_heap;
+	heapsPool[allocation.m_heapIndex].reset();
+	return emptyHeap;
+}
+
+std::unique_ptr<PlacedHeapAllocator::PlacedHeap> PlacedHeapAllocator::CreateHeap(PlacedHeapType heapType, uint64_t heapSize)
+{
+	D3D12_HEAP_DESC heapDesc = {};
+	heapDesc.SizeInBytes = heapSize;
+	heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	heapDesc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heapDesc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	heapDesc.Properties.CreationNodeMask = 1;
+	heapDesc.Properties.VisibleNodeMask = 1;
+
+	switch (heapType) {
+	case PLACED_HEAP_UPLOAD_BUFFER:
+		heapDesc.Properties.Type = D3D12_HEAP_TYPE_UPLOAD;
+		heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+		break;
+	case PLACED_HEAP_DEFAULT_TEXTURE:
+		heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+		heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+		break;
+	default:
+		heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+		heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+		break;
+	}
+
+	std::unique_ptr<PlacedHeap> placedHeap(new PlacedHeap());
+	ThrowIfFailed(GRAPHICS_CORE::g_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&placedHeap->m_heap)));
+	placedHeap->m_heap->SetName(L"PlacedResourceHeap");
+	placedHeap->m_allocator.Initialize(heapSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	return placedHeap;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "headers.h"
+#include "tlsfallocator.h"
+#include "memorybudget.h"
+#include <memory>
+#include <mutex>
+
+//the heap types of placed resources
+//resource heap tier 1 requires buffers and textures in different heaps
+enum PlacedHeapType
+{
+	PLACED_HEAP_DEFAULT_BUFFER = 0,
+	PLACED_HEAP_UPLOAD_BUFFER = 1,
+	PLACED_HEAP_DEFAULT_TEXTURE = 2,
+	PLACED_HEAP_TYPE_COUNT = 3
+};
+
+//The memory of a placed resource inside one heap
+struct PlacedAllocation
+{
+	PlacedHeapType m_heapType = PLACED_HEAP_DEFAULT_BUFFER;
+	uint32_t m_heapIndex = 0;
+	TLSFAllocation m_range;
+	//the budget category reported to MemoryBudgetManager
+	MemoryCategory m_category = MEMORY_CATEGORY_BUFFER;
+
+	bool IsValid() const { return m_range.IsValid(); }
+};
+
+//The fragmentation report of one heap type
+struct PlacedHeapReport
+{
+	uint32_t m_heapCount = 0;
+	uint64_t m_capacity = 0;
+	uint64_t m_usedSize = 0;
+	uint64_t m_largestFreeBlock = 0;
+	uint32_t m_allocationCount = 0;
+	uint32_t m_freeBlockCount = 0;
+	float m_fragmentation = 0.0f;
+};
+
+//Placed Heap Allocator
+//sub-allocate large ID3D12Heaps by tlsf allocators, and place resources into them
+//the ranges are allocated under the mutex, the heaps and the resources are created by the driver out of it
+//a resource bigger than the default size owns a dedicated heap, which is released with the resource
+class PlacedHeapAllocator
+{
+public:
+	static const uint64_t kDefaultHeapSize = 0x4000000; //64mb
+
+	static PlacedHeapAllocator& Instance() {
+		static PlacedHeapAllocator instance;
+		return instance;
+	}
+
+	~PlacedHeapAllocator() { Destroy(); }
+
+	void CreatePlacedResource(PlacedHeapType heapType, MemoryCategory category, const D3D12_RESOURCE_DESC& desc,
+		D3D12_RESOURCE_STATES initState, const D3D12_CLEAR_VALUE* clearValue,
+		PlacedAllocation& allocation, ID3D12Resource** resource);
+	void Free(PlacedAllocation& allocation);
+	void Destroy();
+
+	PlacedHeapReport GetReport(PlacedHeapType heapType);
+
+private:
+	PlacedHeapAllocator() {}
+
+	struct PlacedHeap
+	{
+		ID3D12Heap* m_heap = nullptr;
+		TLSFAllocator m_allocator;
+		//holds a single resource, never shared with the other resources
+		bool m_dedicated = false;
+	};
+
+	//the caller should hold the mutex
+	bool AllocateFromHeaps(PlacedHeapType heapType, uint64_t size, uint64_t alignment, PlacedAllocation& allocation);
+	uint32_t AddHeap(PlacedHeapType heapType, std::unique_ptr<PlacedHeap> placedHeap);
+	//give the range back, return the dedicated heap emptied by it
+	ID3D12Heap* FreeRange(const PlacedAllocation& allocation);
+
+	//the driver call, out of the mutex
+	std::unique_ptr<PlacedHeap> CreateHeap(PlacedHeapType heapType, uint64_t heapSize);
+
+	//the released dedicated heaps leave empty slots, so the heap indices of the allocations stay valid
+	std::vector<std::unique_ptr<PlacedHeap>> m_heapsPool[PLACED_HEAP_TYPE_COUNT];
+	std::mutex m_mutex;
+};
@@ -0,0 +1,75 @@
+#include "ringbufferallocator.h"
+#include <cassert>
+
+static inline size_t AlignUpOffset(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void RingBufferAllocator::Initialize(size_t capacity)
+{
+	m_capacity = capacity;
+	m_head = 0;
+	m_tail = 0;
+	m_usedSize = 0;
+	m_pendingSize = 0;
+	m_retiredSegments = std::queue<RetiredSegment>();
+}
+
+bool RingBufferAllocator::Allocate(size_t size, size_t alignment, size_t& offset)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+	if (size == 0 || size > m_capacity || m_usedSize == m_capacity)
+		return false;
+
+	//restart from the beginning when nothing is in flight
+	if (m_usedSize == 0) {
+		m_head = 0;
+		m_tail = 0;
+	}
+
+	size_t alignedHead = AlignUpOffset(m_head, alignment);
+	size_t consumedSize = 0;
+
+	if (m_head >= m_tail) {
+		//the free space is [head, capacity) and [0, tail)
+		if (alignedHead + size <= m_capacity) {
+			offset = alignedHead;
+			consumedSize = alignedHead + size - m_head;
+		}
+		else if (size <= m_tail) {
+			//wrap around, the bytes at the end of the ring are wasted
+			offset = 0;
+			consumedSize = m_capacity - m_head + size;
+		}
+		else {
+			return false;
+		}
+	}
+	else {
+		//the free space is [head, tail)
+		if (alignedHead + size > m_tail)
+			return false;
+		offset = alignedHead;
+		consumedSize = alignedHead + size - m_head;
+	}
+
+	m_head = (offset + size) % m_capacity;
+	m_usedSize += consumedSize;
+	m_pendingSize += consumedSize;
+	return true;
+}
+
+void RingBufferAllocator::Retire(uint64_t fenceValue)
+{
+	if (m_pendingSize == 0)
+		return;
+
+	RetiredSegment segment;
+	segment.m_fenceValue = fenceValue;
+	segment.m_head = m_head;
+	segment.m_size = m_pendingSize;
+	m_retiredSegments.push(segment);
+	m_pendingSize = 0;
+}
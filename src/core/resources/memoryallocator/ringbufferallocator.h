@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <queue>
+
+//Ring Buffer Allocator
+//only manages the head and tail offsets of the ring, so it does not depend on the device
+//each retired segment records a fence, the tail advances when the fence completes
+class RingBufferAllocator
+{
+public:
+	RingBufferAllocator() : m_capacity(0), m_head(0), m_tail(0), m_usedSize(0), m_pendingSize(0) {}
+
+	void Initialize(size_t capacity);
+	//return false if there is no enough continuous space in the ring
+	bool Allocate(size_t size, size_t alignment, size_t& offset);
+	//the memory allocated since last retirement is in use until the fence completes
+	void Retire(uint64_t fenceValue);
+
+	//advance the tail for the completed fences
+	template<typename FenceCompleteFunc>
+	void ReleaseCompleted(FenceCompleteFunc isFenceComplete) {
+		while (!m_retiredSegments.empty() && isFenceComplete(m_retiredSegments.front().m_fenceValue)) {
+			m_tail = m_retiredSegments.front().m_head;
+			m_usedSize -= m_retiredSegments.front().m_size;
+			m_retiredSegments.pop();
+		}
+	}
+
+	size_t GetCapacity() const { return m_capacity; }
+	//the bytes in flight, including the padding for alignment and wrapping
+	size_t GetUsedSize() const { return m_usedSize; }
+	bool IsInitialized() const { return m_capacity != 0; }
+
+private:
+	struct RetiredSegment
+	{
+		uint64_t m_fenceValue;
+		size_t m_head;
+		size_t m_size;
+	};
+
+	size_t m_capacity;
+	size_t m_head;
+	size_t m_tail;
+	size_t m_usedSize;
+	//the bytes allocated but not retired
+	size_t m_pendingSize;
+	std::queue<RetiredSegment> m_retiredSegments;
+};
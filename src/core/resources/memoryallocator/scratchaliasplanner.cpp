@@ -0,0 +1,108 @@
+#include "scratchaliasplanner.h"
+#include <cassert>
+
+static uint64_t AlignUpOffset(uint64_t value, uint64_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void ScratchAliasPlanner::Initialize(uint64_t pageSize)
+{
+	assert(pageSize > 0);
+	m_pageSize = pageSize;
+	Reset();
+}
+
+bool ScratchAliasPlanner::Allocate(uint64_t size, uint64_t alignment, ScratchRange& range)
+{
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+	if (size == 0 || size > m_pageSize)
+		return false;
+
+	for (uint32_t pageIndex = 0; pageIndex < m_pages.size(); ++pageIndex) {
+		if (AllocateInPage(pageIndex, size, alignment, range))
+			return true;
+	}
+	return false;
+}
+
+bool ScratchAliasPlanner::AllocateInPage(uint32_t pageIndex, uint64_t size, uint64_t alignment, ScratchRange& range)
+{
+	ScratchPage& page = m_pages[pageIndex];
+
+	//first fit, the low offsets are reused first so the touched memory stays small
+	for (size_t i = 0; i < page.m_freeRanges.size(); ++i) {
+		FreeRange freeRange = page.m_freeRanges[i];
+		uint64_t alignedOffset = AlignUpOffset(freeRange.m_offset, alignment);
+		uint64_t rangeEnd = freeRange.m_offset + freeRange.m_size;
+		if (alignedOffset + size > rangeEnd)
+			continue;
+
+		//split the free range, keep the padding and the tail
+		page.m_freeRanges.erase(page.m_freeRanges.begin() + i);
+		if (alignedOffset + size < rangeEnd)
+			page.m_freeRanges.insert(page.m_freeRanges.begin() + i, FreeRange{ alignedOffset + size, rangeEnd - alignedOffset - size });
+		if (alignedOffset > freeRange.m_offset)
+			page.m_freeRanges.insert(page.m_freeRanges.begin() + i, FreeRange{ freeRange.m_offset, alignedOffset - freeRange.m_offset });
+
+		range.m_pageIndex = pageIndex;
+		range.m_offset = alignedOffset;
+		range.m_size = size;
+		range.m_aliased = alignedOffset < page.m_highWater;
+
+		if (range.m_aliased)
+			m_stats.m_aliasedSize += size;
+		if (alignedOffset + size > page.m_highWater)
+			page.m_highWater = alignedOffset + size;
+
+		m_stats.m_usedSize += size;
+		if (m_stats.m_usedSize > m_stats.m_peakUsedSize)
+			m_stats.m_peakUsedSize = m_stats.m_usedSize;
+		return true;
+	}
+	return false;
+}
+
+void ScratchAliasPlanner::Release(const ScratchRange& range)
+{
+	assert(range.IsValid() && range.m_pageIndex < m_pages.size());
+	std::vector<FreeRange>& freeRanges = m_pages[range.m_pageIndex].m_freeRanges;
+
+	//insert by offset
+	size_t index = 0;
+	while (index < freeRanges.size() && freeRanges[index].m_offset < range.m_offset)
+		++index;
+	assert(index == freeRanges.size() || freeRanges[index].m_offset >= range.m_offset + range.m_size);
+	freeRanges.insert(freeRanges.begin() + index, FreeRange{ range.m_offset, range.m_size });
+
+	//merge with the next range
+	if (index + 1 < freeRanges.size() &&
+		freeRanges[index].m_offset + freeRanges[index].m_size == freeRanges[index + 1].m_offset) {
+		freeRanges[index].m_size += freeRanges[index + 1].m_size;
+		freeRanges.erase(freeRanges.begin() + index + 1);
+	}
+
+	//merge with the previous range
+	if (index > 0 && freeRanges[index - 1].m_offset + freeRanges[index - 1].m_size == freeRanges[index].m_offset) {
+		freeRanges[index - 1].m_size += freeRanges[index].m_size;
+		freeRanges.erase(freeRanges.begin() + index);
+	}
+
+	assert(m_stats.m_usedSize >= range.m_size);
+	m_stats.m_usedSize -= range.m_size;
+}
+
+uint32_t ScratchAliasPlanner::AddPage()
+{
+	assert(m_pageSize > 0);
+	ScratchPage page;
+	page.m_freeRanges.push_back(FreeRange{ 0, m_pageSize });
+	m_pages.push_back(page);
+	m_stats.m_pageCount = (uint32_t)m_pages.size();
+	return m_stats.m_pageCount - 1;
+}
+
+void ScratchAliasPlanner::Reset()
+{
+	m_pages.clear();
+	m_stats = ScratchPlannerStats();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//The range of one scratch allocation inside the scratch pages
+struct ScratchRange
+{
+	static const uint32_t kInvalidPage = 0xFFFFFFFF;
+
+	uint32_t m_pageIndex = kInvalidPage;
+	uint64_t m_offset = 0;
+	uint64_t m_size = 0;
+	//the range overlaps the memory used before, a uav barrier is required before writing
+	bool m_aliased = false;
+
+	bool IsValid() const { return m_pageIndex != kInvalidPage; }
+};
+
+struct ScratchPlannerStats
+{
+	uint32_t m_pageCount = 0;
+	uint64_t m_usedSize = 0;
+	uint64_t m_peakUsedSize = 0;
+	//the bytes served by aliasing the released ranges
+	uint64_t m_aliasedSize = 0;
+};
+
+//Scratch Alias Planner
+//plan the transient ranges of one command list inside fixed-size pages
+//the released ranges are reused by the later allocations, so the ranges with disjoint lifetimes alias the same memory
+//the planner does not touch the device, the pages are created by the caller
+class ScratchAliasPlanner
+{
+public:
+	ScratchAliasPlanner() : m_pageSize(0) {}
+
+	void Initialize(uint64_t pageSize);
+
+	//return false when no page has enough space, the caller adds a page and retries
+	bool Allocate(uint64_t size, uint64_t alignment, ScratchRange& range);
+	//the lifetime of the range ended, its memory can be aliased
+	void Release(const ScratchRange& range);
+	//return the index of the new page
+	uint32_t AddPage();
+	//drop all the pages, called when the command list is closed
+	void Reset();
+
+	uint64_t GetPageSize() const { return m_pageSize; }
+	uint32_t GetPageCount() const { return (uint32_t)m_pages.size(); }
+	const ScratchPlannerStats& GetStats() const { return m_stats; }
+
+private:
+	struct FreeRange
+	{
+		uint64_t m_offset;
+		uint64_t m_size;
+	};
+
+	struct ScratchPage
+	{
+		//sorted by offset, the neighbours are always merged
+		std::vector<FreeRange> m_freeRanges;
+		//the end of the memory touched by the command list
+		uint64_t m_highWater = 0;
+	};
+
+	bool AllocateInPage(uint32_t pageIndex, uint64_t size, uint64_t alignment, ScratchRange& range);
+
+	uint64_t m_pageSize;
+	std::vector<ScratchPage> m_pages;
+	ScratchPlannerStats m_stats;
+};
@@ -0,0 +1,332 @@
+#include "tlsfallocator.h"
+#include <cassert>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//index of the lowest set bit
+static inline uint32_t FindFirstSet(uint64_t value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctzll(value);
+#endif
+}
+
+//index of the highest set bit
+static inline uint32_t FindLastSet(uint64_t value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return (uint32_t)index;
+#else
+	return 63 - (uint32_t)__builtin_clzll(value);
+#endif
+}
+
+static inline uint64_t AlignUpValue(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+TLSFAllocator::TLSFAllocator() :
+	m_firstLevelBitMap(0), m_capacity(0), m_granularity(1),
+	m_usedSize(0), m_allocationCount(0)
+{
+	memset(m_secondLevelBitMap, 0, sizeof(m_secondLevelBitMap));
+	memset(m_freeLists, 0xFF, sizeof(m_freeLists));
+}
+
+void TLSFAllocator::Initialize(uint64_t capacity, uint64_t granularity)
+{
+	//the granularity must be the power of 2
+	assert(granularity != 0 && (granularity & (granularity - 1)) == 0);
+
+	m_granularity = granularity;
+	m_capacity = capacity & ~(granularity - 1);
+	Reset();
+}
+
+void TLSFAllocator::Reset()
+{
+	m_blocks.clear();
+	m_unusedBlocks.clear();
+	m_firstLevelBitMap = 0;
+	memset(m_secondLevelBitMap, 0, sizeof(m_secondLevelBitMap));
+	memset(m_freeLists, 0xFF, sizeof(m_freeLists));
+	m_usedSize = 0;
+	m_allocationCount = 0;
+
+	if (m_capacity == 0)
+		return;
+
+	//the whole range is one free block at the beginning
+	uint32_t blockIndex = CreateBlock();
+	Block& block = m_blocks[blockIndex];
+	block.m_offset = 0;
+	block.m_size = m_capacity;
+	InsertFreeBlock(blockIndex);
+}
+
+bool TLSFAllocator::Allocate(uint64_t size, uint64_t alignment, TLSFAllocation& allocation)
+{
+	assert(alignment == 0 || (alignment & (alignment - 1)) == 0);
+
+	if (size == 0)
+		return false;
+
+	if (alignment < m_granularity)
+		alignment = m_granularity;
+	size = AlignUpValue(size, m_granularity);
+
+	//the block found should contain the padding for alignment
+	uint64_t searchSize = size + alignment - m_granularity;
+	if (searchSize > m_capacity)
+		return false;
+
+	uint32_t firstLevel, secondLevel;
+	MappingSearch(searchSize, firstLevel, secondLevel);
+	uint32_t blockIndex = FindSuitableBlock(firstLevel, secondLevel);
+	if (blockIndex == kInvalidBlock)
+		return false;
+
+	RemoveFreeBlock(blockIndex);
+
+	//give the padding in front back to the free lists
+	uint64_t padding = AlignUpValue(m_blocks[blockIndex].m_offset, alignment) - m_blocks[blockIndex].m_offset;
+	if (padding > 0) {
+		uint32_t alignedIndex = SplitBlock(blockIndex, padding);
+		InsertFreeBlock(blockIndex);
+		blockIndex = alignedIndex;
+	}
+
+	//give the remaining tail back to the free lists
+	if (m_blocks[blockIndex].m_size > size) {
+		uint32_t tailIndex = SplitBlock(blockIndex, size);
+		InsertFreeBlock(tailIndex);
+	}
+
+	Block& block = m_blocks[blockIndex];
+	block.m_isFree = false;
+	m_usedSize += block.m_size;
+	m_allocationCount++;
+
+	allocation.m_offset = block.m_offset;
+	allocation.m_size = block.m_size;
+	allocation.m_blockIndex = blockIndex;
+	return true;
+}
+
+void TLSFAllocator::Free(const TLSFAllocation& allocation)
+{
+	assert(allocation.IsValid() && allocation.m_blockIndex < m_blocks.size());
+
+	uint32_t blockIndex = allocation.m_blockIndex;
+	assert(!m_blocks[blockIndex].m_isFree && m_blocks[blockIndex].m_offset == allocation.m_offset);
+
+	m_usedSize -= m_blocks[blockIndex].m_size;
+	m_allocationCount--;
+	m_blocks[blockIndex].m_isFree = true;
+
+	//merge with the free neighbours
+	uint32_t nextIndex = m_blocks[blockIndex].m_nextPhysical;
+	if (nextIndex != kInvalidBlock && m_blocks[nextIndex].m_isFree) {
+		RemoveFreeBlock(nextIndex);
+		MergeWithNext(blockIndex);
+	}
+
+	uint32_t prevIndex = m_blocks[blockIndex].m_prevPhysical;
+	if (prevIndex != kInvalidBlock && m_blocks[prevIndex].m_isFree) {
+		RemoveFreeBlock(prevIndex);
+		MergeWithNext(prevIndex);
+		blockIndex = prevIndex;
+	}
+
+	InsertFreeBlock(blockIndex);
+}
+
+TLSFReport TLSFAllocator::GetReport() const
+{
+	TLSFReport report;
+	report.m_capacity = m_capacity;
+	report.m_usedSize = m_usedSize;
+	report.m_allocationCount = m_allocationCount;
+
+	for (uint32_t firstLevel = 0; firstLevel < kFirstLevelCount; ++firstLevel) {
+		for (uint32_t secondLevel = 0; secondLevel < kSecondLevelCount; ++secondLevel) {
+			uint32_t blockIndex = m_freeLists[firstLevel][secondLevel];
+			while (blockIndex != kInvalidBlock) {
+				const Block& block = m_blocks[blockIndex];
+				report.m_freeSize += block.m_size;
+				report.m_freeBlockCount++;
+				if (block.m_size > report.m_largestFreeBlock)
+					report.m_largestFreeBlock = block.m_size;
+				blockIndex = block.m_nextFree;
+			}
+		}
+	}
+
+	if (report.m_freeSize > 0)
+		report.m_fragmentation = 1.0f - (float)((double)report.m_largestFreeBlock / (double)report.m_freeSize);
+	return report;
+}
+
+void TLSFAllocator::MappingInsert(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) const
+{
+	uint64_t units = size / m_granularity;
+	if (units < kSecondLevelCount) {
+		//small blocks are linearly mapped into the first list
+		firstLevel = 0;
+		secondLevel = (uint32_t)units;
+	}
+	else {
+		uint32_t lastSet = FindLastSet(units);
+		firstLevel = lastSet - kSecondLevelLog2 + 1;
+		secondLevel = (uint32_t)(units >> (lastSet - kSecondLevelLog2)) ^ kSecondLevelCount;
+	}
+}
+
+void TLSFAllocator::MappingSearch(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) const
+{
+	//round up the size so that any block of the list found is big enough
+	uint64_t units = size / m_granularity;
+	if (units >= kSecondLevelCount) {
+		uint64_t round = (1ull << (FindLastSet(units) - kSecondLevelLog2)) - 1;
+		units += round;
+	}
+	MappingInsert(units * m_granularity, firstLevel, secondLevel);
+}
+
+uint32_t TLSFAllocator::FindSuitableBlock(uint32_t firstLevel, uint32_t secondLevel) const
+{
+	if (firstLevel >= kFirstLevelCount)
+		return kInvalidBlock;
+
+	uint32_t secondLevelMap = m_secondLevelBitMap[firstLevel] & (~0u << secondLevel);
+	if (secondLevelMap == 0) {
+		//search the larger first level lists
+		if (firstLevel + 1 >= kFirstLevelCount)
+			return kInvalidBlock;
+		uint64_t firstLevelMap = m_firstLevelBitMap & (~0ull << (firstLevel + 1));
+		if (firstLevelMap == 0)
+			return kInvalidBlock;
+		firstLevel = FindFirstSet(firstLevelMap);
+		secondLevelMap = m_secondLevelBitMap[firstLevel];
+	}
+	secondLevel = FindFirstSet(secondLevelMap);
+	return m_freeLists[firstLevel][secondLevel];
+}
+
+void TLSFAllocator::InsertFreeBlock(uint32_t blockIndex)
+{
+	Block& block = m_blocks[blockIndex];
+	block.m_isFree = true;
+
+	uint32_t firstLevel, secondLevel;
+	MappingInsert(block.m_size, firstLevel, secondLevel);
+
+	uint32_t headIndex = m_freeLists[firstLevel][secondLevel];
+	block.m_prevFree = kInvalidBlock;
+	block.m_nextFree = headIndex;
+	if (headIndex != kInvalidBlock)
+		m_blocks[headIndex].m_prevFree = blockIndex;
+	m_freeLists[firstLevel][secondLevel] = blockIndex;
+
+	m_firstLevelBitMap |= 1ull << firstLevel;
+	m_secondLevelBitMap[firstLevel] |= 1u << secondLevel;
+}
+
+void TLSFAllocator::RemoveFreeBlock(uint32_t blockIndex)
+{
+	Block& block = m_blocks[blockIndex];
+
+	uint32_t firstLevel, secondLevel;
+	MappingInsert(block.m_size, firstLevel, secondLevel);
+
+	if (block.m_prevFree != kInvalidBlock)
+		m_blocks[block.m_prevFree].m_nextFree = block.m_nextFree;
+	else
+		m_freeLists[firstLevel][secondLevel] = block.m_nextFree;
+	if (block.m_nextFree != kInvalidBlock)
+		m_blocks[block.m_nextFree].m_prevFree = block.m_prevFree;
+
+	//clear the bits when the list is empty
+	if (m_freeLists[firstLevel][secondLevel] == kInvalidBlock) {
+		m_secondLevelBitMap[firstLevel] &= ~(1u << secondLevel);
+		if (m_secondLevelBitMap[firstLevel] == 0)
+			m_firstLevelBitMap &= ~(1ull << firstLevel);
+	}
+
+	block.m_prevFree = kInvalidBlock;
+	block.m_nextFree = kInvalidBlock;
+	block.m_isFree = false;
+}
+
+uint32_t TLSFAllocator::SplitBlock(uint32_t blockIndex, uint64_t size)
+{
+	//create block may grow the vector, do not hold the reference before it
+	uint32_t newIndex = CreateBlock();
+	Block& block = m_blocks[blockIndex];
+	Block& newBlock = m_blocks[newIndex];
+
+	newBlock.m_offset = block.m_offset + size;
+	newBlock.m_size = block.m_size - size;
+	newBlock.m_prevPhysical = blockIndex;
+	newBlock.m_nextPhysical = block.m_nextPhysical;
+	if (block.m_nextPhysical != kInvalidBlock)
+		m_blocks[block.m_nextPhysical].m_prevPhysical = newIndex;
+
+	block.m_size = size;
+	block.m_nextPhysical = newIndex;
+	return newIndex;
+}
+
+void TLSFAllocator::MergeWithNext(uint32_t blockIndex)
+{
+	Block& block = m_blocks[blockIndex];
+	uint32_t nextIndex = block.m_nextPhysical;
+	Block& nextBlock = m_blocks[nextIndex];
+
+	block.m_size += nextBlock.m_size;
+	block.m_nextPhysical = nextBlock.m_nextPhysical;
+	if (nextBlock.m_nextPhysical != kInvalidBlock)
+		m_blocks[nextBlock.m_nextPhysical].m_prevPhysical = blockIndex;
+
+	ReleaseBlock(nextIndex);
+}
+
+uint32_t TLSFAllocator::CreateBlock()
+{
+	uint32_t blockIndex;
+	if (!m_unusedBlocks.empty()) {
+		blockIndex = m_unusedBlocks.back();
+		m_unusedBlocks.pop_back();
+	}
+	else {
+		blockIndex = (uint32_t)m_blocks.size();
+		m_blocks.emplace_back();
+	}
+
+	Block& block = m_blocks[blockIndex];
+	block.m_offset = 0;
+	block.m_size = 0;
+	block.m_prevPhysical = kInvalidBlock;
+	block.m_nextPhysical = kInvalidBlock;
+	block.m_prevFree = kInvalidBlock;
+	block.m_nextFree = kInvalidBlock;
+	block.m_isFree = false;
+	return blockIndex;
+}
+
+void TLSFAllocator::ReleaseBlock(uint32_t blockIndex)
+{
+	m_blocks[blockIndex].m_isFree = false;
+	m_blocks[blockIndex].m_size = 0;
+	m_unusedBlocks.push_back(blockIndex);
+}
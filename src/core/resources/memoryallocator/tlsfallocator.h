@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+//The range allocated by tlsf allocator
+struct TLSFAllocation
+{
+	uint64_t m_offset = 0;
+	uint64_t m_size = 0;
+	uint32_t m_blockIndex = 0xFFFFFFFF;
+
+	bool IsValid() const { return m_blockIndex != 0xFFFFFFFF; }
+};
+
+//The fragmentation report of tlsf allocator
+struct TLSFReport
+{
+	uint64_t m_capacity = 0;
+	uint64_t m_usedSize = 0;
+	uint64_t m_freeSize = 0;
+	uint64_t m_largestFreeBlock = 0;
+	uint32_t m_allocationCount = 0;
+	uint32_t m_freeBlockCount = 0;
+	//0 means all the free memory is one block
+	float m_fragmentation = 0.0f;
+};
+
+//Two-level segregated fit allocator
+//it only manages the offsets inside a range, so it does not depend on the device
+//both allocation and free are O(1)
+class TLSFAllocator
+{
+public:
+	TLSFAllocator();
+
+	void Initialize(uint64_t capacity, uint64_t granularity);
+	bool Allocate(uint64_t size, uint64_t alignment, TLSFAllocation& allocation);
+	void Free(const TLSFAllocation& allocation);
+	void Reset();
+
+	TLSFReport GetReport() const;
+	uint64_t GetCapacity() const { return m_capacity; }
+	uint64_t GetUsedSize() const { return m_usedSize; }
+	bool IsEmpty() const { return m_allocationCount == 0; }
+
+private:
+	static const uint32_t kInvalidBlock = 0xFFFFFFFF;
+	static const uint32_t kSecondLevelLog2 = 4;
+	static const uint32_t kSecondLevelCount = 1 << kSecondLevelLog2;
+	static const uint32_t kFirstLevelCount = 64;
+
+	struct Block
+	{
+		uint64_t m_offset;
+		uint64_t m_size;
+		uint32_t m_prevPhysical;
+		uint32_t m_nextPhysical;
+		uint32_t m_prevFree;
+		uint32_t m_nextFree;
+		bool m_isFree;
+	};
+
+	//map the size to the free lists
+	void MappingInsert(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) const;
+	void MappingSearch(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) const;
+	uint32_t FindSuitableBlock(uint32_t firstLevel, uint32_t secondLevel) const;
+
+	void InsertFreeBlock(uint32_t blockIndex);
+	void RemoveFreeBlock(uint32_t blockIndex);
+	//split the block, return the index of the block behind
+	uint32_t SplitBlock(uint32_t blockIndex, uint64_t size);
+	void MergeWithNext(uint32_t blockIndex);
+
+	uint32_t CreateBlock();
+	void ReleaseBlock(uint32_t blockIndex);
+
+	std::vector<Block> m_blocks;
+	std::vector<uint32_t> m_unusedBlocks;
+
+	uint64_t m_firstLevelBitMap;
+	uint32_t m_secondLevelBitMap[kFirstLevelCount];
+	uint32_t m_freeLists[kFirstLevelCount][kSecondLevelCount];
+
+	uint64_t m_capacity;
+	uint64_t m_granularity;
+	uint64_t m_usedSize;
+	uint32_t m_allocationCount;
+};
@@ -1,4 +1,5 @@
 #include "pixelbuffer.h"
+#include "graphicscore.h"
 
 DXGI_FORMAT PixelBuffer::GetBaseFormat(DXGI_FORMAT Format)
 {
@@ -312,6 +313,8 @@ void PixelBuffer::AssociateWithResource(ID3D12Device* device, const std::wstring
 	ID3D12Resource* resource, D3D12_RESOURCE_STATES currentState) {
 
     assert(resource != nullptr);
+    //the views of the previous resource are invalid
+    ReleaseViews();
 
     D3D12_RESOURCE_DESC resourceDesc = resource->GetDesc();
 
@@ -333,6 +336,7 @@ void PixelBuffer::CreateTextureResource(ID3D12Device* device, const std::wstring
     CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
     ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE,
         &resourceDesc, D3D12_RESOURCE_STATE_COMMON, &clearValue, IID_PPV_ARGS(&m_resource)));
+    TrackCommittedMemory(MEMORY_CATEGORY_RENDER_TARGET);
 
     m_usageState = D3D12_RESOURCE_STATE_COMMON;
     m_gpuAddress = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
@@ -351,8 +355,45 @@ void PixelBuffer::CreateTextureResource(ID3D12Device* device, const std::wstring
     CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
     ThrowIfFailed(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE,
         &resourceDesc, m_usageState, &clearValue, IID_PPV_ARGS(&m_resource)));
+    TrackCommittedMemory(MEMORY_CATEGORY_RENDER_TARGET);
   
     m_gpuAddress = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
     m_resource->SetName(name.c_str());
 }
 
+
+D3D12_CPU_DESCRIPTOR_HANDLE PixelBuffer::GetOrCreateView(PIXEL_VIEW_TYPE type, DXGI_FORMAT format,
+    uint32_t mipSlice, uint32_t firstArraySlice, uint32_t flags) const {
+    assert(m_resource != nullptr);
+    PixelViewKey key = { type, format, mipSlice, firstArraySlice, flags };
+
+    std::lock_guard<std::mutex> guard(m_viewMutex);
+    for (const CachedPixelView& view : m_views) {
+        if (view.m_key == key)
+            return view.m_handle;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE handle = GRAPHICS_CORE::AllocatorDescriptors(GetViewHeapType(type));
+    CreateView(key, handle);
+    m_views.push_back({ key, handle });
+    return handle;
+}
+
+void PixelBuffer::ReleaseViews() {
+    std::lock_guard<std::mutex> guard(m_viewMutex);
+    for (const CachedPixelView& view : m_views)
+        GRAPHICS_CORE::FreeDescriptors(GetViewHeapType(view.m_key.m_type), view.m_handle);
+    m_views.clear();
+}
+
+D3D12_DESCRIPTOR_HEAP_TYPE PixelBuffer::GetViewHeapType(PIXEL_VIEW_TYPE type) {
+    switch (type)
+    {
+    case PIXEL_VIEW_RTV:
+        return D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+    case PIXEL_VIEW_DSV:
+        return D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+    default:
+        return D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    }
+}
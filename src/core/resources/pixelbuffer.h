@@ -1,11 +1,42 @@
 #pragma once
+#include <mutex>
+#include <vector>
 #include "gpuresource.h"
 
+enum PIXEL_VIEW_TYPE
+{
+	PIXEL_VIEW_SRV = 0,
+	PIXEL_VIEW_RTV = 1,
+	PIXEL_VIEW_UAV = 2,
+	PIXEL_VIEW_DSV = 3,
+};
+
+//the key of a view in the view cache of the pixel buffer
+struct PixelViewKey
+{
+	PIXEL_VIEW_TYPE m_type;
+	DXGI_FORMAT m_format;
+	uint32_t m_mipSlice;
+	uint32_t m_firstArraySlice;
+	uint32_t m_flags; //the read only flags of the dsv
+
+	bool operator==(const PixelViewKey& key) const {
+		return m_type == key.m_type && m_format == key.m_format && m_mipSlice == key.m_mipSlice &&
+			m_firstArraySlice == key.m_firstArraySlice && m_flags == key.m_flags;
+	}
+};
 
 class PixelBuffer : public GPUResource
 {
 public:
 	PixelBuffer() : m_width(0), m_height(0), m_arraySize(0), m_format(DXGI_FORMAT_UNKNOWN){}
+	~PixelBuffer() { ReleaseViews(); }
+
+	//the views are freed with the resource
+	virtual void Destroy() override {
+		ReleaseViews();
+		GPUResource::Destroy();
+	}
 
 	uint32_t GetWidth() { return m_width; }
 	uint32_t GetHeight() { return m_height; }
@@ -36,6 +67,14 @@ protected:
 	static DXGI_FORMAT GetStencilFormat(DXGI_FORMAT Format);
 	static size_t BytesPerPixel(DXGI_FORMAT Format);
 
+	//the views are created on the first request and cached until the resource is destroyed
+	D3D12_CPU_DESCRIPTOR_HANDLE GetOrCreateView(PIXEL_VIEW_TYPE type, DXGI_FORMAT format,
+		uint32_t mipSlice = 0, uint32_t firstArraySlice = 0, uint32_t flags = 0) const;
+	//write the view of the key to the descriptor, implemented by the buffers
+	virtual void CreateView(const PixelViewKey& key, D3D12_CPU_DESCRIPTOR_HANDLE handle) const = 0;
+	void ReleaseViews();
+	static D3D12_DESCRIPTOR_HEAP_TYPE GetViewHeapType(PIXEL_VIEW_TYPE type);
+
 
 protected:
 	uint32_t m_width;
@@ -43,4 +82,14 @@ protected:
 	uint32_t m_arraySize;
 	DXGI_FORMAT m_format;
 
+private:
+	struct CachedPixelView
+	{
+		PixelViewKey m_key;
+		D3D12_CPU_DESCRIPTOR_HANDLE m_handle;
+	};
+
+	//a buffer has few views, so the cache is searched linearly
+	mutable std::mutex m_viewMutex;
+	mutable std::vector<CachedPixelView> m_views;
 };
@@ -7,7 +7,7 @@ void ReadbackBuffer::Create(const std::wstring& name,
 	Destroy();
 
 	m_elementCount = numElements;
-	m_elementSize = m_elementSize;
+	m_elementSize = elementSize;
 	m_bufferSize = m_elementCount * m_elementSize;
 	m_usageState = D3D12_RESOURCE_STATE_COPY_DEST;
 
@@ -31,8 +31,9 @@ void ReadbackBuffer::Create(const std::wstring& name,
 	resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 	resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-	assert(GRAPHICS_CORE::g_device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+	ThrowIfFailed(GRAPHICS_CORE::g_device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &resourceDesc,
 		D3D12_RESOURCE_STATES::D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m_resource)));
+	TrackCommittedMemory(MEMORY_CATEGORY_UPLOAD);
 
 	m_gpuAddress = m_resource->GetGPUVirtualAddress();
 
@@ -27,9 +27,7 @@ void SamplerDesc::SetAddressMode(D3D12_TEXTURE_ADDRESS_MODE addressMode) {
 
 D3D12_CPU_DESCRIPTOR_HANDLE SamplerDesc::CreateSamplerDescHandle()
 {
-	D3D12_CPU_DESCRIPTOR_HANDLE allocatedHandle = GRAPHICS_CORE::AllocatorDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
-	GRAPHICS_CORE::g_device->CreateSampler(this, allocatedHandle);
-	return allocatedHandle;
+	return GRAPHICS_CORE::g_samplerManager.GetSampler(*this);
 }
 
 void SamplerDesc::CreateSamplerDescHandle(D3D12_CPU_DESCRIPTOR_HANDLE handle)
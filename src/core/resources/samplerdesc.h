@@ -8,6 +8,7 @@ public:
 
 	void SetAddressMode(D3D12_TEXTURE_ADDRESS_MODE addressMode);
 
+	//the descriptor is shared by the samplers with the same states
 	D3D12_CPU_DESCRIPTOR_HANDLE CreateSamplerDescHandle();
 	void CreateSamplerDescHandle(D3D12_CPU_DESCRIPTOR_HANDLE handle);
 };
\ No newline at end of file
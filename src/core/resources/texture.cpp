@@ -3,6 +3,15 @@
 #include "context.h"
 #include "DDSTextureLoader.h"
 
+void Texture::Destroy()
+{
+    GPUResource::Destroy();
+    //give back the srv, the descriptor is allocated again when the texture is recreated
+    if (m_ownsDescriptor && m_hCpuDescriptorHandle.ptr != D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+        GRAPHICS_CORE::FreeDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_hCpuDescriptorHandle);
+    m_hCpuDescriptorHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
+}
+
 void Texture::Create2D(size_t rowPitchBytes, size_t width, size_t height, DXGI_FORMAT format, const void* initData)
 {
     Destroy();
@@ -25,17 +34,9 @@ void Texture::Create2D(size_t rowPitchBytes, size_t width, size_t height, DXGI_F
     desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
     desc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-    D3D12_HEAP_PROPERTIES heapProps;
-    heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
-    heapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-    heapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-    heapProps.CreationNodeMask = 1;
-    heapProps.VisibleNodeMask = 1;
-
-    //initialize the gpu resource
-    GRAPHICS_CORE::g_device->CreateCommittedResource(
-        &heapProps, D3D12_HEAP_FLAG_NONE, &desc,
-        m_usageState, nullptr, IID_PPV_ARGS(&m_resource));
+    //initialize the gpu resource in the placed texture heaps
+    PlacedHeapAllocator::Instance().CreatePlacedResource(PLACED_HEAP_DEFAULT_TEXTURE, MEMORY_CATEGORY_TEXTURE,
+        desc, m_usageState, nullptr, m_placedAllocation, &m_resource);
 
     m_resource->SetName(L"texture");
 
@@ -90,6 +91,7 @@ void Texture::CreateCube(size_t rowPitchBytes, size_t width, size_t height, DXGI
     GRAPHICS_CORE::g_device->CreateCommittedResource(
         &heapProps, D3D12_HEAP_FLAG_NONE, &desc,
         m_usageState, nullptr, IID_PPV_ARGS(&m_resource));
+    TrackCommittedMemory(MEMORY_CATEGORY_TEXTURE);
 
     m_resource->SetName(L"texture_cube");
 
@@ -5,8 +5,9 @@
 class Texture : public GPUResource
 {
 public:
-	Texture() : m_Width(0), m_Height(0), m_Depth(0) { m_hCpuDescriptorHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN; }
-	Texture(D3D12_CPU_DESCRIPTOR_HANDLE handle) : m_Width(0), m_Height(0), m_Depth(0), m_hCpuDescriptorHandle(handle){}
+	Texture() : m_Width(0), m_Height(0), m_Depth(0), m_ownsDescriptor(true) { m_hCpuDescriptorHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN; }
+	Texture(D3D12_CPU_DESCRIPTOR_HANDLE handle) : m_Width(0), m_Height(0), m_Depth(0), m_hCpuDescriptorHandle(handle), m_ownsDescriptor(false){}
+	~Texture() { Destroy(); }
 
 	//create a textures
 	void Create2D(size_t rowPitchBytes, size_t width, size_t height, DXGI_FORMAT format, const void* initData);
@@ -16,11 +17,7 @@ public:
 	bool CreateDDSFromMemory(const void* memBuffer, size_t fillSize, bool sRGB);
 
 
-	virtual void Destroy() override
-	{
-		GPUResource::Destroy();
-		m_hCpuDescriptorHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-	}
+	virtual void Destroy() override;
 
 	uint32_t GetWidth() { return m_Width; }
 	uint32_t GetHeight() { return m_Height; }
@@ -33,6 +30,7 @@ protected:
 	uint32_t m_Depth;
 	
 	D3D12_CPU_DESCRIPTOR_HANDLE m_hCpuDescriptorHandle;
+	bool m_ownsDescriptor; //the descriptor passed by the caller is not freed
 
 };
 
@@ -7,14 +7,6 @@ void UploadBuffer::Create(const std::wstring& name, size_t bufferSize) {
 
 	m_bufferSize = bufferSize;
 
-    //Generate Heap Property for Upload Buffer
-	D3D12_HEAP_PROPERTIES heapProp;
-	heapProp.Type = D3D12_HEAP_TYPE_UPLOAD;
-	heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	heapProp.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-	heapProp.CreationNodeMask = 0;
-	heapProp.VisibleNodeMask = 0;
-
     D3D12_RESOURCE_DESC desc = {};
     desc.Alignment = 0;
     desc.DepthOrArraySize = 1;
@@ -28,10 +20,9 @@ void UploadBuffer::Create(const std::wstring& name, size_t bufferSize) {
     desc.SampleDesc.Count = 1;
     desc.SampleDesc.Quality = 0;
 
-    ThrowIfFailed(GRAPHICS_CORE::g_device->CreateCommittedResource(
-        &heapProp, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, 
-        nullptr, IID_PPV_ARGS(&m_resource)
-    ));
+    //place the buffer in the upload buffer heaps
+    PlacedHeapAllocator::Instance().CreatePlacedResource(PLACED_HEAP_UPLOAD_BUFFER, MEMORY_CATEGORY_UPLOAD,
+        desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, m_placedAllocation, &m_resource);
 
     m_gpuAddress = m_resource->GetGPUVirtualAddress();
     m_resource->SetName(name.c_str());
@@ -1,5 +1,7 @@
 #include "rootsignature.h"
 #include "graphicscore.h"
+#include "rootsignaturehash.h"
+#include <cstring>
 
 
 /*
@@ -8,18 +10,36 @@
 * For the efficiency, we reuse the root signature which has the same descriptors layout 
 * Each root signature should be stored in this singleton.
 */
-void RootSignatureManager::Insert(uint32_t hashValue, ID3D12RootSignature* rootSignatureCompiled) {
-	assert(rootSignatureCompiled != nullptr);
-	m_storage[hashValue].Attach(rootSignatureCompiled);
+const CachedRootSignature& RootSignatureManager::Insert(uint64_t hashValue, const CachedRootSignature& rootSignature) {
+	assert(rootSignature.m_rootSignature != nullptr);
+	std::lock_guard<std::mutex> guard(m_mutex);
+	//another thread may finalize the same layout at the same time, its root signature is released here
+	auto range = m_storage.equal_range(hashValue);
+	for (auto iter = range.first; iter != range.second; ++iter) {
+		if (iter->second.m_serializedBlob == rootSignature.m_serializedBlob)
+			return iter->second;
+	}
+	return m_storage.insert(std::make_pair(hashValue, rootSignature))->second;
 }
 
-ID3D12RootSignature* RootSignatureManager::Get(uint32_t hashValue) {
-	if (m_storage.find(hashValue) != m_storage.end())
-		return m_storage[hashValue].Get();
+const CachedRootSignature* RootSignatureManager::Get(uint64_t hashValue, const void* serializedBlob, size_t blobSize) {
+	std::lock_guard<std::mutex> guard(m_mutex);
+	auto range = m_storage.equal_range(hashValue);
+	for (auto iter = range.first; iter != range.second; ++iter) {
+		const std::vector<uint8_t>& cachedBlob = iter->second.m_serializedBlob;
+		if (cachedBlob.size() == blobSize && memcmp(cachedBlob.data(), serializedBlob, blobSize) == 0)
+			return &iter->second;
+	}
 	return nullptr;
 }
 
+uint32_t RootSignatureManager::GetCount() {
+	std::lock_guard<std::mutex> guard(m_mutex);
+	return (uint32_t)m_storage.size();
+}
+
 void RootSignatureManager::Release() {
+	std::lock_guard<std::mutex> guard(m_mutex);
 	m_storage.clear();
 }
 
@@ -28,6 +48,35 @@ void RootSignatureManager::Release() {
 * Root Signature is a description of the input data types of the shader
 */
 
+void RootSignature::InitFromLayout(const RootSignatureLayout& layout, UINT samplerNum) {
+	assert(!m_finalized);
+	Reset(layout.GetParameterCount(), samplerNum);
+	for (uint32_t rootIndex = 0; rootIndex < layout.GetParameterCount(); ++rootIndex) {
+		const RootParameterDesc& parameter = layout.GetRootParameter(rootIndex);
+		RootParameter& rootParameter = m_parameters[rootIndex];
+		switch (parameter.m_type)
+		{
+		case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+			rootParameter.InitAsConstant32(parameter.m_shaderRegister, parameter.m_sizeInBytes / 4,
+				parameter.m_visibility, parameter.m_registerSpace);
+			break;
+		case D3D12_ROOT_PARAMETER_TYPE_CBV:
+			rootParameter.InitAsConstantBuffer(parameter.m_shaderRegister, parameter.m_visibility, parameter.m_registerSpace);
+			break;
+		case D3D12_ROOT_PARAMETER_TYPE_SRV:
+			rootParameter.InitAsBufferSRV(parameter.m_shaderRegister, parameter.m_visibility, parameter.m_registerSpace);
+			break;
+		case D3D12_ROOT_PARAMETER_TYPE_UAV:
+			rootParameter.InitAsBufferUAV(parameter.m_shaderRegister, parameter.m_visibility, parameter.m_registerSpace);
+			break;
+		default:
+			rootParameter.InitAsDescriptorRange(parameter.m_rangeType, parameter.m_shaderRegister,
+				parameter.m_descriptorsNum, parameter.m_visibility, parameter.m_registerSpace);
+			break;
+		}
+	}
+}
+
 void RootSignature::InitSamplerDesc(UINT registerSlot,
 	const D3D12_SAMPLER_DESC& nonStaticSamplerDesc,
 	D3D12_SHADER_VISIBILITY visibility) {
@@ -72,46 +121,57 @@ void RootSignature::Finalize(const std::wstring& name, D3D12_ROOT_SIGNATURE_FLAG
 	rootSignatureDesc.pStaticSamplers = (const D3D12_STATIC_SAMPLER_DESC*)m_samplers.get();
 	rootSignatureDesc.Flags = Flags;
 
-	m_descriptorTableBitMap = 0;
-	m_samplerBitMap = 0;
-	
-	//extract the parameters information in current root signature
-	for (int paramIndex = 0; paramIndex < m_parametersNum; ++paramIndex)
-	{
-		D3D12_ROOT_PARAMETER parameter = rootSignatureDesc.pParameters[paramIndex];
+	//the same layout is compiled once, the root signatures finalized later share it
+	//the serialization runs on the cpu only, the blob tells the layouts with the same hash apart
+	uint64_t hashValue = HashRootSignatureDesc(rootSignatureDesc);
+	ComPtr<ID3DBlob> pOutBlob, pErrorBlob;
+	ThrowIfFailed(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1,
+		pOutBlob.GetAddressOf(), pErrorBlob.GetAddressOf()));
+	const uint8_t* serializedBlob = (const uint8_t*)pOutBlob->GetBufferPointer();
+	size_t blobSize = pOutBlob->GetBufferSize();
+
+	const CachedRootSignature* cachedRootSignature = RootSignatureManager::Instance().Get(hashValue, serializedBlob, blobSize);
+	if (cachedRootSignature == nullptr) {
+		CachedRootSignature newRootSignature;
 
-		if (parameter.ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
+		//extract the parameters information in current root signature
+		for (int paramIndex = 0; paramIndex < m_parametersNum; ++paramIndex)
 		{
-			//check the descriptor table is valid
-			assert(parameter.DescriptorTable.pDescriptorRanges != nullptr);
-
-			//current descriptor table stores multiple samplers
-			if (parameter.DescriptorTable.pDescriptorRanges->RangeType ==
-				D3D12_DESCRIPTOR_RANGE_TYPE::D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER)
-				m_samplerBitMap |= (1 << paramIndex);
-			else
-				m_descriptorTableBitMap |= (1 << paramIndex);
-
-			//record the descriptors size in current entry
-			for (int subDescriptorRangeIndex = 0; subDescriptorRangeIndex < parameter.DescriptorTable.NumDescriptorRanges; ++subDescriptorRangeIndex)
+			D3D12_ROOT_PARAMETER parameter = rootSignatureDesc.pParameters[paramIndex];
+
+			if (parameter.ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
 			{
-				m_descriptorTableSize[paramIndex] += parameter.DescriptorTable.pDescriptorRanges[subDescriptorRangeIndex].NumDescriptors;
+				//check the descriptor table is valid
+				assert(parameter.DescriptorTable.pDescriptorRanges != nullptr);
+
+				//current descriptor table stores multiple samplers
+				if (parameter.DescriptorTable.pDescriptorRanges->RangeType ==
+					D3D12_DESCRIPTOR_RANGE_TYPE::D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER)
+					newRootSignature.m_samplerBitMap |= (1 << paramIndex);
+				else
+					newRootSignature.m_descriptorTableBitMap |= (1 << paramIndex);
+
+				//record the descriptors size in current entry
+				for (UINT subDescriptorRangeIndex = 0; subDescriptorRangeIndex < parameter.DescriptorTable.NumDescriptorRanges; ++subDescriptorRangeIndex)
+				{
+					newRootSignature.m_descriptorTableSize[paramIndex] += parameter.DescriptorTable.pDescriptorRanges[subDescriptorRangeIndex].NumDescriptors;
+				}
 			}
 		}
-	}
 
-	//TODO: Do not compile the root signature every time; reuse the same parameter layout root signature
-	//TODO: hash function 
+		ThrowIfFailed(GRAPHICS_CORE::g_device->CreateRootSignature(0, serializedBlob,
+			blobSize, IID_PPV_ARGS(&newRootSignature.m_rootSignature)));
+		newRootSignature.m_serializedBlob.assign(serializedBlob, serializedBlob + blobSize);
 
-	ComPtr<ID3DBlob> pOutBlob, pErrorBlob;
-
-	D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1,
-		pOutBlob.GetAddressOf(), pErrorBlob.GetAddressOf());
-
-	ThrowIfFailed(GRAPHICS_CORE::g_device->CreateRootSignature(0, pOutBlob->GetBufferPointer(),
-		pOutBlob->GetBufferSize(), IID_PPV_ARGS(&m_rootSignature)));
+		newRootSignature.m_rootSignature->SetName(name.c_str());
+		cachedRootSignature = &RootSignatureManager::Instance().Insert(hashValue, newRootSignature);
+	}
 
-	m_rootSignature->SetName(name.c_str());
+	m_rootSignature = cachedRootSignature->m_rootSignature.Get();
+	m_hash = hashValue;
+	m_descriptorTableBitMap = cachedRootSignature->m_descriptorTableBitMap;
+	m_samplerBitMap = cachedRootSignature->m_samplerBitMap;
+	memcpy(m_descriptorTableSize, cachedRootSignature->m_descriptorTableSize, sizeof(m_descriptorTableSize));
 
 	m_finalized = true;
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
 #pragma once
 #include "headers.h"
 #include <map>
+#include <mutex>
+#include <vector>
 #include <wrl/client.h>
+#include "rootsignaturelayout.h"
 
 class RootParameter
 {
@@ -86,6 +89,17 @@ protected:
 	D3D12_ROOT_PARAMETER m_rootParam;
 };
 
+//the compiled root signature and the derived information of its layout
+struct CachedRootSignature
+{
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_rootSignature;
+	//the serialized layout, compared on a hit to reject the hash collisions
+	std::vector<uint8_t> m_serializedBlob;
+	uint32_t m_descriptorTableBitMap = 0;
+	uint32_t m_descriptorTableSize[16] = { 0 };
+	uint32_t m_samplerBitMap = 0;
+};
+
 class RootSignatureManager
 {
 public:
@@ -94,8 +108,12 @@ public:
 		return instance;
 	}
 
-	void Insert(uint32_t hashValue, ID3D12RootSignature* rootSignatureCompiled);
-	ID3D12RootSignature* Get(uint32_t hashValue);
+	//keep the first root signature inserted with the layout, return the one kept
+	//the colliding layouts are stored side by side under one hash
+	const CachedRootSignature& Insert(uint64_t hashValue, const CachedRootSignature& rootSignature);
+	//return nullptr if no root signature has the serialized layout
+	const CachedRootSignature* Get(uint64_t hashValue, const void* serializedBlob, size_t blobSize);
+	uint32_t GetCount();
 	void Release();
 
 private:
@@ -104,7 +122,9 @@ private:
 	RootSignatureManager& operator=(const RootSignatureManager& val) = delete;
 		 
 private:
-	std::map<uint32_t, Microsoft::WRL::ComPtr<ID3D12RootSignature>> m_storage;
+	//the elements of the map are never moved, so the returned pointers stay valid until Release
+	std::mutex m_mutex;
+	std::multimap<uint64_t, CachedRootSignature> m_storage;
 };
 
 class RootSignature
@@ -136,6 +156,9 @@ public:
 		m_samplersNum = samplerNum;
 	}
 
+	//reset the parameters to the built layout, the callers bind with the root indices of the layout
+	void InitFromLayout(const RootSignatureLayout& layout, UINT samplerNum = 0);
+
 	void InitSamplerDesc(UINT registerSlot,
 		const D3D12_SAMPLER_DESC& nonStaticSamplerDesc,
 		D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL);
@@ -151,6 +174,8 @@ public:
 	}
 
 	ID3D12RootSignature* GetSignature() const { return m_rootSignature; }
+	//the hash of the layout, valid after finalized
+	uint64_t GetHash() const { return m_hash; }
 
 	//compile and create root signature object
 	void Finalize(const std::wstring& name, D3D12_ROOT_SIGNATURE_FLAGS Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE);
@@ -166,7 +191,9 @@ protected:
 	int m_samplersNum;
 	std::unique_ptr<RootParameter[]> m_parameters;
 	std::unique_ptr<D3D12_STATIC_SAMPLER_DESC[]> m_samplers;
-	ID3D12RootSignature* m_rootSignature;
+	//owned by the root signature manager
+	ID3D12RootSignature* m_rootSignature = nullptr;
+	uint64_t m_hash = 0;
 };
 
 
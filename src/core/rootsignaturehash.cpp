@@ -0,0 +1,41 @@
+#include "rootsignaturehash.h"
+#include "hashutils.h"
+
+uint64_t HashRootSignatureDesc(const D3D12_ROOT_SIGNATURE_DESC& desc)
+{
+	uint64_t hashValue = kFnv1aOffsetBasis;
+	hashValue = HashUint(desc.NumParameters, hashValue);
+	hashValue = HashUint(desc.NumStaticSamplers, hashValue);
+	hashValue = HashUint((uint32_t)desc.Flags, hashValue);
+
+	for (UINT paramIndex = 0; paramIndex < desc.NumParameters; ++paramIndex) {
+		const D3D12_ROOT_PARAMETER& parameter = desc.pParameters[paramIndex];
+		hashValue = HashUint((uint32_t)parameter.ParameterType, hashValue);
+		hashValue = HashUint((uint32_t)parameter.ShaderVisibility, hashValue);
+
+		//only the active member of the union is hashed
+		switch (parameter.ParameterType)
+		{
+		case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+			hashValue = HashUint(parameter.DescriptorTable.NumDescriptorRanges, hashValue);
+			//the range is made of 4 bytes fields, so there is no padding in the hashed bytes
+			hashValue = HashBytes(parameter.DescriptorTable.pDescriptorRanges,
+				sizeof(D3D12_DESCRIPTOR_RANGE) * parameter.DescriptorTable.NumDescriptorRanges, hashValue);
+			break;
+		case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+			hashValue = HashUint(parameter.Constants.ShaderRegister, hashValue);
+			hashValue = HashUint(parameter.Constants.RegisterSpace, hashValue);
+			hashValue = HashUint(parameter.Constants.Num32BitValues, hashValue);
+			break;
+		default:
+			hashValue = HashUint(parameter.Descriptor.ShaderRegister, hashValue);
+			hashValue = HashUint(parameter.Descriptor.RegisterSpace, hashValue);
+			break;
+		}
+	}
+
+	//the static sampler is made of 4 bytes fields too
+	if (desc.NumStaticSamplers > 0)
+		hashValue = HashBytes(desc.pStaticSamplers, sizeof(D3D12_STATIC_SAMPLER_DESC) * desc.NumStaticSamplers, hashValue);
+	return hashValue;
+}
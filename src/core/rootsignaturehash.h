@@ -0,0 +1,9 @@
+#pragma once
+
+#include <d3d12.h>
+#include <cstdint>
+
+//stable 64-bit hash of a root signature layout: the parameters, the ranges of the tables, the static samplers and the flags
+//the pointers in the desc are followed, never hashed, so equal layouts built separately share one hash
+//the hash does not touch the device, so it can be tested alone
+uint64_t HashRootSignatureDesc(const D3D12_ROOT_SIGNATURE_DESC& desc);
@@ -0,0 +1,158 @@
+#include "rootsignaturelayout.h"
+#include <algorithm>
+#include <cassert>
+
+uint32_t RootSignatureLayout::AddConstantBuffer(ROOT_PARAMETER_FREQUENCY frequency, UINT registerSlot, UINT sizeInBytes,
+	D3D12_SHADER_VISIBILITY visibility, UINT space) {
+	RootParameterDesc parameter = {};
+	parameter.m_type = D3D12_ROOT_PARAMETER_TYPE_CBV;
+	parameter.m_frequency = frequency;
+	parameter.m_visibility = visibility;
+	parameter.m_shaderRegister = registerSlot;
+	parameter.m_registerSpace = space;
+	parameter.m_sizeInBytes = sizeInBytes;
+	return AddParameter(parameter);
+}
+
+uint32_t RootSignatureLayout::AddConstants(ROOT_PARAMETER_FREQUENCY frequency, UINT registerSlot, UINT numDwords,
+	D3D12_SHADER_VISIBILITY visibility, UINT space) {
+	RootParameterDesc parameter = {};
+	parameter.m_type = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+	parameter.m_frequency = frequency;
+	parameter.m_visibility = visibility;
+	parameter.m_shaderRegister = registerSlot;
+	parameter.m_registerSpace = space;
+	parameter.m_sizeInBytes = numDwords * 4;
+	return AddParameter(parameter);
+}
+
+uint32_t RootSignatureLayout::AddBufferSRV(ROOT_PARAMETER_FREQUENCY frequency, UINT registerSlot,
+	D3D12_SHADER_VISIBILITY visibility, UINT space) {
+	RootParameterDesc parameter = {};
+	parameter.m_type = D3D12_ROOT_PARAMETER_TYPE_SRV;
+	parameter.m_frequency = frequency;
+	parameter.m_visibility = visibility;
+	parameter.m_shaderRegister = registerSlot;
+	parameter.m_registerSpace = space;
+	return AddParameter(parameter);
+}
+
+uint32_t RootSignatureLayout::AddBufferUAV(ROOT_PARAMETER_FREQUENCY frequency, UINT registerSlot,
+	D3D12_SHADER_VISIBILITY visibility, UINT space) {
+	RootParameterDesc parameter = {};
+	parameter.m_type = D3D12_ROOT_PARAMETER_TYPE_UAV;
+	parameter.m_frequency = frequency;
+	parameter.m_visibility = visibility;
+	parameter.m_shaderRegister = registerSlot;
+	parameter.m_registerSpace = space;
+	return AddParameter(parameter);
+}
+
+uint32_t RootSignatureLayout::AddDescriptorRange(ROOT_PARAMETER_FREQUENCY frequency, D3D12_DESCRIPTOR_RANGE_TYPE type,
+	UINT registerSlot, UINT count, D3D12_SHADER_VISIBILITY visibility, UINT space) {
+	RootParameterDesc parameter = {};
+	parameter.m_type = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	parameter.m_frequency = frequency;
+	parameter.m_visibility = visibility;
+	parameter.m_shaderRegister = registerSlot;
+	parameter.m_registerSpace = space;
+	parameter.m_rangeType = type;
+	parameter.m_descriptorsNum = count;
+	return AddParameter(parameter);
+}
+
+uint32_t RootSignatureLayout::AddParameter(const RootParameterDesc& parameter) {
+	assert(!m_built && "the layout is built already");
+	m_parameters.push_back(parameter);
+	return (uint32_t)m_parameters.size() - 1;
+}
+
+uint32_t RootSignatureLayout::GetParameterDwords(const RootParameterDesc& parameter) {
+	switch (parameter.m_type)
+	{
+	case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+		return (parameter.m_sizeInBytes + 3) / 4;
+	case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+		return 1;
+	default:
+		//the root descriptors are gpu virtual addresses
+		return 2;
+	}
+}
+
+bool RootSignatureLayout::Build() {
+	assert(!m_built && "the layout is built already");
+	uint32_t parametersNum = (uint32_t)m_parameters.size();
+
+	uint32_t rootDwords = 0;
+	for (const RootParameterDesc& parameter : m_parameters)
+		rootDwords += GetParameterDwords(parameter);
+	if (rootDwords > kMaxRootDwords)
+		return false;
+
+	//promote the constant buffers updated most often first, and the smaller ones first in the same frequency
+	std::vector<uint32_t> candidates;
+	for (uint32_t i = 0; i < parametersNum; ++i) {
+		const RootParameterDesc& parameter = m_parameters[i];
+		uint32_t constantDwords = (parameter.m_sizeInBytes + 3) / 4;
+		if (parameter.m_type == D3D12_ROOT_PARAMETER_TYPE_CBV &&
+			constantDwords > 0 && constantDwords <= kMaxPromotedDwords)
+			candidates.push_back(i);
+	}
+	std::stable_sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) {
+		if (m_parameters[a].m_frequency != m_parameters[b].m_frequency)
+			return m_parameters[a].m_frequency > m_parameters[b].m_frequency;
+		return m_parameters[a].m_sizeInBytes < m_parameters[b].m_sizeInBytes;
+	});
+
+	m_promoted.assign(parametersNum, false);
+	for (uint32_t candidate : candidates) {
+		//the root constants replace the 2 dwords of the root descriptor
+		uint32_t constantDwords = (m_parameters[candidate].m_sizeInBytes + 3) / 4;
+		uint32_t promotedDwords = rootDwords - 2 + constantDwords;
+		if (promotedDwords > kMaxRootDwords)
+			continue;
+		rootDwords = promotedDwords;
+		m_promoted[candidate] = true;
+	}
+
+	//the parameters changed most often go first, the added order is kept in the same frequency
+	std::vector<uint32_t> order(parametersNum);
+	for (uint32_t i = 0; i < parametersNum; ++i)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+		return m_parameters[a].m_frequency > m_parameters[b].m_frequency;
+	});
+
+	m_remap.assign(parametersNum, 0);
+	m_rootParameters.clear();
+	m_rootParameters.reserve(parametersNum);
+	for (uint32_t parameterIndex : order) {
+		RootParameterDesc rootParameter = m_parameters[parameterIndex];
+		if (m_promoted[parameterIndex]) {
+			rootParameter.m_type = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+			rootParameter.m_sizeInBytes = (rootParameter.m_sizeInBytes + 3) / 4 * 4;
+		}
+		m_remap[parameterIndex] = (uint32_t)m_rootParameters.size();
+		m_rootParameters.push_back(rootParameter);
+	}
+
+	m_rootDwords = rootDwords;
+	m_built = true;
+	return true;
+}
+
+uint32_t RootSignatureLayout::GetRootIndex(uint32_t parameterIndex) const {
+	assert(m_built && parameterIndex < m_remap.size());
+	return m_remap[parameterIndex];
+}
+
+bool RootSignatureLayout::IsPromoted(uint32_t parameterIndex) const {
+	assert(m_built && parameterIndex < m_promoted.size());
+	return m_promoted[parameterIndex];
+}
+
+const RootParameterDesc& RootSignatureLayout::GetRootParameter(uint32_t rootIndex) const {
+	assert(m_built && rootIndex < m_rootParameters.size());
+	return m_rootParameters[rootIndex];
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <d3d12.h>
+#include <cstdint>
+#include <vector>
+
+//how often the shaders see a new value of the parameter
+enum ROOT_PARAMETER_FREQUENCY
+{
+	ROOT_PARAMETER_PER_FRAME = 0,
+	ROOT_PARAMETER_PER_PASS = 1,
+	ROOT_PARAMETER_PER_DRAW = 2,
+};
+
+//one parameter of the layout, the descriptor tables have a single range
+struct RootParameterDesc
+{
+	D3D12_ROOT_PARAMETER_TYPE m_type;
+	ROOT_PARAMETER_FREQUENCY m_frequency;
+	D3D12_SHADER_VISIBILITY m_visibility;
+	UINT m_shaderRegister;
+	UINT m_registerSpace;
+	UINT m_sizeInBytes; //the size of the constant buffer or the root constants
+	D3D12_DESCRIPTOR_RANGE_TYPE m_rangeType;
+	UINT m_descriptorsNum;
+};
+
+//Root Signature Layout
+//the parameters are added with their update frequency, and Build lays them out:
+//the small constant buffers are promoted to root constants while the root signature stays in 64 dwords,
+//and the parameters are ordered from the highest frequency to the lowest
+//the callers bind through GetRootIndex, a promoted constant buffer is bound with SetConstantArray
+//the layout does not touch the device, so it can be tested alone
+class RootSignatureLayout
+{
+public:
+	static const uint32_t kMaxRootDwords = 64;
+	//the constant buffers up to this size are worth promoting
+	static const uint32_t kMaxPromotedDwords = 16;
+
+	RootSignatureLayout() : m_rootDwords(0), m_built(false) {}
+
+	//return the parameter index used by GetRootIndex
+	uint32_t AddConstantBuffer(ROOT_PARAMETER_FREQUENCY frequency, UINT registerSlot, UINT sizeInBytes,
+		D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL, UINT space = 0);
+	uint32_t AddConstants(ROOT_PARAMETER_FREQUENCY frequency, UINT registerSlot, UINT numDwords,
+		D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL, UINT space = 0);
+	uint32_t AddBufferSRV(ROOT_PARAMETER_FREQUENCY frequency, UINT registerSlot,
+		D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL, UINT space = 0);
+	uint32_t AddBufferUAV(ROOT_PARAMETER_FREQUENCY frequency, UINT registerSlot,
+		D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL, UINT space = 0);
+	uint32_t AddDescriptorRange(ROOT_PARAMETER_FREQUENCY frequency, D3D12_DESCRIPTOR_RANGE_TYPE type,
+		UINT registerSlot, UINT count, D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL, UINT space = 0);
+
+	//return false if the parameters do not fit in 64 dwords even without promotion
+	bool Build();
+
+	//the root index of the added parameter
+	uint32_t GetRootIndex(uint32_t parameterIndex) const;
+	//the constant buffer is bound as root constants
+	bool IsPromoted(uint32_t parameterIndex) const;
+	//the final parameter at the root index, the promoted ones are root constants
+	const RootParameterDesc& GetRootParameter(uint32_t rootIndex) const;
+	uint32_t GetParameterCount() const { return (uint32_t)m_parameters.size(); }
+	uint32_t GetRootDwords() const { return m_rootDwords; }
+
+	//the dwords a parameter takes in the root signature
+	static uint32_t GetParameterDwords(const RootParameterDesc& parameter);
+
+private:
+	uint32_t AddParameter(const RootParameterDesc& parameter);
+
+	std::vector<RootParameterDesc> m_parameters;
+	std::vector<RootParameterDesc> m_rootParameters;
+	std::vector<uint32_t> m_remap; //parameter index to root index
+	std::vector<bool> m_promoted;
+	uint32_t m_rootDwords;
+	bool m_built;
+};
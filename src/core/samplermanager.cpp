@@ -0,0 +1,87 @@
+#include "samplermanager.h"
+#include "graphicscore.h"
+#include "hashutils.h"
+#include <cstring>
+
+void SamplerManager::Release()
+{
+	//the cpu descriptors are destroyed with the descriptor allocator, the tables with the sampler heap
+	std::lock_guard<std::mutex> guard(m_mutex);
+	m_samplers.clear();
+	m_samplerTables.clear();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE SamplerManager::GetSampler(const D3D12_SAMPLER_DESC& desc)
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	return FindOrCreateSampler(desc);
+}
+
+DescriptorHandle SamplerManager::GetSamplerTable(const D3D12_SAMPLER_DESC descs[], uint32_t count)
+{
+	assert(count > 0);
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	//the tables are keyed by the shared cpu descriptors of their samplers
+	std::vector<SIZE_T> samplers(count);
+	for (uint32_t i = 0; i < count; ++i)
+		samplers[i] = FindOrCreateSampler(descs[i]).ptr;
+	uint64_t tableHash = HashBytes(samplers.data(), samplers.size() * sizeof(SIZE_T));
+
+	auto range = m_samplerTables.equal_range(tableHash);
+	for (auto iter = range.first; iter != range.second; ++iter) {
+		if (iter->second.m_samplers == samplers)
+			return iter->second.m_tableHandle;
+	}
+
+	//copy the samplers to the shader visible heap
+	DescriptorHandle tableHandle = GRAPHICS_CORE::g_samplersDescriptorHeap.Alloc(count);
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> srcHandles(count);
+	std::vector<UINT> srcNums(count, 1);
+	for (uint32_t i = 0; i < count; ++i)
+		srcHandles[i].ptr = samplers[i];
+	UINT destNum = count;
+	GRAPHICS_CORE::g_device->CopyDescriptors(1, &tableHandle, &destNum, count,
+		srcHandles.data(), srcNums.data(), D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+
+	CachedSamplerTable& cachedTable = m_samplerTables.emplace(tableHash, CachedSamplerTable())->second;
+	cachedTable.m_samplers.swap(samplers);
+	cachedTable.m_tableHandle = tableHandle;
+	return tableHandle;
+}
+
+uint32_t SamplerManager::GetSamplerTableIndex(const D3D12_SAMPLER_DESC descs[], uint32_t count)
+{
+	return GRAPHICS_CORE::g_samplersDescriptorHeap.GetOffset(GetSamplerTable(descs, count));
+}
+
+uint32_t SamplerManager::GetSamplerCount()
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	return (uint32_t)m_samplers.size();
+}
+
+uint32_t SamplerManager::GetSamplerTableCount()
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	return (uint32_t)m_samplerTables.size();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE SamplerManager::FindOrCreateSampler(const D3D12_SAMPLER_DESC& desc)
+{
+	//the sampler desc is made of 4 bytes fields, so there is no padding in the hashed bytes
+	uint64_t samplerHash = HashBytes(&desc, sizeof(D3D12_SAMPLER_DESC));
+	auto range = m_samplers.equal_range(samplerHash);
+	for (auto iter = range.first; iter != range.second; ++iter) {
+		if (memcmp(&iter->second.m_desc, &desc, sizeof(D3D12_SAMPLER_DESC)) == 0)
+			return iter->second.m_handle;
+	}
+
+	D3D12_CPU_DESCRIPTOR_HANDLE handle = GRAPHICS_CORE::AllocatorDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+	GRAPHICS_CORE::g_device->CreateSampler(&desc, handle);
+
+	CachedSampler& cachedSampler = m_samplers.emplace(samplerHash, CachedSampler())->second;
+	cachedSampler.m_desc = desc;
+	cachedSampler.m_handle = handle;
+	return handle;
+}
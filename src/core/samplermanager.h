@@ -0,0 +1,51 @@
+#pragma once
+#include <d3d12.h>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+
+#include "descriptortypes.h"
+
+//Sampler Manager
+//the samplers with the same states share one cpu descriptor
+//the sampler tables with the same samplers share one range of the shader visible sampler heap
+//so the sampler descriptors grow with the distinct sampler states, not with the materials
+class SamplerManager
+{
+public:
+	SamplerManager() {}
+
+	void Release();
+
+	//the cpu descriptor of the sampler states, the descriptor is shared and never freed by the caller
+	D3D12_CPU_DESCRIPTOR_HANDLE GetSampler(const D3D12_SAMPLER_DESC& desc);
+	//the shader visible table of the samplers in order
+	DescriptorHandle GetSamplerTable(const D3D12_SAMPLER_DESC descs[], uint32_t count);
+	//the offset of the table in the shader visible sampler heap
+	uint32_t GetSamplerTableIndex(const D3D12_SAMPLER_DESC descs[], uint32_t count);
+
+	uint32_t GetSamplerCount();
+	uint32_t GetSamplerTableCount();
+
+private:
+	struct CachedSampler
+	{
+		D3D12_SAMPLER_DESC m_desc;
+		D3D12_CPU_DESCRIPTOR_HANDLE m_handle;
+	};
+
+	struct CachedSamplerTable
+	{
+		//the cpu descriptors of the samplers, they are unique for each sampler states
+		std::vector<SIZE_T> m_samplers;
+		DescriptorHandle m_tableHandle;
+	};
+
+	//the caller should hold the mutex
+	D3D12_CPU_DESCRIPTOR_HANDLE FindOrCreateSampler(const D3D12_SAMPLER_DESC& desc);
+
+	//the entries with colliding hashes are kept side by side, so the same states are never created twice
+	std::mutex m_mutex;
+	std::unordered_multimap<uint64_t, CachedSampler> m_samplers;
+	std::unordered_multimap<uint64_t, CachedSamplerTable> m_samplerTables;
+};
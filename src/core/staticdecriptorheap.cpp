@@ -1,12 +1,14 @@
 
 #include "staticdecriptorheap.h"
 #include "graphicscore.h"
+#include <stdexcept>
 
 
 
-void StaticDescriptorHeap::Initialize(const std::wstring& heapName, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t maxDescriptorsNum) {
+void StaticDescriptorHeap::Initialize(const std::wstring& heapName, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t maxDescriptorsNum,
+	uint32_t dynamicBlockSize, uint32_t dynamicBlockCount) {
 	m_heapDesc.Type = type;
-	m_heapDesc.NumDescriptors = maxDescriptorsNum;
+	m_heapDesc.NumDescriptors = maxDescriptorsNum + dynamicBlockSize * dynamicBlockCount;
 	m_heapDesc.NodeMask = 0;
 	m_heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 
@@ -15,27 +17,81 @@ void StaticDescriptorHeap::Initialize(const std::wstring& heapName, D3D12_DESCRI
 
 	//initialize the basic parameter
 	m_descriptorSize = GRAPHICS_CORE::g_device->GetDescriptorHandleIncrementSize(type);
-	m_numFreeDescriptors = maxDescriptorsNum;
+	MemoryBudgetManager::Instance().ReportAllocation(MEMORY_CATEGORY_DESCRIPTOR_HEAP,
+		(uint64_t)m_descriptorSize * m_heapDesc.NumDescriptors);
+	m_indexAllocator.Initialize(maxDescriptorsNum);
+	m_dynamicRegionOffset = maxDescriptorsNum;
+	m_dynamicBlocks.Initialize(dynamicBlockSize, dynamicBlockCount);
 	m_firstHandle = DescriptorHandle(
 		m_descriptorHeap->GetCPUDescriptorHandleForHeapStart(),
 		m_descriptorHeap->GetGPUDescriptorHandleForHeapStart()
 	);
-	m_nextFreeHandle = m_firstHandle;
 }
 
 void StaticDescriptorHeap::Release() {
 	if (m_descriptorHeap != nullptr) {
+		MemoryBudgetManager::Instance().ReportRelease(MEMORY_CATEGORY_DESCRIPTOR_HEAP,
+			(uint64_t)m_descriptorSize * m_heapDesc.NumDescriptors);
 		m_descriptorHeap->Release();
 		m_descriptorHeap = nullptr;
 	}
 }
 
 DescriptorHandle StaticDescriptorHeap::Alloc(uint32_t count) {
-	assert(HasAvailableSpace(count));
-	DescriptorHandle ret = m_nextFreeHandle;
-	m_nextFreeHandle += count * m_descriptorSize;
-	m_numFreeDescriptors -= count;
-	return ret;
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	//the retired descriptors may fit the request
+	m_indexAllocator.ReleaseCompleted(
+		[](uint64_t fenceValue) { return GRAPHICS_CORE::g_commandManager.IsFenceComplete(fenceValue); });
+
+	uint32_t index = m_indexAllocator.Alloc(count);
+	assert(index != DescriptorIndexAllocator::kInvalidIndex && "the static descriptor heap is full");
+	return m_firstHandle + index * m_descriptorSize;
+}
+
+void StaticDescriptorHeap::Free(const DescriptorHandle& handle, uint32_t count) {
+	//the handle may be recorded in any submitted command list of any queue
+	uint64_t fenceValues[CommandManager::kQueueCount];
+	GRAPHICS_CORE::g_commandManager.GetLastSubmittedFences(fenceValues);
+	assert(ValidateHandle(handle));
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_indexAllocator.Free(GetOffset(handle), count, fenceValues, CommandManager::kQueueCount);
+}
+
+void StaticDescriptorHeap::Free(const DescriptorHandle& handle, uint32_t count, uint64_t fenceValue) {
+	assert(ValidateHandle(handle));
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_indexAllocator.Free(GetOffset(handle), count, fenceValue);
+}
+
+void StaticDescriptorHeap::ReleaseRetiredDescriptors() {
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	m_indexAllocator.ReleaseCompleted(
+		[](uint64_t fenceValue) { return GRAPHICS_CORE::g_commandManager.IsFenceComplete(fenceValue); });
+}
+
+DescriptorIndexReport StaticDescriptorHeap::GetReport() {
+	std::lock_guard<std::mutex> lockGuard(m_mutex);
+	return m_indexAllocator.GetReport();
+}
+
+DescriptorHandle StaticDescriptorHeap::ReserveDynamicBlock() {
+	auto isFenceComplete = [](uint64_t fenceValue) { return GRAPHICS_CORE::g_commandManager.IsFenceComplete(fenceValue); };
+	uint32_t blockIndex = m_dynamicBlocks.Reserve(isFenceComplete);
+	while (blockIndex == DescriptorBlockRing::kInvalidBlock) {
+		//all the blocks are referenced, wait for the oldest retired one instead of the whole device
+		uint64_t oldestFence = m_dynamicBlocks.GetOldestRetiredFence();
+		if (oldestFence == 0)
+			throw std::runtime_error("The dynamic descriptor blocks are all held by the recording contexts");
+		GRAPHICS_CORE::g_commandManager.WaitForFence(oldestFence);
+		blockIndex = m_dynamicBlocks.Reserve(isFenceComplete);
+	}
+	return m_firstHandle + (m_dynamicRegionOffset + blockIndex * m_dynamicBlocks.GetBlockSize()) * m_descriptorSize;
+}
+
+void StaticDescriptorHeap::RetireDynamicBlock(const DescriptorHandle& blockStart, uint64_t fenceValue) {
+	assert(ValidateHandle(blockStart));
+	uint32_t blockIndex = (GetOffset(blockStart) - m_dynamicRegionOffset) / m_dynamicBlocks.GetBlockSize();
+	m_dynamicBlocks.Retire(blockIndex, fenceValue);
 }
 
 bool StaticDescriptorHeap::ValidateHandle(const DescriptorHandle& dhandle) const {
@@ -4,19 +4,37 @@
 #include <string>
 #include "headers.h"
 #include "descriptortypes.h"
+#include "descriptorindexallocator.h"
+#include "descriptorblockring.h"
 
 //StaticDescriptorHeap: for static descriptor 
+//the descriptors are allocated from a range free-list, so the bindless tables can be freed and reused
+//the tail of the heap is the dynamic region shared by all the contexts, so the heap is never switched inside a command list
 class StaticDescriptorHeap
 {
 public:
-	StaticDescriptorHeap() : m_descriptorHeap(nullptr){}
+	StaticDescriptorHeap() : m_descriptorHeap(nullptr), m_dynamicRegionOffset(0){}
 	~StaticDescriptorHeap() { Release(); }
 
-	void Initialize(const std::wstring& heapName, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t maxDescriptorsNum);
+	//the heap holds maxDescriptorsNum static descriptors followed by the dynamic blocks
+	void Initialize(const std::wstring& heapName, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t maxDescriptorsNum,
+		uint32_t dynamicBlockSize = 0, uint32_t dynamicBlockCount = 0);
 	void Release();
 
-	bool HasAvailableSpace(uint32_t count) const { return count <= m_numFreeDescriptors; }
 	DescriptorHandle Alloc(uint32_t count = 1);
+	//the descriptors are reused after the submitted work of all the queues finished
+	void Free(const DescriptorHandle& handle, uint32_t count);
+	void Free(const DescriptorHandle& handle, uint32_t count, uint64_t fenceValue);
+	//give back the freed descriptors whose fences completed
+	void ReleaseRetiredDescriptors();
+	//the occupancy and fragmentation of the heap
+	DescriptorIndexReport GetReport();
+
+	//reserve a block of the dynamic region for the dynamic descriptor tables of one context
+	DescriptorHandle ReserveDynamicBlock();
+	//the block is reused after the command list which referenced it finished
+	void RetireDynamicBlock(const DescriptorHandle& blockStart, uint64_t fenceValue);
+	uint32_t GetDynamicBlockSize() const { return m_dynamicBlocks.GetBlockSize(); }
 
 	DescriptorHandle operator[](uint32_t arrayIndex) { return m_firstHandle + arrayIndex * m_descriptorSize; }
 
@@ -32,9 +50,12 @@ private:
 	ID3D12DescriptorHeap* m_descriptorHeap;
 	D3D12_DESCRIPTOR_HEAP_DESC m_heapDesc;
 	uint32_t m_descriptorSize;
-	uint32_t m_numFreeDescriptors;
 	DescriptorHandle m_firstHandle;
-	DescriptorHandle m_nextFreeHandle;
+	DescriptorIndexAllocator m_indexAllocator;
+	std::mutex m_mutex;
+	//the dynamic region starts behind the static descriptors, the ring is lock free
+	uint32_t m_dynamicRegionOffset;
+	DescriptorBlockRing m_dynamicBlocks;
 };
 
 
@@ -0,0 +1,101 @@
+#include "taskpool.h"
+#include <algorithm>
+#include <cassert>
+
+void TaskPool::Initialize(uint32_t workerCount)
+{
+	assert(m_workers.empty());
+	m_exit = false;
+	for (uint32_t i = 0; i < workerCount; ++i)
+		m_workers.emplace_back(&TaskPool::WorkerLoop, this);
+}
+
+void TaskPool::Release()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_exit = true;
+	}
+	m_workCondition.notify_all();
+	for (std::thread& worker : m_workers)
+		worker.join();
+	m_workers.clear();
+}
+
+void TaskPool::ParallelFor(uint32_t taskCount, const TaskFunc& task)
+{
+	if (taskCount == 0)
+		return;
+	//a single task or a pool without workers is not worth waking the workers
+	if (taskCount == 1 || m_workers.empty()) {
+		for (uint32_t i = 0; i < taskCount; ++i)
+			task(i);
+		return;
+	}
+
+	std::lock_guard<std::mutex> parallelForGuard(m_parallelForMutex);
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_task = &task;
+		m_taskCount = taskCount;
+		m_nextTask.store(0, std::memory_order_relaxed);
+		m_completedTasks.store(0, std::memory_order_relaxed);
+		m_generation++;
+	}
+	m_workCondition.notify_all();
+
+	RunTasks();
+
+	//the task must outlive every worker reading it
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [this, taskCount]() {
+		return m_completedTasks.load(std::memory_order_acquire) == taskCount && m_activeWorkers == 0;
+	});
+	m_task = nullptr;
+}
+
+void TaskPool::WorkerLoop()
+{
+	uint64_t finishedGeneration = 0;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		m_workCondition.wait(lock, [this, finishedGeneration]() {
+			return m_exit || (m_task != nullptr && m_generation != finishedGeneration);
+		});
+		if (m_exit)
+			return;
+
+		finishedGeneration = m_generation;
+		m_activeWorkers++;
+		lock.unlock();
+		RunTasks();
+		lock.lock();
+		m_activeWorkers--;
+		m_doneCondition.notify_all();
+	}
+}
+
+void TaskPool::RunTasks()
+{
+	//the threads take the tasks one by one, so the slow tasks do not hold the others back
+	uint32_t taskIndex;
+	while ((taskIndex = m_nextTask.fetch_add(1, std::memory_order_relaxed)) < m_taskCount) {
+		(*m_task)(taskIndex);
+		m_completedTasks.fetch_add(1, std::memory_order_release);
+	}
+}
+
+uint32_t TaskPool::GetChunkCount(uint32_t itemCount, uint32_t minItemsPerChunk, uint32_t workerCount)
+{
+	assert(minItemsPerChunk > 0);
+	//the caller thread runs a chunk too
+	uint32_t chunkCount = std::min(workerCount + 1, itemCount / minItemsPerChunk);
+	return std::max(chunkCount, 1u);
+}
+
+void TaskPool::GetChunkRange(uint32_t itemCount, uint32_t chunkCount, uint32_t chunkIndex, uint32_t& begin, uint32_t& end)
+{
+	assert(chunkIndex < chunkCount);
+	begin = (uint32_t)((uint64_t)itemCount * chunkIndex / chunkCount);
+	end = (uint32_t)((uint64_t)itemCount * (chunkIndex + 1) / chunkCount);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Task Pool
+//a fixed set of worker threads for the parallel loops of the frame
+//the caller thread joins the loop, so a pool without workers runs the loop serially
+//the pool does not touch the device, so it can be tested alone
+class TaskPool
+{
+public:
+	typedef std::function<void(uint32_t)> TaskFunc;
+
+	TaskPool() : m_task(nullptr), m_taskCount(0), m_nextTask{ 0 }, m_completedTasks{ 0 },
+		m_activeWorkers(0), m_generation(0), m_exit(false) {}
+	~TaskPool() { Release(); }
+
+	TaskPool(const TaskPool&) = delete;
+	TaskPool& operator=(const TaskPool&) = delete;
+
+	void Initialize(uint32_t workerCount);
+	void Release();
+
+	uint32_t GetWorkerCount() const { return (uint32_t)m_workers.size(); }
+
+	//run task(i) for each i in [0, taskCount), return after all the tasks finished
+	//the loops from different threads run one after another
+	void ParallelFor(uint32_t taskCount, const TaskFunc& task);
+
+	//split the items into chunks of at least minItemsPerChunk, one per worker and one for the caller, at least one chunk
+	static uint32_t GetChunkCount(uint32_t itemCount, uint32_t minItemsPerChunk, uint32_t workerCount);
+	//the items [begin, end) of the chunk, the chunks differ in size by one item at most
+	static void GetChunkRange(uint32_t itemCount, uint32_t chunkCount, uint32_t chunkIndex, uint32_t& begin, uint32_t& end);
+
+private:
+	void WorkerLoop();
+	void RunTasks();
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_parallelForMutex;
+
+	//the current loop, written under m_mutex before the workers are woken up
+	std::mutex m_mutex;
+	std::condition_variable m_workCondition;
+	std::condition_variable m_doneCondition;
+	const TaskFunc* m_task;
+	uint32_t m_taskCount;
+	std::atomic<uint32_t> m_nextTask;
+	std::atomic<uint32_t> m_completedTasks;
+	uint32_t m_activeWorkers; //the workers still reading the current loop
+	uint64_t m_generation;
+	bool m_exit;
+};
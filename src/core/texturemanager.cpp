@@ -37,6 +37,7 @@ void ManagedTexture::CreateFromFile(std::wstring filePath, DefaultTextureType fa
 			GetAddressOf(), m_hCpuDescriptorHandle)))
 		{
 			m_isLoading = true;
+			TrackCommittedMemory(MEMORY_CATEGORY_TEXTURE);
 			D3D12_RESOURCE_DESC desc = m_resource->GetDesc();
 			m_Width = (uint32_t)desc.Width;
 			m_Height = desc.Height;
@@ -92,6 +93,8 @@ void ManagedTexture::CreateFromHDRFile(std::string filePath) {
 		D3D12_RESOURCE_STATE_COPY_DEST,
 		nullptr,
 		IID_PPV_ARGS(&m_resource));
+	if (SUCCEEDED(hr))
+		TrackCommittedMemory(MEMORY_CATEGORY_TEXTURE);
 
 	D3D12_SUBRESOURCE_DATA textureData = {};
 	textureData.pData = rgbaData;
@@ -156,6 +159,21 @@ void TextureManager::DestoryTexture(const std::string& key) {
 		m_texturesCache.erase(iter);
 }
 
+uint32_t TextureManager::TrimUnusedTextures() {
+	std::lock_guard<std::mutex> guard(m_mutex);
+	uint32_t trimmedNum = 0;
+	for (auto iter = m_texturesCache.begin(); iter != m_texturesCache.end();) {
+		ManagedTexture* tex = iter->second.get();
+		if (tex->m_referenceCount == 0 && !tex->m_isLoading) {
+			iter = m_texturesCache.erase(iter);
+			trimmedNum++;
+		}
+		else
+			++iter;
+	}
+	return trimmedNum;
+}
+
 D3D12_CPU_DESCRIPTOR_HANDLE TextureManager::GetDefaultTexture(DefaultTextureType defaultID)
 {
 	return defaultTextures[defaultID].GetSRV();
@@ -12,6 +12,7 @@
 class ManagedTexture : public Texture
 {
 	friend class TextureRef;
+	friend class TextureManager;
 public:
 	ManagedTexture(const std::string& fileName);
 
@@ -64,6 +65,8 @@ public:
 
 	TextureRef LoadDDSFromFile(const std::string& filePath, DefaultTextureType defaultTex, bool sRGB = false);
 	void DestoryTexture(const std::string& key);
+	//release the cached textures without references, return the number of released textures
+	uint32_t TrimUnusedTextures();
 
 	D3D12_CPU_DESCRIPTOR_HANDLE GetDefaultTexture(DefaultTextureType texID);
 
@@ -0,0 +1,25 @@
+#include "testharness.h"
+#include <cstring>
+
+//run all the benchmarks, --quick runs a short pass of each
+//the other argument selects the benchmarks whose name contains it
+int main(int argc, char* argv[])
+{
+	GLIMMER_TEST::BenchContext bench;
+	const char* filter = nullptr;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--quick") == 0)
+			bench.m_quick = true;
+		else
+			filter = argv[i];
+	}
+
+	for (const GLIMMER_TEST::BenchCase& benchmark : GLIMMER_TEST::GetBenchmarks()) {
+		if (filter != nullptr && strstr(benchmark.m_name, filter) == nullptr)
+			continue;
+		printf("[ BENCH ] %s\n", benchmark.m_name);
+		benchmark.m_func(bench);
+	}
+	//the benchmarks check their results as well
+	return GLIMMER_TEST::GetFailedChecks() == 0 ? 0 : 1;
+}
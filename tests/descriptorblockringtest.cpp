@@ -0,0 +1,127 @@
+#include "testharness.h"
+#include "simulatedgpu.h"
+#include "descriptorblockring.h"
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(DescriptorBlockRingReserveRetire)
+{
+	SimulatedQueue queue(0, 100);
+	auto isFenceComplete = [&](uint64_t fenceValue) { return queue.IsFenceComplete(fenceValue); };
+	DescriptorBlockRing ring;
+	ring.Initialize(64, 4);
+
+	uint32_t blocks[4];
+	for (uint32_t i = 0; i < 4; ++i) {
+		blocks[i] = ring.Reserve(isFenceComplete);
+		CHECK_EQ(blocks[i], i);
+	}
+	CHECK_EQ(ring.Reserve(isFenceComplete), DescriptorBlockRing::kInvalidBlock);
+	CHECK_EQ(ring.GetReservedCount(), 4u);
+
+	//retired out of order, the second block completes first
+	uint64_t firstFence = queue.Signal();
+	uint64_t secondFence = queue.Signal();
+	ring.Retire(blocks[2], firstFence);
+	ring.Retire(blocks[0], secondFence);
+	CHECK_EQ(ring.GetReservedCount(), 2u);
+	CHECK_EQ(ring.Reserve(isFenceComplete), DescriptorBlockRing::kInvalidBlock);
+
+	queue.WaitForFence(firstFence);
+	CHECK_EQ(ring.Reserve(isFenceComplete), blocks[2]);
+	CHECK_EQ(ring.Reserve(isFenceComplete), DescriptorBlockRing::kInvalidBlock);
+	queue.WaitForFence(secondFence);
+	CHECK_EQ(ring.Reserve(isFenceComplete), blocks[0]);
+	CHECK_EQ(ring.GetReservedCount(), 4u);
+}
+
+//the heap waits for the oldest retired block when the ring is full, never for the whole device
+TEST(DescriptorBlockRingOldestRetiredFence)
+{
+	SimulatedQueue queue(0, 100);
+	auto isFenceComplete = [&](uint64_t fenceValue) { return queue.IsFenceComplete(fenceValue); };
+	DescriptorBlockRing ring;
+	ring.Initialize(64, 3);
+
+	uint32_t blocks[3];
+	for (uint32_t& blockIndex : blocks)
+		blockIndex = ring.Reserve(isFenceComplete);
+	//every block held by the contexts, nothing to wait for
+	CHECK_EQ(ring.GetOldestRetiredFence(), 0ull);
+
+	uint64_t firstFence = queue.Signal();
+	uint64_t secondFence = queue.Signal();
+	ring.Retire(blocks[1], secondFence);
+	ring.Retire(blocks[2], firstFence);
+	CHECK_EQ(ring.GetOldestRetiredFence(), firstFence);
+	CHECK_EQ(ring.Reserve(isFenceComplete), DescriptorBlockRing::kInvalidBlock);
+
+	queue.WaitForFence(ring.GetOldestRetiredFence());
+	CHECK_EQ(ring.Reserve(isFenceComplete), blocks[2]);
+	CHECK_EQ(ring.GetOldestRetiredFence(), secondFence);
+}
+
+//the contexts of several threads reserve and retire the blocks of one heap
+//a block is never owned by two threads, and never reused before its fence completed
+TEST(DescriptorBlockRingConcurrentReserve)
+{
+	const uint32_t kThreadCount = 4;
+	const uint32_t kBlockCount = 16;
+	const uint32_t kCommandListsPerThread = 20000;
+
+	SimulatedQueue queue(0, 12);
+	auto isFenceComplete = [&](uint64_t fenceValue) { return queue.IsFenceComplete(fenceValue); };
+	DescriptorBlockRing ring;
+	ring.Initialize(64, kBlockCount);
+
+	std::unique_ptr<std::atomic<uint32_t>[]> owners(new std::atomic<uint32_t>[kBlockCount]);
+	std::unique_ptr<std::atomic<uint64_t>[]> retiredFences(new std::atomic<uint64_t>[kBlockCount]);
+	for (uint32_t i = 0; i < kBlockCount; ++i) {
+		owners[i] = 0;
+		retiredFences[i] = 0;
+	}
+	std::atomic<uint64_t> exhaustedCount{ 0 };
+
+	std::vector<std::thread> workers;
+	for (uint32_t t = 0; t < kThreadCount; ++t) {
+		workers.emplace_back([&, t]() {
+			std::vector<uint32_t> reservedBlocks;
+			for (uint32_t i = 0; i < kCommandListsPerThread; ++i) {
+				//a command list takes one to three blocks
+				uint32_t blockCount = 1 + (i + t) % 3;
+				for (uint32_t j = 0; j < blockCount; ++j) {
+					uint32_t blockIndex = ring.Reserve(isFenceComplete);
+					if (blockIndex == DescriptorBlockRing::kInvalidBlock) {
+						//every block is in flight, wait for the gpu like the heap does
+						exhaustedCount++;
+						queue.Flush();
+						continue;
+					}
+					CHECK(blockIndex < kBlockCount);
+					uint32_t previousOwner = owners[blockIndex].exchange(t + 1);
+					CHECK_EQ(previousOwner, 0u);
+					uint64_t retiredFence = retiredFences[blockIndex].load();
+					CHECK(retiredFence == 0 || queue.IsFenceComplete(retiredFence));
+					reservedBlocks.push_back(blockIndex);
+				}
+
+				uint64_t fenceValue = queue.Signal();
+				for (uint32_t blockIndex : reservedBlocks) {
+					retiredFences[blockIndex] = fenceValue;
+					owners[blockIndex] = 0;
+					ring.Retire(blockIndex, fenceValue);
+				}
+				reservedBlocks.clear();
+			}
+		});
+	}
+	for (std::thread& worker : workers)
+		worker.join();
+
+	CHECK_EQ(ring.GetReservedCount(), 0u);
+	queue.Flush();
+	for (uint32_t i = 0; i < kBlockCount; ++i)
+		CHECK(ring.Reserve(isFenceComplete) != DescriptorBlockRing::kInvalidBlock);
+	printf("  the ring was exhausted %llu times\n", (unsigned long long)exhaustedCount.load());
+}
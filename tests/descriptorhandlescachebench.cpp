@@ -0,0 +1,78 @@
+#include "testharness.h"
+#include "recordingdevice.h"
+#include "descriptorhandlescache.h"
+
+namespace
+{
+	const UINT kDescriptorSize = 32;
+	const uint32_t kTableCount = 4;
+	const uint32_t kTableSizes[DescriptorHandlesCache::maxNumDescriptorTables] = { 8, 4, 16, 2 };
+	//the shader visible block the tables are copied to, it wraps like the dynamic blocks
+	const size_t kHeapDescriptors = 4096;
+
+	//each draw rewrites one table, like a material change, and commits before the draw
+	//dirtyOnly commits the changed table, otherwise every assigned table is staged and copied again
+	double RunDraws(uint64_t drawCount, bool dirtyOnly, RecordingDevice& device, RecordingCommandList& commandList)
+	{
+		DescriptorHandlesCache cache;
+		cache.ParseRootSignature((1 << kTableCount) - 1, kTableSizes);
+
+		D3D12_CPU_DESCRIPTOR_HANDLE sourceHandles[16];
+		for (uint32_t i = 0; i < 16; ++i)
+			sourceHandles[i].ptr = 0x100000 + i * kDescriptorSize;
+		for (uint32_t rootIndex = 0; rootIndex < kTableCount; ++rootIndex)
+			cache.StoreDescriptorsCPUHandles(rootIndex, 0, kTableSizes[rootIndex], sourceHandles);
+
+		D3D12_CPU_DESCRIPTOR_HANDLE tableCPUHandles[DescriptorHandlesCache::maxNumDescriptorTables];
+		D3D12_GPU_DESCRIPTOR_HANDLE tableGPUHandles[DescriptorHandlesCache::maxNumDescriptorTables];
+		size_t heapOffset = 0;
+
+		GLIMMER_TEST::Stopwatch stopwatch;
+		for (uint64_t draw = 0; draw < drawCount; ++draw) {
+			uint32_t changedTable = (uint32_t)(draw % kTableCount);
+			sourceHandles[0].ptr += kDescriptorSize;
+			cache.StoreDescriptorsCPUHandles(changedTable, 0, 1, sourceHandles);
+
+			uint32_t commitBitMap = dirtyOnly ? cache.m_dirtyRootParamsBitMap : cache.m_assignedRootParamsBitMap;
+			uint32_t copySize = 0;
+			for (uint32_t rootIndex = 0; rootIndex < kTableCount; ++rootIndex) {
+				if ((commitBitMap & (1 << rootIndex)) != 0)
+					copySize += cache.ComputeTableDescriptorsSize(rootIndex);
+			}
+			if (heapOffset + copySize > kHeapDescriptors)
+				heapOffset = 0;
+			for (uint32_t rootIndex = 0; rootIndex < kTableCount; ++rootIndex) {
+				if ((commitBitMap & (1 << rootIndex)) == 0)
+					continue;
+				tableCPUHandles[rootIndex].ptr = 0x8000 + heapOffset * kDescriptorSize;
+				tableGPUHandles[rootIndex].ptr = 0x1008000 + heapOffset * kDescriptorSize;
+				heapOffset += cache.ComputeTableDescriptorsSize(rootIndex);
+			}
+
+			cache.CommitDescriptorHandleToDescriptorHeap(&device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kDescriptorSize,
+				tableCPUHandles, tableGPUHandles, commitBitMap, commitBitMap, &commandList,
+				&ID3D12GraphicsCommandList::SetGraphicsRootDescriptorTable);
+			cache.m_dirtyRootParamsBitMap = 0;
+		}
+		return stopwatch.GetSeconds();
+	}
+}
+
+//the cost of staging the descriptor tables for a draw, against a device which only counts the copies
+BENCHMARK(DescriptorHandlesCacheCommit)
+{
+	const uint64_t drawCount = bench.Iterations(2000000);
+	const bool kModes[] = { true, false };
+
+	for (bool dirtyOnly : kModes) {
+		RecordingDevice device(kDescriptorSize);
+		device.SetApplyCopies(false);
+		RecordingCommandList commandList;
+		double seconds = RunDraws(drawCount, dirtyOnly, device, commandList);
+
+		bench.Report(dirtyOnly ? "commit dirty tables" : "commit all tables", drawCount, seconds);
+		printf("  %-48s %.2f descriptors, %.2f copy calls, %.2f binds per draw\n", "",
+			(double)device.GetCopiedDescriptors() / (double)drawCount, (double)device.GetCopyCalls() / (double)drawCount,
+			(double)commandList.GetBindCalls() / (double)drawCount);
+	}
+}
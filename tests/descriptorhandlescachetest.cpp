@@ -0,0 +1,95 @@
+#include "testharness.h"
+#include "recordingdevice.h"
+#include "descriptorhandlescache.h"
+
+namespace
+{
+	const UINT kDescriptorSize = 32;
+
+	D3D12_CPU_DESCRIPTOR_HANDLE SourceHandle(size_t index)
+	{
+		D3D12_CPU_DESCRIPTOR_HANDLE handle;
+		handle.ptr = 0x100000 + index * kDescriptorSize;
+		return handle;
+	}
+}
+
+//the assigned slots land at their offsets in the heap, the holes are skipped
+TEST(DescriptorHandlesCacheCommitsSparseTables)
+{
+	RecordingDevice device(kDescriptorSize);
+	RecordingCommandList commandList;
+	DescriptorHandlesCache cache;
+
+	//root index 1 has 8 slots and root index 3 has 4 slots
+	uint32_t tableSizes[DescriptorHandlesCache::maxNumDescriptorTables] = { 0, 8, 0, 4 };
+	cache.ParseRootSignature((1 << 1) | (1 << 3), tableSizes);
+
+	D3D12_CPU_DESCRIPTOR_HANDLE handles[8];
+	for (size_t i = 0; i < 8; ++i)
+		handles[i] = SourceHandle(i);
+	cache.StoreDescriptorsCPUHandles(1, 0, 2, handles);
+	cache.StoreDescriptorsCPUHandles(1, 5, 2, handles + 2);
+	cache.StoreDescriptorsCPUHandles(3, 1, 1, handles + 4);
+	CHECK_EQ(cache.m_dirtyRootParamsBitMap, (1u << 1) | (1u << 3));
+	//the table is sized up to its last assigned slot
+	CHECK_EQ(cache.ComputeTableDescriptorsSize(1), 7u);
+	CHECK_EQ(cache.ComputeTableDescriptorsSize(3), 2u);
+	CHECK_EQ(cache.ComputeAssignedDescriptorsSize(), 9u);
+
+	D3D12_CPU_DESCRIPTOR_HANDLE tableCPUHandles[DescriptorHandlesCache::maxNumDescriptorTables] = {};
+	D3D12_GPU_DESCRIPTOR_HANDLE tableGPUHandles[DescriptorHandlesCache::maxNumDescriptorTables] = {};
+	tableCPUHandles[1].ptr = 0x8000;
+	tableGPUHandles[1].ptr = 0x1008000;
+	tableCPUHandles[3].ptr = 0x8000 + 7 * kDescriptorSize;
+	tableGPUHandles[3].ptr = 0x1008000 + 7 * kDescriptorSize;
+
+	uint32_t dirtyBitMap = cache.m_dirtyRootParamsBitMap;
+	cache.CommitDescriptorHandleToDescriptorHeap(&device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kDescriptorSize,
+		tableCPUHandles, tableGPUHandles, dirtyBitMap, dirtyBitMap, &commandList,
+		&ID3D12GraphicsCommandList::SetGraphicsRootDescriptorTable);
+
+	CHECK_EQ(commandList.GetGraphicsTable(1), 0x1008000u);
+	CHECK_EQ(commandList.GetGraphicsTable(3), 0x1008000u + 7 * kDescriptorSize);
+	CHECK_EQ(commandList.GetBindCalls(), 2u);
+	//one copy call with three destination runs
+	CHECK_EQ(device.GetCopyCalls(), 1u);
+	CHECK_EQ(device.GetDestRanges(), 3u);
+	CHECK_EQ(device.GetCopiedDescriptors(), 5u);
+
+	size_t expectedSlots[] = { 0, 1, 5, 6 };
+	for (size_t i = 0; i < 4; ++i)
+		CHECK_EQ(device.GetCopiedSource(0x8000 + expectedSlots[i] * kDescriptorSize), SourceHandle(i).ptr);
+	CHECK_EQ(device.GetCopiedSource(0x8000 + 2 * kDescriptorSize), 0u);
+	CHECK_EQ(device.GetCopiedSource(0x8000 + 8 * kDescriptorSize), SourceHandle(4).ptr);
+}
+
+//the tables missing in copyTablesBitMap are bound without any copy
+TEST(DescriptorHandlesCacheBindsCachedTablesWithoutCopy)
+{
+	RecordingDevice device(kDescriptorSize);
+	RecordingCommandList commandList;
+	DescriptorHandlesCache cache;
+
+	uint32_t tableSizes[DescriptorHandlesCache::maxNumDescriptorTables] = { 4, 4 };
+	cache.ParseRootSignature(0x3, tableSizes);
+	D3D12_CPU_DESCRIPTOR_HANDLE handles[4] = { SourceHandle(0), SourceHandle(1), SourceHandle(2), SourceHandle(3) };
+	cache.StoreDescriptorsCPUHandles(0, 0, 4, handles);
+	cache.StoreDescriptorsCPUHandles(1, 0, 4, handles);
+
+	D3D12_CPU_DESCRIPTOR_HANDLE tableCPUHandles[2] = { { 0x8000 }, { 0x9000 } };
+	D3D12_GPU_DESCRIPTOR_HANDLE tableGPUHandles[2] = { { 0x18000 }, { 0x19000 } };
+	cache.CommitDescriptorHandleToDescriptorHeap(&device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kDescriptorSize,
+		tableCPUHandles, tableGPUHandles, 0x3, 0x1, &commandList, &ID3D12GraphicsCommandList::SetComputeRootDescriptorTable);
+
+	CHECK_EQ(commandList.GetComputeTable(0), 0x18000u);
+	CHECK_EQ(commandList.GetComputeTable(1), 0x19000u);
+	CHECK_EQ(device.GetCopiedDescriptors(), 4u);
+	CHECK_EQ(device.GetCopiedSource(0x9000), 0u);
+
+	//nothing to copy, no copy call
+	cache.CommitDescriptorHandleToDescriptorHeap(&device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kDescriptorSize,
+		tableCPUHandles, tableGPUHandles, 0x2, 0, &commandList, &ID3D12GraphicsCommandList::SetComputeRootDescriptorTable);
+	CHECK_EQ(device.GetCopyCalls(), 1u);
+	CHECK_EQ(commandList.GetBindCalls(), 3u);
+}
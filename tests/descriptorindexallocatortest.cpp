@@ -0,0 +1,197 @@
+#include "testharness.h"
+#include "simulatedgpu.h"
+#include "descriptorindexallocator.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+TEST(DescriptorIndexBestFit)
+{
+	DescriptorIndexAllocator allocator;
+	allocator.Initialize(100);
+
+	uint32_t first = allocator.Alloc(10);
+	uint32_t second = allocator.Alloc(20);
+	uint32_t third = allocator.Alloc(5);
+	uint32_t fourth = allocator.Alloc(30);
+	uint32_t fifth = allocator.Alloc(10);
+	CHECK_EQ(first, 0u);
+	CHECK_EQ(second, 10u);
+	CHECK_EQ(third, 30u);
+	CHECK_EQ(fourth, 35u);
+	CHECK_EQ(fifth, 65u);
+
+	//the free ranges are 20 at 10, 30 at 35 and 25 at 75
+	allocator.Free(second, 20);
+	allocator.Free(fourth, 30);
+	CHECK_EQ(allocator.Alloc(22), 75u);
+	CHECK_EQ(allocator.Alloc(18), 10u);
+	CHECK_EQ(allocator.Alloc(31), DescriptorIndexAllocator::kInvalidIndex);
+	CHECK_EQ(allocator.Alloc(30), 35u);
+	CHECK_EQ(allocator.GetUsedCount(), 95u);
+}
+
+TEST(DescriptorIndexMergesNeighbours)
+{
+	const uint32_t kRangeCount = 64;
+	DescriptorIndexAllocator allocator;
+	allocator.Initialize(kRangeCount * 4);
+
+	std::vector<uint32_t> indices;
+	for (uint32_t i = 0; i < kRangeCount; ++i)
+		indices.push_back(allocator.Alloc(4));
+	CHECK_EQ(allocator.Alloc(1), DescriptorIndexAllocator::kInvalidIndex);
+
+	//free in a random order, the neighbours merge on both sides
+	std::mt19937 random(3);
+	std::shuffle(indices.begin(), indices.end(), random);
+	for (uint32_t index : indices)
+		allocator.Free(index, 4);
+
+	DescriptorIndexReport report = allocator.GetReport();
+	CHECK_EQ(report.m_freeRangeCount, 1u);
+	CHECK_EQ(report.m_largestFreeRange, kRangeCount * 4);
+	CHECK_EQ(report.m_fragmentation, 0.0f);
+	CHECK_EQ(allocator.Alloc(kRangeCount * 4), 0u);
+}
+
+TEST(DescriptorIndexDeferredFree)
+{
+	SimulatedQueue directQueue(0, 100);
+	SimulatedQueue computeQueue(2, 100);
+	auto isFenceComplete = [&](uint64_t fenceValue) {
+		return (fenceValue >> 56) == 0 ? directQueue.IsFenceComplete(fenceValue) : computeQueue.IsFenceComplete(fenceValue);
+	};
+
+	DescriptorIndexAllocator allocator;
+	allocator.Initialize(16);
+	uint32_t first = allocator.Alloc(8);
+	uint32_t second = allocator.Alloc(8);
+
+	//the first range is referenced by both queues, the second only by the direct queue
+	uint64_t fenceValues[] = { directQueue.Signal(), computeQueue.Signal() };
+	allocator.Free(first, 8, fenceValues, 2);
+	allocator.Free(second, 8, fenceValues[0]);
+	CHECK_EQ(allocator.GetReport().m_pendingFreeCount, 16u);
+	CHECK_EQ(allocator.GetUsedCount(), 0u);
+	CHECK_EQ(allocator.ReleaseCompleted(isFenceComplete), 0u);
+	CHECK_EQ(allocator.Alloc(1), DescriptorIndexAllocator::kInvalidIndex);
+
+	//the direct queue alone only releases the second range
+	directQueue.WaitForFence(fenceValues[0]);
+	CHECK_EQ(allocator.ReleaseCompleted(isFenceComplete), 8u);
+	CHECK_EQ(allocator.Alloc(9), DescriptorIndexAllocator::kInvalidIndex);
+	CHECK_EQ(allocator.GetReport().m_pendingFreeCount, 8u);
+
+	computeQueue.WaitForFence(fenceValues[1]);
+	CHECK_EQ(allocator.ReleaseCompleted(isFenceComplete), 8u);
+	CHECK_EQ(allocator.GetReport().m_pendingFreeCount, 0u);
+	CHECK_EQ(allocator.Alloc(16), 0u);
+}
+
+TEST(DescriptorIndexFragmentationReport)
+{
+	DescriptorIndexAllocator allocator;
+	allocator.Initialize(100);
+	uint32_t indices[10];
+	for (uint32_t& index : indices)
+		index = allocator.Alloc(10);
+
+	//every other range is free, five ranges of 10
+	for (uint32_t i = 0; i < 10; i += 2)
+		allocator.Free(indices[i], 10);
+	allocator.Free(indices[1], 10, 1);
+
+	DescriptorIndexReport report = allocator.GetReport();
+	CHECK_EQ(report.m_capacity, 100u);
+	CHECK_EQ(report.m_usedCount, 40u);
+	CHECK_EQ(report.m_pendingFreeCount, 10u);
+	CHECK_EQ(report.m_freeRangeCount, 5u);
+	CHECK_EQ(report.m_largestFreeRange, 10u);
+	CHECK(std::fabs(report.m_fragmentation - 0.8f) < 1e-6f);
+
+	//the pending range joins its neighbours when it is released
+	allocator.ReleaseCompleted([](uint64_t) { return true; });
+	report = allocator.GetReport();
+	CHECK_EQ(report.m_freeRangeCount, 4u);
+	CHECK_EQ(report.m_largestFreeRange, 30u);
+	CHECK(std::fabs(report.m_fragmentation - 0.5f) < 1e-6f);
+}
+
+//random tables allocated and freed behind a simulated fence
+//an index is never handed out while it is live or its free is waiting for the fence
+TEST(DescriptorIndexRandomized)
+{
+	const uint32_t kCapacity = 4096;
+	const uint32_t kFrameCount = 5000;
+
+	struct IndexRange
+	{
+		uint32_t m_index;
+		uint32_t m_count;
+		uint64_t m_fenceValue;
+	};
+
+	SimulatedQueue queue(0, 2);
+	auto isFenceComplete = [&](uint64_t fenceValue) { return queue.IsFenceComplete(fenceValue); };
+	DescriptorIndexAllocator allocator;
+	allocator.Initialize(kCapacity);
+
+	std::mt19937 random(5);
+	std::vector<bool> occupied(kCapacity, false);
+	std::vector<IndexRange> liveRanges;
+	std::vector<IndexRange> pendingRanges;
+	uint32_t failedCount = 0;
+
+	for (uint32_t frame = 0; frame < kFrameCount; ++frame) {
+		allocator.ReleaseCompleted(isFenceComplete);
+		for (size_t i = 0; i < pendingRanges.size();) {
+			if (queue.IsFenceComplete(pendingRanges[i].m_fenceValue)) {
+				for (uint32_t j = 0; j < pendingRanges[i].m_count; ++j)
+					occupied[pendingRanges[i].m_index + j] = false;
+				pendingRanges[i] = pendingRanges.back();
+				pendingRanges.pop_back();
+			}
+			else
+				++i;
+		}
+
+		uint64_t fenceValue = queue.Signal();
+		for (uint32_t i = 0; i < 8; ++i) {
+			uint32_t count = 1 + random() % 64;
+			uint32_t index = allocator.Alloc(count);
+			if (index == DescriptorIndexAllocator::kInvalidIndex) {
+				failedCount++;
+				continue;
+			}
+			CHECK(index + count <= kCapacity);
+			for (uint32_t j = index; j < index + count; ++j) {
+				CHECK(!occupied[j]);
+				occupied[j] = true;
+			}
+			liveRanges.push_back(IndexRange{ index, count, 0 });
+		}
+
+		while (liveRanges.size() > 64) {
+			size_t pick = random() % liveRanges.size();
+			IndexRange range = liveRanges[pick];
+			liveRanges[pick] = liveRanges.back();
+			liveRanges.pop_back();
+			allocator.Free(range.m_index, range.m_count, fenceValue);
+			range.m_fenceValue = fenceValue;
+			pendingRanges.push_back(range);
+		}
+
+		DescriptorIndexReport report = allocator.GetReport();
+		CHECK(report.m_usedCount + report.m_pendingFreeCount <= kCapacity);
+	}
+
+	queue.Flush();
+	allocator.ReleaseCompleted(isFenceComplete);
+	for (const IndexRange& range : liveRanges)
+		allocator.Free(range.m_index, range.m_count);
+	CHECK_EQ(allocator.GetReport().m_freeRangeCount, 1u);
+	CHECK_EQ(allocator.GetUsedCount(), 0u);
+	printf("  %u allocations did not fit\n", failedCount);
+}
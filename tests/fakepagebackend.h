@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//The fake page behind LinearPageCache, it has no memory and never touches the device
+struct FakePage
+{
+	FakePage* m_nextReadyPage = nullptr;
+	size_t m_pageSize = 0;
+	uint64_t m_lastUsedFrame = 0;
+	//set when the cache trimmed the page, a released page must never be requested again
+	std::atomic<bool> m_released{ false };
+};
+
+//Fake Page Backend
+//creates the pages and simulates the gpu fences, a fence completes when fenceLatency newer fences were signaled
+//the released pages are kept until the backend is destroyed, so the tests can check they are not reused
+class FakePageBackend
+{
+public:
+	FakePageBackend(size_t pageSize, uint64_t fenceLatency) :
+		m_pageSize(pageSize), m_fenceLatency(fenceLatency) {}
+
+	FakePage* CreatePage() {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		m_pages.emplace_back(new FakePage());
+		m_pages.back()->m_pageSize = m_pageSize;
+		return m_pages.back().get();
+	}
+
+	void ReleasePage(FakePage* page) {
+		page->m_released = true;
+		m_releasedCount++;
+	}
+
+	//signal the fence of a submission
+	uint64_t Signal() {
+		uint64_t fenceValue = m_nextFenceValue++;
+		if (fenceValue > m_fenceLatency) {
+			uint64_t completedValue = m_completedFenceValue.load();
+			while (fenceValue - m_fenceLatency > completedValue &&
+				!m_completedFenceValue.compare_exchange_weak(completedValue, fenceValue - m_fenceLatency)) {}
+		}
+		return fenceValue;
+	}
+
+	bool IsFenceComplete(uint64_t fenceValue) const { return fenceValue <= m_completedFenceValue.load(); }
+	void CompleteAllFences() { m_completedFenceValue = m_nextFenceValue - 1; }
+
+	uint64_t GetCreatedCount() {
+		std::lock_guard<std::mutex> lockGuard(m_mutex);
+		return m_pages.size();
+	}
+	uint64_t GetReleasedCount() const { return m_releasedCount; }
+
+private:
+	size_t m_pageSize;
+	uint64_t m_fenceLatency;
+	std::atomic<uint64_t> m_nextFenceValue{ 1 };
+	std::atomic<uint64_t> m_completedFenceValue{ 0 };
+	std::atomic<uint64_t> m_releasedCount{ 0 };
+
+	std::mutex m_mutex;
+	std::vector<std::unique_ptr<FakePage>> m_pages;
+};
@@ -0,0 +1,235 @@
+#include "testharness.h"
+#include "simulatedgpu.h"
+#include "fencedreservoir.h"
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	//like CommandAllocatorPool::kThreadMagazineSize and ContextManager::kThreadMagazineSize
+	const uint32_t kMagazineSize = 8;
+	//the submissions the simulated gpu runs behind the cpu
+	const uint64_t kGpuLatency = 4;
+
+	//a command allocator or a context, handed to one thread at a time
+	struct FakeAllocator
+	{
+		std::atomic<bool> m_inUse{ false };
+	};
+
+	//owns every created allocator, only the creation takes the lock like the pools
+	class FakeAllocatorFactory
+	{
+	public:
+		~FakeAllocatorFactory() {
+			for (FakeAllocator* allocator : m_allocators)
+				delete allocator;
+		}
+
+		FakeAllocator* Create() {
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			m_allocators.push_back(new FakeAllocator());
+			return m_allocators.back();
+		}
+
+		size_t GetCreatedCount() {
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			return m_allocators.size();
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::vector<FakeAllocator*> m_allocators;
+	};
+
+	//the allocator pool before the reservoir: one mutex, and only the front of the queue is checked
+	class MutexAllocatorPool
+	{
+	public:
+		explicit MutexAllocatorPool(FakeAllocatorFactory& factory) : m_factory(factory) {}
+
+		template<typename FenceCompleteFunc>
+		FakeAllocator* Request(FenceCompleteFunc isFenceComplete) {
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			if (!m_readyAllocators.empty() && isFenceComplete(m_readyAllocators.front().first)) {
+				FakeAllocator* allocator = m_readyAllocators.front().second;
+				m_readyAllocators.pop();
+				return allocator;
+			}
+			return m_factory.Create();
+		}
+
+		void Discard(uint64_t fenceValue, FakeAllocator* allocator) {
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			m_readyAllocators.push(std::make_pair(fenceValue, allocator));
+		}
+
+	private:
+		FakeAllocatorFactory& m_factory;
+		std::mutex m_mutex;
+		std::queue<std::pair<uint64_t, FakeAllocator*>> m_readyAllocators;
+	};
+
+	typedef ThreadMagazine<FakeAllocator, kMagazineSize> AllocatorMagazine;
+
+	//each thread requests an allocator, records, and retires it with the fence of its submission
+	template<typename RequestFunc, typename DiscardFunc>
+	double RunSubmissions(uint32_t threadCount, uint64_t submissionsPerThread, SimulatedQueue& queue,
+		RequestFunc request, DiscardFunc discard)
+	{
+		GLIMMER_TEST::Stopwatch stopwatch;
+		std::vector<std::thread> workers;
+		for (uint32_t t = 0; t < threadCount; ++t) {
+			workers.emplace_back([&]() {
+				//the thread local magazine of the thread, the baseline ignores it
+				AllocatorMagazine magazine;
+				for (uint64_t i = 0; i < submissionsPerThread; ++i) {
+					FakeAllocator* allocator = request(magazine);
+					CHECK(!allocator->m_inUse.exchange(true));
+					allocator->m_inUse.store(false);
+					discard(magazine, queue.Signal(), allocator);
+				}
+			});
+		}
+		for (std::thread& worker : workers)
+			worker.join();
+		return stopwatch.GetSeconds();
+	}
+}
+
+//N threads requesting and retiring command allocators against a simulated gpu
+//the reservoir refills the thread magazines and takes their retired allocators in batches
+//the baseline takes one mutex per request and one per discard
+BENCHMARK(CommandAllocatorPoolContention)
+{
+	const uint64_t submissionsPerThread = bench.Iterations(1000000);
+	const uint32_t kThreadCounts[] = { 1, 2, 4, 8 };
+
+	for (uint32_t threadCount : kThreadCounts) {
+		char label[64];
+		uint64_t operations = submissionsPerThread * threadCount;
+
+		{
+			SimulatedQueue queue(0, kGpuLatency);
+			FakeAllocatorFactory factory;
+			FencedReservoir<FakeAllocator> reservoir;
+			auto isFenceComplete = [&](uint64_t fenceValue) { return queue.IsFenceComplete(fenceValue); };
+			double seconds = RunSubmissions(threadCount, submissionsPerThread, queue,
+				[&](AllocatorMagazine& magazine) {
+					if (magazine.IsEmpty())
+						magazine.Refill(reservoir, isFenceComplete);
+					return magazine.IsEmpty() ? factory.Create() : magazine.Pop();
+				},
+				[&](AllocatorMagazine& magazine, uint64_t fenceValue, FakeAllocator* allocator) {
+					magazine.Retire(reservoir, fenceValue, allocator);
+				});
+			snprintf(label, sizeof(label), "reservoir, %u threads", threadCount);
+			bench.Report(label, operations, seconds);
+			printf("  %-48s %llu allocators created\n", "", (unsigned long long)factory.GetCreatedCount());
+			//the allocators are bounded by the fences in flight and the magazines, not by the submissions
+			CHECK(factory.GetCreatedCount() <= kGpuLatency + 1 + threadCount * (kMagazineSize + AllocatorMagazine::kRefillCount));
+		}
+
+		{
+			SimulatedQueue queue(0, kGpuLatency);
+			FakeAllocatorFactory factory;
+			MutexAllocatorPool pool(factory);
+			auto isFenceComplete = [&](uint64_t fenceValue) { return queue.IsFenceComplete(fenceValue); };
+			double seconds = RunSubmissions(threadCount, submissionsPerThread, queue,
+				[&](AllocatorMagazine&) { return pool.Request(isFenceComplete); },
+				[&](AllocatorMagazine&, uint64_t fenceValue, FakeAllocator* allocator) { pool.Discard(fenceValue, allocator); });
+			snprintf(label, sizeof(label), "mutex pool, %u threads", threadCount);
+			bench.Report(label, operations, seconds);
+			printf("  %-48s %llu allocators created\n", "", (unsigned long long)factory.GetCreatedCount());
+		}
+	}
+}
+
+//N threads allocating and freeing contexts, a few in flight at a time like the parallel recording
+//the free contexts stay in the thread magazines and move in batches, the baseline takes one mutex per call
+BENCHMARK(ContextPoolContention)
+{
+	const uint64_t allocationsPerThread = bench.Iterations(1000000);
+	const uint32_t kThreadCounts[] = { 1, 2, 4, 8 };
+	const uint32_t kContextsInFlight = 3;
+
+	for (uint32_t threadCount : kThreadCounts) {
+		char label[64];
+		uint64_t operations = allocationsPerThread * threadCount;
+
+		{
+			FakeAllocatorFactory factory;
+			FencedReservoir<FakeAllocator> reservoir;
+			GLIMMER_TEST::Stopwatch stopwatch;
+			std::vector<std::thread> workers;
+			for (uint32_t t = 0; t < threadCount; ++t) {
+				workers.emplace_back([&]() {
+					AllocatorMagazine magazine;
+					FakeAllocator* contexts[kContextsInFlight];
+					for (uint64_t i = 0; i < allocationsPerThread; i += kContextsInFlight) {
+						for (FakeAllocator*& context : contexts) {
+							if (magazine.IsEmpty())
+								magazine.Refill(reservoir, [](uint64_t) { return true; });
+							context = magazine.IsEmpty() ? factory.Create() : magazine.Pop();
+							CHECK(!context->m_inUse.exchange(true));
+						}
+						for (FakeAllocator* context : contexts) {
+							context->m_inUse.store(false);
+							if (magazine.IsFull())
+								magazine.Drain(reservoir);
+							magazine.Push(context);
+						}
+					}
+				});
+			}
+			for (std::thread& worker : workers)
+				worker.join();
+			double seconds = stopwatch.GetSeconds();
+			snprintf(label, sizeof(label), "magazines, %u threads", threadCount);
+			bench.Report(label, operations, seconds);
+			printf("  %-48s %llu contexts created\n", "", (unsigned long long)factory.GetCreatedCount());
+		}
+
+		{
+			FakeAllocatorFactory factory;
+			std::mutex mutex;
+			std::vector<FakeAllocator*> freeContexts;
+			GLIMMER_TEST::Stopwatch stopwatch;
+			std::vector<std::thread> workers;
+			for (uint32_t t = 0; t < threadCount; ++t) {
+				workers.emplace_back([&]() {
+					FakeAllocator* contexts[kContextsInFlight];
+					for (uint64_t i = 0; i < allocationsPerThread; i += kContextsInFlight) {
+						for (FakeAllocator*& context : contexts) {
+							{
+								std::lock_guard<std::mutex> lockGuard(mutex);
+								context = nullptr;
+								if (!freeContexts.empty()) {
+									context = freeContexts.back();
+									freeContexts.pop_back();
+								}
+							}
+							if (context == nullptr)
+								context = factory.Create();
+							CHECK(!context->m_inUse.exchange(true));
+						}
+						for (FakeAllocator* context : contexts) {
+							context->m_inUse.store(false);
+							std::lock_guard<std::mutex> lockGuard(mutex);
+							freeContexts.push_back(context);
+						}
+					}
+				});
+			}
+			for (std::thread& worker : workers)
+				worker.join();
+			double seconds = stopwatch.GetSeconds();
+			snprintf(label, sizeof(label), "mutex pool, %u threads", threadCount);
+			bench.Report(label, operations, seconds);
+			printf("  %-48s %llu contexts created\n", "", (unsigned long long)factory.GetCreatedCount());
+		}
+	}
+}
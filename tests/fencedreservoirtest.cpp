@@ -0,0 +1,99 @@
+#include "testharness.h"
+#include "simulatedgpu.h"
+#include "fencedreservoir.h"
+#include <thread>
+
+namespace
+{
+	struct FakeItem
+	{
+		uint32_t m_id;
+	};
+
+	typedef ThreadMagazine<FakeItem, 8> ItemMagazine;
+}
+
+//the retired items reach the reservoir in batches, the refill takes the own batch of the thread too
+TEST(FencedReservoirBatchesRetiredItems)
+{
+	SimulatedQueue queue(0, 100);
+	auto isFenceComplete = [&](uint64_t fenceValue) { return queue.IsFenceComplete(fenceValue); };
+	FencedReservoir<FakeItem> reservoir;
+	ItemMagazine magazine;
+	const uint32_t kBatchSize = ItemMagazine::kRefillCount;
+	FakeItem items[kBatchSize];
+
+	for (uint32_t i = 0; i + 1 < kBatchSize; ++i)
+		magazine.Retire(reservoir, queue.Signal(), &items[i]);
+	CHECK_EQ(reservoir.GetRetiredCount(), 0u);
+	magazine.Retire(reservoir, queue.Signal(), &items[kBatchSize - 1]);
+	CHECK_EQ(reservoir.GetRetiredCount(), (size_t)kBatchSize);
+	CHECK_EQ(magazine.m_retiredCount, 0u);
+
+	//not completed yet, nothing to take
+	uint64_t lastFence = queue.Signal();
+	magazine.Retire(reservoir, lastFence, &items[0]);
+	CHECK_EQ(magazine.Refill(reservoir, isFenceComplete), 0u);
+	CHECK_EQ(reservoir.GetRetiredCount(), (size_t)kBatchSize + 1);
+
+	//retired out of order by several threads, every completed item is found
+	queue.WaitForFence(lastFence);
+	CHECK_EQ(magazine.Refill(reservoir, isFenceComplete), kBatchSize);
+	CHECK_EQ(reservoir.GetRetiredCount(), 0u);
+	CHECK_EQ(reservoir.GetReadyCount(), 1u);
+}
+
+TEST(FencedReservoirSkipsPendingFences)
+{
+	SimulatedQueue queue(0, 100);
+	auto isFenceComplete = [&](uint64_t fenceValue) { return queue.IsFenceComplete(fenceValue); };
+	FencedReservoir<FakeItem> reservoir;
+	FakeItem items[3];
+
+	uint64_t firstFence = queue.Signal();
+	uint64_t secondFence = queue.Signal();
+	reservoir.Retire(secondFence, &items[0]);
+	reservoir.Retire(firstFence, &items[1]);
+	FakeItem* readyItem = &items[2];
+	reservoir.GiveBack(&readyItem, 1);
+
+	FakeItem* taken[3];
+	queue.WaitForFence(firstFence);
+	CHECK_EQ(reservoir.Take(isFenceComplete, taken, 3), 2u);
+	CHECK(taken[0] == &items[1] || taken[1] == &items[1]);
+	CHECK_EQ(reservoir.GetRetiredCount(), 1u);
+
+	reservoir.Clear();
+	queue.WaitForFence(secondFence);
+	CHECK_EQ(reservoir.Take(isFenceComplete, taken, 3), 0u);
+}
+
+//the items parked in the magazines of the other threads are released with the owner, they must not come back after Clear
+TEST(FencedReservoirClearDropsParkedItems)
+{
+	FencedReservoir<FakeItem> reservoir;
+	FakeItem items[2];
+	FakeItem* readyItems[] = { &items[0], &items[1] };
+	reservoir.GiveBack(readyItems, 2);
+
+	ItemMagazine workerMagazine;
+	std::thread worker([&]() {
+		workerMagazine.Attach(reservoir);
+		workerMagazine.Refill(reservoir, [](uint64_t) { return true; });
+		workerMagazine.Retire(reservoir, 1, &items[0]);
+	});
+	worker.join();
+	CHECK_EQ(workerMagazine.m_count, 2u);
+	CHECK_EQ(workerMagazine.m_retiredCount, 1u);
+
+	reservoir.Clear();
+	workerMagazine.Attach(reservoir);
+	CHECK(workerMagazine.IsEmpty());
+	CHECK_EQ(workerMagazine.m_retiredCount, 0u);
+
+	//a magazine never keeps the items of another reservoir
+	FencedReservoir<FakeItem> otherReservoir;
+	workerMagazine.Push(&items[1]);
+	workerMagazine.Attach(otherReservoir);
+	CHECK(workerMagazine.IsEmpty());
+}
@@ -0,0 +1,152 @@
+#include "testharness.h"
+#include "simulatedgpu.h"
+#include "framepacer.h"
+
+namespace
+{
+	const uint32_t kDirectQueue = 0;
+	const uint32_t kComputeQueue = 2;
+
+	//the pacer on the simulated direct and compute queues, the waits are counted by the queues
+	struct SimulatedFrames
+	{
+		SimulatedQueue m_direct;
+		SimulatedQueue m_compute;
+		FramePacer m_pacer;
+
+		SimulatedFrames(uint32_t framesInFlight, uint64_t latency) :
+			m_direct(kDirectQueue, latency), m_compute(kComputeQueue, latency)
+		{
+			m_pacer.Initialize(framesInFlight,
+				[this](uint64_t fenceValue) { return GetQueue(fenceValue).IsFenceComplete(fenceValue); },
+				[this](uint64_t fenceValue) { GetQueue(fenceValue).WaitForFence(fenceValue); });
+		}
+
+		SimulatedQueue& GetQueue(uint64_t fenceValue) {
+			return (fenceValue >> 56) == kComputeQueue ? m_compute : m_direct;
+		}
+
+		//one frame with the given submissions on each queue, return the last direct fence
+		uint64_t RunFrame(uint32_t directSubmissions, uint32_t computeSubmissions) {
+			m_pacer.BeginFrame();
+			uint64_t fenceValue = 0;
+			for (uint32_t i = 0; i < computeSubmissions; ++i)
+				m_pacer.AddFrameFence(m_compute.Signal());
+			for (uint32_t i = 0; i < directSubmissions; ++i) {
+				fenceValue = m_direct.Signal();
+				m_pacer.AddFrameFence(fenceValue);
+			}
+			m_pacer.EndFrame();
+			return fenceValue;
+		}
+	};
+}
+
+//the gpu finishes a frame latency frames after it was submitted
+//the cpu never waits while the gpu is fewer frames behind than the frames in flight, and waits every frame once it is not
+TEST(FramePacerStallsOnlyWhenAhead)
+{
+	const uint32_t kFrameCount = 100;
+	for (uint32_t framesInFlight = 1; framesInFlight <= 4; ++framesInFlight) {
+		for (uint64_t latency = 0; latency <= 5; ++latency) {
+			SimulatedFrames frames(framesInFlight, latency);
+			for (uint32_t frame = 0; frame < kFrameCount; ++frame)
+				frames.RunFrame(1, 0);
+
+			uint64_t expectedStalls = latency >= framesInFlight ? kFrameCount - framesInFlight : 0;
+			CHECK_EQ(frames.m_pacer.GetStallCount(), expectedStalls);
+			//only the begin of a frame waits, never a pass inside it
+			CHECK_EQ(frames.m_direct.GetWaitCount(), expectedStalls);
+			CHECK_EQ(frames.m_pacer.GetFrameIndex(), (uint64_t)kFrameCount);
+		}
+	}
+}
+
+//the frame which reuses a slot starts only after the gpu finished the frame which used it before
+TEST(FramePacerBoundsFramesInFlight)
+{
+	const uint32_t kFrameCount = 64;
+	for (uint32_t framesInFlight = 1; framesInFlight <= FramePacer::kMaxFramesInFlight; ++framesInFlight) {
+		SimulatedFrames frames(framesInFlight, 6);
+		uint64_t frameFences[kFrameCount];
+		for (uint32_t frame = 0; frame < kFrameCount; ++frame) {
+			frames.m_pacer.BeginFrame();
+			if (frame >= framesInFlight)
+				CHECK(frames.m_direct.IsFenceComplete(frameFences[frame - framesInFlight]));
+			CHECK_EQ(frames.m_pacer.GetFrameSlot(), frame % framesInFlight);
+
+			//several passes per frame, only the last fence is kept
+			frames.m_pacer.AddFrameFence(frames.m_direct.Signal());
+			frameFences[frame] = frames.m_direct.Signal();
+			frames.m_pacer.AddFrameFence(frameFences[frame]);
+			CHECK_EQ(frames.m_pacer.GetSlotFence(frames.m_pacer.GetFrameSlot(), kDirectQueue), frameFences[frame]);
+			frames.m_pacer.EndFrame();
+		}
+	}
+}
+
+TEST(FramePacerWaitsForEveryQueue)
+{
+	//the compute queue runs far behind, the direct queue finishes right away
+	SimulatedFrames frames(2, 0);
+	SimulatedQueue slowCompute(kComputeQueue, 10);
+	frames.m_pacer.Initialize(2,
+		[&](uint64_t fenceValue) {
+			return (fenceValue >> 56) == kComputeQueue ? slowCompute.IsFenceComplete(fenceValue) : frames.m_direct.IsFenceComplete(fenceValue);
+		},
+		[&](uint64_t fenceValue) {
+			if ((fenceValue >> 56) == kComputeQueue)
+				slowCompute.WaitForFence(fenceValue);
+			else
+				frames.m_direct.WaitForFence(fenceValue);
+		});
+
+	uint64_t computeFences[8];
+	for (uint32_t frame = 0; frame < 8; ++frame) {
+		frames.m_pacer.BeginFrame();
+		if (frame >= 2)
+			CHECK(slowCompute.IsFenceComplete(computeFences[frame - 2]));
+		//the older compute fences of the frame are covered by the newest one
+		frames.m_pacer.AddFrameFence(frames.m_direct.Signal());
+		slowCompute.Signal();
+		computeFences[frame] = slowCompute.Signal();
+		frames.m_pacer.AddFrameFence(computeFences[frame]);
+		frames.m_pacer.AddFrameFence(computeFences[frame] - 1);
+		CHECK_EQ(frames.m_pacer.GetSlotFence(frames.m_pacer.GetFrameSlot(), kComputeQueue), computeFences[frame]);
+		CHECK_EQ(frames.m_pacer.GetSlotFence(frames.m_pacer.GetFrameSlot(), 1), 0ull);
+		frames.m_pacer.EndFrame();
+	}
+	CHECK_EQ(frames.m_direct.GetWaitCount(), 0ull);
+	CHECK_EQ(slowCompute.GetWaitCount(), 6ull);
+	CHECK_EQ(frames.m_pacer.GetStallCount(), 6ull);
+
+	frames.m_pacer.WaitForAllFrames();
+	CHECK(slowCompute.IsFenceComplete(computeFences[7]));
+	for (uint32_t slot = 0; slot < 2; ++slot) {
+		for (uint32_t queueIndex = 0; queueIndex < FramePacer::kQueueTypeCount; ++queueIndex)
+			CHECK_EQ(frames.m_pacer.GetSlotFence(slot, queueIndex), 0ull);
+	}
+}
+
+//changing the frames in flight drains the slots of the old count first
+TEST(FramePacerReinitializeDrainsFrames)
+{
+	SimulatedFrames frames(3, 8);
+	uint64_t lastFence = 0;
+	for (uint32_t frame = 0; frame < 5; ++frame)
+		lastFence = frames.RunFrame(2, 1);
+	CHECK(!frames.m_direct.IsFenceComplete(lastFence));
+
+	frames.m_pacer.Initialize(2,
+		[&](uint64_t fenceValue) { return frames.GetQueue(fenceValue).IsFenceComplete(fenceValue); },
+		[&](uint64_t fenceValue) { frames.GetQueue(fenceValue).WaitForFence(fenceValue); });
+	CHECK(frames.m_direct.IsFenceComplete(lastFence));
+	CHECK(frames.m_compute.IsFenceComplete(frames.m_compute.GetLastSignaledFence()));
+	CHECK_EQ(frames.m_pacer.GetFramesInFlight(), 2u);
+
+	//the frames go on with the new count, nothing left to wait for
+	uint64_t waitsBefore = frames.m_direct.GetWaitCount();
+	frames.RunFrame(1, 0);
+	frames.RunFrame(1, 0);
+	CHECK_EQ(frames.m_direct.GetWaitCount(), waitsBefore);
+}
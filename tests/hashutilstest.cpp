@@ -0,0 +1,27 @@
+#include "testharness.h"
+#include "hashutils.h"
+
+TEST(HashBytesMatchesFnv1a)
+{
+	//the published 64-bit fnv-1a vectors
+	CHECK_EQ(HashBytes("", 0), 0xcbf29ce484222325ull);
+	CHECK_EQ(HashBytes("a", 1), 0xaf63dc4c8601ec8cull);
+	CHECK_EQ(HashBytes("foobar", 6), 0x85944171f73967e8ull);
+	//the hash can be continued over several buffers
+	CHECK_EQ(HashBytes("bar", 3, HashBytes("foo", 3)), HashBytes("foobar", 6));
+
+	//the integers are hashed as their little-endian bytes
+	const uint8_t valueBytes[] = { 0x78, 0x56, 0x34, 0x12 };
+	CHECK_EQ(HashUint(0x12345678, kFnv1aOffsetBasis), HashBytes(valueBytes, sizeof(valueBytes)));
+}
+
+TEST(HashWordSeesEveryBit)
+{
+	uint64_t baseHash = HashWord(0x1000, HashWord(7));
+	for (uint32_t bit = 0; bit < 64; ++bit) {
+		CHECK(HashWord(0x1000 ^ (1ull << bit), HashWord(7)) != baseHash);
+		CHECK(HashWord(0x1000, HashWord(7 ^ (1ull << bit))) != baseHash);
+	}
+	//the order of the words is part of the hash
+	CHECK(HashWord(7, HashWord(0x1000)) != baseHash);
+}
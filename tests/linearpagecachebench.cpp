@@ -0,0 +1,136 @@
+#include "testharness.h"
+#include "fakepagebackend.h"
+#include "resources/memoryallocator/linearpagecache.h"
+#include <thread>
+
+namespace
+{
+	const uint32_t kBenchSlot = 3;
+	const size_t kPageSize = 0x10000;
+	const size_t kAllocationSize = 256;
+	//the allocations recorded into one command list before it is submitted
+	const uint32_t kAllocationsPerSubmit = 2048;
+
+	//a page rollover under one global mutex, the shape before the thread magazines
+	class MutexPagePool
+	{
+	public:
+		explicit MutexPagePool(FakePageBackend& backend) : m_backend(backend) {}
+
+		FakePage* Request() {
+			std::lock_guard<std::mutex> lockGuard(m_mutex);
+			m_retiredPages.Retire([this](uint64_t fenceValue) { return m_backend.IsFenceComplete(fenceValue); },
+				[this](FakePage* page) { m_readyPages.push_back(page); });
+			if (m_readyPages.empty())
+				return m_backend.CreatePage();
+			FakePage* page = m_readyPages.back();
+			m_readyPages.pop_back();
+			return page;
+		}
+
+		void Retire(uint64_t fenceValue, FakePage* page) { m_retiredPages.Push(fenceValue, page); }
+
+	private:
+		FakePageBackend& m_backend;
+		std::mutex m_mutex;
+		DeferredReleaseQueue<FakePage> m_retiredPages;
+		std::vector<FakePage*> m_readyPages;
+	};
+
+	//each thread bumps 256 bytes at a time through its current page, and retires the used pages on submit
+	//the main thread trims the cache like the end of a frame
+	template<typename RequestFunc, typename RetireFunc, typename TrimFunc>
+	double RunContention(uint32_t threadCount, uint64_t allocationsPerThread, FakePageBackend& backend,
+		RequestFunc request, RetireFunc retire, TrimFunc trim)
+	{
+		std::atomic<uint32_t> runningCount{ threadCount };
+		GLIMMER_TEST::Stopwatch stopwatch;
+
+		std::vector<std::thread> workers;
+		for (uint32_t t = 0; t < threadCount; ++t) {
+			workers.emplace_back([&]() {
+				std::vector<FakePage*> usedPages;
+				FakePage* currentPage = nullptr;
+				size_t offset = kPageSize;
+				for (uint64_t i = 0; i < allocationsPerThread; ++i) {
+					if (offset + kAllocationSize > kPageSize) {
+						if (currentPage != nullptr)
+							usedPages.push_back(currentPage);
+						currentPage = request();
+						offset = 0;
+					}
+					offset += kAllocationSize;
+
+					if ((i + 1) % kAllocationsPerSubmit == 0) {
+						usedPages.push_back(currentPage);
+						uint64_t fenceValue = backend.Signal();
+						for (FakePage* page : usedPages)
+							retire(fenceValue, page);
+						usedPages.clear();
+						currentPage = nullptr;
+						offset = kPageSize;
+					}
+				}
+				if (currentPage != nullptr)
+					usedPages.push_back(currentPage);
+				uint64_t fenceValue = backend.Signal();
+				for (FakePage* page : usedPages)
+					retire(fenceValue, page);
+				runningCount--;
+			});
+		}
+
+		uint64_t frameIndex = 0;
+		while (runningCount > 0) {
+			trim(++frameIndex);
+			std::this_thread::sleep_for(std::chrono::microseconds(500));
+		}
+		for (std::thread& worker : workers)
+			worker.join();
+		return stopwatch.GetSeconds();
+	}
+}
+
+//N threads allocating 256 bytes against the fake page backend
+//the page cache rolls over through the thread magazines, the baseline takes one mutex per rollover
+BENCHMARK(LinearPageCacheContention)
+{
+	const uint64_t allocationsPerThread = bench.Iterations(4000000);
+	const uint32_t kThreadCounts[] = { 1, 2, 4, 8 };
+
+	for (uint32_t threadCount : kThreadCounts) {
+		char label[64];
+		uint64_t operations = allocationsPerThread * threadCount;
+
+		{
+			FakePageBackend backend(kPageSize, 4);
+			LinearPageCache<FakePage> cache(kBenchSlot);
+			auto isFenceComplete = [&](uint64_t fenceValue) { return backend.IsFenceComplete(fenceValue); };
+			double seconds = RunContention(threadCount, allocationsPerThread, backend,
+				[&]() {
+					FakePage* page = cache.Request(isFenceComplete, [&]() { return backend.CreatePage(); });
+					CHECK(!page->m_released);
+					return page;
+				},
+				[&](uint64_t fenceValue, FakePage* page) { cache.Retire(fenceValue, page); },
+				[&](uint64_t frameIndex) {
+					cache.Trim(isFenceComplete, frameIndex, 16, 300, [&](FakePage* page) { backend.ReleasePage(page); });
+				});
+			snprintf(label, sizeof(label), "page cache, %u threads", threadCount);
+			bench.Report(label, operations, seconds);
+			printf("  %-48s %llu pages created, %llu us lock wait\n", "", (unsigned long long)backend.GetCreatedCount(),
+				(unsigned long long)cache.GetCounters().m_lockWaitMicroseconds.load());
+		}
+
+		{
+			FakePageBackend backend(kPageSize, 4);
+			MutexPagePool pool(backend);
+			double seconds = RunContention(threadCount, allocationsPerThread, backend,
+				[&]() { return pool.Request(); },
+				[&](uint64_t fenceValue, FakePage* page) { pool.Retire(fenceValue, page); },
+				[](uint64_t) {});
+			snprintf(label, sizeof(label), "mutex pool, %u threads", threadCount);
+			bench.Report(label, operations, seconds);
+		}
+	}
+}
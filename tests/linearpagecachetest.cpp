@@ -0,0 +1,151 @@
+#include "testharness.h"
+#include "fakepagebackend.h"
+#include "resources/memoryallocator/linearpagecache.h"
+#include <random>
+#include <thread>
+
+namespace
+{
+	//the engine page managers use the slots 0 and 1
+	const uint32_t kTestSlot = 3;
+	const size_t kPageSize = 0x10000;
+}
+
+TEST(LinearPageCacheReusesCompletedPages)
+{
+	FakePageBackend backend(kPageSize, 1);
+	LinearPageCache<FakePage> cache(kTestSlot);
+	auto isFenceComplete = [&](uint64_t fenceValue) { return backend.IsFenceComplete(fenceValue); };
+	auto createPage = [&]() { return backend.CreatePage(); };
+
+	FakePage* firstPage = cache.Request(isFenceComplete, createPage);
+	uint64_t fenceValue = backend.Signal();
+	cache.Retire(fenceValue, firstPage);
+	CHECK_EQ(cache.GetCounters().m_inFlightBytes.load(), kPageSize);
+
+	//the fence is not completed, so a new page is created
+	FakePage* secondPage = cache.Request(isFenceComplete, createPage);
+	CHECK(secondPage != firstPage);
+	CHECK_EQ(backend.GetCreatedCount(), 2u);
+
+	backend.Signal();
+	CHECK(backend.IsFenceComplete(fenceValue));
+	CHECK(cache.Request(isFenceComplete, createPage) == firstPage);
+	CHECK_EQ(backend.GetCreatedCount(), 2u);
+	CHECK_EQ(cache.GetCounters().m_inFlightBytes.load(), 0u);
+	CHECK_EQ(cache.GetCounters().m_pagesReused.load(), 1u);
+}
+
+//the pages parked in the magazines are released with the owner, they must not come back after Clear
+TEST(LinearPageCacheClearDropsParkedPages)
+{
+	FakePageBackend backend(kPageSize, 0);
+	LinearPageCache<FakePage> cache(kTestSlot);
+	auto isFenceComplete = [&](uint64_t fenceValue) { return backend.IsFenceComplete(fenceValue); };
+	auto createPage = [&]() { return backend.CreatePage(); };
+
+	//another thread parks a full magazine
+	std::thread worker([&]() {
+		FakePage* pages[LinearPageCache<FakePage>::kMagazineSize + 1];
+		for (FakePage*& page : pages)
+			page = cache.Request(isFenceComplete, createPage);
+		uint64_t fenceValue = backend.Signal();
+		for (FakePage* page : pages)
+			cache.Retire(fenceValue, page);
+		cache.Request(isFenceComplete, createPage);
+
+		//the main thread clears the cache before this thread exits
+		cache.Clear();
+	});
+	worker.join();
+
+	//the calling thread and the exited thread gave nothing back
+	uint64_t createdCount = backend.GetCreatedCount();
+	cache.Request(isFenceComplete, createPage);
+	CHECK_EQ(backend.GetCreatedCount(), createdCount + 1);
+	CHECK_EQ(cache.GetRetiredCount(), 0u);
+}
+
+TEST(LinearPageCacheTrimKeepsRecentPages)
+{
+	FakePageBackend backend(kPageSize, 0);
+	LinearPageCache<FakePage> cache(kTestSlot);
+	auto isFenceComplete = [&](uint64_t fenceValue) { return backend.IsFenceComplete(fenceValue); };
+	auto createPage = [&]() { return backend.CreatePage(); };
+	auto releasePage = [&](FakePage* page) { backend.ReleasePage(page); };
+
+	//retire 8 pages, the first half is used at frame 0 and the others at frame 10
+	std::vector<FakePage*> pages;
+	for (uint32_t i = 0; i < 8; ++i)
+		pages.push_back(cache.Request(isFenceComplete, createPage));
+	uint64_t fenceValue = backend.Signal();
+	for (uint32_t i = 0; i < 8; ++i) {
+		pages[i]->m_lastUsedFrame = i < 4 ? 0 : 10;
+		cache.Retire(fenceValue, pages[i]);
+	}
+
+	//at frame 20 the pages idle for more than 15 frames and the pages above 3 are released
+	cache.Trim(isFenceComplete, 20, 3, 15, releasePage);
+	CHECK_EQ(backend.GetReleasedCount(), 5u);
+	for (uint32_t i = 0; i < 4; ++i)
+		CHECK(pages[i]->m_released);
+
+	uint32_t keptCount = 0;
+	for (uint32_t i = 0; i < 8; ++i) {
+		FakePage* page = cache.Request(isFenceComplete, createPage);
+		CHECK(!page->m_released);
+		if (page->m_lastUsedFrame == 10)
+			keptCount++;
+	}
+	CHECK_EQ(keptCount, 3u);
+}
+
+//the workers roll pages over while the main thread trims the ready stack
+//the trimmed pages must never be handed out again
+TEST(LinearPageCacheConcurrentTrim)
+{
+	const uint32_t kThreadCount = 4;
+	const uint32_t kRolloversPerThread = 20000;
+
+	FakePageBackend backend(kPageSize, 2);
+	LinearPageCache<FakePage> cache(kTestSlot);
+	auto isFenceComplete = [&](uint64_t fenceValue) { return backend.IsFenceComplete(fenceValue); };
+	auto createPage = [&]() { return backend.CreatePage(); };
+	std::atomic<uint32_t> runningCount{ kThreadCount };
+
+	std::vector<std::thread> workers;
+	for (uint32_t t = 0; t < kThreadCount; ++t) {
+		workers.emplace_back([&, t]() {
+			std::mt19937 random(t);
+			std::vector<FakePage*> usedPages;
+			for (uint32_t i = 0; i < kRolloversPerThread; ++i) {
+				FakePage* page = cache.Request(isFenceComplete, createPage);
+				CHECK(!page->m_released);
+				usedPages.push_back(page);
+				//submit after a few rollovers, like a command list
+				if (random() % 4 == 0) {
+					uint64_t fenceValue = backend.Signal();
+					for (FakePage* usedPage : usedPages)
+						cache.Retire(fenceValue, usedPage);
+					usedPages.clear();
+				}
+			}
+			uint64_t fenceValue = backend.Signal();
+			for (FakePage* usedPage : usedPages)
+				cache.Retire(fenceValue, usedPage);
+			runningCount--;
+		});
+	}
+
+	uint64_t frameIndex = 0;
+	while (runningCount > 0) {
+		cache.Trim(isFenceComplete, ++frameIndex, 2, 0xFFFFFFFF, [&](FakePage* page) { backend.ReleasePage(page); });
+		std::this_thread::yield();
+	}
+	for (std::thread& worker : workers)
+		worker.join();
+
+	CHECK(backend.GetReleasedCount() > 0);
+	printf("  %llu pages created, %llu released\n",
+		(unsigned long long)backend.GetCreatedCount(), (unsigned long long)backend.GetReleasedCount());
+}
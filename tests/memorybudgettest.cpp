@@ -0,0 +1,192 @@
+#include "testharness.h"
+#include "memorybudget.h"
+#include <thread>
+#include <vector>
+
+namespace
+{
+	//Fake Resource Factory
+	//stands in for the resource-creating paths, reports the committed memory like GpuResource::TrackCommittedMemory
+	//the pressure callback releases the oldest resources, like a cache trimming itself
+	class FakeResourceFactory
+	{
+	public:
+		FakeResourceFactory(MemoryBudgetManager& budget, MemoryCategory category) :
+			m_budget(budget), m_category(category), m_callbackId(0), m_pressureCount(0) {}
+
+		~FakeResourceFactory() {
+			if (m_callbackId != 0)
+				m_budget.UnregisterPressureCallback(m_callbackId);
+			while (!m_resources.empty())
+				ReleaseOldest();
+		}
+
+		//return false when the budget rejects the resource, like a failed creation
+		bool Create(uint64_t size) {
+			if (!m_budget.CanAllocate(m_category, size))
+				return false;
+			m_budget.ReportAllocation(m_category, size);
+			m_resources.push_back(size);
+			return true;
+		}
+
+		void ReleaseOldest() {
+			m_budget.ReportRelease(m_category, m_resources.front());
+			m_resources.erase(m_resources.begin());
+		}
+
+		void RegisterTrimming() {
+			m_callbackId = m_budget.RegisterPressureCallback(m_category, [this](const MemoryPressureEvent& pressureEvent) {
+				m_pressureCount++;
+				uint64_t releasedSize = 0;
+				while (releasedSize < pressureEvent.m_bytesOverThreshold && !m_resources.empty()) {
+					releasedSize += m_resources.front();
+					ReleaseOldest();
+				}
+			});
+		}
+
+		size_t GetResourceCount() const { return m_resources.size(); }
+		uint32_t GetPressureCount() const { return m_pressureCount; }
+
+	private:
+		MemoryBudgetManager& m_budget;
+		MemoryCategory m_category;
+		std::vector<uint64_t> m_resources;
+		uint32_t m_callbackId;
+		uint32_t m_pressureCount;
+	};
+}
+
+TEST(MemoryBudgetCategoryAccounting)
+{
+	MemoryBudgetManager budget;
+	FakeResourceFactory textures(budget, MEMORY_CATEGORY_TEXTURE);
+	FakeResourceFactory buffers(budget, MEMORY_CATEGORY_BUFFER);
+
+	CHECK(textures.Create(1000));
+	CHECK(textures.Create(3000));
+	CHECK(buffers.Create(500));
+	textures.ReleaseOldest();
+
+	MemoryBudgetReport report = budget.GetReport();
+	CHECK_EQ(report.m_usage[MEMORY_CATEGORY_TEXTURE], 3000u);
+	CHECK_EQ(report.m_peakUsage[MEMORY_CATEGORY_TEXTURE], 4000u);
+	CHECK_EQ(report.m_usage[MEMORY_CATEGORY_BUFFER], 500u);
+	CHECK_EQ(report.m_usage[MEMORY_CATEGORY_UPLOAD], 0u);
+	CHECK_EQ(report.m_totalUsage, 3500u);
+	CHECK_EQ(report.m_budget[MEMORY_CATEGORY_TEXTURE], MemoryBudgetManager::kUnlimitedBudget);
+
+	textures.ReleaseOldest();
+	buffers.ReleaseOldest();
+	CHECK_EQ(budget.GetTotalUsage(), 0u);
+	budget.Reset();
+	CHECK_EQ(budget.GetReport().m_peakUsage[MEMORY_CATEGORY_TEXTURE], 0u);
+}
+
+TEST(MemoryBudgetRejectsOverBudget)
+{
+	MemoryBudgetManager budget;
+	budget.SetCategoryBudget(MEMORY_CATEGORY_TEXTURE, 4096);
+	budget.SetTotalBudget(6144);
+	FakeResourceFactory textures(budget, MEMORY_CATEGORY_TEXTURE);
+	FakeResourceFactory buffers(budget, MEMORY_CATEGORY_BUFFER);
+
+	CHECK(textures.Create(4096));
+	CHECK(!textures.Create(1));
+	//the buffers have no category budget, but share the total budget
+	CHECK(buffers.Create(2048));
+	CHECK(!buffers.Create(1));
+
+	textures.ReleaseOldest();
+	CHECK(buffers.Create(1024));
+	CHECK(textures.Create(3072));
+	CHECK(!textures.Create(1));
+}
+
+TEST(MemoryBudgetPressureTrimsCategory)
+{
+	MemoryBudgetManager budget;
+	budget.SetCategoryBudget(MEMORY_CATEGORY_UPLOAD, 10000);
+	budget.SetPressureThreshold(0.5f);
+	FakeResourceFactory uploads(budget, MEMORY_CATEGORY_UPLOAD);
+	FakeResourceFactory textures(budget, MEMORY_CATEGORY_TEXTURE);
+	uploads.RegisterTrimming();
+	textures.RegisterTrimming();
+
+	for (uint32_t i = 0; i < 4; ++i)
+		CHECK(uploads.Create(1000));
+	CHECK(textures.Create(100000));
+	//at the threshold is not under pressure
+	CHECK(uploads.Create(1000));
+	CHECK_EQ(budget.DispatchPressureCallbacks(), 0u);
+
+	//1000 bytes over the threshold, only the upload callback runs
+	CHECK(uploads.Create(1000));
+	CHECK_EQ(budget.DispatchPressureCallbacks(), 1u);
+	CHECK_EQ(uploads.GetPressureCount(), 1u);
+	CHECK_EQ(textures.GetPressureCount(), 0u);
+	CHECK_EQ(uploads.GetResourceCount(), 5u);
+	CHECK_EQ(budget.GetUsage(MEMORY_CATEGORY_UPLOAD), 5000u);
+	CHECK_EQ(budget.DispatchPressureCallbacks(), 0u);
+	CHECK_EQ(budget.GetReport().m_pressureEvents, 1u);
+}
+
+TEST(MemoryBudgetTotalPressureReachesAllCallbacks)
+{
+	MemoryBudgetManager budget;
+	budget.SetTotalBudget(8000);
+	FakeResourceFactory uploads(budget, MEMORY_CATEGORY_UPLOAD);
+	FakeResourceFactory textures(budget, MEMORY_CATEGORY_TEXTURE);
+	uploads.RegisterTrimming();
+	textures.RegisterTrimming();
+
+	CHECK(uploads.Create(4000));
+	CHECK(textures.Create(4000));
+	//7200 is the threshold, both caches see the total event and trim 800 bytes each
+	CHECK_EQ(budget.DispatchPressureCallbacks(), 1u);
+	CHECK_EQ(uploads.GetPressureCount(), 1u);
+	CHECK_EQ(textures.GetPressureCount(), 1u);
+	CHECK_EQ(budget.GetTotalUsage(), 0u);
+
+	//an unregistered callback is not invoked, the event is still counted
+	{
+		FakeResourceFactory buffers(budget, MEMORY_CATEGORY_BUFFER);
+		buffers.RegisterTrimming();
+	}
+	FakeResourceFactory buffers(budget, MEMORY_CATEGORY_BUFFER);
+	CHECK(buffers.Create(7500));
+	CHECK_EQ(budget.DispatchPressureCallbacks(), 1u);
+	CHECK_EQ(buffers.GetResourceCount(), 1u);
+	CHECK_EQ(budget.GetReport().m_pressureEvents, 2u);
+}
+
+//the resource-creating paths report from the loading threads
+TEST(MemoryBudgetConcurrentReports)
+{
+	const uint32_t kThreadCount = 4;
+	const uint32_t kResourceCount = 20000;
+
+	MemoryBudgetManager budget;
+	std::vector<std::thread> workers;
+	for (uint32_t t = 0; t < kThreadCount; ++t) {
+		workers.emplace_back([&budget, t]() {
+			MemoryCategory category = (MemoryCategory)(t % MEMORY_CATEGORY_COUNT);
+			for (uint32_t i = 0; i < kResourceCount; ++i) {
+				budget.ReportAllocation(category, 256);
+				budget.ReportAllocation(category, 4096);
+				budget.ReportRelease(category, 256);
+				budget.ReportRelease(category, 4096);
+			}
+		});
+	}
+	for (std::thread& worker : workers)
+		worker.join();
+
+	MemoryBudgetReport report = budget.GetReport();
+	CHECK_EQ(report.m_totalUsage, 0u);
+	for (uint32_t i = 0; i < kThreadCount; ++i) {
+		CHECK_EQ(report.m_usage[i], 0u);
+		CHECK(report.m_peakUsage[i] >= 4352u);
+	}
+}
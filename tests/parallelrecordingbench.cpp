@@ -0,0 +1,109 @@
+#include "testharness.h"
+#include "recordingdevice.h"
+#include "taskpool.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const uint32_t kDrawCount = 8192;
+	//like ParallelGraphicsRecorder::kMinDrawsPerChunk
+	const uint32_t kMinDrawsPerChunk = 64;
+	const UINT kTexturesRootIndex = 2;
+	const UINT kSamplersRootIndex = 3;
+
+	struct DrawItem
+	{
+		D3D12_VERTEX_BUFFER_VIEW m_vertexView;
+		D3D12_INDEX_BUFFER_VIEW m_indexView;
+		UINT m_indexCount;
+		D3D12_GPU_DESCRIPTOR_HANDLE m_textureTable;
+		D3D12_GPU_DESCRIPTOR_HANDLE m_samplerTable;
+	};
+
+	std::vector<DrawItem> MakeDraws()
+	{
+		std::vector<DrawItem> draws(kDrawCount);
+		for (uint32_t i = 0; i < kDrawCount; ++i) {
+			DrawItem& draw = draws[i];
+			draw.m_vertexView = { 0x10000000ull + i * 0x10000ull, 0x8000, 32 };
+			draw.m_indexView = { 0x80000000ull + i * 0x4000ull, 0x3000, DXGI_FORMAT_R32_UINT };
+			draw.m_indexCount = 0x3000 / 4;
+			draw.m_textureTable.ptr = 0x1000000 + (i % 97) * 5 * 32;
+			draw.m_samplerTable.ptr = 0x2000000 + (i % 5) * 32;
+		}
+		return draws;
+	}
+
+	//the draw loop of the scene pass, the same calls per draw
+	void RecordDraws(ID3D12GraphicsCommandList& commandList, const std::vector<DrawItem>& draws, uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i) {
+			const DrawItem& draw = draws[i];
+			commandList.SetGraphicsRootDescriptorTable(kTexturesRootIndex, draw.m_textureTable);
+			commandList.SetGraphicsRootDescriptorTable(kSamplersRootIndex, draw.m_samplerTable);
+			commandList.IASetVertexBuffers(0, 1, &draw.m_vertexView);
+			commandList.IASetIndexBuffer(&draw.m_indexView);
+			commandList.DrawIndexedInstanced(draw.m_indexCount, 1, 0, 0, 0);
+		}
+	}
+
+	//record the pass like the parallel recorder: one pooled list per chunk, the chunks on the task pool
+	void RecordPass(TaskPool& pool, std::vector<RecordingCommandList>& commandLists, const std::vector<DrawItem>& draws)
+	{
+		uint32_t chunkCount = TaskPool::GetChunkCount(kDrawCount, kMinDrawsPerChunk, pool.GetWorkerCount());
+		pool.ParallelFor(chunkCount, [&](uint32_t chunkIndex) {
+			uint32_t begin, end;
+			TaskPool::GetChunkRange(kDrawCount, chunkCount, chunkIndex, begin, end);
+			RecordingCommandList& commandList = commandLists[chunkIndex];
+			commandList.Reset();
+			RecordDraws(commandList, draws, begin, end);
+		});
+	}
+}
+
+//the draw recording of one pass split over the task pool, against command lists which write a fake command stream
+//the lists in chunk order must hold the same stream as the serial recording
+BENCHMARK(ParallelRecordingScaling)
+{
+	const uint64_t frameCount = bench.Iterations(500);
+	const std::vector<DrawItem> draws = MakeDraws();
+
+	RecordingCommandList serialList;
+	RecordDraws(serialList, draws, 0, kDrawCount);
+
+	//the caller thread records too, so the thread count is the worker count plus one
+	uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 4u);
+	double serialSeconds = 0.0;
+	for (uint32_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+		TaskPool pool;
+		pool.Initialize(threadCount - 1);
+		std::vector<RecordingCommandList> commandLists(threadCount);
+
+		//the first pass grows the command streams, like the allocators of the first frames
+		RecordPass(pool, commandLists, draws);
+
+		GLIMMER_TEST::Stopwatch stopwatch;
+		for (uint64_t frame = 0; frame < frameCount; ++frame)
+			RecordPass(pool, commandLists, draws);
+		double seconds = stopwatch.GetSeconds();
+		if (threadCount == 1)
+			serialSeconds = seconds;
+
+		char label[64];
+		snprintf(label, sizeof(label), "record %u draws on %u threads", kDrawCount, threadCount);
+		bench.Report(label, frameCount * kDrawCount, seconds);
+		printf("  %-48s %.2fx of one thread\n", "", seconds > 0.0 ? serialSeconds / seconds : 0.0);
+
+		std::vector<uint64_t> commands;
+		uint64_t drawCalls = 0;
+		uint32_t chunkCount = TaskPool::GetChunkCount(kDrawCount, kMinDrawsPerChunk, pool.GetWorkerCount());
+		for (uint32_t i = 0; i < chunkCount; ++i) {
+			commands.insert(commands.end(), commandLists[i].GetCommands().begin(), commandLists[i].GetCommands().end());
+			drawCalls += commandLists[i].GetDrawCalls();
+		}
+		CHECK_EQ(drawCalls, (uint64_t)kDrawCount);
+		CHECK(commands == serialList.GetCommands());
+	}
+}
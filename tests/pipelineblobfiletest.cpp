@@ -0,0 +1,129 @@
+#include "testharness.h"
+#include "pipelineblobfile.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace
+{
+	//the magic, the version, the size and the hash of the data
+	static const size_t kHeaderSize = 24;
+	static const size_t kVersionOffset = 4;
+	static const size_t kSizeOffset = 8;
+
+	//the blob is written next to the test binary and removed at the end of each test
+	struct ScopedBlobPath
+	{
+		std::string m_path;
+
+		explicit ScopedBlobPath(const char* name) : m_path(std::string("glimmer_") + name + ".bin") {}
+		~ScopedBlobPath() {
+			std::remove(m_path.c_str());
+			std::remove((m_path + ".tmp").c_str());
+		}
+	};
+
+	std::vector<uint8_t> MakeBlob(size_t size)
+	{
+		std::vector<uint8_t> blob(size);
+		for (size_t i = 0; i < size; ++i)
+			blob[i] = (uint8_t)(i * 31 + 7);
+		return blob;
+	}
+
+	std::vector<uint8_t> ReadFileBytes(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	void WriteFileBytes(const std::string& path, const std::vector<uint8_t>& bytes)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+	}
+}
+
+TEST(PipelineBlobFileRoundTrip)
+{
+	ScopedBlobPath path("blobroundtrip");
+	std::vector<uint8_t> blob = MakeBlob(4096);
+	CHECK(PipelineBlobFile::Save(path.m_path, blob.data(), blob.size()));
+	CHECK_EQ(ReadFileBytes(path.m_path).size(), kHeaderSize + blob.size());
+	//the temporary file is renamed over the path
+	CHECK(!std::ifstream(path.m_path + ".tmp").good());
+
+	std::vector<uint8_t> loaded;
+	CHECK(PipelineBlobFile::Load(path.m_path, loaded));
+	CHECK(loaded == blob);
+
+	//a second save replaces the first blob
+	std::vector<uint8_t> smallerBlob = MakeBlob(100);
+	CHECK(PipelineBlobFile::Save(path.m_path, smallerBlob.data(), smallerBlob.size()));
+	CHECK(PipelineBlobFile::Load(path.m_path, loaded));
+	CHECK(loaded == smallerBlob);
+}
+
+TEST(PipelineBlobFileRejectsMissingFile)
+{
+	std::vector<uint8_t> loaded(8, 1);
+	CHECK(!PipelineBlobFile::Load("glimmer_missing_pipeline_blob.bin", loaded));
+	CHECK(loaded.empty());
+}
+
+//the driver must never see a partially written library, every truncation point is rejected
+TEST(PipelineBlobFileRejectsTruncatedFile)
+{
+	ScopedBlobPath path("blobtruncated");
+	std::vector<uint8_t> blob = MakeBlob(256);
+	CHECK(PipelineBlobFile::Save(path.m_path, blob.data(), blob.size()));
+	std::vector<uint8_t> bytes = ReadFileBytes(path.m_path);
+	CHECK_EQ(bytes.size(), kHeaderSize + blob.size());
+
+	size_t truncatedSizes[] = { 0, 3, kHeaderSize - 1, kHeaderSize, kHeaderSize + 1, kHeaderSize + blob.size() / 2, bytes.size() - 1 };
+	for (size_t truncatedSize : truncatedSizes) {
+		WriteFileBytes(path.m_path, std::vector<uint8_t>(bytes.begin(), bytes.begin() + truncatedSize));
+		std::vector<uint8_t> loaded;
+		CHECK(!PipelineBlobFile::Load(path.m_path, loaded));
+		CHECK(loaded.empty());
+	}
+}
+
+TEST(PipelineBlobFileRejectsCorruptFile)
+{
+	ScopedBlobPath path("blobcorrupt");
+	std::vector<uint8_t> blob = MakeBlob(256);
+	CHECK(PipelineBlobFile::Save(path.m_path, blob.data(), blob.size()));
+	const std::vector<uint8_t> bytes = ReadFileBytes(path.m_path);
+
+	//the magic, the version, the hash and the first, middle and last data bytes
+	size_t corruptOffsets[] = { 0, kVersionOffset, 16, 23, kHeaderSize, kHeaderSize + 128, bytes.size() - 1 };
+	for (size_t offset : corruptOffsets) {
+		std::vector<uint8_t> corrupt = bytes;
+		corrupt[offset] ^= 0x01;
+		WriteFileBytes(path.m_path, corrupt);
+		std::vector<uint8_t> loaded;
+		CHECK(!PipelineBlobFile::Load(path.m_path, loaded));
+		CHECK(loaded.empty());
+	}
+
+	//a size larger than the data is a truncated file, a smaller one fails the hash
+	uint64_t sizes[] = { 0, blob.size() - 1, blob.size() + 1 };
+	for (uint64_t size : sizes) {
+		std::vector<uint8_t> corrupt = bytes;
+		for (size_t i = 0; i < sizeof(uint64_t); ++i)
+			corrupt[kSizeOffset + i] = (uint8_t)(size >> (i * 8));
+		WriteFileBytes(path.m_path, corrupt);
+		std::vector<uint8_t> loaded;
+		CHECK(!PipelineBlobFile::Load(path.m_path, loaded));
+		CHECK(loaded.empty());
+	}
+
+	//the untouched bytes still load
+	WriteFileBytes(path.m_path, bytes);
+	std::vector<uint8_t> loaded;
+	CHECK(PipelineBlobFile::Load(path.m_path, loaded));
+	CHECK(loaded == blob);
+}
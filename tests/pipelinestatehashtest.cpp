@@ -0,0 +1,257 @@
+#include "testharness.h"
+#include "pipelinestatehash.h"
+#include "hashutils.h"
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	static const uint64_t kRootSignatureHash = 0x9054142681524460ull;
+
+	//a pbr-like pipeline, every builder owns its shaders and semantic names in new memory
+	//the desc is filled with the given byte first, so the padding and the unused fields differ between builders
+	struct GraphicsPipelineDescBuilder
+	{
+		std::vector<uint8_t> m_vertexShader;
+		std::vector<uint8_t> m_pixelShader;
+		std::string m_positionName;
+		std::string m_texcoordName;
+		std::vector<D3D12_INPUT_ELEMENT_DESC> m_inputElements;
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC m_desc;
+
+		explicit GraphicsPipelineDescBuilder(uint8_t fill) :
+			m_vertexShader(64), m_pixelShader(96), m_positionName("POSITION"), m_texcoordName("TEXCOORD"), m_inputElements(2)
+		{
+			for (size_t i = 0; i < m_vertexShader.size(); ++i)
+				m_vertexShader[i] = (uint8_t)(i * 7 + 1);
+			for (size_t i = 0; i < m_pixelShader.size(); ++i)
+				m_pixelShader[i] = (uint8_t)(i * 13 + 5);
+
+			memset(m_inputElements.data(), fill, sizeof(D3D12_INPUT_ELEMENT_DESC) * m_inputElements.size());
+			m_inputElements[0] = { m_positionName.c_str(), 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+			m_inputElements[1] = { m_texcoordName.c_str(), 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+
+			memset(&m_desc, fill, sizeof(m_desc));
+			//the root signature object and the cached blob are not part of the key
+			m_desc.pRootSignature = nullptr;
+			m_desc.VS = { m_vertexShader.data(), m_vertexShader.size() };
+			m_desc.PS = { m_pixelShader.data(), m_pixelShader.size() };
+			m_desc.DS = { nullptr, 0 };
+			m_desc.HS = { nullptr, 0 };
+			m_desc.GS = { nullptr, 0 };
+			m_desc.StreamOutput.pSODeclaration = nullptr;
+			m_desc.StreamOutput.NumEntries = 0;
+			m_desc.StreamOutput.pBufferStrides = nullptr;
+			m_desc.StreamOutput.NumStrides = 0;
+			m_desc.StreamOutput.RasterizedStream = 0;
+
+			//only the first render target blend is used without independent blend
+			D3D12_BLEND_DESC& blendState = m_desc.BlendState;
+			blendState.AlphaToCoverageEnable = 0;
+			blendState.IndependentBlendEnable = 0;
+			D3D12_RENDER_TARGET_BLEND_DESC& blendTarget = blendState.RenderTarget[0];
+			blendTarget.BlendEnable = 1;
+			blendTarget.LogicOpEnable = 0;
+			blendTarget.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+			blendTarget.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+			blendTarget.BlendOp = D3D12_BLEND_OP_ADD;
+			blendTarget.SrcBlendAlpha = D3D12_BLEND_ONE;
+			blendTarget.DestBlendAlpha = D3D12_BLEND_ZERO;
+			blendTarget.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+			blendTarget.LogicOp = D3D12_LOGIC_OP_NOOP;
+			blendTarget.RenderTargetWriteMask = 0xF;
+			m_desc.SampleMask = 0xFFFFFFFF;
+
+			D3D12_RASTERIZER_DESC& rasterizerState = m_desc.RasterizerState;
+			rasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+			rasterizerState.CullMode = D3D12_CULL_MODE_BACK;
+			rasterizerState.FrontCounterClockwise = 0;
+			rasterizerState.DepthBias = 0;
+			rasterizerState.DepthBiasClamp = 0.0f;
+			rasterizerState.SlopeScaledDepthBias = 0.0f;
+			rasterizerState.DepthClipEnable = 1;
+			rasterizerState.MultisampleEnable = 0;
+			rasterizerState.AntialiasedLineEnable = 0;
+			rasterizerState.ForcedSampleCount = 0;
+			rasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+
+			D3D12_DEPTH_STENCIL_DESC& depthStencilState = m_desc.DepthStencilState;
+			depthStencilState.DepthEnable = 1;
+			depthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+			depthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+			depthStencilState.StencilEnable = 0;
+			depthStencilState.StencilReadMask = 0xFF;
+			depthStencilState.StencilWriteMask = 0xFF;
+			depthStencilState.FrontFace = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+			depthStencilState.BackFace = depthStencilState.FrontFace;
+
+			m_desc.InputLayout.pInputElementDescs = m_inputElements.data();
+			m_desc.InputLayout.NumElements = (UINT)m_inputElements.size();
+			m_desc.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
+			m_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+			m_desc.NumRenderTargets = 2;
+			m_desc.RTVFormats[0] = DXGI_FORMAT_R16G16B16A16_FLOAT;
+			m_desc.RTVFormats[1] = DXGI_FORMAT_R8G8B8A8_UNORM;
+			m_desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+			m_desc.SampleDesc = { 1, 0 };
+			m_desc.NodeMask = 0;
+			m_desc.CachedPSO = { nullptr, 0 };
+			m_desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+		}
+
+		GraphicsPipelineDescBuilder(const GraphicsPipelineDescBuilder&) = delete;
+		GraphicsPipelineDescBuilder& operator=(const GraphicsPipelineDescBuilder&) = delete;
+
+		uint64_t Hash() const { return HashGraphicsPipelineDesc(m_desc, kRootSignatureHash); }
+	};
+
+	//the hash of the pipeline after one change
+	template<typename ModifyFunc>
+	uint64_t HashModified(ModifyFunc modify)
+	{
+		GraphicsPipelineDescBuilder builder(0);
+		modify(builder);
+		return builder.Hash();
+	}
+}
+
+//the descs built in different memory, with different bytes in the padding and in the unused fields, share one hash
+TEST(PipelineStateHashIgnoresPaddingAndPointers)
+{
+	GraphicsPipelineDescBuilder first(0x00);
+	GraphicsPipelineDescBuilder second(0xCD);
+	GraphicsPipelineDescBuilder third(0x5A);
+	CHECK(first.m_desc.VS.pShaderBytecode != second.m_desc.VS.pShaderBytecode);
+	CHECK(first.m_inputElements[0].SemanticName != second.m_inputElements[0].SemanticName);
+	CHECK(memcmp(&first.m_desc, &second.m_desc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC)) != 0);
+	CHECK_EQ(second.Hash(), first.Hash());
+	CHECK_EQ(third.Hash(), first.Hash());
+
+	//the cached blob and the root signature object are not part of the key
+	static const uint8_t cachedBlob[16] = {};
+	third.m_desc.CachedPSO = { cachedBlob, sizeof(cachedBlob) };
+	third.m_desc.pRootSignature = reinterpret_cast<ID3D12RootSignature*>(0x1000);
+	CHECK_EQ(third.Hash(), first.Hash());
+}
+
+TEST(PipelineStateHashIgnoresUnusedRenderTargets)
+{
+	GraphicsPipelineDescBuilder first(0);
+	GraphicsPipelineDescBuilder second(0);
+	//the formats after the bound render targets are left over from another pipeline
+	for (UINT i = second.m_desc.NumRenderTargets; i < 8; ++i)
+		second.m_desc.RTVFormats[i] = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	//without independent blend only the first render target blend is used
+	second.m_desc.BlendState.RenderTarget[1].BlendEnable = 1;
+	second.m_desc.BlendState.RenderTarget[7].SrcBlend = D3D12_BLEND_ONE;
+	CHECK_EQ(second.Hash(), first.Hash());
+
+	//the bound slots are still part of the key
+	second.m_desc.RTVFormats[1] = DXGI_FORMAT_R32G32B32A32_FLOAT;
+	CHECK(second.Hash() != first.Hash());
+}
+
+TEST(PipelineStateHashSeesEveryField)
+{
+	typedef GraphicsPipelineDescBuilder Builder;
+	std::vector<uint64_t> hashes;
+	hashes.push_back(Builder(0).Hash());
+	hashes.push_back(HashGraphicsPipelineDesc(Builder(0).m_desc, kRootSignatureHash + 1));
+	hashes.push_back(HashModified([](Builder& b) { b.m_vertexShader[10] ^= 0xFF; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.PS.BytecodeLength = 64; }));
+	//the same bytes bound to another stage are another pipeline
+	hashes.push_back(HashModified([](Builder& b) { std::swap(b.m_desc.VS, b.m_desc.PS); }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.BlendState.RenderTarget[0].DestBlend = D3D12_BLEND_ONE; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.BlendState.RenderTarget[0].RenderTargetWriteMask = 0x7; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.BlendState.IndependentBlendEnable = 1; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.SampleMask = 0x1; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.RasterizerState.SlopeScaledDepthBias = 1.5f; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.DepthStencilState.StencilWriteMask = 0x0F; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.DepthStencilState.BackFace.StencilPassOp = D3D12_STENCIL_OP_REPLACE; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_texcoordName = "NORMAL"; b.m_inputElements[1].SemanticName = b.m_texcoordName.c_str(); }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_inputElements[1].AlignedByteOffset = 16; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.InputLayout.NumElements = 1; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.NumRenderTargets = 1; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.DSVFormat = DXGI_FORMAT_UNKNOWN; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.SampleDesc.Count = 4; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.Flags = D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG; }));
+
+	for (size_t i = 0; i < hashes.size(); ++i) {
+		for (size_t j = i + 1; j < hashes.size(); ++j)
+			CHECK(hashes[i] != hashes[j]);
+	}
+}
+
+TEST(ComputePipelineHashFollowsShader)
+{
+	std::vector<uint8_t> shader(48, 0x3C);
+	std::vector<uint8_t> shaderCopy(shader);
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC first;
+	memset(&first, 0x00, sizeof(first));
+	first.CS = { shader.data(), shader.size() };
+	D3D12_COMPUTE_PIPELINE_STATE_DESC second;
+	memset(&second, 0xCD, sizeof(second));
+	second.pRootSignature = nullptr;
+	second.CS = { shaderCopy.data(), shaderCopy.size() };
+	second.NodeMask = 0;
+	second.CachedPSO = { nullptr, 0 };
+	second.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+	CHECK_EQ(HashComputePipelineDesc(second, kRootSignatureHash), HashComputePipelineDesc(first, kRootSignatureHash));
+	CHECK(HashComputePipelineDesc(first, kRootSignatureHash) != HashComputePipelineDesc(first, kRootSignatureHash + 1));
+
+	shaderCopy[47] = 0;
+	CHECK(HashComputePipelineDesc(second, kRootSignatureHash) != HashComputePipelineDesc(first, kRootSignatureHash));
+}
+
+//the cache compares the keys on a hit, so the keys follow the hashes
+TEST(PipelineStateKeyMatchesHash)
+{
+	GraphicsPipelineDescBuilder first(0x00);
+	GraphicsPipelineDescBuilder second(0xCD);
+	std::vector<uint8_t> firstKey, secondKey;
+	BuildGraphicsPipelineKey(first.m_desc, kRootSignatureHash, firstKey);
+	BuildGraphicsPipelineKey(second.m_desc, kRootSignatureHash, secondKey);
+	CHECK(firstKey == secondKey);
+	CHECK_EQ(HashPipelineKey(firstKey), first.Hash());
+
+	second.m_pixelShader[95] ^= 0x01;
+	BuildGraphicsPipelineKey(second.m_desc, kRootSignatureHash, secondKey);
+	CHECK(firstKey != secondKey);
+	BuildGraphicsPipelineKey(first.m_desc, kRootSignatureHash + 1, secondKey);
+	CHECK(firstKey != secondKey);
+
+	std::vector<uint8_t> shader(32, 0x5A);
+	D3D12_COMPUTE_PIPELINE_STATE_DESC computeDesc = {};
+	computeDesc.CS = { shader.data(), shader.size() };
+	std::vector<uint8_t> computeKey;
+	BuildComputePipelineKey(computeDesc, kRootSignatureHash, computeKey);
+	CHECK_EQ(HashPipelineKey(computeKey), HashComputePipelineDesc(computeDesc, kRootSignatureHash));
+}
+
+//the hash keys the persisted pipeline library, so it must not change between runs and builds
+TEST(PipelineStateHashIsStable)
+{
+	const uint8_t shader[4] = { 0x44, 0x58, 0x42, 0x43 }; //"DXBC"
+	D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
+	desc.CS = { shader, sizeof(shader) };
+
+	//the root signature hash, the bytecode length and bytes, the node mask, then the flags
+	uint64_t length = sizeof(shader);
+	uint32_t trailingFields[] = { 0, 0 };
+	uint64_t expectedHash = HashBytes(&kRootSignatureHash, sizeof(uint64_t));
+	expectedHash = HashBytes(&length, sizeof(length), expectedHash);
+	expectedHash = HashBytes(shader, sizeof(shader), expectedHash);
+	expectedHash = HashBytes(trailingFields, sizeof(trailingFields), expectedHash);
+	CHECK_EQ(HashComputePipelineDesc(desc, kRootSignatureHash), expectedHash);
+	//pinned, a new value invalidates every pipeline blob on disk
+	CHECK_EQ(expectedHash, 0xd58dd5cc8384ea5dull);
+
+	//the graphics pipeline too, with the stub enums carrying the sdk values
+	CHECK_EQ(GraphicsPipelineDescBuilder(0).Hash(), 0xade551130012d198ull);
+}
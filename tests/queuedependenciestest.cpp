@@ -0,0 +1,187 @@
+#include "testharness.h"
+#include "simulatedgpu.h"
+#include "queuedependencies.h"
+#include <thread>
+#include <vector>
+
+namespace
+{
+	//the simulated queues of the engine, indexed by the queue type in the fence value
+	struct SimulatedQueues
+	{
+		SimulatedQueue m_direct;
+		SimulatedQueue m_compute;
+		SimulatedQueue m_copy;
+
+		explicit SimulatedQueues(uint64_t latency) :
+			m_direct(D3D12_COMMAND_LIST_TYPE_DIRECT, latency),
+			m_compute(D3D12_COMMAND_LIST_TYPE_COMPUTE, latency),
+			m_copy(D3D12_COMMAND_LIST_TYPE_COPY, latency) {}
+
+		SimulatedQueue& GetQueue(uint64_t fenceValue) {
+			switch (QueueDependencies::GetQueueIndex(fenceValue)) {
+			case D3D12_COMMAND_LIST_TYPE_COMPUTE: return m_compute;
+			case D3D12_COMMAND_LIST_TYPE_COPY: return m_copy;
+			default: return m_direct;
+			}
+		}
+
+		QueueDependencies::FenceCompleteFunc GetFenceCompleteFunc() {
+			return [this](uint64_t fenceValue) { return GetQueue(fenceValue).IsFenceComplete(fenceValue); };
+		}
+	};
+}
+
+TEST(QueueDependenciesIgnoreSameQueue)
+{
+	SimulatedQueues queues(4);
+	QueueDependencies dependencies(D3D12_COMMAND_LIST_TYPE_DIRECT);
+	dependencies.AddDependency(queues.m_direct.Signal());
+	CHECK(!dependencies.HasDependencies());
+
+	uint64_t waitFences[QueueDependencies::kQueueTypeCount];
+	CHECK_EQ(dependencies.TakeWaits(queues.GetFenceCompleteFunc(), waitFences), 0u);
+	CHECK_EQ(dependencies.GetWaitedFence(D3D12_COMMAND_LIST_TYPE_DIRECT), 0ull);
+}
+
+TEST(QueueDependenciesKeepNewestFencePerQueue)
+{
+	SimulatedQueues queues(8);
+	QueueDependencies dependencies(D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+	uint64_t computeFences[3];
+	for (uint64_t& fenceValue : computeFences)
+		fenceValue = queues.m_compute.Signal();
+	uint64_t copyFence = queues.m_copy.Signal();
+	//out of order, the newest fence of each queue covers the older ones
+	dependencies.AddDependency(computeFences[1]);
+	dependencies.AddDependency(copyFence);
+	dependencies.AddDependency(computeFences[2]);
+	dependencies.AddDependency(computeFences[0]);
+	CHECK(dependencies.HasDependencies());
+
+	uint64_t waitFences[QueueDependencies::kQueueTypeCount];
+	CHECK_EQ(dependencies.TakeWaits(queues.GetFenceCompleteFunc(), waitFences), 2u);
+	CHECK_EQ(waitFences[0], computeFences[2]);
+	CHECK_EQ(waitFences[1], copyFence);
+	CHECK(!dependencies.HasDependencies());
+	CHECK_EQ(dependencies.GetWaitedFence(D3D12_COMMAND_LIST_TYPE_COMPUTE), computeFences[2]);
+	CHECK_EQ(dependencies.GetWaitedFence(D3D12_COMMAND_LIST_TYPE_COPY), copyFence);
+
+	//a fence older than the one waited is covered by the gpu wait already
+	dependencies.AddDependency(computeFences[1]);
+	CHECK(!dependencies.HasDependencies());
+	CHECK_EQ(dependencies.TakeWaits(queues.GetFenceCompleteFunc(), waitFences), 0u);
+}
+
+TEST(QueueDependenciesSkipCompletedFences)
+{
+	SimulatedQueues queues(2);
+	QueueDependencies dependencies(D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+	uint64_t computeFence = queues.m_compute.Signal();
+	dependencies.AddDependency(computeFence);
+	queues.m_compute.Flush();
+	CHECK(dependencies.HasDependencies());
+
+	//the producer finished on the cpu side, a gpu wait would be wasted
+	uint64_t waitFences[QueueDependencies::kQueueTypeCount];
+	CHECK_EQ(dependencies.TakeWaits(queues.GetFenceCompleteFunc(), waitFences), 0u);
+	CHECK(!dependencies.HasDependencies());
+	CHECK_EQ(dependencies.GetWaitedFence(D3D12_COMMAND_LIST_TYPE_COMPUTE), 0ull);
+}
+
+//async compute feeding the frames, like the mip generation on the compute queue
+//every frame reads the output of the compute submissions before it, so its gpu waits must cover them
+TEST(QueueDependenciesCoverProducersAcrossFrames)
+{
+	const uint64_t kLatencies[] = { 0, 1, 3, 7 };
+	for (uint64_t latency : kLatencies) {
+		SimulatedQueues queues(latency);
+		QueueDependencies dependencies(D3D12_COMMAND_LIST_TYPE_DIRECT);
+		uint64_t gpuWaits = 0;
+		uint64_t producedFences = 0;
+
+		for (uint32_t frame = 0; frame < 200; ++frame) {
+			//some frames produce on the compute and copy queues, some several times
+			uint64_t newestCompute = 0, newestCopy = 0;
+			for (uint32_t i = 0; i < frame % 3; ++i) {
+				newestCompute = queues.m_compute.Signal();
+				dependencies.AddDependency(newestCompute);
+				producedFences++;
+			}
+			if (frame % 5 == 0) {
+				newestCopy = queues.m_copy.Signal();
+				dependencies.AddDependency(newestCopy);
+				producedFences++;
+			}
+
+			uint64_t waitFences[QueueDependencies::kQueueTypeCount];
+			uint32_t waitCount = dependencies.TakeWaits(queues.GetFenceCompleteFunc(), waitFences);
+			gpuWaits += waitCount;
+			for (uint32_t i = 0; i < waitCount; ++i) {
+				CHECK(QueueDependencies::GetQueueIndex(waitFences[i]) != D3D12_COMMAND_LIST_TYPE_DIRECT);
+				//the consumer queue waits on the gpu, the simulated producer finishes the fence then
+				queues.GetQueue(waitFences[i]).WaitForFence(waitFences[i]);
+			}
+
+			//the frame runs only after all it consumes
+			if (newestCompute != 0)
+				CHECK(queues.m_compute.IsFenceComplete(newestCompute));
+			if (newestCopy != 0)
+				CHECK(queues.m_copy.IsFenceComplete(newestCopy));
+			queues.m_direct.Signal();
+		}
+
+		//one wait per producer queue and frame at most, and none for the fences already complete
+		CHECK(gpuWaits <= producedFences);
+		if (latency == 0)
+			CHECK_EQ(gpuWaits, 0ull);
+		else
+			CHECK(gpuWaits > 0);
+	}
+}
+
+//the producers declare the dependencies from their threads while the consumer submits
+TEST(QueueDependenciesConcurrentProducers)
+{
+	SimulatedQueues queues(16);
+	QueueDependencies dependencies(D3D12_COMMAND_LIST_TYPE_DIRECT);
+	const uint32_t kSubmissions = 5000;
+
+	std::vector<std::thread> producers;
+	SimulatedQueue* producerQueues[] = { &queues.m_compute, &queues.m_copy };
+	for (SimulatedQueue* queue : producerQueues) {
+		producers.emplace_back([&dependencies, queue, kSubmissions]() {
+			for (uint32_t i = 0; i < kSubmissions; ++i)
+				dependencies.AddDependency(queue->Signal());
+		});
+	}
+
+	uint64_t lastWaited[QueueDependencies::kQueueTypeCount] = {};
+	bool ordered = true;
+	auto consume = [&]() {
+		uint64_t waitFences[QueueDependencies::kQueueTypeCount];
+		uint32_t waitCount = dependencies.TakeWaits(queues.GetFenceCompleteFunc(), waitFences);
+		for (uint32_t i = 0; i < waitCount; ++i) {
+			//the waits of one producer only move forward
+			uint32_t producerIndex = QueueDependencies::GetQueueIndex(waitFences[i]);
+			ordered = ordered && waitFences[i] > lastWaited[producerIndex];
+			lastWaited[producerIndex] = waitFences[i];
+		}
+	};
+	for (uint32_t i = 0; i < kSubmissions; ++i)
+		consume();
+	for (std::thread& producer : producers)
+		producer.join();
+	consume();
+
+	CHECK(ordered);
+	CHECK(!dependencies.HasDependencies());
+	//the last fence of each producer is waited, unless it completed on its own
+	for (SimulatedQueue* queue : producerQueues) {
+		uint64_t lastFence = queue->GetLastSignaledFence();
+		uint32_t producerIndex = QueueDependencies::GetQueueIndex(lastFence);
+		CHECK(dependencies.GetWaitedFence(producerIndex) == lastFence || queue->IsFenceComplete(lastFence));
+	}
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <d3d12.h>
+
+//Recording Device
+//a fake device built on the stub interfaces, the descriptor copies are applied to a map of the destination slots
+//so the tests can check where each source descriptor landed, and the benchmarks can count the copies
+class RecordingDevice : public ID3D12Device
+{
+public:
+	explicit RecordingDevice(UINT descriptorSize) : m_descriptorSize(descriptorSize) {}
+
+	void STDMETHODCALLTYPE CopyDescriptors(UINT NumDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pDestDescriptorRangeStarts,
+		const UINT* pDestDescriptorRangeSizes, UINT NumSrcDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorRangeStarts,
+		const UINT* pSrcDescriptorRangeSizes, D3D12_DESCRIPTOR_HEAP_TYPE) override {
+		m_copyCalls++;
+		m_destRanges += NumDestDescriptorRanges;
+		if (!m_applyCopies) {
+			for (UINT i = 0; i < NumSrcDescriptorRanges; ++i)
+				m_copiedDescriptors += pSrcDescriptorRangeSizes[i];
+			return;
+		}
+
+		//walk both range lists descriptor by descriptor, like the runtime does
+		UINT srcRange = 0, srcOffset = 0;
+		for (UINT i = 0; i < NumDestDescriptorRanges; ++i) {
+			for (UINT j = 0; j < pDestDescriptorRangeSizes[i]; ++j) {
+				size_t destSlot = pDestDescriptorRangeStarts[i].ptr + (size_t)j * m_descriptorSize;
+				m_heap[destSlot] = pSrcDescriptorRangeStarts[srcRange].ptr + (size_t)srcOffset * m_descriptorSize;
+				m_copiedDescriptors++;
+				if (++srcOffset == pSrcDescriptorRangeSizes[srcRange]) {
+					srcRange++;
+					srcOffset = 0;
+				}
+			}
+		}
+	}
+
+	//the benchmarks only count, the map is too slow for them
+	void SetApplyCopies(bool applyCopies) { m_applyCopies = applyCopies; }
+
+	//0 when nothing was copied to the slot
+	size_t GetCopiedSource(size_t destSlot) const {
+		auto iter = m_heap.find(destSlot);
+		return iter == m_heap.end() ? 0 : iter->second;
+	}
+
+	uint64_t GetCopyCalls() const { return m_copyCalls; }
+	uint64_t GetDestRanges() const { return m_destRanges; }
+	uint64_t GetCopiedDescriptors() const { return m_copiedDescriptors; }
+
+private:
+	UINT m_descriptorSize;
+	bool m_applyCopies = true;
+	std::unordered_map<size_t, size_t> m_heap;
+	uint64_t m_copyCalls = 0;
+	uint64_t m_destRanges = 0;
+	uint64_t m_copiedDescriptors = 0;
+};
+
+//Recording Command List
+//keeps the last table bound to each root index, and writes the input assembler and draw calls
+//into a command stream like the allocator memory of a real list, so the recording cost is not free
+class RecordingCommandList : public ID3D12GraphicsCommandList
+{
+public:
+	static const UINT kMaxRootIndex = 64;
+
+	RecordingCommandList() : m_graphicsTables(kMaxRootIndex, 0), m_computeTables(kMaxRootIndex, 0) {}
+
+	void STDMETHODCALLTYPE SetComputeRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) override {
+		m_computeTables[RootParameterIndex] = BaseDescriptor.ptr;
+		m_bindCalls++;
+	}
+
+	void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) override {
+		m_graphicsTables[RootParameterIndex] = BaseDescriptor.ptr;
+		m_bindCalls++;
+	}
+
+	void STDMETHODCALLTYPE IASetVertexBuffers(UINT StartSlot, UINT NumViews, const D3D12_VERTEX_BUFFER_VIEW* pViews) override {
+		m_commands.push_back(kVertexBuffersCommand);
+		m_commands.push_back(StartSlot);
+		m_commands.push_back(NumViews);
+		for (UINT i = 0; i < NumViews; ++i) {
+			m_commands.push_back(pViews[i].BufferLocation);
+			m_commands.push_back(((uint64_t)pViews[i].SizeInBytes << 32) | pViews[i].StrideInBytes);
+		}
+	}
+
+	void STDMETHODCALLTYPE IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView) override {
+		m_commands.push_back(kIndexBufferCommand);
+		m_commands.push_back(pView->BufferLocation);
+		m_commands.push_back(((uint64_t)pView->SizeInBytes << 32) | pView->Format);
+	}
+
+	void STDMETHODCALLTYPE DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation,
+		INT BaseVertexLocation, UINT StartInstanceLocation) override {
+		m_commands.push_back(kDrawIndexedCommand);
+		m_commands.push_back(((uint64_t)IndexCountPerInstance << 32) | InstanceCount);
+		m_commands.push_back(((uint64_t)StartIndexLocation << 32) | (uint32_t)BaseVertexLocation);
+		m_commands.push_back(StartInstanceLocation);
+		m_drawCalls++;
+	}
+
+	//like resetting the list on a new allocator, the stream memory is kept
+	void Reset() {
+		m_commands.clear();
+		m_drawCalls = 0;
+		m_bindCalls = 0;
+	}
+
+	uint64_t GetGraphicsTable(UINT rootIndex) const { return m_graphicsTables[rootIndex]; }
+	uint64_t GetComputeTable(UINT rootIndex) const { return m_computeTables[rootIndex]; }
+	uint64_t GetBindCalls() const { return m_bindCalls; }
+	uint64_t GetDrawCalls() const { return m_drawCalls; }
+	const std::vector<uint64_t>& GetCommands() const { return m_commands; }
+
+private:
+	//an enum, the stream takes the values by reference
+	enum CommandType : uint64_t
+	{
+		kVertexBuffersCommand = 1,
+		kIndexBufferCommand = 2,
+		kDrawIndexedCommand = 3
+	};
+
+	std::vector<uint64_t> m_graphicsTables;
+	std::vector<uint64_t> m_computeTables;
+	std::vector<uint64_t> m_commands;
+	uint64_t m_bindCalls = 0;
+	uint64_t m_drawCalls = 0;
+};
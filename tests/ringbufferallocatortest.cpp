@@ -0,0 +1,150 @@
+#include "testharness.h"
+#include "simulatedgpu.h"
+#include "resources/memoryallocator/ringbufferallocator.h"
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct RingRange
+	{
+		size_t m_offset;
+		size_t m_size;
+	};
+
+	bool Overlaps(const RingRange& a, const RingRange& b)
+	{
+		return a.m_offset < b.m_offset + b.m_size && b.m_offset < a.m_offset + a.m_size;
+	}
+}
+
+TEST(RingBufferHeadTailWrap)
+{
+	SimulatedQueue queue(0, 8);
+	auto isFenceComplete = [&](uint64_t fenceValue) { return queue.IsFenceComplete(fenceValue); };
+	RingBufferAllocator ring;
+	ring.Initialize(1024);
+
+	size_t offset = 0;
+	CHECK(ring.Allocate(400, 1, offset));
+	CHECK_EQ(offset, 0u);
+	uint64_t firstFence = queue.Signal();
+	ring.Retire(firstFence);
+
+	CHECK(ring.Allocate(400, 1, offset));
+	CHECK_EQ(offset, 400u);
+	uint64_t secondFence = queue.Signal();
+	ring.Retire(secondFence);
+
+	//the end of the ring is too small and the tail has not moved
+	CHECK(!ring.Allocate(300, 1, offset));
+	ring.ReleaseCompleted(isFenceComplete);
+	CHECK_EQ(ring.GetUsedSize(), 800u);
+
+	//the first segment completed, the head wraps and wastes the 224 bytes at the end
+	queue.WaitForFence(firstFence);
+	ring.ReleaseCompleted(isFenceComplete);
+	CHECK_EQ(ring.GetUsedSize(), 400u);
+	CHECK(ring.Allocate(300, 1, offset));
+	CHECK_EQ(offset, 0u);
+	CHECK_EQ(ring.GetUsedSize(), 924u);
+
+	//the head runs up to the tail, then the ring is full
+	CHECK(ring.Allocate(100, 1, offset));
+	CHECK_EQ(offset, 300u);
+	CHECK_EQ(ring.GetUsedSize(), 1024u);
+	CHECK(!ring.Allocate(1, 1, offset));
+	uint64_t thirdFence = queue.Signal();
+	ring.Retire(thirdFence);
+
+	queue.WaitForFence(secondFence);
+	ring.ReleaseCompleted(isFenceComplete);
+	CHECK_EQ(ring.GetUsedSize(), 624u);
+	CHECK(!ring.Allocate(500, 1, offset));
+	CHECK(ring.Allocate(400, 1, offset));
+	CHECK_EQ(offset, 400u);
+
+	//nothing in flight, the ring restarts from the beginning
+	ring.Retire(queue.Signal());
+	queue.Flush();
+	ring.ReleaseCompleted(isFenceComplete);
+	CHECK_EQ(ring.GetUsedSize(), 0u);
+	CHECK(ring.Allocate(1024, 1, offset));
+	CHECK_EQ(offset, 0u);
+}
+
+TEST(RingBufferAlignment)
+{
+	RingBufferAllocator ring;
+	ring.Initialize(4096);
+
+	size_t offset = 0;
+	CHECK(ring.Allocate(10, 1, offset));
+	CHECK(ring.Allocate(16, 256, offset));
+	CHECK_EQ(offset, 256u);
+	//the padding is in flight with the allocation
+	CHECK_EQ(ring.GetUsedSize(), 272u);
+	CHECK(!ring.Allocate(4097, 1, offset));
+	CHECK(!ring.Allocate(0, 1, offset));
+}
+
+//the frames allocate random sizes and the gpu finishes them a few submissions later
+//the live ranges must never overlap, and the tail must follow the fences in order
+TEST(RingBufferRandomizedFrames)
+{
+	const size_t kCapacity = 1 << 20;
+	const uint32_t kFrameCount = 20000;
+	const size_t kAlignments[] = { 1, 16, 256, 512 };
+
+	SimulatedQueue queue(0, 3);
+	auto isFenceComplete = [&](uint64_t fenceValue) { return queue.IsFenceComplete(fenceValue); };
+	RingBufferAllocator ring;
+	ring.Initialize(kCapacity);
+
+	std::mt19937_64 random(7);
+	std::deque<std::pair<uint64_t, std::vector<RingRange>>> framesInFlight;
+	uint64_t failedCount = 0;
+
+	for (uint32_t frame = 0; frame < kFrameCount; ++frame) {
+		ring.ReleaseCompleted(isFenceComplete);
+		while (!framesInFlight.empty() && queue.IsFenceComplete(framesInFlight.front().first))
+			framesInFlight.pop_front();
+
+		std::vector<RingRange> frameRanges;
+		uint32_t allocationCount = 1 + (uint32_t)(random() % 32);
+		for (uint32_t i = 0; i < allocationCount; ++i) {
+			size_t size = 1 + (size_t)(random() % 16384);
+			size_t alignment = kAlignments[random() % 4];
+			size_t offset = 0;
+			if (!ring.Allocate(size, alignment, offset)) {
+				failedCount++;
+				continue;
+			}
+			RingRange range = { offset, size };
+			CHECK_EQ(offset % alignment, 0u);
+			CHECK(offset + size <= kCapacity);
+			for (const auto& inFlight : framesInFlight) {
+				for (const RingRange& other : inFlight.second)
+					CHECK(!Overlaps(range, other));
+			}
+			for (const RingRange& other : frameRanges)
+				CHECK(!Overlaps(range, other));
+			frameRanges.push_back(range);
+		}
+		CHECK(ring.GetUsedSize() <= kCapacity);
+
+		uint64_t fenceValue = queue.Signal();
+		ring.Retire(fenceValue);
+		framesInFlight.emplace_back(fenceValue, std::move(frameRanges));
+
+		//sometimes the cpu blocks on the oldest frame, like a full swap chain
+		if (random() % 64 == 0)
+			queue.WaitForFence(framesInFlight.front().first);
+	}
+
+	queue.Flush();
+	ring.ReleaseCompleted(isFenceComplete);
+	CHECK_EQ(ring.GetUsedSize(), 0u);
+	printf("  %llu allocations did not fit\n", (unsigned long long)failedCount);
+}
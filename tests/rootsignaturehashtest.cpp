@@ -0,0 +1,144 @@
+#include "testharness.h"
+#include "rootsignaturehash.h"
+#include "hashutils.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	//a layout like the pbr root signature, every call builds it in new memory
+	struct RootSignatureDescBuilder
+	{
+		std::vector<D3D12_DESCRIPTOR_RANGE> m_ranges;
+		std::vector<D3D12_ROOT_PARAMETER> m_parameters;
+		std::vector<D3D12_STATIC_SAMPLER_DESC> m_samplers;
+		D3D12_ROOT_SIGNATURE_DESC m_desc;
+
+		RootSignatureDescBuilder() : m_ranges(2), m_parameters(4), m_samplers(1) {
+			//the inactive bytes of the unions are garbage, like an uninitialized parameter
+			memset(m_parameters.data(), 0xCD, sizeof(D3D12_ROOT_PARAMETER) * m_parameters.size());
+
+			m_ranges[0] = { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 5, 0, 0, 0 };
+			m_ranges[1] = { D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0, 0, 5 };
+
+			m_parameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+			m_parameters[0].Descriptor.ShaderRegister = 0;
+			m_parameters[0].Descriptor.RegisterSpace = 0;
+			m_parameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+			m_parameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+			m_parameters[1].Constants.ShaderRegister = 1;
+			m_parameters[1].Constants.RegisterSpace = 0;
+			m_parameters[1].Constants.Num32BitValues = 4;
+			m_parameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+			m_parameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+			m_parameters[2].DescriptorTable.NumDescriptorRanges = 2;
+			m_parameters[2].DescriptorTable.pDescriptorRanges = m_ranges.data();
+			m_parameters[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+			m_parameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+			m_parameters[3].Descriptor.ShaderRegister = 6;
+			m_parameters[3].Descriptor.RegisterSpace = 1;
+			m_parameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+			D3D12_STATIC_SAMPLER_DESC& sampler = m_samplers[0];
+			sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+			sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+			sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+			sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+			sampler.MipLODBias = 0.0f;
+			sampler.MaxAnisotropy = 16;
+			sampler.ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+			sampler.BorderColor = D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK;
+			sampler.MinLOD = 0.0f;
+			sampler.MaxLOD = 1000.0f;
+			sampler.ShaderRegister = 0;
+			sampler.RegisterSpace = 0;
+			sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+			m_desc.NumParameters = (UINT)m_parameters.size();
+			m_desc.pParameters = m_parameters.data();
+			m_desc.NumStaticSamplers = (UINT)m_samplers.size();
+			m_desc.pStaticSamplers = m_samplers.data();
+			m_desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+		}
+
+		RootSignatureDescBuilder(const RootSignatureDescBuilder&) = delete;
+		RootSignatureDescBuilder& operator=(const RootSignatureDescBuilder&) = delete;
+
+		uint64_t Hash() const { return HashRootSignatureDesc(m_desc); }
+	};
+
+	//the hash of the layout after one change
+	template<typename ModifyFunc>
+	uint64_t HashModified(ModifyFunc modify)
+	{
+		RootSignatureDescBuilder builder;
+		modify(builder);
+		return builder.Hash();
+	}
+}
+
+//the layouts built in different memory with different garbage in the unions share one hash
+TEST(RootSignatureHashFollowsPointers)
+{
+	RootSignatureDescBuilder first;
+	RootSignatureDescBuilder others[3];
+	memset(&others[1].m_parameters[0].Constants.Num32BitValues, 0x11, sizeof(UINT));
+	for (const RootSignatureDescBuilder& other : others) {
+		CHECK(other.m_desc.pParameters != first.m_desc.pParameters);
+		CHECK_EQ(other.Hash(), first.Hash());
+	}
+}
+
+TEST(RootSignatureHashSeesEveryField)
+{
+	typedef RootSignatureDescBuilder Builder;
+	std::vector<uint64_t> hashes;
+	hashes.push_back(RootSignatureDescBuilder().Hash());
+	hashes.push_back(HashModified([](Builder& b) { b.m_parameters[0].Descriptor.ShaderRegister = 1; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_parameters[3].Descriptor.RegisterSpace = 0; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_parameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_parameters[1].Constants.Num32BitValues = 8; }));
+	//the srv and the uav at the same register differ by the type only
+	hashes.push_back(HashModified([](Builder& b) { b.m_parameters[3].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_ranges[1].NumDescriptors = 2; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_ranges[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_parameters[2].DescriptorTable.NumDescriptorRanges = 1; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_samplers[0].Filter = D3D12_FILTER_ANISOTROPIC; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_samplers[0].MaxLOD = 8.0f; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.NumStaticSamplers = 0; }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE; }));
+	//the parameter order is the root index, so the swapped layout is another root signature
+	hashes.push_back(HashModified([](Builder& b) { std::swap(b.m_parameters[0], b.m_parameters[3]); }));
+	hashes.push_back(HashModified([](Builder& b) { b.m_desc.NumParameters = 3; }));
+
+	for (size_t i = 0; i < hashes.size(); ++i) {
+		for (size_t j = i + 1; j < hashes.size(); ++j)
+			CHECK(hashes[i] != hashes[j]);
+	}
+}
+
+//the hash keys the persisted pipeline blobs, so it must not change between runs and builds
+TEST(RootSignatureHashIsStable)
+{
+	D3D12_DESCRIPTOR_RANGE range = { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0, 0, 0 };
+	D3D12_ROOT_PARAMETER parameter;
+	memset(&parameter, 0, sizeof(parameter));
+	parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	parameter.DescriptorTable.NumDescriptorRanges = 1;
+	parameter.DescriptorTable.pDescriptorRanges = &range;
+	parameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+	D3D12_ROOT_SIGNATURE_DESC desc = {};
+	desc.NumParameters = 1;
+	desc.pParameters = &parameter;
+	desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+	//the fields are hashed in the order of the desc: the counts, the flags, then each parameter
+	uint32_t expectedFields[] = { 1, 0, 1, 0, 5, 1 };
+	uint64_t expectedHash = HashBytes(expectedFields, sizeof(expectedFields));
+	expectedHash = HashBytes(&range, sizeof(range), expectedHash);
+	CHECK_EQ(HashRootSignatureDesc(desc), expectedHash);
+	//pinned, a new value invalidates every pipeline blob on disk
+	CHECK_EQ(expectedHash, 0x9054142681524460ull);
+}
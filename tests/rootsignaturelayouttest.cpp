@@ -0,0 +1,89 @@
+#include "testharness.h"
+#include "rootsignaturelayout.h"
+
+TEST(RootSignatureLayoutRejectsOverLimit)
+{
+	//33 root descriptors take 66 dwords, the promotion only shrinks the constant buffers
+	RootSignatureLayout overLayout;
+	for (UINT i = 0; i < 33; ++i)
+		overLayout.AddBufferSRV(ROOT_PARAMETER_PER_DRAW, i);
+	CHECK(!overLayout.Build());
+
+	RootSignatureLayout fullLayout;
+	fullLayout.AddConstants(ROOT_PARAMETER_PER_DRAW, 0, 62);
+	fullLayout.AddDescriptorRange(ROOT_PARAMETER_PER_PASS, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 8);
+	fullLayout.AddDescriptorRange(ROOT_PARAMETER_PER_PASS, D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, 0, 2);
+	CHECK(fullLayout.Build());
+	CHECK_EQ(fullLayout.GetRootDwords(), 64u);
+
+	RootSignatureLayout constantsLayout;
+	constantsLayout.AddConstants(ROOT_PARAMETER_PER_DRAW, 0, 65);
+	CHECK(!constantsLayout.Build());
+}
+
+//the promotion stops when the next constant buffer does not fit, the parameters out of budget stay root descriptors
+TEST(RootSignatureLayoutPartialPromotion)
+{
+	RootSignatureLayout layout;
+	uint32_t constants = layout.AddConstants(ROOT_PARAMETER_PER_DRAW, 0, 30);
+	uint32_t frameBuffer = layout.AddConstantBuffer(ROOT_PARAMETER_PER_FRAME, 1, 64);
+	uint32_t passBuffer = layout.AddConstantBuffer(ROOT_PARAMETER_PER_PASS, 2, 32);
+	uint32_t drawBuffer = layout.AddConstantBuffer(ROOT_PARAMETER_PER_DRAW, 3, 64);
+	uint32_t smallDrawBuffer = layout.AddConstantBuffer(ROOT_PARAMETER_PER_DRAW, 4, 10);
+	//too large to promote, and the unknown size is never promoted
+	uint32_t largeBuffer = layout.AddConstantBuffer(ROOT_PARAMETER_PER_DRAW, 5, 68);
+	uint32_t unsizedBuffer = layout.AddConstantBuffer(ROOT_PARAMETER_PER_DRAW, 6, 0);
+	CHECK(layout.Build());
+
+	//30 + 6 * 2 = 42 dwords, then the per draw buffers 42 - 2 + 3 = 43 and 43 - 2 + 16 = 57,
+	//the pass buffer 57 - 2 + 8 = 63, and the frame buffer would take 77
+	CHECK(!layout.IsPromoted(constants));
+	CHECK(layout.IsPromoted(smallDrawBuffer));
+	CHECK(layout.IsPromoted(drawBuffer));
+	CHECK(layout.IsPromoted(passBuffer));
+	CHECK(!layout.IsPromoted(frameBuffer));
+	CHECK(!layout.IsPromoted(largeBuffer));
+	CHECK(!layout.IsPromoted(unsizedBuffer));
+	CHECK_EQ(layout.GetRootDwords(), 63u);
+
+	//the promoted buffer is root constants rounded up to dwords
+	const RootParameterDesc& smallParameter = layout.GetRootParameter(layout.GetRootIndex(smallDrawBuffer));
+	CHECK_EQ(smallParameter.m_type, D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS);
+	CHECK_EQ(smallParameter.m_sizeInBytes, 12u);
+	CHECK_EQ(smallParameter.m_shaderRegister, 4u);
+	CHECK_EQ(layout.GetRootParameter(layout.GetRootIndex(frameBuffer)).m_type, D3D12_ROOT_PARAMETER_TYPE_CBV);
+
+	uint32_t rootDwords = 0;
+	for (uint32_t i = 0; i < layout.GetParameterCount(); ++i)
+		rootDwords += RootSignatureLayout::GetParameterDwords(layout.GetRootParameter(i));
+	CHECK_EQ(rootDwords, layout.GetRootDwords());
+}
+
+//the root indices go from the per draw parameters to the per frame ones, in the added order inside one frequency
+TEST(RootSignatureLayoutRemapOrder)
+{
+	RootSignatureLayout layout;
+	uint32_t frameTable = layout.AddDescriptorRange(ROOT_PARAMETER_PER_FRAME, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 4);
+	uint32_t drawSRV = layout.AddBufferSRV(ROOT_PARAMETER_PER_DRAW, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+	uint32_t passTable = layout.AddDescriptorRange(ROOT_PARAMETER_PER_PASS, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 2);
+	uint32_t frameSampler = layout.AddDescriptorRange(ROOT_PARAMETER_PER_FRAME, D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, 0, 1);
+	uint32_t drawConstants = layout.AddConstants(ROOT_PARAMETER_PER_DRAW, 1, 4);
+	uint32_t passUAV = layout.AddBufferUAV(ROOT_PARAMETER_PER_PASS, 1);
+	CHECK(layout.Build());
+
+	CHECK_EQ(layout.GetRootIndex(drawSRV), 0u);
+	CHECK_EQ(layout.GetRootIndex(drawConstants), 1u);
+	CHECK_EQ(layout.GetRootIndex(passTable), 2u);
+	CHECK_EQ(layout.GetRootIndex(passUAV), 3u);
+	CHECK_EQ(layout.GetRootIndex(frameTable), 4u);
+	CHECK_EQ(layout.GetRootIndex(frameSampler), 5u);
+
+	//the remapped parameters keep their descriptions
+	const RootParameterDesc& drawParameter = layout.GetRootParameter(0);
+	CHECK_EQ(drawParameter.m_type, D3D12_ROOT_PARAMETER_TYPE_SRV);
+	CHECK_EQ(drawParameter.m_visibility, D3D12_SHADER_VISIBILITY_VERTEX);
+	const RootParameterDesc& samplerParameter = layout.GetRootParameter(5);
+	CHECK_EQ(samplerParameter.m_rangeType, D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER);
+	CHECK_EQ(samplerParameter.m_descriptorsNum, 1u);
+	CHECK_EQ(layout.GetRootDwords(), 2u + 4u + 1u + 2u + 1u + 1u);
+}
@@ -0,0 +1,137 @@
+#include "testharness.h"
+#include "resources/memoryallocator/scratchaliasplanner.h"
+#include <random>
+#include <vector>
+
+TEST(ScratchPlannerAliasesReleasedRanges)
+{
+	ScratchAliasPlanner planner;
+	planner.Initialize(4096);
+	ScratchRange range;
+	//no page yet, the caller adds one
+	CHECK(!planner.Allocate(256, 256, range));
+	CHECK_EQ(planner.AddPage(), 0u);
+
+	ScratchRange first, second, third;
+	CHECK(planner.Allocate(1000, 256, first));
+	CHECK(planner.Allocate(1000, 256, second));
+	CHECK_EQ(first.m_offset, 0u);
+	CHECK_EQ(second.m_offset, 1024u);
+	CHECK(!first.m_aliased && !second.m_aliased);
+
+	//the first range ended, the third one reuses its memory and needs a barrier
+	planner.Release(first);
+	CHECK(planner.Allocate(512, 256, third));
+	CHECK_EQ(third.m_offset, 0u);
+	CHECK(third.m_aliased);
+	CHECK_EQ(planner.GetStats().m_aliasedSize, 512u);
+	CHECK_EQ(planner.GetStats().m_usedSize, 1512u);
+	CHECK_EQ(planner.GetStats().m_peakUsedSize, 2000u);
+
+	//the untouched memory is not aliased
+	ScratchRange fourth;
+	CHECK(planner.Allocate(1024, 1024, fourth));
+	CHECK_EQ(fourth.m_offset, 2048u);
+	CHECK(!fourth.m_aliased);
+}
+
+TEST(ScratchPlannerMergesFreeRanges)
+{
+	ScratchAliasPlanner planner;
+	planner.Initialize(4096);
+	planner.AddPage();
+
+	ScratchRange ranges[4];
+	for (ScratchRange& range : ranges)
+		CHECK(planner.Allocate(1024, 1, range));
+	ScratchRange range;
+	CHECK(!planner.Allocate(1, 1, range));
+
+	//release out of order, the neighbours merge back into one page-size range
+	planner.Release(ranges[1]);
+	planner.Release(ranges[3]);
+	CHECK(!planner.Allocate(2048, 1, range));
+	planner.Release(ranges[2]);
+	CHECK(!planner.Allocate(4096, 1, range));
+	planner.Release(ranges[0]);
+	CHECK(planner.Allocate(4096, 1, range));
+	CHECK_EQ(range.m_offset, 0u);
+	CHECK(range.m_aliased);
+	CHECK_EQ(planner.GetStats().m_usedSize, 4096u);
+}
+
+TEST(ScratchPlannerAddsPages)
+{
+	ScratchAliasPlanner planner;
+	planner.Initialize(1024);
+	planner.AddPage();
+
+	ScratchRange first, second;
+	CHECK(planner.Allocate(768, 1, first));
+	CHECK(!planner.Allocate(512, 1, second));
+	CHECK_EQ(planner.AddPage(), 1u);
+	CHECK(planner.Allocate(512, 1, second));
+	CHECK_EQ(second.m_pageIndex, 1u);
+	CHECK(!planner.Allocate(2048, 1, second));
+	CHECK_EQ(planner.GetStats().m_pageCount, 2u);
+
+	planner.Reset();
+	CHECK_EQ(planner.GetPageCount(), 0u);
+	CHECK_EQ(planner.GetStats().m_usedSize, 0u);
+}
+
+//random transient lifetimes, the live ranges must never overlap and the aliased flag follows the touched memory
+TEST(ScratchPlannerRandomizedLifetimes)
+{
+	const uint64_t kPageSize = 1 << 20;
+	const uint32_t kOperationCount = 100000;
+	const uint64_t kAlignments[] = { 1, 256, 4096, 65536 };
+
+	ScratchAliasPlanner planner;
+	planner.Initialize(kPageSize);
+	std::mt19937_64 random(11);
+	std::vector<ScratchRange> liveRanges;
+	std::vector<uint64_t> touchedEnds;
+
+	for (uint32_t i = 0; i < kOperationCount; ++i) {
+		if (!liveRanges.empty() && (random() % 2 == 0 || liveRanges.size() > 256)) {
+			size_t index = (size_t)(random() % liveRanges.size());
+			planner.Release(liveRanges[index]);
+			liveRanges[index] = liveRanges.back();
+			liveRanges.pop_back();
+			continue;
+		}
+
+		uint64_t size = 1 + random() % 32768;
+		uint64_t alignment = kAlignments[random() % 4];
+		ScratchRange range;
+		if (!planner.Allocate(size, alignment, range)) {
+			planner.AddPage();
+			touchedEnds.push_back(0);
+			CHECK(planner.Allocate(size, alignment, range));
+		}
+
+		CHECK_EQ(range.m_offset % alignment, 0u);
+		CHECK(range.m_offset + range.m_size <= kPageSize);
+		for (const ScratchRange& other : liveRanges) {
+			if (other.m_pageIndex == range.m_pageIndex)
+				CHECK(range.m_offset >= other.m_offset + other.m_size || other.m_offset >= range.m_offset + range.m_size);
+		}
+		uint64_t& touchedEnd = touchedEnds[range.m_pageIndex];
+		CHECK_EQ(range.m_aliased, range.m_offset < touchedEnd);
+		if (range.m_offset + range.m_size > touchedEnd)
+			touchedEnd = range.m_offset + range.m_size;
+		liveRanges.push_back(range);
+	}
+
+	for (const ScratchRange& range : liveRanges)
+		planner.Release(range);
+	CHECK_EQ(planner.GetStats().m_usedSize, 0u);
+	//every page merged back into one range
+	for (uint32_t i = 0; i < planner.GetPageCount(); ++i) {
+		ScratchRange range;
+		CHECK(planner.Allocate(kPageSize, 1, range));
+	}
+	printf("  %u pages, peak %llu bytes, %llu bytes aliased\n", planner.GetPageCount(),
+		(unsigned long long)planner.GetStats().m_peakUsedSize, (unsigned long long)planner.GetStats().m_aliasedSize);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+//Simulated Queue
+//the fences of one gpu queue without the device, the queue type is in the top byte like CommandQueue
+//a signaled fence completes when the gpu advanced by latency submissions, or when the cpu waits for it
+//thread-safe, the threads may signal and wait at the same time
+class SimulatedQueue
+{
+public:
+	SimulatedQueue(uint32_t queueType, uint64_t latency) :
+		m_queueBits((uint64_t)queueType << 56), m_latency(latency),
+		m_nextFenceValue{ ((uint64_t)queueType << 56) | 1 }, m_completedFenceValue{ (uint64_t)queueType << 56 } {}
+
+	//signal the fence of a submission, the older submissions make progress
+	uint64_t Signal() {
+		uint64_t fenceValue = m_nextFenceValue++;
+		if (fenceValue - m_queueBits > m_latency)
+			Complete(fenceValue - m_latency);
+		return fenceValue;
+	}
+
+	//the gpu finished everything signaled
+	void Flush() { Complete(m_nextFenceValue - 1); }
+
+	//block the cpu until the fence completed
+	void WaitForFence(uint64_t fenceValue) {
+		m_waitCount++;
+		Complete(fenceValue);
+	}
+
+	bool IsFenceComplete(uint64_t fenceValue) const { return fenceValue <= m_completedFenceValue.load(); }
+	uint64_t GetCompletedFenceValue() const { return m_completedFenceValue; }
+	uint64_t GetLastSignaledFence() const { return m_nextFenceValue - 1; }
+	uint64_t GetWaitCount() const { return m_waitCount; }
+
+private:
+	void Complete(uint64_t fenceValue) {
+		uint64_t completedValue = m_completedFenceValue.load();
+		while (fenceValue > completedValue && !m_completedFenceValue.compare_exchange_weak(completedValue, fenceValue)) {}
+	}
+
+	uint64_t m_queueBits;
+	uint64_t m_latency;
+	std::atomic<uint64_t> m_nextFenceValue;
+	std::atomic<uint64_t> m_completedFenceValue;
+	std::atomic<uint64_t> m_waitCount{ 0 };
+};
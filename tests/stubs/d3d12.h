@@ -0,0 +1,436 @@
+#pragma once
+
+//The d3d12 declarations used by the headless tests on the platforms without the windows sdk
+//only the types the tested sources touch are declared, the interfaces keep the methods the fakes record
+#include <cstddef>
+#include <cstdint>
+
+#define STDMETHODCALLTYPE
+
+typedef int INT;
+typedef int BOOL;
+typedef unsigned int UINT;
+typedef unsigned char UINT8;
+typedef float FLOAT;
+typedef const char* LPCSTR;
+
+typedef uint64_t D3D12_GPU_VIRTUAL_ADDRESS;
+
+struct D3D12_CPU_DESCRIPTOR_HANDLE { size_t ptr; };
+struct D3D12_GPU_DESCRIPTOR_HANDLE { uint64_t ptr; };
+
+enum D3D12_DESCRIPTOR_HEAP_TYPE
+{
+	D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV = 0,
+	D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER = 1,
+	D3D12_DESCRIPTOR_HEAP_TYPE_RTV = 2,
+	D3D12_DESCRIPTOR_HEAP_TYPE_DSV = 3
+};
+
+enum D3D12_COMMAND_LIST_TYPE
+{
+	D3D12_COMMAND_LIST_TYPE_DIRECT = 0,
+	D3D12_COMMAND_LIST_TYPE_BUNDLE = 1,
+	D3D12_COMMAND_LIST_TYPE_COMPUTE = 2,
+	D3D12_COMMAND_LIST_TYPE_COPY = 3
+};
+
+enum D3D12_ROOT_PARAMETER_TYPE
+{
+	D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE = 0,
+	D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS = 1,
+	D3D12_ROOT_PARAMETER_TYPE_CBV = 2,
+	D3D12_ROOT_PARAMETER_TYPE_SRV = 3,
+	D3D12_ROOT_PARAMETER_TYPE_UAV = 4
+};
+
+enum D3D12_SHADER_VISIBILITY
+{
+	D3D12_SHADER_VISIBILITY_ALL = 0,
+	D3D12_SHADER_VISIBILITY_VERTEX = 1,
+	D3D12_SHADER_VISIBILITY_HULL = 2,
+	D3D12_SHADER_VISIBILITY_DOMAIN = 3,
+	D3D12_SHADER_VISIBILITY_GEOMETRY = 4,
+	D3D12_SHADER_VISIBILITY_PIXEL = 5
+};
+
+enum D3D12_DESCRIPTOR_RANGE_TYPE
+{
+	D3D12_DESCRIPTOR_RANGE_TYPE_SRV = 0,
+	D3D12_DESCRIPTOR_RANGE_TYPE_UAV = 1,
+	D3D12_DESCRIPTOR_RANGE_TYPE_CBV = 2,
+	D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER = 3
+};
+
+enum D3D12_FILTER
+{
+	D3D12_FILTER_MIN_MAG_MIP_POINT = 0,
+	D3D12_FILTER_MIN_MAG_MIP_LINEAR = 0x15,
+	D3D12_FILTER_ANISOTROPIC = 0x55
+};
+
+enum D3D12_TEXTURE_ADDRESS_MODE
+{
+	D3D12_TEXTURE_ADDRESS_MODE_WRAP = 1,
+	D3D12_TEXTURE_ADDRESS_MODE_MIRROR = 2,
+	D3D12_TEXTURE_ADDRESS_MODE_CLAMP = 3,
+	D3D12_TEXTURE_ADDRESS_MODE_BORDER = 4
+};
+
+enum D3D12_COMPARISON_FUNC
+{
+	D3D12_COMPARISON_FUNC_NEVER = 1,
+	D3D12_COMPARISON_FUNC_LESS = 2,
+	D3D12_COMPARISON_FUNC_ALWAYS = 8
+};
+
+enum D3D12_STATIC_BORDER_COLOR
+{
+	D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK = 0,
+	D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK = 1,
+	D3D12_STATIC_BORDER_COLOR_OPAQUE_WHITE = 2
+};
+
+enum D3D12_ROOT_SIGNATURE_FLAGS
+{
+	D3D12_ROOT_SIGNATURE_FLAG_NONE = 0,
+	D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT = 0x1
+};
+
+struct D3D12_DESCRIPTOR_RANGE
+{
+	D3D12_DESCRIPTOR_RANGE_TYPE RangeType;
+	UINT NumDescriptors;
+	UINT BaseShaderRegister;
+	UINT RegisterSpace;
+	UINT OffsetInDescriptorsFromTableStart;
+};
+
+struct D3D12_ROOT_DESCRIPTOR_TABLE
+{
+	UINT NumDescriptorRanges;
+	const D3D12_DESCRIPTOR_RANGE* pDescriptorRanges;
+};
+
+struct D3D12_ROOT_CONSTANTS
+{
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+	UINT Num32BitValues;
+};
+
+struct D3D12_ROOT_DESCRIPTOR
+{
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+};
+
+struct D3D12_ROOT_PARAMETER
+{
+	D3D12_ROOT_PARAMETER_TYPE ParameterType;
+	union
+	{
+		D3D12_ROOT_DESCRIPTOR_TABLE DescriptorTable;
+		D3D12_ROOT_CONSTANTS Constants;
+		D3D12_ROOT_DESCRIPTOR Descriptor;
+	};
+	D3D12_SHADER_VISIBILITY ShaderVisibility;
+};
+
+struct D3D12_STATIC_SAMPLER_DESC
+{
+	D3D12_FILTER Filter;
+	D3D12_TEXTURE_ADDRESS_MODE AddressU;
+	D3D12_TEXTURE_ADDRESS_MODE AddressV;
+	D3D12_TEXTURE_ADDRESS_MODE AddressW;
+	float MipLODBias;
+	UINT MaxAnisotropy;
+	D3D12_COMPARISON_FUNC ComparisonFunc;
+	D3D12_STATIC_BORDER_COLOR BorderColor;
+	float MinLOD;
+	float MaxLOD;
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+	D3D12_SHADER_VISIBILITY ShaderVisibility;
+};
+
+struct D3D12_ROOT_SIGNATURE_DESC
+{
+	UINT NumParameters;
+	const D3D12_ROOT_PARAMETER* pParameters;
+	UINT NumStaticSamplers;
+	const D3D12_STATIC_SAMPLER_DESC* pStaticSamplers;
+	D3D12_ROOT_SIGNATURE_FLAGS Flags;
+};
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+	DXGI_FORMAT_R32G32_FLOAT = 16,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_D32_FLOAT = 40,
+	DXGI_FORMAT_R32_UINT = 42
+};
+
+struct DXGI_SAMPLE_DESC
+{
+	UINT Count;
+	UINT Quality;
+};
+
+enum D3D12_BLEND
+{
+	D3D12_BLEND_ZERO = 1,
+	D3D12_BLEND_ONE = 2,
+	D3D12_BLEND_SRC_ALPHA = 5,
+	D3D12_BLEND_INV_SRC_ALPHA = 6
+};
+
+enum D3D12_BLEND_OP
+{
+	D3D12_BLEND_OP_ADD = 1,
+	D3D12_BLEND_OP_SUBTRACT = 2
+};
+
+enum D3D12_LOGIC_OP
+{
+	D3D12_LOGIC_OP_CLEAR = 0,
+	D3D12_LOGIC_OP_NOOP = 4
+};
+
+enum D3D12_FILL_MODE
+{
+	D3D12_FILL_MODE_WIREFRAME = 2,
+	D3D12_FILL_MODE_SOLID = 3
+};
+
+enum D3D12_CULL_MODE
+{
+	D3D12_CULL_MODE_NONE = 1,
+	D3D12_CULL_MODE_FRONT = 2,
+	D3D12_CULL_MODE_BACK = 3
+};
+
+enum D3D12_CONSERVATIVE_RASTERIZATION_MODE
+{
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF = 0,
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON = 1
+};
+
+enum D3D12_DEPTH_WRITE_MASK
+{
+	D3D12_DEPTH_WRITE_MASK_ZERO = 0,
+	D3D12_DEPTH_WRITE_MASK_ALL = 1
+};
+
+enum D3D12_STENCIL_OP
+{
+	D3D12_STENCIL_OP_KEEP = 1,
+	D3D12_STENCIL_OP_ZERO = 2,
+	D3D12_STENCIL_OP_REPLACE = 3
+};
+
+enum D3D12_INPUT_CLASSIFICATION
+{
+	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA = 0,
+	D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA = 1
+};
+
+enum D3D12_INDEX_BUFFER_STRIP_CUT_VALUE
+{
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED = 0,
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFF = 1,
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFFFFFF = 2
+};
+
+enum D3D12_PRIMITIVE_TOPOLOGY_TYPE
+{
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED = 0,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT = 1,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE = 2,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE = 3
+};
+
+enum D3D12_PIPELINE_STATE_FLAGS
+{
+	D3D12_PIPELINE_STATE_FLAG_NONE = 0,
+	D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG = 0x1
+};
+
+struct D3D12_SHADER_BYTECODE
+{
+	const void* pShaderBytecode;
+	size_t BytecodeLength;
+};
+
+struct D3D12_SO_DECLARATION_ENTRY
+{
+	UINT Stream;
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	UINT8 StartComponent;
+	UINT8 ComponentCount;
+	UINT8 OutputSlot;
+};
+
+struct D3D12_STREAM_OUTPUT_DESC
+{
+	const D3D12_SO_DECLARATION_ENTRY* pSODeclaration;
+	UINT NumEntries;
+	const UINT* pBufferStrides;
+	UINT NumStrides;
+	UINT RasterizedStream;
+};
+
+struct D3D12_RENDER_TARGET_BLEND_DESC
+{
+	BOOL BlendEnable;
+	BOOL LogicOpEnable;
+	D3D12_BLEND SrcBlend;
+	D3D12_BLEND DestBlend;
+	D3D12_BLEND_OP BlendOp;
+	D3D12_BLEND SrcBlendAlpha;
+	D3D12_BLEND DestBlendAlpha;
+	D3D12_BLEND_OP BlendOpAlpha;
+	D3D12_LOGIC_OP LogicOp;
+	UINT8 RenderTargetWriteMask;
+};
+
+struct D3D12_BLEND_DESC
+{
+	BOOL AlphaToCoverageEnable;
+	BOOL IndependentBlendEnable;
+	D3D12_RENDER_TARGET_BLEND_DESC RenderTarget[8];
+};
+
+struct D3D12_RASTERIZER_DESC
+{
+	D3D12_FILL_MODE FillMode;
+	D3D12_CULL_MODE CullMode;
+	BOOL FrontCounterClockwise;
+	INT DepthBias;
+	FLOAT DepthBiasClamp;
+	FLOAT SlopeScaledDepthBias;
+	BOOL DepthClipEnable;
+	BOOL MultisampleEnable;
+	BOOL AntialiasedLineEnable;
+	UINT ForcedSampleCount;
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE ConservativeRaster;
+};
+
+struct D3D12_DEPTH_STENCILOP_DESC
+{
+	D3D12_STENCIL_OP StencilFailOp;
+	D3D12_STENCIL_OP StencilDepthFailOp;
+	D3D12_STENCIL_OP StencilPassOp;
+	D3D12_COMPARISON_FUNC StencilFunc;
+};
+
+struct D3D12_DEPTH_STENCIL_DESC
+{
+	BOOL DepthEnable;
+	D3D12_DEPTH_WRITE_MASK DepthWriteMask;
+	D3D12_COMPARISON_FUNC DepthFunc;
+	BOOL StencilEnable;
+	UINT8 StencilReadMask;
+	UINT8 StencilWriteMask;
+	D3D12_DEPTH_STENCILOP_DESC FrontFace;
+	D3D12_DEPTH_STENCILOP_DESC BackFace;
+};
+
+struct D3D12_INPUT_ELEMENT_DESC
+{
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	DXGI_FORMAT Format;
+	UINT InputSlot;
+	UINT AlignedByteOffset;
+	D3D12_INPUT_CLASSIFICATION InputSlotClass;
+	UINT InstanceDataStepRate;
+};
+
+struct D3D12_INPUT_LAYOUT_DESC
+{
+	const D3D12_INPUT_ELEMENT_DESC* pInputElementDescs;
+	UINT NumElements;
+};
+
+struct D3D12_CACHED_PIPELINE_STATE
+{
+	const void* pCachedBlob;
+	size_t CachedBlobSizeInBytes;
+};
+
+struct D3D12_VERTEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	UINT StrideInBytes;
+};
+
+struct D3D12_INDEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	DXGI_FORMAT Format;
+};
+
+class ID3D12RootSignature;
+
+struct D3D12_GRAPHICS_PIPELINE_STATE_DESC
+{
+	ID3D12RootSignature* pRootSignature;
+	D3D12_SHADER_BYTECODE VS;
+	D3D12_SHADER_BYTECODE PS;
+	D3D12_SHADER_BYTECODE DS;
+	D3D12_SHADER_BYTECODE HS;
+	D3D12_SHADER_BYTECODE GS;
+	D3D12_STREAM_OUTPUT_DESC StreamOutput;
+	D3D12_BLEND_DESC BlendState;
+	UINT SampleMask;
+	D3D12_RASTERIZER_DESC RasterizerState;
+	D3D12_DEPTH_STENCIL_DESC DepthStencilState;
+	D3D12_INPUT_LAYOUT_DESC InputLayout;
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE IBStripCutValue;
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE PrimitiveTopologyType;
+	UINT NumRenderTargets;
+	DXGI_FORMAT RTVFormats[8];
+	DXGI_FORMAT DSVFormat;
+	DXGI_SAMPLE_DESC SampleDesc;
+	UINT NodeMask;
+	D3D12_CACHED_PIPELINE_STATE CachedPSO;
+	D3D12_PIPELINE_STATE_FLAGS Flags;
+};
+
+struct D3D12_COMPUTE_PIPELINE_STATE_DESC
+{
+	ID3D12RootSignature* pRootSignature;
+	D3D12_SHADER_BYTECODE CS;
+	UINT NodeMask;
+	D3D12_CACHED_PIPELINE_STATE CachedPSO;
+	D3D12_PIPELINE_STATE_FLAGS Flags;
+};
+
+class ID3D12Device
+{
+public:
+	virtual ~ID3D12Device() {}
+	virtual void STDMETHODCALLTYPE CopyDescriptors(UINT NumDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pDestDescriptorRangeStarts,
+		const UINT* pDestDescriptorRangeSizes, UINT NumSrcDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorRangeStarts,
+		const UINT* pSrcDescriptorRangeSizes, D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType) = 0;
+};
+
+class ID3D12GraphicsCommandList
+{
+public:
+	virtual ~ID3D12GraphicsCommandList() {}
+	virtual void STDMETHODCALLTYPE SetComputeRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) = 0;
+	virtual void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) = 0;
+	virtual void STDMETHODCALLTYPE IASetVertexBuffers(UINT StartSlot, UINT NumViews, const D3D12_VERTEX_BUFFER_VIEW* pViews) = 0;
+	virtual void STDMETHODCALLTYPE IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView) = 0;
+	virtual void STDMETHODCALLTYPE DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation,
+		INT BaseVertexLocation, UINT StartInstanceLocation) = 0;
+};
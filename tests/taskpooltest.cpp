@@ -0,0 +1,93 @@
+#include "testharness.h"
+#include "taskpool.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(TaskPoolRunsEveryTaskOnce)
+{
+	const uint32_t kWorkerCounts[] = { 0, 1, 3 };
+	for (uint32_t workerCount : kWorkerCounts) {
+		TaskPool pool;
+		pool.Initialize(workerCount);
+		CHECK_EQ(pool.GetWorkerCount(), workerCount);
+
+		//several loops in a row reuse the same workers
+		for (uint32_t loop = 0; loop < 20; ++loop) {
+			const uint32_t taskCount = 1 + loop * 37;
+			std::vector<std::atomic<uint32_t>> runs(taskCount);
+			for (std::atomic<uint32_t>& run : runs)
+				run.store(0);
+			pool.ParallelFor(taskCount, [&](uint32_t taskIndex) { runs[taskIndex]++; });
+			for (const std::atomic<uint32_t>& run : runs)
+				CHECK_EQ(run.load(), 1u);
+		}
+	}
+}
+
+//the loops started from different threads run one after another, never mixed
+TEST(TaskPoolSerializesLoopsFromThreads)
+{
+	TaskPool pool;
+	pool.Initialize(2);
+	//the loop owning the running tasks, taken by its first task and given back by its last running one
+	std::atomic<uintptr_t> owner{ 0 };
+	std::atomic<uint32_t> runningTasks{ 0 };
+	std::atomic<uint32_t> overlaps{ 0 };
+	std::atomic<uint32_t> completedTasks{ 0 };
+
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < 3; ++i) {
+		threads.emplace_back([&]() {
+			for (uint32_t loop = 0; loop < 50; ++loop) {
+				std::atomic<uint32_t> loopTasks{ 0 };
+				const uintptr_t loopId = (uintptr_t)&loopTasks;
+				pool.ParallelFor(16, [&](uint32_t) {
+					runningTasks++;
+					uintptr_t expected = 0;
+					if (!owner.compare_exchange_strong(expected, loopId) && expected != loopId)
+						overlaps++;
+					loopTasks++;
+					completedTasks++;
+					if (--runningTasks == 0) {
+						expected = loopId;
+						owner.compare_exchange_strong(expected, 0);
+					}
+				});
+				CHECK_EQ(loopTasks.load(), 16u);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+		thread.join();
+
+	CHECK_EQ(overlaps.load(), 0u);
+	CHECK_EQ(completedTasks.load(), 3u * 50u * 16u);
+}
+
+TEST(TaskPoolChunksCoverItems)
+{
+	//below the minimum chunk size the items stay on the caller thread
+	CHECK_EQ(TaskPool::GetChunkCount(0, 64, 7), 1u);
+	CHECK_EQ(TaskPool::GetChunkCount(127, 64, 7), 1u);
+	CHECK_EQ(TaskPool::GetChunkCount(128, 64, 7), 2u);
+	//one chunk per worker and one for the caller
+	CHECK_EQ(TaskPool::GetChunkCount(8192, 64, 7), 8u);
+	CHECK_EQ(TaskPool::GetChunkCount(8192, 64, 0), 1u);
+
+	const uint32_t kItemCounts[] = { 1, 63, 100, 1000, 8191 };
+	for (uint32_t itemCount : kItemCounts) {
+		for (uint32_t chunkCount = 1; chunkCount <= 9; ++chunkCount) {
+			uint32_t expectedBegin = 0;
+			for (uint32_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) {
+				uint32_t begin, end;
+				TaskPool::GetChunkRange(itemCount, chunkCount, chunkIndex, begin, end);
+				CHECK_EQ(begin, expectedBegin);
+				CHECK(end >= begin);
+				CHECK(end - begin <= itemCount / chunkCount + 1);
+				expectedBegin = end;
+			}
+			CHECK_EQ(expectedBegin, itemCount);
+		}
+	}
+}
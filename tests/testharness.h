@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+//Test Harness
+//a tiny registry for the headless tests and benchmarks of the device-free sources
+//the tests fail through CHECK, the benchmarks print their throughput
+namespace GLIMMER_TEST
+{
+	typedef void(*TestFunc)();
+
+	struct BenchContext
+	{
+		//run a short pass, used by ctest to keep the benchmarks building and running
+		bool m_quick = false;
+
+		//scale the iteration count down in the quick pass
+		uint64_t Iterations(uint64_t fullCount) const { return m_quick ? (fullCount / 100 > 0 ? fullCount / 100 : 1) : fullCount; }
+		void Report(const char* label, uint64_t operations, double seconds) const {
+			double nanoseconds = operations > 0 ? seconds * 1e9 / (double)operations : 0.0;
+			printf("  %-48s %12llu ops %10.3f ms %9.2f ns/op\n", label, (unsigned long long)operations, seconds * 1e3, nanoseconds);
+		}
+	};
+	typedef void(*BenchFunc)(const BenchContext&);
+
+	struct TestCase
+	{
+		const char* m_name;
+		TestFunc m_func;
+	};
+
+	struct BenchCase
+	{
+		const char* m_name;
+		BenchFunc m_func;
+	};
+
+	inline std::vector<TestCase>& GetTests() {
+		static std::vector<TestCase> tests;
+		return tests;
+	}
+
+	inline std::vector<BenchCase>& GetBenchmarks() {
+		static std::vector<BenchCase> benchmarks;
+		return benchmarks;
+	}
+
+	//the failed checks of the running test, the checks may fail in the worker threads
+	inline std::atomic<uint32_t>& GetFailedChecks() {
+		static std::atomic<uint32_t> failedChecks{ 0 };
+		return failedChecks;
+	}
+
+	inline void ReportFailure(const char* file, int line, const char* expression) {
+		GetFailedChecks()++;
+		printf("  %s:%d: CHECK(%s) failed\n", file, line, expression);
+	}
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* name, TestFunc func) { GetTests().push_back({ name, func }); }
+	};
+
+	struct BenchRegistrar
+	{
+		BenchRegistrar(const char* name, BenchFunc func) { GetBenchmarks().push_back({ name, func }); }
+	};
+
+	class Stopwatch
+	{
+	public:
+		Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+		double GetSeconds() const {
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point m_start;
+	};
+}
+
+#define TEST(name) \
+	static void name(); \
+	static GLIMMER_TEST::TestRegistrar s_testRegistrar_##name(#name, name); \
+	static void name()
+
+#define BENCHMARK(name) \
+	static void name(const GLIMMER_TEST::BenchContext& bench); \
+	static GLIMMER_TEST::BenchRegistrar s_benchRegistrar_##name(#name, name); \
+	static void name(const GLIMMER_TEST::BenchContext& bench)
+
+#define CHECK(expression) \
+	do { if (!(expression)) GLIMMER_TEST::ReportFailure(__FILE__, __LINE__, #expression); } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
@@ -0,0 +1,29 @@
+#include "testharness.h"
+#include <cstring>
+
+//run all the tests, or the tests whose name contains the first argument
+int main(int argc, char* argv[])
+{
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+	uint32_t runCount = 0;
+	uint32_t failedCount = 0;
+
+	for (const GLIMMER_TEST::TestCase& test : GLIMMER_TEST::GetTests()) {
+		if (filter != nullptr && strstr(test.m_name, filter) == nullptr)
+			continue;
+
+		printf("[ RUN  ] %s\n", test.m_name);
+		GLIMMER_TEST::GetFailedChecks() = 0;
+		GLIMMER_TEST::Stopwatch stopwatch;
+		test.m_func();
+		bool passed = GLIMMER_TEST::GetFailedChecks() == 0;
+		printf("[ %s ] %s (%.0f ms)\n", passed ? " OK " : "FAIL", test.m_name, stopwatch.GetSeconds() * 1e3);
+
+		runCount++;
+		if (!passed)
+			failedCount++;
+	}
+
+	printf("%u tests, %u failed\n", runCount, failedCount);
+	return failedCount == 0 && runCount > 0 ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#include "testharness.h"
+#include "resources/memoryallocator/tlsfallocator.h"
+#include <map>
+#include <random>
+
+namespace
+{
+	struct LiveAllocation
+	{
+		TLSFAllocation m_allocation;
+		uint64_t m_requestedSize;
+	};
+
+	//the live ranges keyed by the offset, used to find the overlaps
+	typedef std::map<uint64_t, uint64_t> RangeMap;
+
+	bool OverlapsLiveRange(const RangeMap& ranges, uint64_t offset, uint64_t size)
+	{
+		RangeMap::const_iterator next = ranges.lower_bound(offset);
+		if (next != ranges.end() && next->first < offset + size)
+			return true;
+		if (next != ranges.begin()) {
+			RangeMap::const_iterator prev = std::prev(next);
+			if (prev->first + prev->second > offset)
+				return true;
+		}
+		return false;
+	}
+}
+
+TEST(TLSFAllocateFreeSingleBlock)
+{
+	TLSFAllocator allocator;
+	allocator.Initialize(1 << 20, 256);
+
+	TLSFAllocation allocation;
+	CHECK(allocator.Allocate(1000, 0, allocation));
+	CHECK_EQ(allocation.m_offset, 0u);
+	CHECK_EQ(allocation.m_size, 1024u);
+	CHECK_EQ(allocator.GetUsedSize(), 1024u);
+
+	allocator.Free(allocation);
+	CHECK(allocator.IsEmpty());
+	TLSFReport report = allocator.GetReport();
+	CHECK_EQ(report.m_freeBlockCount, 1u);
+	CHECK_EQ(report.m_largestFreeBlock, 1u << 20);
+}
+
+TEST(TLSFRejectsOversizedRequest)
+{
+	TLSFAllocator allocator;
+	allocator.Initialize(1 << 16, 256);
+
+	TLSFAllocation allocation;
+	CHECK(!allocator.Allocate(0, 0, allocation));
+	CHECK(!allocator.Allocate((1 << 16) + 1, 0, allocation));
+	CHECK(allocator.Allocate(1 << 16, 0, allocation));
+	CHECK(!allocator.Allocate(256, 0, allocation));
+}
+
+//millions of random allocations and frees against a shadow map of the live ranges
+//checks the ranges never overlap, keep the alignment, and the free blocks merge back into one
+TEST(TLSFRandomizedAllocateFree)
+{
+	const uint64_t kCapacity = 256ull << 20;
+	const uint64_t kGranularity = 256;
+	const uint32_t kOperationCount = 2000000;
+	const uint32_t kMaxLiveCount = 4096;
+	const uint64_t kAlignments[] = { 0, 256, 4096, 65536 };
+
+	TLSFAllocator allocator;
+	allocator.Initialize(kCapacity, kGranularity);
+
+	std::mt19937_64 random(0x9E3779B97F4A7C15ull);
+	std::vector<LiveAllocation> liveAllocations;
+	RangeMap liveRanges;
+	uint64_t liveSize = 0;
+	uint32_t failedAllocations = 0;
+
+	for (uint32_t i = 0; i < kOperationCount; ++i) {
+		//keep the live count around the half of the maximum
+		bool allocate = liveAllocations.empty() ||
+			(liveAllocations.size() < kMaxLiveCount && random() % kMaxLiveCount >= liveAllocations.size() / 2);
+
+		if (allocate) {
+			//the sizes spread over the size classes, from one byte to 1mb
+			uint64_t size = 1 + random() % (1ull << (random() % 21));
+			uint64_t alignment = kAlignments[random() % 4];
+
+			TLSFAllocation allocation;
+			if (!allocator.Allocate(size, alignment, allocation)) {
+				//good fit rounds the request up by one second level step at most
+				uint64_t searchSize = ((size + kGranularity - 1) & ~(kGranularity - 1)) + (alignment > kGranularity ? alignment - kGranularity : 0);
+				CHECK(allocator.GetReport().m_largestFreeBlock < searchSize + searchSize / 16 + kGranularity);
+				failedAllocations++;
+				continue;
+			}
+
+			CHECK(allocation.m_size >= size);
+			CHECK(allocation.m_size % kGranularity == 0);
+			CHECK(allocation.m_offset + allocation.m_size <= kCapacity);
+			if (alignment != 0)
+				CHECK(allocation.m_offset % alignment == 0);
+			CHECK(!OverlapsLiveRange(liveRanges, allocation.m_offset, allocation.m_size));
+
+			liveRanges[allocation.m_offset] = allocation.m_size;
+			liveAllocations.push_back({ allocation, size });
+			liveSize += allocation.m_size;
+		}
+		else {
+			size_t index = random() % liveAllocations.size();
+			const TLSFAllocation& allocation = liveAllocations[index].m_allocation;
+			liveRanges.erase(allocation.m_offset);
+			liveSize -= allocation.m_size;
+			allocator.Free(allocation);
+			liveAllocations[index] = liveAllocations.back();
+			liveAllocations.pop_back();
+		}
+
+		CHECK_EQ(allocator.GetUsedSize(), liveSize);
+		if (i % 65536 == 0) {
+			TLSFReport report = allocator.GetReport();
+			CHECK_EQ(report.m_usedSize + report.m_freeSize, kCapacity);
+			CHECK_EQ(report.m_allocationCount, (uint32_t)liveAllocations.size());
+		}
+	}
+
+	for (const LiveAllocation& live : liveAllocations)
+		allocator.Free(live.m_allocation);
+
+	//all the free neighbours merged back into the whole range
+	TLSFReport report = allocator.GetReport();
+	CHECK(allocator.IsEmpty());
+	CHECK_EQ(report.m_freeBlockCount, 1u);
+	CHECK_EQ(report.m_largestFreeBlock, kCapacity);
+	CHECK(report.m_fragmentation == 0.0f);
+	printf("  %u operations, %u allocations failed\n", kOperationCount, failedAllocations);
+}